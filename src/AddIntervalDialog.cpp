@@ -493,20 +493,32 @@ AddIntervalDialog::findFirsts(bool typeTime, const RideFile *ride, double window
 
 }
 
+// adds a peak power interval, named e.g. "Peak 5s (800w)"
+static void
+addPeak(const RideFile *ride, double windowSize, QList<AddIntervalDialog::AddedInterval> &results, QString name)
+{
+    RideFilePeak peak = ride->peakPower(windowSize);
+    if (peak.isEmpty()) return;
+
+    AddIntervalDialog::AddedInterval interval(peak.start, ride->series(RideFile::secs)[peak.last], peak.avg);
+    interval.name = QString(name + " (%4w)").arg(round(peak.avg));
+    results.append(interval);
+}
+
 void
 AddIntervalDialog::findPeakPowerStandard(const RideFile *ride, QList<AddedInterval> &results)
 {
-    findBests(true, ride, 5, 1, results, "Peak 5s");
-    findBests(true, ride, 10, 1, results, "Peak 10s");
-    findBests(true, ride, 20, 1, results, "Peak 20s");
-    findBests(true, ride, 30, 1, results, "Peak 30s");
-    findBests(true, ride, 60, 1, results, "Peak 1min");
-    findBests(true, ride, 120, 1, results, "Peak 2min");
-    findBests(true, ride, 300, 1, results, "Peak 5min");
-    findBests(true, ride, 600, 1, results, "Peak 10min");
-    findBests(true, ride, 1200, 1, results, "Peak 20min");
-    findBests(true, ride, 1800, 1, results, "Peak 30min");
-    findBests(true, ride, 3600, 1, results, "Peak 60min");
+    addPeak(ride, 5, results, "Peak 5s");
+    addPeak(ride, 10, results, "Peak 10s");
+    addPeak(ride, 20, results, "Peak 20s");
+    addPeak(ride, 30, results, "Peak 30s");
+    addPeak(ride, 60, results, "Peak 1min");
+    addPeak(ride, 120, results, "Peak 2min");
+    addPeak(ride, 300, results, "Peak 5min");
+    addPeak(ride, 600, results, "Peak 10min");
+    addPeak(ride, 1200, results, "Peak 20min");
+    addPeak(ride, 1800, results, "Peak 30min");
+    addPeak(ride, 3600, results, "Peak 60min");
 }
 
 void
@@ -24,6 +24,7 @@
 #include "Settings.h"
 #include "Units.h"
 #include "Colors.h"
+#include "MinMaxSeriesData.h"
 
 #include <math.h>
 #include <assert.h>
@@ -34,6 +35,7 @@
 #include <qwt_plot_marker.h>
 #include <qwt_symbol.h>
 #include <set>
+#include <algorithm>
 #include <QDebug>
 
 #define PI M_PI
@@ -308,14 +310,10 @@ Aerolab::configChanged()
 void
 Aerolab::setData(RideItem *_rideItem, bool new_zoom) {
 
-  // HARD-CODED DATA: p1->kph
-  double vfactor = 3.600;
-  double m       =  totalMass;
-  double small_number = 0.00001;
-
   rideItem = _rideItem;
   RideFile *ride = rideItem->ride();
 
+  model = VirtualElevation();
   veArray.clear();
   altArray.clear();
   distanceArray.clear();
@@ -332,7 +330,6 @@ Aerolab::setData(RideItem *_rideItem, bool new_zoom) {
       // If watts are present, then we can fill the veArray data:
       const RideFileDataPresent *dataPresent = ride->areDataPresent();
       int npoints = ride->dataPoints().size();
-      double dt = ride->recIntSecs();
       veArray.resize(dataPresent->watts ? npoints : 0);
       altArray.resize(dataPresent->alt ? npoints : 0);
       timeArray.resize(dataPresent->watts ? npoints : 0);
@@ -358,60 +355,25 @@ Aerolab::setData(RideItem *_rideItem, bool new_zoom) {
         altCurve->setVisible(dataPresent->alt);
       }
 
-      // Fill the virtual elevation profile with data from the ride data:
-      double t = 0.0;
-      double vlast = 0.0;
-      double e     = 0.0;
-      //double d = 0; //XXX not used?
+      // the model does the sums for the virtual elevation once, the
+      // sliders then only need to evaluate it for the samples in view
+      model.setRide(ride);
+
       arrayLength = 0;
       foreach(const RideFilePoint *p1, ride->dataPoints()) {
-      if ( arrayLength == 0 )
-        e = eoffset;
-
-      timeArray[arrayLength]  = p1->secs / 60.0;
-      if ( have_recorded_alt_curve )
-        altArray[arrayLength] = (useMetricUnits
-                   ? p1->alt
-                   : p1->alt * FEET_PER_METER);
-
-      // Unpack:
-      double power = max(0, p1->watts);
-      double v     = p1->kph/vfactor;
-      double headwind = v;
-      if( dataPresent->headwind ) {
-        headwind   = p1->headwind/vfactor;
-      }
-      double f     = 0.0;
-      double a     = 0.0;
 
-      // Use km data insteed of formula for file with a stop (gap).
-      //d += v * dt;
-      //distanceArray[arrayLength] = d/1000;
+        timeArray[arrayLength]  = p1->secs / 60.0;
+        if ( have_recorded_alt_curve )
+          altArray[arrayLength] = (useMetricUnits
+                     ? p1->alt
+                     : p1->alt * FEET_PER_METER);
 
-      distanceArray[arrayLength] = p1->km;
+        // Use km data insteed of formula for file with a stop (gap).
+        distanceArray[arrayLength] = p1->km;
 
-
-
-      if( v > small_number ) {
-        f  = power/v;
-        a  = ( v*v - vlast*vlast ) / ( 2.0 * dt * v );
-      } else {
-        a = ( v - vlast ) / dt;
+        ++arrayLength;
       }
 
-      f *= eta; // adjust for drivetrain efficiency if using a crank-based meter
-      double s   = slope( f, a, m, crr, cda, rho, headwind );
-      double de  = s * v * dt;
-
-      e += de;
-      t += dt;
-      veArray[arrayLength] = e;
-
-      vlast = v;
-
-      ++arrayLength;
-    }
-
   } else {
       veCurve->setVisible(false);
       altCurve->setVisible(false);
@@ -438,23 +400,22 @@ Aerolab::setAxisTitle(int axis, QString label)
     QwtPlot::setAxisTitle(axis, title);
 }
 
-void
+// returns true if the offset was moved
+bool
 Aerolab::adjustEoffset() {
 
-    if (autoEoffset && !altArray.empty()) {
+    if (autoEoffset && !altArray.empty() && model.count()) {
         double idx = axisScaleDiv( QwtPlot::xBottom )->lowerBound();
         parent->eoffsetSlider->setEnabled(false);
 
-        if (bydist) {
-            int v = 100*(altArray.at(rideItem->ride()->distanceIndex(idx))-veArray.at(rideItem->ride()->distanceIndex(idx)));
-            parent->eoffsetSlider->setValue(intEoffset()+v);
-        }
-        else {
-            int v = 100*(altArray.at(rideItem->ride()->timeIndex(60*idx))-veArray.at(rideItem->ride()->timeIndex(60*idx)));
-            parent->eoffsetSlider->setValue(intEoffset()+v);
-        }
+        int index = bydist ? rideItem->ride()->distanceIndex(idx) : rideItem->ride()->timeIndex(60*idx);
+        int v = 100*(altArray.at(index)-model.elevation(index, parameters()));
+        int old = parent->eoffsetSlider->value();
+        parent->eoffsetSlider->setValue(intEoffset()+v);
+        return parent->eoffsetSlider->value() != old;
     } else
         parent->eoffsetSlider->setEnabled(true);
+    return false;
 }
 
 
@@ -476,7 +437,7 @@ Aerolab::recalc( bool new_zoom ) {
   if (rideTimeSecs > 7*24*60*60) {
     QVector<double> data;
 
-    if (!veArray.empty()){
+    if (model.count()){
       veCurve->setData(data, data);
     }
     if( !altArray.empty()) {
@@ -489,13 +450,28 @@ Aerolab::recalc( bool new_zoom ) {
   int startingIndex = 0;
   int totalPoints   = arrayLength - startingIndex;
 
+  // when zoomed in only the samples in view (and one either
+  // side so the line runs off the edge) are worked out
+  if (!new_zoom) {
+      updateAxes();
+      const QwtScaleDiv *x = axisScaleDiv(xBottom);
+      startingIndex = std::lower_bound(xaxis.constBegin(), xaxis.constBegin() + arrayLength,
+                                       x->lowerBound()) - xaxis.constBegin();
+      int stop = std::upper_bound(xaxis.constBegin(), xaxis.constBegin() + arrayLength,
+                                  x->upperBound()) - xaxis.constBegin();
+      startingIndex = qMax(0, startingIndex - 1);
+      totalPoints = qMin(arrayLength, stop + 1) - startingIndex;
+  }
+
   // set curves
-  if (!veArray.empty()) {
-      veCurve->setData(xaxis.data() + startingIndex, veArray.data() + startingIndex, totalPoints);
+  if (model.count()) {
+      veArray.resize(totalPoints);
+      model.elevations(startingIndex, startingIndex + totalPoints, parameters(), veArray.data());
+      veCurve->setData(new MinMaxSeriesData(xaxis.data() + startingIndex, veArray.data(), totalPoints));
   }
 
   if (!altArray.empty()){
-      altCurve->setData(xaxis.data() + startingIndex, altArray.data() + startingIndex, totalPoints);
+      altCurve->setData(new MinMaxSeriesData(xaxis.data() + startingIndex, altArray.data() + startingIndex, totalPoints));
   }
 
   if( new_zoom )
@@ -536,6 +512,11 @@ Aerolab::setYMax(bool new_zoom)
             double minY = 0.0;
             double maxY = 0.0;
 
+            // the curves only hold the samples in view, but the axis
+            // is for the whole ride so it stays put as we zoom around
+            double veMin = 0.0, veMax = 0.0;
+            model.range(parameters(), veMin, veMax);
+
             //************
 
   //if (veCurve->isVisible()) {
@@ -545,8 +526,13 @@ Aerolab::setYMax(bool new_zoom)
    //          min( veCurve->minYValue(), altCurve->minYValue() ) - 10,
    //          10.0 + max( veCurve->maxYValue(), altCurve->maxYValue() ) );
 
-        minY = min( veCurve->minYValue(), altCurve->minYValue() ) - 10;
-        maxY = 10.0 + max( veCurve->maxYValue(), altCurve->maxYValue() );
+        double altMin = altArray[0], altMax = altArray[0];
+        for (int i=1; i<arrayLength; i++) {
+            altMin = min(altMin, altArray[i]);
+            altMax = max(altMax, altArray[i]);
+        }
+        minY = min( veMin, altMin ) - 10;
+        maxY = 10.0 + max( veMax, altMax );
 
     } else {
       //setAxisScale(yLeft,
@@ -557,9 +543,9 @@ Aerolab::setYMax(bool new_zoom)
 
               {
 
-                minY = veCurve->minYValue();
+                minY = veMin;
 
-                maxY = veCurve->maxYValue();
+                maxY = veMax;
 
               }
 
@@ -614,23 +600,25 @@ Aerolab::setByDistance(int value) {
 }
 
 
-double
-Aerolab::slope(
-           double f,
-           double a,
-           double m,
-           double crr,
-           double cda,
-           double rho,
-           double v
-        )  {
-
-  double g = 9.80665;
-
-  // Small angle version of slope calculation:
-  double s = f/(m*g) - crr - cda*rho*v*v/(2.0*m*g) - a/g;
+VEParameters
+Aerolab::parameters() const
+{
+  VEParameters x;
+  x.cda = cda;
+  x.crr = crr;
+  x.eta = eta;
+  x.rho = rho;
+  x.totalMass = totalMass;
+  x.eoffset = eoffset;
+  return x;
+}
 
-  return s;
+// the model changed, keep the offset in step if it is automatic
+// (moving the offset slider redraws) otherwise just redraw
+void
+Aerolab::parametersChanged()
+{
+  if (!adjustEoffset()) recalc(false);
 }
 
 // At slider 1000, we want to get max Crr=0.1000
@@ -642,7 +630,7 @@ Aerolab::setIntCrr(
 
   crr = (double) value / 1000000.0;
 
-  recalc(false);
+  parametersChanged();
 }
 
 // At slider 1000, we want to get max CdA=1.000
@@ -652,7 +640,7 @@ Aerolab::setIntCda(
            int value
             )  {
   cda = (double) value / 10000.0;
-  recalc(false);
+  parametersChanged();
 }
 
 // At slider 1000, we want to get max CdA=1.000
@@ -663,7 +651,7 @@ Aerolab::setIntTotalMass(
               ) {
 
   totalMass = (double) value / 100.0;
-  recalc(false);
+  parametersChanged();
 }
 
 
@@ -675,7 +663,7 @@ Aerolab::setIntRho(
             ) {
 
   rho = (double) value / 10000.0;
-  recalc(false);
+  parametersChanged();
 }
 
 
@@ -687,7 +675,7 @@ Aerolab::setIntEta(
                      ) {
 
   eta = (double) value / 10000.0;
-  recalc(false);
+  parametersChanged();
 }
 
 
@@ -792,7 +780,8 @@ QString Aerolab::estimateCdACrr(RideItem *rideItem)
         if(dataPresent->alt && dataPresent->watts) {
             double dt = ride->recIntSecs();
             int npoints = ride->dataPoints().size();
-            double X1[npoints], X2[npoints], Egain[npoints];
+            // every point can close a segment and open another
+            QVector<double> X1(npoints + 1), X2(npoints + 1), Egain(npoints + 1);
             int nSeg = -1;
             double altInit = 0, vInit = 0;
             /* For each segment, defined between points with alt != 0,
@@ -898,3 +887,74 @@ QString Aerolab::estimateCdACrr(RideItem *rideItem)
     }
     return errMsg;
 }
+
+/*
+ * Search CdA and Crr for the best fit of the virtual elevation to the
+ * recorded elevation over the part of the ride in view, with eta, rho
+ * and the total mass as they are set. The offset is fitted too unless
+ * it is being set automatically.
+ * Returns an explanatory error message if it can't, otherwise it updates
+ * cda and crr and returns an empty error message.
+ */
+VESweep Aerolab::sweepGrid() const
+{
+    // the slider ranges, in steps of the last digit shown
+    VESweep grid;
+    for (int i=1; i<=600; i++) grid.cda << i / 1000.0;
+    for (int i=20; i<=200; i++) grid.crr << i / 20000.0;
+    grid.eta << eta;
+    grid.rho << rho;
+    return grid;
+}
+
+QString Aerolab::sweepCdACrr()
+{
+    if (!model.count()) return tr("Altitude and Power data must be present");
+
+    // the samples in view
+    QVector<double> &xaxis = (bydist?distanceArray:timeArray);
+    const QwtScaleDiv *x = axisScaleDiv(xBottom);
+    int from = std::lower_bound(xaxis.constBegin(), xaxis.constBegin() + arrayLength,
+                                x->lowerBound()) - xaxis.constBegin();
+    int to = std::upper_bound(xaxis.constBegin(), xaxis.constBegin() + arrayLength,
+                              x->upperBound()) - xaxis.constBegin();
+
+    VESweepResult result = model.sweep(sweepGrid(), totalMass, from, to);
+    if (!result.error.isEmpty()) return result.error;
+
+    cda = result.best.cda;
+    crr = result.best.crr;
+    if (!autoEoffset) eoffset = result.best.eoffset;
+    return "";
+}
+
+/*
+ * The same search, but for one CdA and Crr across all the intervals
+ * selected, each with an offset of its own. This is what you want for
+ * a field test with several runs up and down the same road. The offset
+ * of the first interval is the one shown.
+ */
+QString Aerolab::sweepIntervalsCdACrr()
+{
+    if (!model.count() || !model.hasAltitude()) return tr("Altitude and Power data must be present");
+
+    QList<VEFitSums> stretches;
+    const QTreeWidgetItem *allIntervals = mainWindow->allIntervalItems();
+    for (int i=0; allIntervals && i<allIntervals->childCount(); i++) {
+        IntervalItem *current = (IntervalItem *) allIntervals->child(i);
+        if (current == NULL || current->isSelected() == false) continue;
+
+        int from = rideItem->ride()->timeIndex(current->start);
+        int to = rideItem->ride()->timeIndex(current->stop) + 1;
+        stretches << model.sums(from, to);
+    }
+    if (stretches.isEmpty()) return tr("Select the intervals to fit first");
+
+    VESweepResult result = VirtualElevation::sweep(sweepGrid(), totalMass, stretches);
+    if (!result.error.isEmpty()) return result.error;
+
+    cda = result.best.cda;
+    crr = result.best.crr;
+    if (!autoEoffset) eoffset = result.best.eoffset;
+    return "";
+}
@@ -24,6 +24,7 @@
 #include <qwt_series_data.h>
 #include <QtGui>
 #include "LTMWindow.h" // for tooltip/canvaspicker
+#include "VirtualElevation.h"
 
 // forward references
 class RideItem;
@@ -60,7 +61,8 @@ class Aerolab : public QwtPlot {
         LTMToolTip      *tooltip;
         LTMCanvasPicker *_canvasPicker; // allow point selection/hover
 
-        void adjustEoffset();
+        bool adjustEoffset();
+        void parametersChanged();
 
   public slots:
 
@@ -93,7 +95,9 @@ class Aerolab : public QwtPlot {
   QVector<double> speedArray;
   QVector<double> cadArray;
 
-  // We store virtual elevation, time, altitude,and distance:
+  // virtual elevation comes from the model, veArray only holds
+  // the samples in view. We store time, altitude, and distance:
+  VirtualElevation model;
   QVector<double> veArray;
   QVector<double> altArray;
   QVector<double> timeArray;
@@ -113,7 +117,6 @@ class Aerolab : public QwtPlot {
   double eoffset;
 
 
-  double   slope(double, double, double, double, double, double, double);
   void     recalc(bool);
   void     setYMax(bool);
   void     setXTitle();
@@ -129,6 +132,7 @@ class Aerolab : public QwtPlot {
   double   getRho() const { return (double)rho; }
   double   getEta() const { return (double)eta; }
   double   getEoffset() const { return (double)eoffset; }
+  VEParameters parameters() const;
   int      intCrr() const { return (int)( crr * 1000000  ); }
   int      intCda() const { return (int)( cda * 10000); }
   int      intTotalMass() const { return (int)( totalMass * 100); }
@@ -136,6 +140,9 @@ class Aerolab : public QwtPlot {
   int      intEta() const { return (int)( eta * 10000); }
   int      intEoffset() const { return (int)( eoffset * 100); }
   QString  estimateCdACrr(RideItem* rideItem);
+  VESweep  sweepGrid() const;
+  QString  sweepCdACrr();
+  QString  sweepIntervalsCdACrr();
 
 };
 
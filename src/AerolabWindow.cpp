@@ -203,6 +203,14 @@ AerolabWindow::AerolabWindow(MainWindow *mainWindow) :
   QPushButton *btnEstCdACrr = new QPushButton(tr("&Estimate CdA and Crr"), this);
   smoothLayout->addWidget(btnEstCdACrr);
 
+  QPushButton *btnFitCdACrr = new QPushButton(tr("&Fit CdA and Crr"), this);
+  btnFitCdACrr->setToolTip(tr("Search for the CdA and Crr that best fit the recorded elevation in view"));
+  smoothLayout->addWidget(btnFitCdACrr);
+
+  QPushButton *btnFitIntervals = new QPushButton(tr("Fit &Intervals"), this);
+  btnFitIntervals->setToolTip(tr("Search for the CdA and Crr that best fit the recorded elevation across all the selected intervals"));
+  smoothLayout->addWidget(btnFitIntervals);
+
   // Add to leftControls:
   rightControls->addLayout( mLayout );
   rightControls->addLayout( rhoLayout );
@@ -240,6 +248,8 @@ AerolabWindow::AerolabWindow(MainWindow *mainWindow) :
   connect(eoffsetAuto, SIGNAL(stateChanged(int)), this, SLOT(setAutoEoffset(int)));
   connect(comboDistance, SIGNAL(currentIndexChanged(int)), this, SLOT(setByDistance(int)));
   connect(btnEstCdACrr, SIGNAL(clicked()), this, SLOT(doEstCdACrr()));
+  connect(btnFitCdACrr, SIGNAL(clicked()), this, SLOT(doFitCdACrr()));
+  connect(btnFitIntervals, SIGNAL(clicked()), this, SLOT(doFitIntervalsCdACrr()));
   connect(mainWindow, SIGNAL(configChanged()), aerolab, SLOT(configChanged()));
   connect(mainWindow, SIGNAL(configChanged()), this, SLOT(configChanged()));
   connect(mainWindow, SIGNAL(intervalSelected() ), this, SLOT(intervalSelected()));
@@ -281,8 +291,8 @@ AerolabWindow::AerolabWindow(MainWindow *mainWindow) :
 void
 AerolabWindow::zoomChanged()
 {
-    RideItem *ride = myRideItem;
-    aerolab->setData(ride, false);
+    // just the samples now in view
+    aerolab->recalc(false);
 }
 
 
@@ -316,8 +326,6 @@ AerolabWindow::setCrrFromText(const QString text) {
     aerolab->setIntCrr(value);
     //crrQLCDNumber->display(QString("%1").arg(aerolab->getCrr()));
     crrSlider->setValue(aerolab->intCrr());
-    RideItem *ride = mainWindow->rideItem();
-    aerolab->setData(ride, false);
   }
 }
 
@@ -328,8 +336,6 @@ AerolabWindow::setCrrFromSlider() {
     aerolab->setIntCrr(crrSlider->value());
     //crrQLCDNumber->display(QString("%1").arg(aerolab->getCrr()));
     crrLineEdit->setText(QString("%1").arg(aerolab->getCrr()) );
-    RideItem *ride = myRideItem;
-    aerolab->setData(ride, false);
   }
 }
 
@@ -340,8 +346,6 @@ AerolabWindow::setCdaFromText(const QString text) {
     aerolab->setIntCda(value);
     //cdaQLCDNumber->display(QString("%1").arg(aerolab->getCda()));
     cdaSlider->setValue(aerolab->intCda());
-    RideItem *ride = myRideItem;
-    aerolab->setData(ride, false);
   }
 }
 
@@ -352,8 +356,6 @@ AerolabWindow::setCdaFromSlider() {
     aerolab->setIntCda(cdaSlider->value());
     //cdaQLCDNumber->display(QString("%1").arg(aerolab->getCda()));
     cdaLineEdit->setText(QString("%1").arg(aerolab->getCda()) );
-    RideItem *ride = myRideItem;
-    aerolab->setData(ride, false);
   }
 }
 
@@ -366,8 +368,6 @@ AerolabWindow::setTotalMassFromText(const QString text) {
     aerolab->setIntTotalMass(value);
     //mQLCDNumber->display(QString("%1").arg(aerolab->getTotalMass()));
     mSlider->setValue(aerolab->intTotalMass());
-    RideItem *ride = mainWindow->rideItem();
-    aerolab->setData(ride, false);
   }
 }
 
@@ -378,8 +378,6 @@ AerolabWindow::setTotalMassFromSlider() {
     aerolab->setIntTotalMass(mSlider->value());
     //mQLCDNumber->display(QString("%1").arg(aerolab->getTotalMass()));
     mLineEdit->setText(QString("%1").arg(aerolab->getTotalMass()) );
-    RideItem *ride = myRideItem;
-    aerolab->setData(ride, false);
   }
 }
 
@@ -390,8 +388,6 @@ AerolabWindow::setRhoFromText(const QString text) {
     aerolab->setIntRho(value);
     //rhoQLCDNumber->display(QString("%1").arg(aerolab->getRho()));
     rhoSlider->setValue(aerolab->intRho());
-    RideItem *ride = myRideItem;
-    aerolab->setData(ride, false);
   }
 }
 
@@ -402,8 +398,6 @@ AerolabWindow::setRhoFromSlider() {
     aerolab->setIntRho(rhoSlider->value());
     //rhoQLCDNumber->display(QString("%1").arg(aerolab->getRho()));
     rhoLineEdit->setText(QString("%1").arg(aerolab->getRho()) );
-    RideItem *ride = myRideItem;
-    aerolab->setData(ride, false);
   }
 }
 
@@ -414,8 +408,6 @@ AerolabWindow::setEtaFromText(const QString text) {
     aerolab->setIntEta(value);
     //etaQLCDNumber->display(QString("%1").arg(aerolab->getEta()));
     etaSlider->setValue(aerolab->intEta());
-    RideItem *ride = myRideItem;
-    aerolab->setData(ride, false);
   }
 }
 
@@ -426,8 +418,6 @@ AerolabWindow::setEtaFromSlider() {
     aerolab->setIntEta(etaSlider->value());
     //etaQLCDNumber->display(QString("%1").arg(aerolab->getEta()));
     etaLineEdit->setText(QString("%1").arg(aerolab->getEta()) );
-    RideItem *ride = myRideItem;
-    aerolab->setData(ride, false);
   }
 }
 
@@ -438,8 +428,6 @@ AerolabWindow::setEoffsetFromText(const QString text) {
     aerolab->setIntEoffset(value);
     //eoffsetQLCDNumber->display(QString("%1").arg(aerolab->getEoffset()));
     eoffsetSlider->setValue(aerolab->intEoffset());
-    RideItem *ride = myRideItem;
-    aerolab->setData(ride, false);
   }
 }
 
@@ -450,8 +438,6 @@ AerolabWindow::setEoffsetFromSlider() {
     aerolab->setIntEoffset(eoffsetSlider->value());
     //eoffsetQLCDNumber->display(QString("%1").arg(aerolab->getEoffset()));
     eoffsetLineEdit->setText(QString("%1").arg(aerolab->getEoffset()) );
-    RideItem *ride = myRideItem;
-    aerolab->setData(ride, false);
   }
 }
 
@@ -483,13 +469,50 @@ AerolabWindow::doEstCdACrr()
         cdaLineEdit->setText(QString("%1").arg(aerolab->getCda()) );
         cdaSlider->setValue(aerolab->intCda());
         /* Refresh */
-        aerolab->setData(ride, false);
+        aerolab->parametersChanged();
     } else {
         /* report error: insufficient data to estimate Cda&Crr */
         QMessageBox::warning(this, tr("Estimate CdA and Crr"), errMsg);
     }
 }
 
+void
+AerolabWindow::doFitCdACrr()
+{
+    const QString errMsg = aerolab->sweepCdACrr();
+    if (errMsg.isEmpty()) {
+        /* Update Crr/Cda/Eoffset values in UI */
+        crrLineEdit->setText(QString("%1").arg(aerolab->getCrr()) );
+        crrSlider->setValue(aerolab->intCrr());
+        cdaLineEdit->setText(QString("%1").arg(aerolab->getCda()) );
+        cdaSlider->setValue(aerolab->intCda());
+        eoffsetLineEdit->setText(QString("%1").arg(aerolab->getEoffset()) );
+        eoffsetSlider->setValue(aerolab->intEoffset());
+        /* Refresh */
+        aerolab->parametersChanged();
+    } else {
+        QMessageBox::warning(this, tr("Fit CdA and Crr"), errMsg);
+    }
+}
+
+void
+AerolabWindow::doFitIntervalsCdACrr()
+{
+    const QString errMsg = aerolab->sweepIntervalsCdACrr();
+    if (errMsg.isEmpty()) {
+        /* Update Crr/Cda/Eoffset values in UI */
+        crrLineEdit->setText(QString("%1").arg(aerolab->getCrr()) );
+        crrSlider->setValue(aerolab->intCrr());
+        cdaLineEdit->setText(QString("%1").arg(aerolab->getCda()) );
+        cdaSlider->setValue(aerolab->intCda());
+        eoffsetLineEdit->setText(QString("%1").arg(aerolab->getEoffset()) );
+        eoffsetSlider->setValue(aerolab->intEoffset());
+        /* Refresh */
+        aerolab->parametersChanged();
+    } else {
+        QMessageBox::warning(this, tr("Fit CdA and Crr"), errMsg);
+    }
+}
 
 void
 AerolabWindow::zoomInterval(IntervalItem *which) {
@@ -60,6 +60,8 @@ class AerolabWindow : public GcWindow {
   void setEoffsetFromSlider();
   void setEoffsetFromText(const QString text);
   void doEstCdACrr();
+  void doFitCdACrr();
+  void doFitIntervalsCdACrr();
   void setAutoEoffset(int value);
   void setByDistance(int value);
   void rideSelected();
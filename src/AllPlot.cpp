@@ -26,6 +26,7 @@
 #include "Units.h"
 #include "Zones.h"
 #include "Colors.h"
+#include "MinMaxSeriesData.h"
 
 #include <assert.h>
 #include <qwt_plot_curve.h>
@@ -471,11 +472,9 @@ AllPlot::configChanged()
 
 }
 
-struct DataPoint {
-    double time, hr, watts, speed, cad, alt, temp, wind, torque, lrbalance;
-    DataPoint(double t, double h, double w, double s, double c, double a, double te, double wi, double tq, double lrb) :
-        time(t), hr(h), watts(w), speed(s), cad(c), alt(a), temp(te), wind(wi), torque(tq), lrbalance(lrb) {}
-};
+// the series we smooth, in the order they are added to the smoother
+enum { SmoothWatts, SmoothHr, SmoothSpeed, SmoothCad, SmoothAlt, SmoothTemp,
+       SmoothWind, SmoothTorque, SmoothBalance };
 
 bool AllPlot::shadeZones() const
 {
@@ -562,18 +561,7 @@ AllPlot::recalc()
     // we should only smooth the curves if smoothed rate is greater than sample rate
     if (smooth > rideItem->ride()->recIntSecs()) {
 
-        double totalWatts = 0.0;
-        double totalHr = 0.0;
-        double totalSpeed = 0.0;
-        double totalCad = 0.0;
-        double totalDist = 0.0;
-        double totalAlt = 0.0;
-        double totalTemp = 0.0;
-        double totalWind = 0.0;
-        double totalTorque = 0.0;
-        double totalBalance = 0.0;
-
-        QList<DataPoint> list;
+        const SmoothedData &smoothed = smoother.smooth(smooth);
 
         smoothWatts.resize(rideTimeSecs + 1); //(rideTimeSecs + 1);
         smoothHr.resize(rideTimeSecs + 1);
@@ -606,65 +594,14 @@ AllPlot::recalc()
             smoothBalanceR[secs]  = 50;
         }
 
-        int i = 0;
         for (int secs = smooth; secs <= rideTimeSecs; ++secs) {
-            while ((i < arrayLength) && (timeArray[i] <= secs)) {
-                DataPoint dp(timeArray[i],
-                             (!hrArray.empty() ? hrArray[i] : 0),
-                             (!wattsArray.empty() ? wattsArray[i] : 0),
-                             (!speedArray.empty() ? speedArray[i] : 0),
-                             (!cadArray.empty() ? cadArray[i] : 0),
-                             (!altArray.empty() ? altArray[i] : 0),
-                             (!tempArray.empty() ? tempArray[i] : 0),
-                             (!windArray.empty() ? windArray[i] : 0),
-                             (!torqueArray.empty() ? torqueArray[i] : 0),
-                             (!balanceArray.empty() ? balanceArray[i] : 0));
-                if (!wattsArray.empty())
-                    totalWatts += wattsArray[i];
-                if (!hrArray.empty())
-                    totalHr    += hrArray[i];
-                if (!speedArray.empty())
-                    totalSpeed += speedArray[i];
-                if (!cadArray.empty())
-                    totalCad   += cadArray[i];
-                if (!altArray.empty())
-                    totalAlt   += altArray[i];
-                if (!tempArray.empty() ) {
-                    if (tempArray[i] == RideFile::noTemp && i>0) {
-                        dp.temp = (i>0 && !list.empty()?list.back().temp:0.0);
-                        totalTemp   += dp.temp;
-                    }
-                    else {
-                        totalTemp   += tempArray[i];
-                    }
-                }
-                if (!windArray.empty())
-                    totalWind   += windArray[i];
-                if (!torqueArray.empty())
-                    totalTorque   += torqueArray[i];
-                if (!balanceArray.empty())
-                    totalBalance   += (balanceArray[i]>0?balanceArray[i]:50);
-
-                totalDist   = distanceArray[i];
-                list.append(dp);
-                ++i;
-            }
-            while (!list.empty() && (list.front().time < secs - smooth)) {
-                DataPoint &dp = list.front();
-                totalWatts -= dp.watts;
-                totalHr    -= dp.hr;
-                totalSpeed -= dp.speed;
-                totalCad   -= dp.cad;
-                totalAlt   -= dp.alt;
-                totalTemp   -= dp.temp;
-                totalWind   -= dp.wind;
-                totalTorque   -= dp.torque;
-                totalBalance   -= (dp.lrbalance>0?dp.lrbalance:50);
-                list.removeFirst();
-            }
+
+            // distance is where we got to, not an average
+            double totalDist = smoothed.last[secs] >= 0 ? distanceArray[smoothed.last[secs]] : 0.0;
+
             // TODO: this is wrong.  We should do a weighted average over the
             // seconds represented by each point...
-            if (list.empty()) {
+            if (smoothed.count[secs] == 0) {
                 smoothWatts[secs] = 0.0;
                 smoothHr[secs]    = 0.0;
                 smoothSpeed[secs] = 0.0;
@@ -678,17 +615,17 @@ AllPlot::recalc()
                 smoothBalanceR[secs] = 50;
             }
             else {
-                smoothWatts[secs]    = totalWatts / list.size();
-                smoothHr[secs]       = totalHr / list.size();
-                smoothSpeed[secs]    = totalSpeed / list.size();
-                smoothCad[secs]      = totalCad / list.size();
-                smoothAltitude[secs]      = totalAlt / list.size();
-                smoothTemp[secs]      = totalTemp / list.size();
-                smoothWind[secs]    = totalWind / list.size();
-                smoothRelSpeed[secs] =  QwtIntervalSample( bydist ? totalDist : secs / 60.0, QwtInterval(qMin(totalWind / list.size(), totalSpeed / list.size()), qMax(totalWind / list.size(), totalSpeed / list.size()) ) );
-                smoothTorque[secs]    = totalTorque / list.size();
-
-                double balance = totalBalance / list.size();
+                smoothWatts[secs]    = smoothed.mean[SmoothWatts][secs];
+                smoothHr[secs]       = smoothed.mean[SmoothHr][secs];
+                smoothSpeed[secs]    = smoothed.mean[SmoothSpeed][secs];
+                smoothCad[secs]      = smoothed.mean[SmoothCad][secs];
+                smoothAltitude[secs]      = smoothed.mean[SmoothAlt][secs];
+                smoothTemp[secs]      = smoothed.mean[SmoothTemp][secs];
+                smoothWind[secs]    = smoothed.mean[SmoothWind][secs];
+                smoothRelSpeed[secs] =  QwtIntervalSample( bydist ? totalDist : secs / 60.0, QwtInterval(qMin(smoothWind[secs], smoothSpeed[secs]), qMax(smoothWind[secs], smoothSpeed[secs]) ) );
+                smoothTorque[secs]    = smoothed.mean[SmoothTorque][secs];
+
+                double balance = smoothed.mean[SmoothBalance][secs];
                 if (balance == 0) {
                     smoothBalanceL[secs]    = 50;
                     smoothBalanceR[secs]    = 50;
@@ -760,27 +697,27 @@ AllPlot::recalc()
 
     // set curves - we set the intervalHighlighter to whichver is available
     if (!wattsArray.empty()) {
-        wattsCurve->setData(xaxis.data() + startingIndex, smoothWatts.data() + startingIndex, totalPoints);
+        wattsCurve->setData(new MinMaxSeriesData(xaxis.data() + startingIndex, smoothWatts.data() + startingIndex, totalPoints));
         intervalHighlighterCurve->setYAxis(yLeft);
 
     } if (!hrArray.empty()) {
-        hrCurve->setData(xaxis.data() + startingIndex, smoothHr.data() + startingIndex, totalPoints);
+        hrCurve->setData(new MinMaxSeriesData(xaxis.data() + startingIndex, smoothHr.data() + startingIndex, totalPoints));
         intervalHighlighterCurve->setYAxis(yLeft2);
 
     } if (!speedArray.empty()) {
-        speedCurve->setData(xaxis.data() + startingIndex, smoothSpeed.data() + startingIndex, totalPoints);
+        speedCurve->setData(new MinMaxSeriesData(xaxis.data() + startingIndex, smoothSpeed.data() + startingIndex, totalPoints));
         intervalHighlighterCurve->setYAxis(yRight);
 
     } if (!cadArray.empty()) {
-        cadCurve->setData(xaxis.data() + startingIndex, smoothCad.data() + startingIndex, totalPoints);
+        cadCurve->setData(new MinMaxSeriesData(xaxis.data() + startingIndex, smoothCad.data() + startingIndex, totalPoints));
         intervalHighlighterCurve->setYAxis(yLeft2);
 
     } if (!altArray.empty()) {
-        altCurve->setData(xaxis.data() + startingIndex, smoothAltitude.data() + startingIndex, totalPoints);
+        altCurve->setData(new MinMaxSeriesData(xaxis.data() + startingIndex, smoothAltitude.data() + startingIndex, totalPoints));
         intervalHighlighterCurve->setYAxis(yRight2);
 
     } if (!tempArray.empty()) {
-        tempCurve->setData(xaxis.data() + startingIndex, smoothTemp.data() + startingIndex, totalPoints);
+        tempCurve->setData(new MinMaxSeriesData(xaxis.data() + startingIndex, smoothTemp.data() + startingIndex, totalPoints));
         intervalHighlighterCurve->setYAxis(yRight);
 
     } if (!windArray.empty()) {
@@ -788,13 +725,13 @@ AllPlot::recalc()
         intervalHighlighterCurve->setYAxis(yRight);
 
     } if (!torqueArray.empty()) {
-        torqueCurve->setData(xaxis.data() + startingIndex, smoothTorque.data() + startingIndex, totalPoints);
+        torqueCurve->setData(new MinMaxSeriesData(xaxis.data() + startingIndex, smoothTorque.data() + startingIndex, totalPoints));
         intervalHighlighterCurve->setYAxis(yRight);
 
     } if (!balanceArray.empty()) {
-        balanceLCurve->setData(xaxis.data() + startingIndex, smoothBalanceL.data() + startingIndex, totalPoints);
+        balanceLCurve->setData(new MinMaxSeriesData(xaxis.data() + startingIndex, smoothBalanceL.data() + startingIndex, totalPoints));
         intervalHighlighterCurve->setYAxis(yLeft2);
-        balanceRCurve->setData(xaxis.data() + startingIndex, smoothBalanceR.data() + startingIndex, totalPoints);
+        balanceRCurve->setData(new MinMaxSeriesData(xaxis.data() + startingIndex, smoothBalanceR.data() + startingIndex, totalPoints));
         intervalHighlighterCurve->setYAxis(yLeft2);
     }
 
@@ -1071,19 +1008,19 @@ AllPlot::setDataFromPlot(AllPlot *plot, int startidx, int stopidx)
     balanceLCurve->setVisible(rideItem->ride()->areDataPresent()->lrbalance && showBalance);
     balanceRCurve->setVisible(rideItem->ride()->areDataPresent()->lrbalance && showBalance);
 
-    wattsCurve->setData(xaxis,smoothW,stopidx-startidx);
-    hrCurve->setData(xaxis, smoothHR,stopidx-startidx);
-    speedCurve->setData(xaxis, smoothS, stopidx-startidx);
-    cadCurve->setData(xaxis, smoothC, stopidx-startidx);
-    altCurve->setData(xaxis, smoothA, stopidx-startidx);
-    tempCurve->setData(xaxis, smoothTE, stopidx-startidx);
+    wattsCurve->setData(new MinMaxSeriesData(xaxis, smoothW, stopidx-startidx));
+    hrCurve->setData(new MinMaxSeriesData(xaxis, smoothHR, stopidx-startidx));
+    speedCurve->setData(new MinMaxSeriesData(xaxis, smoothS, stopidx-startidx));
+    cadCurve->setData(new MinMaxSeriesData(xaxis, smoothC, stopidx-startidx));
+    altCurve->setData(new MinMaxSeriesData(xaxis, smoothA, stopidx-startidx));
+    tempCurve->setData(new MinMaxSeriesData(xaxis, smoothTE, stopidx-startidx));
 
     QVector<QwtIntervalSample> tmpWND(stopidx-startidx);
     qMemCopy( tmpWND.data(), smoothRS, (stopidx-startidx) * sizeof( QwtIntervalSample ) );
     windCurve->setData(new QwtIntervalSeriesData(tmpWND));
-    torqueCurve->setData(xaxis, smoothNM, stopidx-startidx);
-    balanceLCurve->setData(xaxis, smoothBALL, stopidx-startidx);
-    balanceRCurve->setData(xaxis, smoothBALR, stopidx-startidx);
+    torqueCurve->setData(new MinMaxSeriesData(xaxis, smoothNM, stopidx-startidx));
+    balanceLCurve->setData(new MinMaxSeriesData(xaxis, smoothBALL, stopidx-startidx));
+    balanceRCurve->setData(new MinMaxSeriesData(xaxis, smoothBALR, stopidx-startidx));
 
     /*QVector<double> _time(stopidx-startidx);
     qMemCopy( _time.data(), xaxis, (stopidx-startidx) * sizeof( double ) );
@@ -1173,9 +1110,9 @@ AllPlot::setDataFromRide(RideItem *_rideItem)
     wattsArray.clear();
 
     RideFile *ride = rideItem->ride();
-    if (ride && ride->dataPoints().size()) {
+    if (ride && ride->samples()) {
         const RideFileDataPresent *dataPresent = ride->areDataPresent();
-        int npoints = ride->dataPoints().size();
+        int npoints = ride->samples();
         wattsArray.resize(dataPresent->watts ? npoints : 0);
         hrArray.resize(dataPresent->hr ? npoints : 0);
         speedArray.resize(dataPresent->kph ? npoints : 0);
@@ -1224,8 +1161,20 @@ AllPlot::setDataFromRide(RideItem *_rideItem)
         balanceLCurve->setVisible(dataPresent->lrbalance && showBalance);
         balanceRCurve->setVisible(dataPresent->lrbalance && showBalance);
 
-        arrayLength = 0;
-        foreach (const RideFilePoint *point, ride->dataPoints()) {
+        // scan the columns rather than each point
+        RideFileSeries secsSeries = ride->series(RideFile::secs);
+        RideFileSeries wattsSeries = ride->series(RideFile::watts);
+        RideFileSeries hrSeries = ride->series(RideFile::hr);
+        RideFileSeries kphSeries = ride->series(RideFile::kph);
+        RideFileSeries cadSeries = ride->series(RideFile::cad);
+        RideFileSeries altSeries = ride->series(RideFile::alt);
+        RideFileSeries tempSeries = ride->series(RideFile::temp);
+        RideFileSeries windSeries = ride->series(RideFile::headwind);
+        RideFileSeries balanceSeries = ride->series(RideFile::lrbalance);
+        RideFileSeries kmSeries = ride->series(RideFile::km);
+        RideFileSeries nmSeries = ride->series(RideFile::nm);
+
+        for (arrayLength = 0; arrayLength < npoints; ++arrayLength) {
 
             // we round the time to nearest 100th of a second
             // before adding to the array, to avoid situation
@@ -1237,49 +1186,71 @@ AllPlot::setDataFromRide(RideItem *_rideItem)
             //
             // NOTE: this rounding mechanism is identical to that
             //       used by the Ride Editor.
-            double secs = floor(point->secs);
-            double msecs = round((point->secs - secs) * 100) * 10;
+            double secs = floor(secsSeries[arrayLength]);
+            double msecs = round((secsSeries[arrayLength] - secs) * 100) * 10;
 
             timeArray[arrayLength]  = secs + msecs/1000;
             if (!wattsArray.empty())
-                wattsArray[arrayLength] = max(0, point->watts);
+                wattsArray[arrayLength] = max(0, wattsSeries[arrayLength]);
             if (!hrArray.empty())
-                hrArray[arrayLength]    = max(0, point->hr);
+                hrArray[arrayLength]    = max(0, hrSeries[arrayLength]);
             if (!speedArray.empty())
                 speedArray[arrayLength] = max(0,
                                               (useMetricUnits
-                                               ? point->kph
-                                               : point->kph * MILES_PER_KM));
+                                               ? kphSeries[arrayLength]
+                                               : kphSeries[arrayLength] * MILES_PER_KM));
             if (!cadArray.empty())
-                cadArray[arrayLength]   = max(0, point->cad);
+                cadArray[arrayLength]   = max(0, cadSeries[arrayLength]);
             if (!altArray.empty())
                 altArray[arrayLength]   = (useMetricUnits
-                                           ? point->alt
-                                           : point->alt * FEET_PER_METER);
+                                           ? altSeries[arrayLength]
+                                           : altSeries[arrayLength] * FEET_PER_METER);
             if (!tempArray.empty())
-                tempArray[arrayLength]   = point->temp;
+                tempArray[arrayLength]   = tempSeries[arrayLength];
 
             if (!windArray.empty())
                 windArray[arrayLength] = max(0,
                                              (useMetricUnits
-                                              ? point->headwind
-                                              : point->headwind * MILES_PER_KM));
+                                              ? windSeries[arrayLength]
+                                              : windSeries[arrayLength] * MILES_PER_KM));
 
             if (!balanceArray.empty())
-                balanceArray[arrayLength]   = point->lrbalance;
+                balanceArray[arrayLength]   = balanceSeries[arrayLength];
 
+            double km = kmSeries.isEmpty() ? 0 : kmSeries[arrayLength];
             distanceArray[arrayLength] = max(0,
                                              (useMetricUnits
-                                              ? point->km
-                                              : point->km * MILES_PER_KM));
+                                              ? km
+                                              : km * MILES_PER_KM));
 
             if (!torqueArray.empty())
                 torqueArray[arrayLength] = max(0,
                                               (useMetricUnits
-                                               ? point->nm
-                                               : point->nm * FEET_LB_PER_NM));
-            ++arrayLength;
+                                               ? nmSeries[arrayLength]
+                                               : nmSeries[arrayLength] * FEET_LB_PER_NM));
         }
+
+        // the smoother takes missing series as zero, temperature
+        // carries on from the last reading when it is missing and
+        // balance is 50/50 when not recorded
+        QVector<double> none(arrayLength, 0.0);
+        QVector<double> temp(tempArray), balance(balanceArray);
+        for (int i=1; i<temp.count(); i++)
+            if (temp[i] == RideFile::noTemp) temp[i] = temp[i-1];
+        for (int i=0; i<balance.count(); i++)
+            if (balance[i] <= 0) balance[i] = 50;
+
+        smoother.setTimes(timeArray);
+        smoother.addSeries(wattsArray.empty() ? none : wattsArray);
+        smoother.addSeries(hrArray.empty() ? none : hrArray);
+        smoother.addSeries(speedArray.empty() ? none : speedArray);
+        smoother.addSeries(cadArray.empty() ? none : cadArray);
+        smoother.addSeries(altArray.empty() ? none : altArray);
+        smoother.addSeries(temp.empty() ? none : temp);
+        smoother.addSeries(windArray.empty() ? none : windArray);
+        smoother.addSeries(torqueArray.empty() ? none : torqueArray);
+        smoother.addSeries(balance.empty() ? none : balance);
+
         recalc();
     }
     else {
@@ -23,6 +23,7 @@
 #include <qwt_plot.h>
 #include <qwt_series_data.h>
 #include <QtGui>
+#include "Smoother.h"
 
 class QwtPlotCurve;
 class QwtPlotIntervalCurve;
@@ -159,6 +160,7 @@ class AllPlot : public QwtPlot
         QVector<double> smoothBalanceL;
         QVector<double> smoothBalanceR;
         QVector<QwtIntervalSample> smoothRelSpeed;
+        Smoother smoother;
 
         // array / smooth state
         int arrayLength;
@@ -70,17 +70,20 @@ class XPower : public RideMetric {
         double total = 0.0;
         int count = 0;
 
-        foreach(const RideFilePoint *point, ride->dataPoints()) {
+        RideFileSeries times = ride->series(RideFile::secs);
+        RideFileSeries watts = ride->series(RideFile::watts);
+        int samples = ride->samples(); // it locks, so only once
+        for (int i=0; i<samples; i++) {
             while ((weighted > NEGLIGIBLE)
-                   && (point->secs > lastSecs + secsDelta + EPSILON)) {
+                   && (times[i] > lastSecs + secsDelta + EPSILON)) {
                 weighted *= attenuation;
                 lastSecs += secsDelta;
                 total += pow(weighted, 4.0);
                 count++;
             }
             weighted *= attenuation;
-            weighted += sampleWeight * point->watts;
-            lastSecs = point->secs;
+            weighted += sampleWeight * (watts.isEmpty() ? 0 : watts[i]);
+            lastSecs = times[i];
             total += pow(weighted, 4.0);
             count++;
         }
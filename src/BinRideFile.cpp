@@ -497,7 +497,7 @@ struct BinFileReaderState
                         temperature += value/10.0;
                         temperature_count ++;
 
-                        rideFile->dataPoints().at(rideFile->timeIndex(secs))->temp = temperature;
+                        rideFile->setPointValue(rideFile->timeIndex(secs), RideFile::temp, temperature);
                         rideFile->setDataPresent(RideFile::temp, true);
                         break;
                     case FORMAT_ID__RIDE_TIME :
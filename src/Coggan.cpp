@@ -63,12 +63,16 @@ class NP : public RideMetric {
 
             // loop over the data and convert to a rolling
             // average for the given windowsize
-            for (int i=0; i<ride->dataPoints().size(); i++) {
+            // (rides without power still count toward the duration)
+            RideFileSeries watts = ride->series(RideFile::watts);
+            int samples = ride->samples(); // it locks, so only once
+            for (int i=0; i<samples; i++) {
 
-                sum += ride->dataPoints()[i]->watts;
+                double value = watts.isEmpty() ? 0 : watts[i];
+                sum += value;
                 sum -= rolling[index];
 
-                rolling[index] = ride->dataPoints()[i]->watts;
+                rolling[index] = value;
 
                 total += pow(sum/rollingwindowsize,4); // raise rolling average to 4th power
                 count ++;
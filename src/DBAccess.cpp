@@ -33,6 +33,8 @@
 #include "SummaryMetrics.h"
 #include "RideMetadata.h"
 #include "SpecialFields.h"
+#include "PMCData.h"
+#include "LTMSettings.h"
 
 #include <boost/scoped_array.hpp>
 #include <boost/crc.hpp>
@@ -62,10 +64,13 @@
 // 40  20  Oct 2012 Mark Liversedge    Lucene search/filter and checkbox metadata field
 // 41  27  Oct 2012 Mark Liversedge    Lucene switched to StandardAnalyzer and search all texts by default
 // 42  03  Dec 2012 Mark Liversedge    W/KG ridefilecache changes - force a rebuild.
+// 43  17  Oct 2026 Mark Liversedge    Daily load table for the PMC stress metrics
+// 44  17  Oct 2026 Mark Liversedge    Day, week, month and year rollups for the LTM charts
 
-static int DBSchemaVersion = 42;
+static int DBSchemaVersion = 44;
 
-DBAccess::DBAccess(MainWindow* main, QDir home) : main(main), home(home)
+DBAccess::DBAccess(MainWindow* main, QDir home) : main(main), home(home),
+    metadatacrc(0), statementcrc(0), insertQuery(NULL), rangeQuery(NULL), writeCount(0)
 {
 	initDatabase(home);
 
@@ -78,6 +83,7 @@ DBAccess::DBAccess(MainWindow* main, QDir home) : main(main), home(home)
 
 void DBAccess::closeConnection()
 {
+    clearStatements();
     dbconn.close();
 }
 
@@ -118,6 +124,14 @@ DBAccess::initDatabase(QDir home)
                                        "Click Cancel to exit."), QMessageBox::Cancel);
     } else {
 
+        // readers don't block the writer and a commit doesn't have to
+        // wait for the disk twice, the page cache is big enough to hold
+        // the metrics for a few thousand rides (it is in pages of 1k)
+        QSqlQuery pragma(dbconn);
+        pragma.exec("PRAGMA journal_mode=WAL;");
+        pragma.exec("PRAGMA synchronous=NORMAL;");
+        pragma.exec("PRAGMA cache_size=16000;");
+
         // create database - does nothing if its already there
         createDatabase();
     }
@@ -212,16 +226,47 @@ bool DBAccess::createMetricsTable()
 	    query.addBindValue(metadatacrcnow);
         rc = query.exec();
     }
+
+    // charts always ask for a date range
+    if (rc) query.exec("CREATE INDEX IF NOT EXISTS metrics_ride_date ON metrics (ride_date);");
+
     return rc;
 }
 
 bool DBAccess::dropMetricTable()
 {
+    // the cached statements would stop the drop
+    clearStatements();
+
     QSqlQuery query("DROP TABLE metrics", dbconn);
     bool rc = query.exec();
+
+    // derived from the metrics so they go too
+    QSqlQuery dropLoad("DROP TABLE IF EXISTS dailyload", dbconn);
+    dropLoad.exec();
+    QSqlQuery dropRollups("DROP TABLE IF EXISTS rollups", dbconn);
+    dropRollups.exec();
+
     return rc;
 }
 
+bool DBAccess::createDailyLoadTable()
+{
+    // the sum of each stress metric for every day with a ride
+    QSqlQuery query("CREATE TABLE IF NOT EXISTS dailyload (metric varchar, day date, load double, "
+                    "PRIMARY KEY (metric, day));", dbconn);
+    return query.exec();
+}
+
+bool DBAccess::createRollupsTable()
+{
+    // each metric summed up for every day, week, month and year with a ride
+    QSqlQuery query("CREATE TABLE IF NOT EXISTS rollups (period integer, bucket date, metric varchar, "
+                    "sum double, count integer, wsum double, seconds double, allseconds double, "
+                    "rides integer, max double, PRIMARY KEY (period, metric, bucket));", dbconn);
+    return query.exec();
+}
+
 bool DBAccess::createMeasuresTable()
 {
     QSqlQuery query(dbconn);
@@ -303,6 +348,8 @@ bool DBAccess::createDatabase()
 
     // Ride metrics
 	createMetricsTable();
+    createDailyLoadTable();
+    createRollupsTable();
 
     // Athlete measures
     createMeasuresTable();
@@ -320,6 +367,10 @@ void DBAccess::checkDBVersion()
     QString measuresXML =  QString(home.absolutePath()) + "/measures.xml";
     int measurescrcnow = computeFileCRC(measuresXML);
 
+    // fields may have been added, the statements need to match
+    if (metadatacrcnow != metadatacrc) clearStatements();
+    metadatacrc = metadatacrcnow;
+
     // can we get a version number?
     QSqlQuery query("SELECT table_name, schema_version, creation_date, metadata_crc from version;", dbconn);
 
@@ -342,6 +393,8 @@ void DBAccess::checkDBVersion()
 
         // create afresh
         createMetricsTable();
+        createDailyLoadTable();
+        createRollupsTable();
         createMeasuresTable();
 
         return;
@@ -372,6 +425,8 @@ void DBAccess::checkDBVersion()
     if (dropMetric) {
         dropMetricTable();
         createMetricsTable();
+        createDailyLoadTable();
+        createRollupsTable();
     }
 
     // "measures" table, is it up-to-date? - export - recreate - import ....
@@ -403,21 +458,26 @@ int DBAccess::getDBVersion()
 /*----------------------------------------------------------------------
  * CRUD routines for Metrics table
  *----------------------------------------------------------------------*/
-bool DBAccess::importRide(SummaryMetrics *summaryMetrics, RideFile *ride, QColor color, unsigned long fingerprint, bool modify)
+void
+DBAccess::clearStatements()
 {
-	QSqlQuery query(dbconn);
-    QDateTime timestamp = QDateTime::currentDateTime();
+    delete insertQuery;
+    insertQuery = NULL;
+    delete rangeQuery;
+    rangeQuery = NULL;
+}
 
-    if (modify) {
-        // zap the current row
-	    query.prepare("DELETE FROM metrics WHERE filename = ?;");
-	    query.addBindValue(summaryMetrics->getFileName());
-        query.exec();
-    }
+void
+DBAccess::prepareStatements()
+{
+    if (insertQuery && rangeQuery && statementcrc == metadatacrc) return;
+    clearStatements();
+    statementcrc = metadatacrc;
 
-    // construct an insert statement
-    QString insertStatement = "insert into metrics ( filename, identifier, timestamp, ride_date, color, fingerprint ";
     const RideMetricFactory &factory = RideMetricFactory::instance();
+
+    // construct an insert statement, a row for the same file is replaced
+    QString insertStatement = "INSERT OR REPLACE INTO metrics ( filename, identifier, timestamp, ride_date, color, fingerprint ";
     for (int i=0; i<factory.metricCount(); i++)
         insertStatement += QString(", X%1 ").arg(factory.metricName(i));
 
@@ -444,47 +504,119 @@ bool DBAccess::importRide(SummaryMetrics *summaryMetrics, RideFile *ride, QColor
     }
     insertStatement += ")";
 
-	query.prepare(insertStatement);
+    insertQuery = new QSqlQuery(dbconn);
+    insertQuery->prepare(insertStatement);
+
+    // construct the range select statement, working out which
+    // column of the result set each select column goes to
+    QString selectStatement = "SELECT filename, identifier, ride_date";
+    rangeValueIds.clear();
+    rangeTextIds.clear();
+    for (int i=0; i<factory.metricCount(); i++) {
+        selectStatement += QString(", X%1 ").arg(factory.metricName(i));
+        rangeValueIds << MetricResultSet::symbolId(factory.metricName(i));
+        rangeTextIds << -1;
+    }
+    foreach(FieldDefinition field, main->rideMetadata()->getFields()) {
+        if (!main->specialFields.isMetric(field.name) && (field.type < 5 || field.type == 7)) {
+            selectStatement += QString(", Z%1 ").arg(main->specialFields.makeTechName(field.name));
+
+            QString underscored = field.name;
+            int symbol = MetricResultSet::symbolId(underscored.replace("_"," "));
+            if (field.type == 3 || field.type == 4) {
+                rangeValueIds << symbol;
+                rangeTextIds << -1;
+            } else {
+                // ignore texts for now XXX todo if want metadata from Summary Metrics
+                rangeValueIds << -1;
+                rangeTextIds << symbol;
+            }
+        }
+    }
+
+    // ride_date is held as yyyy-MM-ddThh:mm:ss so comparing it with the
+    // days as yyyy-MM-dd is the same as comparing DATE(ride_date), but
+    // can use the index
+    selectStatement += " FROM metrics where ride_date >= :start AND ride_date < :end "
+                       " ORDER BY ride_date;";
+
+    rangeQuery = new QSqlQuery(dbconn);
+    rangeQuery->setForwardOnly(true);
+    rangeQuery->prepare(selectStatement);
+}
+
+bool
+DBAccess::bindRide(QSqlQuery *query, SummaryMetrics *summaryMetrics, RideFile *ride, QColor color, unsigned long fingerprint)
+{
+    QDateTime timestamp = QDateTime::currentDateTime();
+    const RideMetricFactory &factory = RideMetricFactory::instance();
+    int n = 0;
 
     // filename, timestamp, ride date
-	query.addBindValue(summaryMetrics->getFileName());
-	query.addBindValue(summaryMetrics->getId());
-	query.addBindValue(timestamp.toTime_t());
-    query.addBindValue(summaryMetrics->getRideDate());
-    query.addBindValue(color.name());
-    query.addBindValue((int)fingerprint);
+	query->bindValue(n++, summaryMetrics->getFileName());
+	query->bindValue(n++, summaryMetrics->getId());
+	query->bindValue(n++, timestamp.toTime_t());
+    query->bindValue(n++, summaryMetrics->getRideDate());
+    query->bindValue(n++, color.name());
+    query->bindValue(n++, (int)fingerprint);
 
     // values
     for (int i=0; i<factory.metricCount(); i++) {
-	    query.addBindValue(summaryMetrics->getForSymbol(factory.metricName(i)));
+	    query->bindValue(n++, summaryMetrics->getForSymbol(factory.metricName(i)));
     }
 
     // And all the metadata texts
     foreach(FieldDefinition field, main->rideMetadata()->getFields()) {
 
         if (!main->specialFields.isMetric(field.name) && (field.type < 3 || field.type ==7)) {
-            query.addBindValue(ride->getTag(field.name, ""));
+            query->bindValue(n++, ride->getTag(field.name, ""));
         }
     }
     // And all the metadata metrics
     foreach(FieldDefinition field, main->rideMetadata()->getFields()) {
 
         if (!main->specialFields.isMetric(field.name) && (field.type == 3 || field.type == 4)) {
-            query.addBindValue(ride->getTag(field.name, "0.0").toDouble());
+            query->bindValue(n++, ride->getTag(field.name, "0.0").toDouble());
         } else if (!main->specialFields.isMetric(field.name)) {
             if (field.name == "Recording Interval")  // XXX Special - need a better way...
-                query.addBindValue(ride->recIntSecs());
+                query->bindValue(n++, ride->recIntSecs());
         }
     }
 
     // go do it!
-	bool rc = query.exec();
+	bool rc = query->exec();
+    if (rc) writes.insert(summaryMetrics->getFileName(), ++writeCount);
 
-	//if(!rc) qDebug() << query.lastError();
+	//if(!rc) qDebug() << query->lastError();
 
 	return rc;
 }
 
+bool DBAccess::importRide(SummaryMetrics *summaryMetrics, RideFile *ride, QColor color, unsigned long fingerprint, bool)
+{
+    prepareStatements();
+    return bindRide(insertQuery, summaryMetrics, ride, color, fingerprint);
+}
+
+bool
+DBAccess::importRides(const QList<DBRideImport> &rides)
+{
+    if (rides.isEmpty()) return true;
+
+    prepareStatements();
+
+    // the refresh will already have a transaction open, if
+    // not we make one so there is a single sync to disk
+    bool ownTransaction = dbconn.transaction();
+
+    bool rc = true;
+    foreach (DBRideImport add, rides)
+        if (!bindRide(insertQuery, add.summary, add.ride, add.color, add.fingerprint)) rc = false;
+
+    if (ownTransaction) dbconn.commit();
+    return rc;
+}
+
 bool
 DBAccess::deleteRide(QString name)
 {
@@ -495,6 +627,256 @@ DBAccess::deleteRide(QString name)
     return query.exec();
 }
 
+void
+DBAccess::updateDailyLoad(QList<QDate> days)
+{
+    QSqlQuery query(dbconn);
+
+    // after a rebuild it is quicker to do them all at once
+    if (days.count() > 100) {
+        query.exec("DELETE FROM dailyload;");
+        foreach (QString metric, PMCData::metrics()) {
+            query.prepare(QString("INSERT INTO dailyload (metric, day, load) "
+                                  "SELECT ?, DATE(ride_date), SUM(X%1) FROM metrics "
+                                  "GROUP BY DATE(ride_date);").arg(metric));
+            query.addBindValue(metric);
+            query.exec();
+        }
+        return;
+    }
+
+    // prepared once, only the day changes from here on. The metric is
+    // a column name so it needs a statement of its own
+    query.prepare("DELETE FROM dailyload WHERE day = DATE(?);");
+    QList<QSqlQuery> inserts;
+    foreach (QString metric, PMCData::metrics()) {
+        QSqlQuery insert(dbconn);
+        insert.prepare(QString("INSERT INTO dailyload (metric, day, load) "
+                               "SELECT ?, DATE(ride_date), SUM(X%1) FROM metrics "
+                               "WHERE DATE(ride_date) = DATE(?) GROUP BY DATE(ride_date);").arg(metric));
+        insert.bindValue(0, metric);
+        inserts << insert;
+    }
+
+    foreach (QDate day, days) {
+        query.bindValue(0, day);
+        query.exec();
+
+        for (int i=0; i<inserts.count(); i++) {
+            inserts[i].bindValue(1, day);
+            inserts[i].exec();
+        }
+    }
+}
+
+// the first day of the period date is in, and the first day after it
+static QDate
+rollupStart(QDate date, int period)
+{
+    switch (period) {
+    case LTM_WEEK: return date.addDays(1 - date.dayOfWeek()); // monday
+    case LTM_MONTH: return QDate(date.year(), date.month(), 1);
+    case LTM_YEAR: return QDate(date.year(), 1, 1);
+    case LTM_DAY:
+    default: return date;
+    }
+}
+
+static QDate
+rollupEnd(QDate date, int period)
+{
+    QDate start = rollupStart(date, period);
+    switch (period) {
+    case LTM_WEEK: return start.addDays(7);
+    case LTM_MONTH: return start.addMonths(1);
+    case LTM_YEAR: return start.addYears(1);
+    case LTM_DAY:
+    default: return start.addDays(1);
+    }
+}
+
+// and the same in sql, for the ride_date of a row in metrics
+static QString
+rollupBucket(int period)
+{
+    switch (period) {
+    case LTM_WEEK: return "DATE(ride_date, '-6 days', 'weekday 1')";
+    case LTM_MONTH: return "DATE(ride_date, 'start of month')";
+    case LTM_YEAR: return "DATE(ride_date, 'start of year')";
+    case LTM_DAY:
+    default: return "DATE(ride_date)";
+    }
+}
+
+// the sums for one metric, rides with a zero value don't count towards the
+// averages or the max since LTMPlot has always skipped them
+static QString
+rollupColumns(QString metric)
+{
+    return QString("SUM(X%1), SUM(X%1 != 0), SUM(X%1 * Xworkout_time), "
+                   "SUM(CASE WHEN X%1 != 0 THEN Xworkout_time ELSE 0 END), SUM(Xworkout_time), "
+                   "COUNT(*), MAX(CASE WHEN X%1 != 0 THEN X%1 END)").arg(metric);
+}
+
+void
+DBAccess::updateRollups(QList<QDate> days)
+{
+    static const int periods[] = { LTM_DAY, LTM_WEEK, LTM_MONTH, LTM_YEAR };
+    static const int sums = 7; // columns from rollupColumns(), rides is the 6th
+
+    // all the metrics are summed in one pass of the metrics table, that
+    // is ~120 x 7 columns which is well inside sqlite's limit of 2000
+    const RideMetricFactory &factory = RideMetricFactory::instance();
+    QString select;
+    for (int i=0; i<factory.metricCount(); i++)
+        select += ", " + rollupColumns(factory.metricName(i));
+
+    // and each one written back with the same statement
+    QSqlQuery insert(dbconn);
+    insert.prepare("INSERT INTO rollups (period, bucket, metric, sum, count, wsum, seconds, allseconds, rides, max) "
+                   "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+
+    QSqlQuery query(dbconn);
+    query.setForwardOnly(true);
+
+    // after a rebuild it is quicker to do them all at once
+    if (days.count() > 100) {
+        query.exec("DELETE FROM rollups;");
+        for (int p=0; p<4; p++) {
+            if (!query.exec(QString("SELECT %1%2 FROM metrics GROUP BY %1;").arg(rollupBucket(periods[p])).arg(select)))
+                continue;
+
+            while (query.next()) {
+                for (int i=0; i<factory.metricCount(); i++) {
+                    insert.addBindValue(periods[p]);
+                    insert.addBindValue(query.value(0));
+                    insert.addBindValue(factory.metricName(i));
+                    for (int j=0; j<sums; j++) insert.addBindValue(query.value(1 + i*sums + j));
+                    insert.exec();
+                }
+            }
+        }
+        return;
+    }
+
+    // otherwise just the periods that have changed, a few rides on the
+    // same day or week only need the week, month and year doing once
+    QSet<QPair<int,QDate> > buckets;
+    foreach (QDate day, days)
+        for (int p=0; p<4; p++)
+            buckets.insert(QPair<int,QDate>(periods[p], rollupStart(day, periods[p])));
+
+    // ride_date is yyyy-MM-ddThh:mm:ss so it can be compared with the days
+    QSqlQuery remove(dbconn);
+    remove.prepare("DELETE FROM rollups WHERE period = ? AND bucket = ?;");
+    query.prepare(QString("SELECT %1 FROM metrics WHERE ride_date >= ? AND ride_date < ?;").arg(select.mid(2)));
+
+    QPair<int,QDate> bucket;
+    foreach (bucket, buckets) {
+        remove.addBindValue(bucket.first);
+        remove.addBindValue(bucket.second);
+        remove.exec();
+
+        query.addBindValue(bucket.second);
+        query.addBindValue(rollupEnd(bucket.second, bucket.first));
+        if (!query.exec() || !query.next()) continue;
+
+        // no rides left in it, e.g. the last one was deleted
+        if (query.value(5).toInt() == 0) continue;
+
+        for (int i=0; i<factory.metricCount(); i++) {
+            insert.addBindValue(bucket.first);
+            insert.addBindValue(bucket.second);
+            insert.addBindValue(factory.metricName(i));
+            for (int j=0; j<sums; j++) insert.addBindValue(query.value(i*sums + j));
+            insert.exec();
+        }
+    }
+}
+
+QList<MetricRollup>
+DBAccess::getRollups(QString metric, int period, QDate from, QDate to)
+{
+    QList<MetricRollup> rollups;
+
+    QSqlQuery query(dbconn);
+    query.setForwardOnly(true);
+    query.prepare("SELECT bucket, sum, count, wsum, seconds, allseconds, rides, max FROM rollups "
+                  "WHERE period = ? AND metric = ? AND bucket >= ? AND bucket <= ? ORDER BY bucket;");
+    query.addBindValue(period);
+    query.addBindValue(metric);
+    query.addBindValue(rollupStart(from, period));
+    query.addBindValue(to);
+    query.exec();
+    while (query.next()) {
+        MetricRollup add;
+        add.bucket = query.value(0).toDate();
+        add.sum = query.value(1).toDouble();
+        add.count = query.value(2).toInt();
+        add.wsum = query.value(3).toDouble();
+        add.seconds = query.value(4).toDouble();
+        add.allSeconds = query.value(5).toDouble();
+        add.rides = query.value(6).toInt();
+        add.max = query.value(7).toDouble();
+        rollups << add;
+    }
+    query.finish();
+
+    // the first and last may only be partly in range, those
+    // are added up again from the days that are
+    for (int i=0; i<rollups.count(); i++) {
+
+        MetricRollup &partial = rollups[i];
+        if (partial.bucket >= from && rollupEnd(partial.bucket, period) <= to.addDays(1)) continue;
+
+        QDate start = partial.bucket < from ? from : partial.bucket;
+        QDate end = rollupEnd(partial.bucket, period).addDays(-1);
+        if (end > to) end = to;
+
+        query.prepare("SELECT SUM(sum), SUM(count), SUM(wsum), SUM(seconds), SUM(allseconds), SUM(rides), MAX(max) "
+                      "FROM rollups WHERE period = ? AND metric = ? AND bucket >= ? AND bucket <= ?;");
+        query.addBindValue(LTM_DAY);
+        query.addBindValue(metric);
+        query.addBindValue(start);
+        query.addBindValue(end);
+        if (query.exec() && query.next()) {
+            partial.sum = query.value(0).toDouble();
+            partial.count = query.value(1).toInt();
+            partial.wsum = query.value(2).toDouble();
+            partial.seconds = query.value(3).toDouble();
+            partial.allSeconds = query.value(4).toDouble();
+            partial.rides = query.value(5).toInt();
+            partial.max = query.value(6).toDouble();
+        }
+        query.finish();
+
+        if (partial.rides == 0) rollups.removeAt(i--); // none in range
+    }
+    return rollups;
+}
+
+QList<QPair<QDate,double> >
+DBAccess::getDailyLoad(QString metric, QDate from)
+{
+    QList<QPair<QDate,double> > days;
+
+    QSqlQuery query(dbconn);
+    query.setForwardOnly(true);
+    if (from.isValid()) {
+        query.prepare("SELECT day, load FROM dailyload WHERE metric = ? AND day >= DATE(?) ORDER BY day;");
+        query.addBindValue(metric);
+        query.addBindValue(from);
+    } else {
+        query.prepare("SELECT day, load FROM dailyload WHERE metric = ? ORDER BY day;");
+        query.addBindValue(metric);
+    }
+    query.exec();
+    while (query.next())
+        days << QPair<QDate,double>(query.value(0).toDate(), query.value(1).toDouble());
+
+    return days;
+}
+
 QList<QDateTime> DBAccess::getAllDates()
 {
     QSqlQuery query("SELECT ride_date from metrics ORDER BY ride_date;", dbconn);
@@ -563,59 +945,68 @@ DBAccess::getRide(QString filename, SummaryMetrics &summaryMetrics, QColor&color
     return found;
 }
 
-QList<SummaryMetrics> DBAccess::getAllMetricsFor(QDateTime start, QDateTime end)
+MetricResultSetPtr DBAccess::getMetricResultsFor(QDateTime start, QDateTime end)
 {
-    QList<SummaryMetrics> metrics;
+    MetricResultSet *metrics = new MetricResultSet;
 
     // null date range fetches all, but not currently used by application code
     // since it relies too heavily on the results of the QDateTime constructor
     if (start == QDateTime()) start = QDateTime::currentDateTime().addYears(-10);
     if (end == QDateTime()) end = QDateTime::currentDateTime().addYears(+10);
 
-    // construct the select statement
-    QString selectStatement = "SELECT filename, identifier, ride_date";
-    const RideMetricFactory &factory = RideMetricFactory::instance();
-    for (int i=0; i<factory.metricCount(); i++)
-        selectStatement += QString(", X%1 ").arg(factory.metricName(i));
-    foreach(FieldDefinition field, main->rideMetadata()->getFields()) {
-        if (!main->specialFields.isMetric(field.name) && (field.type < 5 || field.type == 7)) {
-            selectStatement += QString(", Z%1 ").arg(main->specialFields.makeTechName(field.name));
-        }
+    prepareStatements();
+    const QVector<int> &valueIds = rangeValueIds;
+    const QVector<int> &textIds = rangeTextIds;
+
+    for (int i=0; i<valueIds.count(); i++) {
+        if (valueIds[i] >= 0) metrics->addValueColumn(valueIds[i]);
+        else metrics->addTextColumn(textIds[i]);
     }
-    selectStatement += " FROM metrics where DATE(ride_date) >=DATE(:start) AND DATE(ride_date) <=DATE(:end) "
-                       " ORDER BY ride_date;";
 
-    // execute the select statement
-    QSqlQuery query(selectStatement, dbconn);
-    query.bindValue(":start", start.date());
-    query.bindValue(":end", end.date());
-    query.exec();
-    while(query.next())
+    // execute the select statement, up to the start of the day after
+    QSqlQuery *query = rangeQuery;
+    query->bindValue(":start", start.date());
+    query->bindValue(":end", end.date().addDays(1));
+    query->exec();
+    while(query->next())
     {
-        SummaryMetrics summaryMetrics;
-
         // filename and date
-        summaryMetrics.setFileName(query.value(0).toString());
-        summaryMetrics.setId(query.value(1).toString());
-        summaryMetrics.setRideDate(query.value(2).toDateTime());
+        int row = metrics->addRow(query->value(0).toString(), query->value(1).toString(),
+                                  query->value(2).toDateTime());
         // the values
-        int i=0;
-        for (; i<factory.metricCount(); i++)
-            summaryMetrics.setForSymbol(factory.metricName(i), query.value(i+3).toDouble());
-        foreach(FieldDefinition field, main->rideMetadata()->getFields()) {
-            if (!main->specialFields.isMetric(field.name) && (field.type == 3 || field.type == 4)) {
-                QString underscored = field.name;
-                summaryMetrics.setForSymbol(underscored.replace("_"," "), query.value(i+3).toDouble());
-                i++;
-            } else if (!main->specialFields.isMetric(field.name) && (field.type < 3 || field.type == 7)) {
-                QString underscored = field.name;
-                // ignore texts for now XXX todo if want metadata from Summary Metrics
-                summaryMetrics.setText(underscored.replace("_"," "), query.value(i+3).toString());
-                i++;
-            }
+        for (int i=0; i<valueIds.count(); i++) {
+            if (valueIds[i] >= 0) metrics->setValue(row, valueIds[i], query->value(i+3).toDouble());
+            else metrics->setText(row, textIds[i], query->value(i+3).toString());
         }
-        metrics << summaryMetrics;
     }
+    query->finish(); // so it is ready for next time
+    return MetricResultSetPtr(metrics);
+}
+
+QList<SummaryMetrics> DBAccess::getAllMetricsFor(QDateTime start, QDateTime end)
+{
+    return toSummaryMetrics(getMetricResultsFor(start, end));
+}
+
+QStringList DBAccess::getRidesWhere(QString where, const QList<QVariant> &params)
+{
+    QStringList rides;
+
+    QSqlQuery query(dbconn);
+    query.setForwardOnly(true);
+    query.prepare(QString("SELECT filename FROM metrics WHERE %1 ORDER BY ride_date;").arg(where));
+    foreach (QVariant param, params) query.addBindValue(param);
+    query.exec();
+    while(query.next()) rides << query.value(0).toString();
+
+    return rides;
+}
+
+QList<SummaryMetrics> DBAccess::toSummaryMetrics(MetricResultSetPtr results)
+{
+    QList<SummaryMetrics> metrics;
+    metrics.reserve(results->rows());
+    for (int i=0; i<results->rows(); i++) metrics << SummaryMetrics(results, i);
     return metrics;
 }
 
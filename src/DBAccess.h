@@ -35,6 +35,35 @@
 class RideFile;
 class Zones;
 class RideMetric;
+
+// a ride for importRides(), the caller owns the summary and ride
+struct DBRideImport
+{
+    DBRideImport() : summary(NULL), ride(NULL), fingerprint(0) {}
+    DBRideImport(SummaryMetrics *summary, RideFile *ride, QColor color, unsigned long fingerprint) :
+        summary(summary), ride(ride), color(color), fingerprint(fingerprint) {}
+
+    SummaryMetrics *summary;
+    RideFile *ride;
+    QColor color;
+    unsigned long fingerprint;
+};
+
+// one period of one metric for the LTM charts, see DBAccess::updateRollups().
+// the averages are weighted by workout_time like LTMPlot always has, and
+// rides with a zero value are only counted in rides and allSeconds
+struct MetricRollup
+{
+    QDate bucket;       // first day of the day, week (monday), month or year
+    double sum;         // of the values
+    int count;          // rides with a non-zero value
+    double wsum;        // value x workout_time, summed
+    double seconds;     // workout_time of the rides with a non-zero value
+    double allSeconds;  // workout_time of all the rides
+    int rides;          // all the rides
+    double max;         // of the non-zero values
+};
+
 class DBAccess
 {
 
@@ -53,20 +82,39 @@ class DBAccess
 	DBAccess(MainWindow *main, QDir home);
     ~DBAccess();
 
-    // Create/Delete Metrics
+    // Create/Delete Metrics, rows are replaced so there is no need to delete first
 	bool importRide(SummaryMetrics *summaryMetrics, RideFile *ride, QColor color, unsigned long, bool);
+    bool importRides(const QList<DBRideImport> &rides); // many at once, in one transaction
     bool deleteRide(QString);
 
+    // bumped each time a ride's row is written, the timestamp is only
+    // to the second so it can't tell if a ride was written twice in one
+    unsigned long written(QString filename) const { return writes.value(filename, 0); }
+
     // Create/Delete Measures
     bool importMeasure(SummaryMetrics *summaryMetrics);
 
     // Query Records
+    MetricResultSetPtr getMetricResultsFor(QDateTime start, QDateTime end);
     QList<SummaryMetrics> getAllMetricsFor(QDateTime start, QDateTime end);
+    QStringList getRidesWhere(QString where, const QList<QVariant> &params); // filenames, in date order
     QList<SummaryMetrics> getAllMetricsFor(DateRange dr) {
         return getAllMetricsFor(QDateTime(dr.from,QTime(0,0,0)), QDateTime(dr.to, QTime(23,59,59)));
     }
 
     bool getRide(QString filename, SummaryMetrics &metrics, QColor&color);
+
+    // Daily load for the PMC stress metrics, kept in step with the metrics
+    // table by telling us which days have had rides added/changed/deleted
+    void updateDailyLoad(QList<QDate> days);
+    QList<QPair<QDate,double> > getDailyLoad(QString metric, QDate from = QDate());
+
+    // Every metric summed up by day, week, month and year for the LTM
+    // charts, kept up to date in the same way as the daily load. period
+    // is LTM_DAY, LTM_WEEK, LTM_MONTH or LTM_YEAR and buckets that are
+    // only partly between from and to are made up from the days that are
+    void updateRollups(QList<QDate> days);
+    QList<MetricRollup> getRollups(QString metric, int period, QDate from, QDate to);
     QList<SummaryMetrics> getAllMeasuresFor(QDateTime start, QDateTime end);
     QList<SummaryMetrics> getAllMeasuresFor(DateRange dr) { 
         return getAllMeasuresFor(QDateTime(dr.from,QTime(0,0,0)), QDateTime(dr.to, QTime(23,59,59)));
@@ -74,6 +122,9 @@ class DBAccess
 
     SummaryMetrics getRideMetrics(QString filename); // for a filename
 
+    // a SummaryMetrics view of each row for the old callers
+    static QList<SummaryMetrics> toSummaryMetrics(MetricResultSetPtr results);
+
 	QList<QDateTime> getAllDates();
     QList<Season> getAllSeasons();
 
@@ -90,10 +141,25 @@ class DBAccess
 
 	typedef QHash<QString,RideMetric*> MetricMap;
 
+    // the metrics insert and date range select are very wide so we
+    // only build and prepare them once for each metadata.xml, they
+    // are thrown away whenever the metrics table is dropped
+    int metadatacrc, statementcrc;
+    QSqlQuery *insertQuery, *rangeQuery;
+    QVector<int> rangeValueIds, rangeTextIds;
+    void prepareStatements();
+    void clearStatements();
+    bool bindRide(QSqlQuery *query, SummaryMetrics *summaryMetrics, RideFile *ride, QColor color, unsigned long fingerprint);
+
+    unsigned long writeCount;
+    QHash<QString, unsigned long> writes; // filename -> writeCount when last written
+
 	bool createDatabase();
     void closeConnection();
     bool createMetricsTable();
     bool dropMetricTable();
+    bool createDailyLoadTable();
+    bool createRollupsTable();
     bool createMeasuresTable();
     bool dropMeasuresTable();
 	void initDatabase(QDir home);
@@ -76,16 +76,19 @@ class DanielsPoints : public RideMetric {
         score = 0.0;
         double cp = zones->getCP(zoneRange);
 
-        foreach(const RideFilePoint *point, ride->dataPoints()) {
+        RideFileSeries times = ride->series(RideFile::secs);
+        RideFileSeries watts = ride->series(RideFile::watts);
+        int samples = ride->samples(); // it locks, so only once
+        for (int i=0; i<samples; i++) {
             while ((weighted > NEGLIGIBLE)
-                   && (point->secs > lastSecs + secsDelta + EPSILON)) {
+                   && (times[i] > lastSecs + secsDelta + EPSILON)) {
                 weighted *= attenuation;
                 lastSecs += secsDelta;
                 inc(secsDelta, weighted, cp);
             }
             weighted *= attenuation;
-            weighted += sampleWeight * point->watts;
-            lastSecs = point->secs;
+            weighted += sampleWeight * (watts.isEmpty() ? 0 : watts[i]);
+            lastSecs = times[i];
             inc(secsDelta, weighted, cp);
         }
         while (weighted > NEGLIGIBLE) {
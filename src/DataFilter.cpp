@@ -20,6 +20,7 @@
 #include "MainWindow.h"
 #include "RideNavigator.h"
 #include <QDebug>
+#include <QVarLengthArray>
 
 #include "DataFilter_yacc.h"
 
@@ -80,8 +81,8 @@ void Leaf::clear(Leaf *leaf)
     case Leaf::String : delete leaf->lvalue.s; break;
     case Leaf::Symbol : delete leaf->lvalue.n; break;
     case Leaf::Logical  : 
-    case Leaf::Operation : clear(leaf->lvalue.l);
-                           clear(leaf->rvalue.l);
+    case Leaf::Operation : if (leaf->lvalue.l) clear(leaf->lvalue.l);
+                           if (leaf->rvalue.l) clear(leaf->rvalue.l);
                            delete(leaf->lvalue.l);
                            delete(leaf->rvalue.l);
                            break;
@@ -128,7 +129,7 @@ void Leaf::validateFilter(DataFilter *df, Leaf *leaf)
         break;
 
     case Leaf::Logical : validateFilter(df, leaf->lvalue.l);
-                         validateFilter(df, leaf->rvalue.l);
+                         if (leaf->rvalue.l) validateFilter(df, leaf->rvalue.l);
         break;
     default:
         break;
@@ -174,18 +175,24 @@ QStringList DataFilter::parseFilter(QString query)
         //treeRoot->print(treeRoot);
         emit parseGood();
 
-        // get all fields...
-        QList<SummaryMetrics> allRides = main->metricDB->getAllMetricsFor(QDateTime(), QDateTime());
+        // let the db do the work if we can
+        QString where;
+        QList<QVariant> params;
+        if (treeRoot->toSQL(this, treeRoot, where, params)) {
 
-        filenames.clear();
+            filenames = main->metricDB->getRidesWhere(where, params);
 
-        for (int i=0; i<allRides.count(); i++) {
+        } else {
 
-            // evaluate each ride...
-            bool result = treeRoot->eval(this, treeRoot, allRides.at(i));
-            if (result) {
-                filenames << allRides.at(i).getFileName();
-            }
+            // otherwise run the compiled program over all the rides
+            DataFilterProgram program;
+            treeRoot->compile(this, treeRoot, program);
+
+            MetricResultSetPtr allRides = main->metricDB->getMetricResultsFor(QDateTime(QDate(1900,1,1)),
+                                                                              QDateTime(QDate(3000,1,1)));
+            filenames.clear();
+            for (int i=0; i<allRides->rows(); i++)
+                if (program.eval(*allRides, i)) filenames << allRides->fileName(i);
         }
         emit results(filenames);
     }
@@ -206,6 +213,7 @@ void DataFilter::configUpdate()
 {
     lookupMap.clear();
     lookupType.clear();
+    lookupColumn.clear();
 
     // create lookup map from 'friendly name' to name used in smmaryMetrics
     // to enable a quick lookup && the lookup for the field type (number, text)
@@ -215,6 +223,7 @@ void DataFilter::configUpdate()
         QString name = factory.rideMetric(symbol)->name();
         lookupMap.insert(name.replace(" ","_"), symbol);
         lookupType.insert(name.replace(" ","_"), true);
+        lookupColumn.insert(name.replace(" ","_"), "X" + symbol);
     }
 
     // now add the ride metadata fields -- should be the same generally
@@ -223,6 +232,11 @@ void DataFilter::configUpdate()
             if (!main->specialFields.isMetric(underscored)) { 
                 lookupMap.insert(underscored.replace(" ","_"), field.name);
                 lookupType.insert(underscored.replace(" ","_"), (field.type > 2)); // true if is number
+
+                // only text and numeric fields are in the metrics table
+                if (field.type < 5)
+                    lookupColumn.insert(underscored.replace(" ","_"),
+                                        "Z" + main->specialFields.makeTechName(field.name));
             }
     }
 
@@ -236,188 +250,232 @@ void DataFilter::configUpdate()
 #endif
 }
 
-bool Leaf::eval(DataFilter *df, Leaf *leaf, SummaryMetrics m)
+// an operand as sql, symbols that aren't held in the table
+// get the value they would have had from a result set
+static void sqlOperand(DataFilter *df, Leaf *leaf, bool number, bool lhs,
+                       QString &sql, QList<QVariant> &params)
 {
-    switch(leaf->type) {
+    switch (leaf->type) {
 
-    case Leaf::Logical  : 
+    case Leaf::Symbol :
     {
-        switch (leaf->op) {
-            case AND :
-                return (eval(df, leaf->lvalue.l, m) && eval(df, leaf->rvalue.l, m));
-
-            case OR :
-                return (eval(df, leaf->lvalue.l, m) || eval(df, leaf->rvalue.l, m));
+        QString column = df->lookupColumn.value(*(leaf->lvalue.n), "");
+        if (number) {
+            if (column != "") sql += QString("CAST(COALESCE(%1,0) AS REAL)").arg(column);
+            else sql += "0";
+        } else {
+            if (column != "") sql += QString("COALESCE(%1,'')").arg(column);
+            else {
+                sql += "?";
+                params << QString(lhs ? "" : "notfound");
+            }
         }
     }
     break;
 
-    case Leaf::Operation : 
-    {
-        double lhsdouble, rhsdouble;
-        QString lhsstring, rhsstring;
-        bool lhsisNumber, rhsisNumber;
-
-        // GET LHS VALUE
-        switch (leaf->lvalue.l->type) {
-
-            case Leaf::Symbol :
-            {
-                QString rename;
-                // get symbol value
-                if ((lhsisNumber = df->lookupType.value(*(leaf->lvalue.l->lvalue.n))) == true) {
-                    // numeric
-                    lhsdouble = m.getForSymbol(rename=df->lookupMap.value(*(leaf->lvalue.l->lvalue.n),""));
-                    //qDebug()<<"symbol" << *(leaf->lvalue.l->lvalue.n) << "is" << lhsdouble << "via" << rename;
-                } else {
-                    // string
-                    lhsstring = m.getText(rename=df->lookupMap.value(*(leaf->lvalue.l->lvalue.n),""), "");
-                    //qDebug()<<"symbol" << *(leaf->lvalue.l->lvalue.n) << "is" << lhsstring << "via" << rename;
-                }
-            }
-            break;
-
-            case Leaf::Float :
-                lhsisNumber = true;
-                lhsdouble = leaf->lvalue.l->lvalue.f;
-                break;
+    case Leaf::Float : sql += "?"; params << (double) leaf->lvalue.f; break;
+    case Leaf::Integer : sql += "?"; params << (double) leaf->lvalue.i; break;
+    case Leaf::String : sql += "?"; params << *(leaf->lvalue.s); break;
 
-            case Leaf::Integer :
-                lhsisNumber = true;
-                lhsdouble = leaf->lvalue.l->lvalue.i;
-                break;
+    default:
+        break;
+    }
+}
 
-            case Leaf::String :
-                lhsisNumber = false;
-                lhsstring = *(leaf->lvalue.l->lvalue.s);
-                break;
+bool Leaf::toSQL(DataFilter *df, Leaf *leaf, QString &where, QList<QVariant> &params)
+{
+    switch(leaf->type) {
 
-            default:
-            break;
+    case Leaf::Logical :
+    {
+        QString op;
+        switch (leaf->op) {
+            case AND : op = " AND "; break;
+            case OR : op = " OR "; break;
+            default : break; // brackets
         }
 
-        // GET RHS VALUE
-        switch (leaf->rvalue.l->type) {
-
-            case Leaf::Symbol :
-            {
-                QString rename;
-                // get symbol value
-                if ((rhsisNumber=df->lookupType.value(*(leaf->rvalue.l->lvalue.n))) == true) {
-                    // numeric
-                    rhsdouble = m.getForSymbol(rename=df->lookupMap.value(*(leaf->rvalue.l->lvalue.n),""));
-                    //qDebug()<<"symbol" << *(leaf->rvalue.l->lvalue.n) << "is" << rhsdouble << "via" << rename;
-                } else {
-                    // string
-                    rhsstring = m.getText(rename=df->lookupMap.value(*(leaf->rvalue.l->lvalue.n),""), "notfound");
-                    //qDebug()<<"symbol" << *(leaf->rvalue.l->lvalue.n) << "is" << rhsstring << "via" << rename;
-                }
-            }
-            break;
+        where += "(";
+        if (!toSQL(df, leaf->lvalue.l, where, params)) return false;
+        if (op != "") {
+            where += op;
+            if (!toSQL(df, leaf->rvalue.l, where, params)) return false;
+        }
+        where += ")";
+    }
+    return true;
 
-            case Leaf::Float :
-                rhsisNumber = true;
-                rhsdouble = leaf->rvalue.l->lvalue.f;
-                break;
+    case Leaf::Operation :
+    {
+        // sqlite has no regular expressions
+        if (leaf->op == MATCHES) return false;
 
-            case Leaf::Integer :
-                rhsisNumber = true;
-                rhsdouble = leaf->rvalue.l->lvalue.i;
-                break;
+        bool number = isNumber(df, leaf->lvalue.l);
+        QString lhs, rhs;
+        QList<QVariant> lhsparams, rhsparams;
+        sqlOperand(df, leaf->lvalue.l, number, true, lhs, lhsparams);
+        sqlOperand(df, leaf->rvalue.l, number, false, rhs, rhsparams);
 
-            case Leaf::String :
-                rhsisNumber = false;
-                rhsstring = *(leaf->rvalue.l->lvalue.s);
-                break;
+        // string matching is case sensitive, as it is in QString
+        // so we can't use LIKE, and the rhs may be used twice
+        switch (leaf->op) {
+        case EQ : where += QString("(%1 = %2)").arg(lhs).arg(rhs); break;
+        case NEQ : where += QString("(%1 <> %2)").arg(lhs).arg(rhs); break;
+        case LT : where += QString("(%1 < %2)").arg(lhs).arg(rhs); break;
+        case LTE : where += QString("(%1 <= %2)").arg(lhs).arg(rhs); break;
+        case GT : where += QString("(%1 > %2)").arg(lhs).arg(rhs); break;
+        case GTE : where += QString("(%1 >= %2)").arg(lhs).arg(rhs); break;
+
+        case BEGINSWITH :
+            where += QString("(substr(%1, 1, length(%2)) = %2)").arg(lhs).arg(rhs);
+            params << lhsparams << rhsparams << rhsparams;
+            return true;
+
+        case ENDSWITH :
+            where += QString("(length(%2) = 0 OR substr(%1, -length(%2)) = %2)").arg(lhs).arg(rhs);
+            params << rhsparams << lhsparams << rhsparams << rhsparams;
+            return true;
+
+        case CONTAINS :
+            where += QString("(length(%2) = 0 OR replace(%1, %2, '') <> %1)").arg(lhs).arg(rhs);
+            params << rhsparams << lhsparams << rhsparams << lhsparams;
+            return true;
 
-            default:
-            break;
+        default:
+            return false;
         }
+        params << lhsparams << rhsparams;
+    }
+    return true;
 
-        // NOW PERFORM OPERATION
-        switch (leaf->op) {
+    default:
+        return false;
+    }
+}
 
-        case EQ:
-        {
-            if (lhsisNumber) {
-                return lhsdouble == rhsdouble;
-            } else {
-                return lhsstring == rhsstring;
-            }
-        }
-        break;
+static DataFilterOperand programOperand(DataFilter *df, Leaf *leaf, bool lhs)
+{
+    DataFilterOperand operand;
+    operand.kind = DataFilterOperand::Constant;
+    operand.symbol = -1;
+    operand.number = 0;
 
-        case NEQ:
-        {
-            if (lhsisNumber) {
-                return lhsdouble != rhsdouble;
-            } else {
-                return lhsstring != rhsstring;
-            }
-        }
+    switch (leaf->type) {
+
+    case Leaf::Symbol :
+        operand.kind = leaf->isNumber(df, leaf) ? DataFilterOperand::Value : DataFilterOperand::Text;
+        operand.symbol = MetricResultSet::symbolId(df->lookupMap.value(*(leaf->lvalue.n), ""));
+        operand.string = lhs ? "" : "notfound";
         break;
 
-        case LT:
-        {
-            if (lhsisNumber) {
-                return lhsdouble < rhsdouble;
-            } else {
-                return lhsstring < rhsstring;
-            }
-        }
+    case Leaf::Float : operand.number = leaf->lvalue.f; break;
+    case Leaf::Integer : operand.number = leaf->lvalue.i; break;
+    case Leaf::String : operand.string = *(leaf->lvalue.s); break;
+
+    default:
         break;
-        case LTE:
-        {
-            if (lhsisNumber) {
-                return lhsdouble <= rhsdouble;
-            } else {
-                return lhsstring <= rhsstring;
-            }
+    }
+    return operand;
+}
+
+void Leaf::compile(DataFilter *df, Leaf *leaf, DataFilterProgram &program)
+{
+    switch(leaf->type) {
+
+    case Leaf::Logical :
+    {
+        compile(df, leaf->lvalue.l, program);
+        if (leaf->op == AND || leaf->op == OR) {
+            compile(df, leaf->rvalue.l, program);
+
+            DataFilterInstruction instruction;
+            instruction.op = leaf->op;
+            instruction.number = false;
+            program.code << instruction;
         }
+    }
+    break;
+
+    case Leaf::Operation :
+    {
+        DataFilterInstruction instruction;
+        instruction.op = leaf->op;
+        instruction.number = isNumber(df, leaf->lvalue.l);
+        instruction.lhs = programOperand(df, leaf->lvalue.l, true);
+        instruction.rhs = programOperand(df, leaf->rvalue.l, false);
+        if (leaf->op == MATCHES && instruction.rhs.kind == DataFilterOperand::Constant)
+            instruction.regexp = QRegExp(instruction.rhs.string);
+        program.code << instruction;
+    }
+    break;
+
+    default:
         break;
-        case GT:
+    }
+}
+
+bool DataFilterProgram::eval(const MetricResultSet &results, int row) const
+{
+    QVarLengthArray<bool, 32> stack;
+
+    for (int pc=0; pc<code.count(); pc++) {
+        const DataFilterInstruction &i = code[pc];
+
+        switch (i.op) {
+
+        case AND :
+        case OR :
         {
-            if (lhsisNumber) {
-                return lhsdouble > rhsdouble;
-            } else {
-                return lhsstring > rhsstring;
-            }
+            bool rhs = stack[stack.count()-1];
+            bool lhs = stack[stack.count()-2];
+            stack.resize(stack.count()-1);
+            stack[stack.count()-1] = (i.op == AND) ? (lhs && rhs) : (lhs || rhs);
         }
         break;
-        case GTE:
+
+        default:
         {
-            if (lhsisNumber) {
-                return lhsdouble >= rhsdouble;
+            bool result = false;
+
+            if (i.number) {
+                double lhs = i.lhs.kind == DataFilterOperand::Value ? results.value(row, i.lhs.symbol) : i.lhs.number;
+                double rhs = i.rhs.kind == DataFilterOperand::Value ? results.value(row, i.rhs.symbol) : i.rhs.number;
+
+                switch (i.op) {
+                case EQ : result = lhs == rhs; break;
+                case NEQ : result = lhs != rhs; break;
+                case LT : result = lhs < rhs; break;
+                case LTE : result = lhs <= rhs; break;
+                case GT : result = lhs > rhs; break;
+                case GTE : result = lhs >= rhs; break;
+                default: break;
+                }
+
             } else {
-                return lhsstring >= rhsstring;
+                QString lhs = i.lhs.kind == DataFilterOperand::Text ? results.text(row, i.lhs.symbol, i.lhs.string) : i.lhs.string;
+                QString rhs = i.rhs.kind == DataFilterOperand::Text ? results.text(row, i.rhs.symbol, i.rhs.string) : i.rhs.string;
+
+                switch (i.op) {
+                case EQ : result = lhs == rhs; break;
+                case NEQ : result = lhs != rhs; break;
+                case LT : result = lhs < rhs; break;
+                case LTE : result = lhs <= rhs; break;
+                case GT : result = lhs > rhs; break;
+                case GTE : result = lhs >= rhs; break;
+                case MATCHES :
+                    if (i.rhs.kind == DataFilterOperand::Constant) result = i.regexp.exactMatch(lhs);
+                    else result = QRegExp(rhs).exactMatch(lhs);
+                    break;
+                case ENDSWITH : result = lhs.endsWith(rhs); break;
+                case BEGINSWITH : result = lhs.startsWith(rhs); break;
+                case CONTAINS : result = lhs.contains(rhs); break;
+                default: break;
+                }
             }
+            stack.append(result);
         }
         break;
-
-        case MATCHES:
-            return QRegExp(rhsstring).exactMatch(lhsstring);
-            break;
-
-        case ENDSWITH:
-            return lhsstring.endsWith(rhsstring);
-            break;
-
-        case BEGINSWITH:
-            return lhsstring.startsWith(rhsstring);
-            break;
-
-        case CONTAINS:
-            return lhsstring.contains(rhsstring);
-            break;
-
-        default:
-            break;
         }
     }
-    break;
-
-    default: // we don't need to evaluate any lower - they are leaf nodes handled above
-        break;
-    }
-    return false;
+    return stack.count() ? stack[0] : false;
 }
@@ -21,11 +21,14 @@
 #include <QDebug>
 #include <QList>
 #include <QStringList>
+#include <QVector>
+#include <QVariant>
+#include <QRegExp>
 
 class MainWindow;
 class RideMetric;
 class FieldDefinition;
-class SummaryMetrics;
+class MetricResultSet;
 
 class SymbolDef {
 
@@ -41,14 +44,19 @@ class SymbolDef {
 };
 
 class DataFilter;
+class DataFilterProgram;
 class Leaf {
 
     public:
 
-        Leaf() : type(none) { }
+        Leaf() : type(none) { lvalue.l = rvalue.l = NULL; }
 
-        // evaluate against a SummaryMetric
-        bool eval(DataFilter *df, Leaf *, SummaryMetrics);
+        // compile to an sql where clause with positional parameters,
+        // false if it can't be expressed in sql (regular expressions)
+        bool toSQL(DataFilter *df, Leaf *, QString &where, QList<QVariant> &params);
+
+        // compile to a program to evaluate against a result set
+        void compile(DataFilter *df, Leaf *, DataFilterProgram &program);
 
         // tree traversal etc
         void print(Leaf *);  // print leaf and all children
@@ -71,6 +79,31 @@ class Leaf {
         SymbolDef symbol; // hold information about symbols
 };
 
+// A filter compiled to a flat postfix program. Each comparison has its
+// symbols resolved to result set ids up front and pushes its result,
+// AND and OR combine the top two results.
+struct DataFilterOperand {
+    enum { Constant, Value, Text } kind;
+    int symbol;         // result set id for values and texts
+    double number;      // numeric constant
+    QString string;     // string constant, or the fallback for texts
+};
+
+struct DataFilterInstruction {
+    int op;             // a comparison, AND or OR
+    bool number;        // numeric comparison
+    DataFilterOperand lhs, rhs;
+    QRegExp regexp;     // for MATCHES with a constant pattern
+};
+
+class DataFilterProgram {
+
+    public:
+        bool eval(const MetricResultSet &results, int row) const;
+
+        QVector<DataFilterInstruction> code;
+};
+
 class DataFilter : public QObject
 {
     Q_OBJECT
@@ -82,6 +115,7 @@ class DataFilter : public QObject
         // used by Leaf
         QMap<QString,QString> lookupMap;
         QMap<QString,bool> lookupType; // true if a number, false if a string
+        QMap<QString,QString> lookupColumn; // column in the metrics table, if it has one
 
     public slots:
         QStringList parseFilter(QString query);
@@ -39,7 +39,7 @@ DataProcessorFactory::registerProcessor(QString name, DataProcessor *processor)
 }
 
 bool
-DataProcessorFactory::autoProcess(RideFile *ride)
+DataProcessorFactory::autoProcess(RideFile *ride, const RideFileContext &context)
 {
     bool changed = false;
 
@@ -49,8 +49,8 @@ DataProcessorFactory::autoProcess(RideFile *ride)
     while (i.hasNext()) {
         i.next();
         QString configsetting = QString("dp/%1/apply").arg(i.key());
-        if (appsettings->value(NULL, configsetting, "Manual").toString() == "Auto")
-            i.value()->postProcess(ride);
+        if (context.value(configsetting, "Manual").toString() == "Auto")
+            i.value()->postProcess(ride, NULL, &context);
     }
 
     return changed;
@@ -71,7 +71,7 @@ class DataProcessor
     public:
         DataProcessor() {}
         virtual ~DataProcessor() {}
-        virtual bool postProcess(RideFile *, DataProcessorConfig*settings=0) = 0;
+        virtual bool postProcess(RideFile *, DataProcessorConfig*settings=0, const RideFileContext *context=0) = 0;
         virtual DataProcessorConfig *processorConfig(QWidget *parent) = 0;
         virtual QString name() = 0; // Localized Name for user interface
 };
@@ -90,7 +90,7 @@ class DataProcessorFactory {
         static DataProcessorFactory &instance();
         bool registerProcessor(QString name, DataProcessor *processor);
         QMap<QString,DataProcessor*> getProcessors() const { return processors; }
-        bool autoProcess(RideFile *); // run auto processes (after open rideFile)
+        bool autoProcess(RideFile *, const RideFileContext &); // run auto processes (after open rideFile)
 };
 
 class MainWindow;
@@ -18,6 +18,7 @@
 
 
 #include "DiaryWindow.h"
+#include "RideNavigatorModel.h"
 
 DiaryWindow::DiaryWindow(MainWindow *mainWindow) :
     GcWindow(mainWindow), mainWindow(mainWindow), active(false)
@@ -72,7 +73,7 @@ DiaryWindow::DiaryWindow(MainWindow *mainWindow) :
 
     // monthly view via QCalendarWidget
     calendarModel = new GcCalendarModel(this, &fieldDefinitions, mainWindow);
-    calendarModel->setSourceModel(mainWindow->listView->sqlModel);
+    calendarModel->setSourceModel(mainWindow->listView->rideModel);
 
     monthlyView = new QTableView(this);
     monthlyView->setItemDelegate(new GcCalendarDelegate);
@@ -87,7 +88,7 @@ DiaryWindow::DiaryWindow(MainWindow *mainWindow) :
     // weekly view via QxtScheduleView
     weeklyView = new QxtScheduleView;
     weeklyViewProxy = new QxtScheduleViewProxy(this, &fieldDefinitions, mainWindow);
-    weeklyViewProxy->setSourceModel(mainWindow->listView->sqlModel);
+    weeklyViewProxy->setSourceModel(mainWindow->listView->rideModel);
     weeklyView->setCurrentZoomDepth (30, Qxt::Minute);
     weeklyView->setDateRange(QDate(2010,9,2), QDate(2010,9,8));
     weeklyView->setModel(weeklyViewProxy);
@@ -25,7 +25,11 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include <limits>
+#include <QTextStream>
+#include <QTime>
+#include <QDir>
 
 #define RECORD_TYPE 20
 
@@ -35,15 +39,20 @@ static int fitFileReaderRegistered =
 
 static const QDateTime qbase_time(QDate(1989, 12, 31), QTime(0, 0, 0), Qt::UTC);
 
+// a definition message is compiled into a plan for decoding the data
+// messages that follow it, where each field is in the message and how
+// to read it, so a data message is a bounds check and a tight loop
 struct FitField {
     int num;
-    int type; // FIT base_type
+    int type; // FIT base_type, -1 if we can't decode it
     int size; // in bytes
+    int offset; // from the start of the message content
 };
 
 struct FitDefinition {
     int global_msg_num;
     bool is_big_endian;
+    int size; // of the message content
     std::vector<FitField> fields;
 };
 
@@ -53,6 +62,54 @@ struct FitDefinition {
 typedef qint64 fit_value_t;
 #define NA_VALUE std::numeric_limits<fit_value_t>::max()
 
+// the size of each base type we decode, 0 for those we don't
+static int
+fitTypeSize(int type)
+{
+    switch (type) {
+        case 0: case 1: case 2: case 10: return 1;
+        case 3: case 4: case 11: return 2;
+        case 5: case 6: case 12: return 4;
+        default: return 0; //XXX: support float, string + byte base types
+    }
+}
+
+static inline fit_value_t
+fitValue(const uchar *p, int type, bool is_big_endian)
+{
+    switch (type) {
+        case 0:
+        case 2: { quint8 i = *p; return i == 0xff ? NA_VALUE : i; }
+        case 1: { qint8 i = *p; return i == 0x7f ? NA_VALUE : i; }
+        case 10: { quint8 i = *p; return i == 0x00 ? NA_VALUE : i; }
+        case 3: {
+            qint16 i = is_big_endian ? qFromBigEndian<qint16>(p) : qFromLittleEndian<qint16>(p);
+            return i == 0x7fff ? NA_VALUE : i;
+        }
+        case 4: {
+            quint16 i = is_big_endian ? qFromBigEndian<quint16>(p) : qFromLittleEndian<quint16>(p);
+            return i == 0xffff ? NA_VALUE : i;
+        }
+        case 11: {
+            quint16 i = is_big_endian ? qFromBigEndian<quint16>(p) : qFromLittleEndian<quint16>(p);
+            return i == 0x0000 ? NA_VALUE : i;
+        }
+        case 5: {
+            qint32 i = is_big_endian ? qFromBigEndian<qint32>(p) : qFromLittleEndian<qint32>(p);
+            return i == 0x7fffffff ? NA_VALUE : i;
+        }
+        case 6: {
+            quint32 i = is_big_endian ? qFromBigEndian<quint32>(p) : qFromLittleEndian<quint32>(p);
+            return i == 0xffffffff ? NA_VALUE : i;
+        }
+        case 12: {
+            quint32 i = is_big_endian ? qFromBigEndian<quint32>(p) : qFromLittleEndian<quint32>(p);
+            return i == 0x00000000 ? NA_VALUE : i;
+        }
+        default: return NA_VALUE;
+    }
+}
+
 
 struct FitFileReaderState
 {
@@ -71,144 +128,72 @@ struct FitFileReaderState
     int last_event;
     int last_msg_type;
 
+    // the whole file is mapped (or read if it can't be) and
+    // decoded from a cursor, rather than a read per field
+    uchar *map;
+    QByteArray buffer;
+    const uchar *data, *end;
+    std::vector<fit_value_t> values;
+
     FitFileReaderState(QFile &file, QStringList &errors) :
         file(file), errors(errors), rideFile(NULL), start_time(0),
         last_time(0), last_distance(0.00f), interval(0), devices(0), stopped(true),
-        last_event_type(-1), last_event(-1), last_msg_type(-1)
+        last_event_type(-1), last_event(-1), last_msg_type(-1),
+        map(NULL), data(NULL), end(NULL)
     {
     }
 
-    struct TruncatedRead {};
+    ~FitFileReaderState()
+    {
+        if (map) file.unmap(map);
+    }
 
-    void read_unknown( int size, int *count = NULL ){
-        char c[size+1];
+    struct TruncatedRead {};
 
-        // XXX: just seek instead of read?
-        if (file.read(c, size ) != size)
+    void need(int size) {
+        if (end - data < size)
             throw TruncatedRead();
-        if (count)
-            (*count) += size;
     }
 
-    fit_value_t read_int8(int *count = NULL) {
-        qint8 i;
-        if (file.read(reinterpret_cast<char*>( &i), 1) != 1)
-            throw TruncatedRead();
+    void read_unknown( int size, int *count = NULL ){
+        need(size);
+        data += size;
         if (count)
-            (*count) += 1;
-
-        return i == 0x7f ? NA_VALUE : i;
+            (*count) += size;
     }
 
     fit_value_t read_uint8(int *count = NULL) {
-        quint8 i;
-        if (file.read(reinterpret_cast<char*>( &i), 1) != 1)
-            throw TruncatedRead();
+        need(1);
+        fit_value_t v = fitValue(data, 2, false);
+        data += 1;
         if (count)
             (*count) += 1;
-
-        return i == 0xff ? NA_VALUE : i;
-    }
-
-    fit_value_t read_uint8z(int *count = NULL) {
-        quint8 i;
-        if (file.read(reinterpret_cast<char*>( &i), 1) != 1)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 1;
-
-        return i == 0x00 ? NA_VALUE : i;
-    }
-
-    fit_value_t read_int16(bool is_big_endian, int *count = NULL) {
-        qint16 i;
-        if (file.read(reinterpret_cast<char*>(&i), 2) != 2)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 2;
-
-        i = is_big_endian
-            ? qFromBigEndian<qint16>( i )
-            : qFromLittleEndian<qint16>( i );
-
-        return i == 0x7fff ? NA_VALUE : i;
+        return v;
     }
 
     fit_value_t read_uint16(bool is_big_endian, int *count = NULL) {
-        quint16 i;
-        if (file.read(reinterpret_cast<char*>(&i), 2) != 2)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 2;
-
-        i = is_big_endian
-            ? qFromBigEndian<quint16>( i )
-            : qFromLittleEndian<quint16>( i );
-
-        return i == 0xffff ? NA_VALUE : i;
-    }
-
-    fit_value_t read_uint16z(bool is_big_endian, int *count = NULL) {
-        quint16 i;
-        if (file.read(reinterpret_cast<char*>(&i), 2) != 2)
-            throw TruncatedRead();
+        need(2);
+        fit_value_t v = fitValue(data, 4, is_big_endian);
+        data += 2;
         if (count)
             (*count) += 2;
-
-        i = is_big_endian
-            ? qFromBigEndian<quint16>( i )
-            : qFromLittleEndian<quint16>( i );
-
-        return i == 0x0000 ? NA_VALUE : i;
-    }
-
-    fit_value_t read_int32(bool is_big_endian, int *count = NULL) {
-        qint32 i;
-        if (file.read(reinterpret_cast<char*>(&i), 4) != 4)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 4;
-
-        i = is_big_endian
-            ? qFromBigEndian<qint32>( i )
-            : qFromLittleEndian<qint32>( i );
-
-        return i == 0x7fffffff ? NA_VALUE : i;
+        return v;
     }
 
     fit_value_t read_uint32(bool is_big_endian, int *count = NULL) {
-        quint32 i;
-        if (file.read(reinterpret_cast<char*>(&i), 4) != 4)
-            throw TruncatedRead();
-        if (count)
-            (*count) += 4;
-
-        i = is_big_endian
-            ? qFromBigEndian<quint32>( i )
-            : qFromLittleEndian<quint32>( i );
-
-        return i == 0xffffffff ? NA_VALUE : i;
-    }
-
-    fit_value_t read_uint32z(bool is_big_endian, int *count = NULL) {
-        quint32 i;
-        if (file.read(reinterpret_cast<char*>(&i), 4) != 4)
-            throw TruncatedRead();
+        need(4);
+        fit_value_t v = fitValue(data, 6, is_big_endian);
+        data += 4;
         if (count)
             (*count) += 4;
-
-        i = is_big_endian
-            ? qFromBigEndian<quint32>( i )
-            : qFromLittleEndian<quint32>( i );
-
-        return i == 0x00000000 ? NA_VALUE : i;
+        return v;
     }
 
-    void decodeFileId(const FitDefinition &def, int, const std::vector<fit_value_t> values) {
-        int i = 0;
+    void decodeFileId(const FitDefinition &def, int, const std::vector<fit_value_t> &values) {
         int manu = -1, prod = -1;
-        foreach(const FitField &field, def.fields) {
-            fit_value_t value = values[i++];
+        for (size_t i = 0; i < def.fields.size(); ++i) {
+            const FitField &field = def.fields[i];
+            fit_value_t value = values[i];
 
             if( value == NA_VALUE )
                 continue;
@@ -237,13 +222,13 @@ struct FitFileReaderState
         rideFile->setFileFormat("FIT (*.fit)");
     }
 
-    void decodeEvent(const FitDefinition &def, int, const std::vector<fit_value_t> values) {
+    void decodeEvent(const FitDefinition &def, int, const std::vector<fit_value_t> &values) {
         time_t time = 0;
         int event = -1;
         int event_type = -1;
-        int i = 0;
-        foreach(const FitField &field, def.fields) {
-            fit_value_t value = values[i++];
+        for (size_t i = 0; i < def.fields.size(); ++i) {
+            const FitField &field = def.fields[i];
+            fit_value_t value = values[i];
 
             if( value == NA_VALUE )
                 continue;
@@ -287,17 +272,17 @@ struct FitFileReaderState
         last_event_type = event_type;
     }
 
-    void decodeLap(const FitDefinition &def, int time_offset, const std::vector<fit_value_t> values) {
+    void decodeLap(const FitDefinition &def, int time_offset, const std::vector<fit_value_t> &values) {
         time_t time = 0;
         if (time_offset > 0)
             time = last_time + time_offset;
         else
             time = last_time;
-        int i = 0;
         time_t this_start_time = 0;
         ++interval;
-        foreach(const FitField &field, def.fields) {
-            fit_value_t value = values[i++];
+        for (size_t i = 0; i < def.fields.size(); ++i) {
+            const FitField &field = def.fields[i];
+            fit_value_t value = values[i];
 
             if( value == NA_VALUE )
                 continue;
@@ -318,20 +303,20 @@ struct FitFileReaderState
             }
         }
 
-        if (rideFile->dataPoints().count()) // no samples means no laps..
+        if (rideFile->samples()) // no samples means no laps..
             rideFile->addInterval(this_start_time - start_time, time - start_time, QString("%1").arg(interval));
     }
 
-    void decodeRecord(const FitDefinition &def, int time_offset, const std::vector<fit_value_t> values) {
+    void decodeRecord(const FitDefinition &def, int time_offset, const std::vector<fit_value_t> &values) {
         time_t time = 0;
         if (time_offset > 0)
             time = last_time + time_offset;
         double alt = 0, cad = 0, km = 0, grade = 0, hr = 0, lat = 0, lng = 0, badgps = 0, lrbalance = 0;
         double resistance = 0, kph = 0, temperature = RideFile::noTemp, time_from_course = 0, watts = 0;
         fit_value_t lati = NA_VALUE, lngi = NA_VALUE;
-        int i = 0;
-        foreach(const FitField &field, def.fields) {
-            fit_value_t value = values[i++];
+        for (size_t i = 0; i < def.fields.size(); ++i) {
+            const FitField &field = def.fields[i];
+            fit_value_t value = values[i];
 
             if( value == NA_VALUE )
                 continue;
@@ -404,48 +389,47 @@ struct FitFileReaderState
         int interval = 0;
         if ((last_msg_type == RECORD_TYPE) && (last_time != 0) && (time > last_time + 1)) {
             // Evil smart recording.  Linearly interpolate missing points.
-            RideFilePoint *prevPoint = rideFile->dataPoints().back();
-            int deltaSecs = (int) (secs - prevPoint->secs);
-            assert(deltaSecs == secs - prevPoint->secs); // no fractional part
+            RideFilePoint prevPoint = rideFile->point(rideFile->samples()-1);
+            int deltaSecs = (int) (secs - prevPoint.secs);
+            assert(deltaSecs == secs - prevPoint.secs); // no fractional part
             // This is only true if the previous record was of type record:
             assert(deltaSecs == time - last_time);
             // If the last lat/lng was missing (0/0) then all points up to lat/lng are marked as 0/0.
-            if (prevPoint->lat == 0 && prevPoint->lon == 0 ) {
+            if (prevPoint.lat == 0 && prevPoint.lon == 0 ) {
                 badgps = 1;
             }
-            double deltaCad = cad - prevPoint->cad;
-            double deltaHr = hr - prevPoint->hr;
-            double deltaDist = km - prevPoint->km;
+            double deltaCad = cad - prevPoint.cad;
+            double deltaHr = hr - prevPoint.hr;
+            double deltaDist = km - prevPoint.km;
             if (km < 0.00001) deltaDist = 0.000f; // effectively zero distance
-            double deltaSpeed = kph - prevPoint->kph;
-            double deltaTorque = nm - prevPoint->nm;
-            double deltaPower = watts - prevPoint->watts;
-            double deltaAlt = alt - prevPoint->alt;
-            double deltaLon = lng - prevPoint->lon;
-            double deltaLat = lat - prevPoint->lat;
-            double deltaHeadwind = headwind - prevPoint->headwind;
-            double deltaLeftRightBalance = lrbalance - prevPoint->lrbalance;
+            double deltaSpeed = kph - prevPoint.kph;
+            double deltaTorque = nm - prevPoint.nm;
+            double deltaPower = watts - prevPoint.watts;
+            double deltaAlt = alt - prevPoint.alt;
+            double deltaLon = lng - prevPoint.lon;
+            double deltaLat = lat - prevPoint.lat;
+            double deltaHeadwind = headwind - prevPoint.headwind;
+            double deltaLeftRightBalance = lrbalance - prevPoint.lrbalance;
 
             for (int i = 1; i < deltaSecs; i++) {
                 double weight = 1.0 * i / deltaSecs;
                 rideFile->appendPoint(
-                    prevPoint->secs + (deltaSecs * weight),
-                    prevPoint->cad + (deltaCad * weight),
-                    prevPoint->hr + (deltaHr * weight),
-                    prevPoint->km + (deltaDist * weight),
-                    prevPoint->kph + (deltaSpeed * weight),
-                    prevPoint->nm + (deltaTorque * weight),
-                    prevPoint->watts + (deltaPower * weight),
-                    prevPoint->alt + (deltaAlt * weight),
-                    (badgps == 1) ? 0 : prevPoint->lon + (deltaLon * weight),
-                    (badgps == 1) ? 0 : prevPoint->lat + (deltaLat * weight),
-                    prevPoint->headwind + (deltaHeadwind * weight),
+                    prevPoint.secs + (deltaSecs * weight),
+                    prevPoint.cad + (deltaCad * weight),
+                    prevPoint.hr + (deltaHr * weight),
+                    prevPoint.km + (deltaDist * weight),
+                    prevPoint.kph + (deltaSpeed * weight),
+                    prevPoint.nm + (deltaTorque * weight),
+                    prevPoint.watts + (deltaPower * weight),
+                    prevPoint.alt + (deltaAlt * weight),
+                    (badgps == 1) ? 0 : prevPoint.lon + (deltaLon * weight),
+                    (badgps == 1) ? 0 : prevPoint.lat + (deltaLat * weight),
+                    prevPoint.headwind + (deltaHeadwind * weight),
                     0,
                     temperature,
-                    prevPoint->lrbalance + (deltaLeftRightBalance * weight),
+                    prevPoint.lrbalance + (deltaLeftRightBalance * weight),
                     interval);
             }
-            prevPoint = rideFile->dataPoints().back();
         }
 
         if (km < 0.00001f) km = last_distance;
@@ -473,6 +457,7 @@ struct FitFileReaderState
             //       local_msg_type, def.global_msg_num, def.is_big_endian,
             //       num_fields );
 
+            def.size = 0;
             for (int i = 0; i < num_fields; ++i) {
                 def.fields.push_back(FitField());
                 FitField &field = def.fields.back();
@@ -481,8 +466,16 @@ struct FitFileReaderState
                 field.size = read_uint8(&count);
                 int base_type = read_uint8(&count);
                 field.type = base_type & 0x1f;
+                field.offset = def.size;
+                def.size += field.size;
                 //printf("  field %d: %d bytes, num %d, type %d\n",
                 //       i, field.size, field.num, field.type );
+
+                // arrays are skipped too, we only take single values
+                if (fitTypeSize(field.type) != field.size) {
+                    if (!fitTypeSize(field.type)) unknown_base_type.insert(field.num);
+                    field.type = -1;
+                }
             }
         }
         else {
@@ -507,30 +500,14 @@ struct FitFileReaderState
             //printf( "message local=%d global=%d\n", local_msg_type,
             //    def.global_msg_num );
 
-            std::vector<fit_value_t> values;
-            foreach(const FitField &field, def.fields) {
-                fit_value_t v;
-                switch (field.type) {
-                    case 0: v = read_uint8(&count); break;
-                    case 1: v = read_int8(&count); break;
-                    case 2: v = read_uint8(&count); break;
-                    case 3: v = read_int16(def.is_big_endian, &count); break;
-                    case 4: v = read_uint16(def.is_big_endian, &count); break;
-                    case 5: v = read_int32(def.is_big_endian, &count); break;
-                    case 6: v = read_uint32(def.is_big_endian, &count); break;
-                    case 10: v = read_uint8z(&count); break;
-                    case 11: v = read_uint16z(def.is_big_endian, &count); break;
-                    case 12: v = read_uint32z(def.is_big_endian, &count); break;
-                    //XXX: support float, string + byte base types
-                    default:
-                        read_unknown( field.size, &count );
-                        v = NA_VALUE;
-                        unknown_base_type.insert(field.num);
-                }
-                values.push_back(v);
-                //printf( " field: type=%d num=%d value=%lld\n",
-                //    field.type, field.num, v );
+            // apply the plan
+            need(def.size);
+            values.resize(def.fields.size());
+            for (size_t i = 0; i < def.fields.size(); ++i) {
+                const FitField &field = def.fields[i];
+                values[i] = fitValue(data + field.offset, field.type, def.is_big_endian);
             }
+            read_unknown(def.size, &count);
             // Most of the record types in the FIT format aren't actually all
             // that useful.  FileId, Lap, and Record clearly are.  The one
             // other one that might be useful is DeviceInfo, but it doesn't
@@ -565,6 +542,21 @@ struct FitFileReaderState
             delete rideFile;
             return NULL;
         }
+        map = file.size() ? file.map(0, file.size()) : NULL;
+        if (map) {
+            data = map;
+            end = map + file.size();
+        } else {
+            buffer = file.readAll();
+            data = reinterpret_cast<const uchar*>(buffer.constData());
+            end = data + buffer.size();
+        }
+        if (end - data < 12) {
+            errors << "truncated header";
+            delete rideFile;
+            return NULL;
+        }
+
         int header_size = read_uint8();
         if (header_size != 12 && header_size != 14) {
             errors << QString("bad header size: %1").arg(header_size);
@@ -581,11 +573,8 @@ struct FitFileReaderState
 
         int data_size = read_uint32(false); // always littleEndian
         char fit_str[5];
-        if (file.read(fit_str, 4) != 4) {
-            errors << "truncated header";
-            delete rideFile;
-            return NULL;
-        }
+        memcpy(fit_str, data, 4);
+        data += 4;
         fit_str[4] = '\0';
         if (strcmp(fit_str, ".FIT") != 0) {
             errors << QString("bad header, expected \".FIT\" but got \"%1\"").arg(fit_str);
@@ -594,7 +583,7 @@ struct FitFileReaderState
         }
 
         // read the rest of the header
-        if (header_size == 14) read_uint16(false);
+        if (header_size == 14 && end - data >= 2) read_uint16(false);
 
         int bytes_read = 0;
         bool stop = false;
@@ -612,8 +601,10 @@ struct FitFileReaderState
             return NULL;
         }
         else {
-            int crc = read_uint16( false ); // always littleEndian
-            (void) crc;
+            if (end - data >= 2) {
+                int crc = read_uint16( false ); // always littleEndian
+                (void) crc;
+            }
             foreach(int num, unknown_global_msg_nums)
                 qDebug() << QString("FitRideFile: unknown global message number %1; ignoring it").arg(num);
             foreach(int num, unknown_record_fields)
@@ -632,4 +623,158 @@ RideFile *FitFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
     return state->run();
 }
 
+//
+// Synthetic FIT files for the benchmark, one second recording with
+// a definition for each message type and then the data messages.
+//
+static void
+fitPut8(QByteArray &out, int value)
+{
+    out.append((char) value);
+}
+
+static void
+fitPut16(QByteArray &out, int value)
+{
+    uchar b[2];
+    qToLittleEndian<quint16>(value, b);
+    out.append((const char *) b, 2);
+}
+
+static void
+fitPut32(QByteArray &out, qint64 value)
+{
+    uchar b[4];
+    qToLittleEndian<quint32>((quint32) value, b);
+    out.append((const char *) b, 4);
+}
+
+// fields are triples of field number, size and base type
+static void
+fitDefine(QByteArray &out, int local, int global, const int *fields, int count)
+{
+    fitPut8(out, 0x40 | local);
+    fitPut8(out, 0); // reserved
+    fitPut8(out, 0); // little endian
+    fitPut16(out, global);
+    fitPut8(out, count);
+    for (int i=0; i<count * 3; i++) fitPut8(out, fields[i]);
+}
+
+static QByteArray
+fitSynthetic(int seconds)
+{
+    static const int fileId[] = { 1, 2, 0x84, 2, 2, 0x84 };
+    static const int event[] = { 253, 4, 0x86, 0, 1, 0x00, 1, 1, 0x00 };
+    static const int record[] = { 253, 4, 0x86, 0, 4, 0x85, 1, 4, 0x85, 2, 2, 0x84, 3, 1, 0x02,
+                                  4, 1, 0x02, 5, 4, 0x86, 6, 2, 0x84, 7, 2, 0x84 };
+    static const int lap[] = { 253, 4, 0x86, 2, 4, 0x86 };
+    const qint64 start = 700000000; // FIT time, sometime in 2012
+
+    QByteArray body;
+    fitDefine(body, 0, 0, fileId, 2);
+    fitPut8(body, 0);
+    fitPut16(body, 1); // Garmin
+    fitPut16(body, 1036); // Edge 500
+
+    fitDefine(body, 1, 21, event, 3);
+    fitPut8(body, 1);
+    fitPut32(body, start);
+    fitPut8(body, 0); // timer
+    fitPut8(body, 0); // start
+
+    // a wandering ride with the odd stop
+    fitDefine(body, 2, RECORD_TYPE, record, 9);
+    double power = 200, alt = 100, km = 0, lat = 51.5, lon = -0.1;
+    for (int i=1; i<=seconds; i++) {
+        power = qBound(0.0, power + qrand() % 21 - 10, 600.0);
+        alt = qMax(0.0, alt + (qrand() % 5 - 2) / 10.0);
+        double kph = (qrand() % 100) ? 25 + power / 40.0 : 0;
+        km += kph / 3600.0;
+        lat += (qrand() % 3 - 1) / 100000.0;
+        lon += (qrand() % 3 - 1) / 100000.0;
+
+        fitPut8(body, 2);
+        fitPut32(body, start + i);
+        fitPut32(body, (qint64) (lat * 0x7fffffff / 180.0));
+        fitPut32(body, (qint64) (lon * 0x7fffffff / 180.0));
+        fitPut16(body, (int) ((alt + 500.0) * 5.0));
+        fitPut8(body, 120 + qrand() % 40);
+        fitPut8(body, kph ? 80 + qrand() % 20 : 0);
+        fitPut32(body, (qint64) (km * 100000.0));
+        fitPut16(body, (int) (kph * 1000.0 / 3.6));
+        fitPut16(body, kph ? (int) power : 0);
+    }
+
+    fitDefine(body, 3, 19, lap, 2);
+    fitPut8(body, 3);
+    fitPut32(body, start + seconds);
+    fitPut32(body, start);
+
+    QByteArray file;
+    fitPut8(file, 14);
+    fitPut8(file, 0x10); // protocol 1.0
+    fitPut16(file, 100); // profile 1.00
+    fitPut32(file, body.size());
+    file.append(".FIT");
+    fitPut16(file, 0); // no header crc
+    file.append(body);
+    fitPut16(file, 0); // we don't check the crc
+    return file;
+}
+
+void
+FitFileReader::benchmark(QTextStream &out)
+{
+    out << "FIT decode benchmark\n";
+
+    FitFileReader reader;
+    int hours[] = { 1, 6, 24 };
+    for (int h=0; h<3; h++) {
+
+        // a corpus of a few rides each long
+        qsrand(hours[h]);
+        QStringList corpus;
+        qint64 bytes = 0;
+        for (int i=0; i<4; i++) {
+            QString name = QDir::temp().absoluteFilePath(QString("gc-fit-benchmark-%1-%2.fit").arg(hours[h]).arg(i));
+            QFile file(name);
+            if (!file.open(QIODevice::WriteOnly)) {
+                out << "can't write " << name << "\n";
+                return;
+            }
+            QByteArray content = fitSynthetic(hours[h] * 3600);
+            file.write(content);
+            file.close();
+            bytes += content.size();
+            corpus << name;
+        }
+
+        // decode it a few times over
+        int repeats = 24 / hours[h], points = 0, errorCount = 0;
+        QTime timer;
+        timer.start();
+        for (int r=0; r<repeats; r++) {
+            foreach (QString name, corpus) {
+                QFile file(name);
+                QStringList errors;
+                RideFile *ride = reader.openRideFile(file, errors);
+                if (ride) points += ride->samples();
+                else errorCount++;
+                delete ride;
+            }
+        }
+        int elapsed = qMax(1, timer.elapsed());
+
+        foreach (QString name, corpus) QFile::remove(name);
+
+        double mb = double(bytes) * repeats / (1024.0 * 1024.0);
+        out << hours[h] << "h rides: " << mb << "MB in " << elapsed << "ms, "
+            << (mb * 1000.0 / elapsed) << " MB/s, " << points << " samples";
+        if (errorCount) out << ", " << errorCount << " failed";
+        out << "\n";
+    }
+    out.flush();
+}
+
 // vi:expandtab tabstop=4 shiftwidth=4
@@ -22,9 +22,14 @@
 
 #include "RideFile.h"
 
+class QTextStream;
+
 struct FitFileReader : public RideFileReader {
     virtual RideFile *openRideFile(QFile &file, QStringList &errors, QList<RideFile*>* = 0) const; 
     bool hasWrite() const { return false; }
+
+    // developers: decode synthetic files and report the throughput
+    static void benchmark(QTextStream &out);
 };
 
 #endif // _FitRideFile_h
@@ -118,6 +118,7 @@ FitlogParser::endElement( const QString&, const QString&, const QString& qName)
             RideFilePoint last;
             bool first = true;
             double rdist = 0;
+            int index = 0;
 
             foreach(RideFilePoint *point, rideFile->dataPoints()) {
 
@@ -133,9 +134,10 @@ FitlogParser::endElement( const QString&, const QString&, const QString& qName)
                         else
                             rdist += distanceBetween(last.lat, last.lon, point->lat, point->lon);
                     }
-                    point->km = rdist; 
+                    rideFile->setPointValue(index, RideFile::km, rdist);
                 }
                 last = *point;
+                index++;
             }
             rideFile->setDataPresent(RideFile::km, (rdist > 0));
         }
@@ -145,6 +147,7 @@ FitlogParser::endElement( const QString&, const QString&, const QString& qName)
 
             RideFilePoint last;
             bool first = true;
+            int index = 0;
 
             foreach(RideFilePoint *point, rideFile->dataPoints()) {
 
@@ -155,13 +158,14 @@ FitlogParser::endElement( const QString&, const QString&, const QString& qName)
                     double timedelta = point->secs - last.secs;
 
                     if (timedelta) {
-                        point->kph = (distdelta / timedelta) * 3600; // km/s to km/h
+                        rideFile->setPointValue(index, RideFile::kph, (distdelta / timedelta) * 3600); // km/s to km/h
 
                     } else {
-                        point->kph = 0;
+                        rideFile->setPointValue(index, RideFile::kph, 0);
                     }
                 }
                 last = *point;
+                index++;
             }
             rideFile->setDataPresent(RideFile::kph, true);
         }
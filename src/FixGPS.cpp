@@ -56,7 +56,7 @@ class FixGPS : public DataProcessor {
         ~FixGPS() {}
 
         // the processor
-        bool postProcess(RideFile *, DataProcessorConfig* config);
+        bool postProcess(RideFile *, DataProcessorConfig* config, const RideFileContext *context);
 
         // the config widget
         DataProcessorConfig* processorConfig(QWidget *parent) {
@@ -72,7 +72,7 @@ class FixGPS : public DataProcessor {
 static bool fixGPSAdded = DataProcessorFactory::instance().registerProcessor(QString("Fix GPS errors"), new FixGPS());
 
 bool
-FixGPS::postProcess(RideFile *ride, DataProcessorConfig *)
+FixGPS::postProcess(RideFile *ride, DataProcessorConfig *, const RideFileContext *)
 {
     // ignore null or files without GPS data
     if (!ride || ride->areDataPresent()->lat == false || ride->areDataPresent()->lon == false)
@@ -114,7 +114,7 @@ class FixGaps : public DataProcessor {
         ~FixGaps() {}
 
         // the processor
-        bool postProcess(RideFile *, DataProcessorConfig* config);
+        bool postProcess(RideFile *, DataProcessorConfig* config, const RideFileContext *context);
 
         // the config widget
         DataProcessorConfig* processorConfig(QWidget *parent) {
@@ -130,13 +130,13 @@ class FixGaps : public DataProcessor {
 static bool fixGapsAdded = DataProcessorFactory::instance().registerProcessor(QString("Fix Gaps in Recording"), new FixGaps());
 
 bool
-FixGaps::postProcess(RideFile *ride, DataProcessorConfig *config=0)
+FixGaps::postProcess(RideFile *ride, DataProcessorConfig *config=0, const RideFileContext *context=0)
 {
     // get settings
     double tolerance, stop;
     if (config == NULL) { // being called automatically
-        tolerance = appsettings->value(NULL, GC_DPFG_TOLERANCE, "1.0").toDouble();
-        stop = appsettings->value(NULL, GC_DPFG_STOP, "1.0").toDouble();
+        tolerance = context->value(GC_DPFG_TOLERANCE, "1.0").toDouble();
+        stop = context->value(GC_DPFG_STOP, "1.0").toDouble();
     } else { // being called manually
         tolerance = ((FixGapsConfig*)(config))->tolerance->value();
         stop = ((FixGapsConfig*)(config))->beerandburrito->value();
@@ -115,7 +115,7 @@ class FixSpikes : public DataProcessor {
         ~FixSpikes() {}
 
         // the processor
-        bool postProcess(RideFile *, DataProcessorConfig* config);
+        bool postProcess(RideFile *, DataProcessorConfig* config, const RideFileContext *context);
 
         // the config widget
         DataProcessorConfig* processorConfig(QWidget *parent) {
@@ -131,7 +131,7 @@ class FixSpikes : public DataProcessor {
 static bool fixSpikesAdded = DataProcessorFactory::instance().registerProcessor(QString("Fix Power Spikes"), new FixSpikes());
 
 bool
-FixSpikes::postProcess(RideFile *ride, DataProcessorConfig *config=0)
+FixSpikes::postProcess(RideFile *ride, DataProcessorConfig *config=0, const RideFileContext *context=0)
 {
     // does this ride have power?
     if (ride->areDataPresent()->watts == false) return false;
@@ -139,8 +139,8 @@ FixSpikes::postProcess(RideFile *ride, DataProcessorConfig *config=0)
     // get settings
     double variance, max;
     if (config == NULL) { // being called automatically
-        max = appsettings->value(NULL, GC_DPFS_MAX, "1500").toDouble();
-        variance = appsettings->value(NULL, GC_DPFS_VARIANCE, "1000").toDouble();
+        max = context->value(GC_DPFS_MAX, "1500").toDouble();
+        variance = context->value(GC_DPFS_VARIANCE, "1000").toDouble();
     } else { // being called manually
         max = ((FixSpikesConfig*)(config))->max->value();
         variance = ((FixSpikesConfig*)(config))->variance->value();
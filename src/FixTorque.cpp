@@ -88,7 +88,7 @@ class FixTorque : public DataProcessor {
         ~FixTorque() {}
 
         // the processor
-        bool postProcess(RideFile *, DataProcessorConfig* config);
+        bool postProcess(RideFile *, DataProcessorConfig* config, const RideFileContext *context);
 
         // the config widget
         DataProcessorConfig* processorConfig(QWidget *parent) {
@@ -104,7 +104,7 @@ class FixTorque : public DataProcessor {
 static bool fixTorqueAdded = DataProcessorFactory::instance().registerProcessor(QString("Adjust Torque Values"), new FixTorque());
 
 bool
-FixTorque::postProcess(RideFile *ride, DataProcessorConfig *config=0)
+FixTorque::postProcess(RideFile *ride, DataProcessorConfig *config=0, const RideFileContext *context=0)
 {
     // does this ride have torque?
     if (ride->areDataPresent()->nm == false) return false;
@@ -114,7 +114,7 @@ FixTorque::postProcess(RideFile *ride, DataProcessorConfig *config=0)
     double nmAdjust;
 
     if (config == NULL) { // being called automatically
-        ta = appsettings->value(NULL, GC_DPTA, "0 nm").toString();
+        ta = context->value(GC_DPTA, "0 nm").toString();
     } else { // being called manually
         ta = ((FixTorqueConfig*)(config))->ta->text();
     }
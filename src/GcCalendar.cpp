@@ -21,6 +21,7 @@
 #include <QWebSettings>
 #include <QWebFrame>
 #include "TimeUtils.h"
+#include "RideNavigatorModel.h"
 
 GcCalendar::GcCalendar(MainWindow *main) : main(main)
 {
@@ -65,7 +66,7 @@ GcCalendar::GcCalendar(MainWindow *main) : main(main)
     // get the model
     fieldDefinitions = main->rideMetadata()->getFields();
     calendarModel = new GcCalendarModel(this, &fieldDefinitions, main);
-    calendarModel->setSourceModel(main->listView->sqlModel);
+    calendarModel->setSourceModel(main->listView->rideModel);
 
     QFont font;
     font.setPointSize(40);
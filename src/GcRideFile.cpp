@@ -18,7 +18,9 @@
 
 #include "GcRideFile.h"
 #include <algorithm> // for std::sort
+#include "XmlUtils.h"
 #include <QDomDocument>
+#include <QXmlStreamReader>
 #include <QVector>
 #include <assert.h>
 
@@ -33,130 +35,152 @@ static int gcFileReaderRegistered =
 RideFile *
 GcFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*) const
 {
-    QDomDocument doc("GoldenCheetah");
     if (!file.open(QIODevice::ReadOnly)) {
         errors << "Could not open file.";
         return NULL;
     }
 
-    bool parsed = doc.setContent(&file);
-    file.close();
-    if (!parsed) {
-        errors << "Could not parse file.";
-        return NULL;
-    }
-
+    // pulled a sample at a time rather than building a document
+    // of the whole ride, the writer puts everything before the samples
+    QXmlStreamReader xml(&file);
     RideFile *rideFile = new RideFile();
-    QDomElement root = doc.documentElement();
-    QDomNode attributes = root.firstChildElement("attributes");
-
-    for (QDomElement attr = attributes.firstChildElement("attribute");
-         !attr.isNull(); attr = attr.nextSiblingElement("attribute")) {
-        QString key = attr.attribute("key");
-        QString value = attr.attribute("value");
-        if (key == "Device type")
-            rideFile->setDeviceType(value);
-        else if (key == "File Format")
-            rideFile->setFileFormat(value);
-        if (key == "Start time") {
-            // by default QDateTime is localtime - the source however is UTC
-            QDateTime aslocal = QDateTime::fromString(value, DATETIME_FORMAT);
-            // construct in UTC so we can honour the conversion to localtime
-            QDateTime asUTC = QDateTime(aslocal.date(), aslocal.time(), Qt::UTC);
-            // now set in localtime
-            rideFile->setStartTime(asUTC.toLocalTime());
-        }
-        if (key == "Identifier") {
-            rideFile->setId(value);
-        }
-    }
-
-    // read in metric overrides:
-    //  <override>
-    //    <metric name="skiba_bike_score" value="100"/>
-    //    <metric name="average_speed" secs="3600" km="30"/>
-    //  </override>
-
-    QDomNode overrides = root.firstChildElement("override");
-    if (!overrides.isNull()) {
-
-        for (QDomElement override = overrides.firstChildElement("metric");
-            !override.isNull();
-            override = override.nextSiblingElement("metric")) {
-
-            // setup the metric overrides QMap
-            QMap<QString, QString> bsm;
-
-            // for now only value is known to be maintained
-            bsm.insert("value", override.attribute("value"));
-
-            // insert into the rideFile overrides
-            rideFile->metricOverrides.insert(override.attribute("name"), bsm);
-        }
-    }
-
-    // read in the name/value metadata pairs
-    QDomNode tags = root.firstChildElement("tags");
-    if (!tags.isNull()) {
-
-        for (QDomElement tag = tags.firstChildElement("tag");
-             !tag.isNull();
-             tag = tag.nextSiblingElement("tag")) {
-
-            rideFile->setTag(tag.attribute("name"), tag.attribute("value"));
-        }
-    }
 
     QVector<double> intervalStops; // used to set the interval number for each point
     RideFileInterval add;          // used to add each named interval to RideFile
-    QDomNode intervals = root.firstChildElement("intervals");
-    if (!intervals.isNull()) {
-        for (QDomElement interval = intervals.firstChildElement("interval");
-             !interval.isNull(); interval = interval.nextSiblingElement("interval")) {
-
-            // record the stops for old-style datapoint interval numbering
-            double stop = interval.attribute("stop").toDouble();
-            intervalStops.append(stop);
-
-            // add a new interval to the new-style interval ranges
-            add.stop = stop;
-            add.start = interval.attribute("start").toDouble();
-            add.name = interval.attribute("name");
-            rideFile->addInterval(add.start, add.stop, add.name);
-        }
-    }
-    std::sort(intervalStops.begin(), intervalStops.end()); // just in case
     int interval = 0;
-
-    QDomElement samples = root.firstChildElement("samples");
-    if (samples.isNull()) return rideFile; // manual file will have no samples
-
     bool recIntSet = false;
-    for (QDomElement sample = samples.firstChildElement("sample");
-         !sample.isNull(); sample = sample.nextSiblingElement("sample")) {
-        double secs, cad, hr, km, kph, nm, watts, alt, lon, lat;
-        double headwind = 0.0;
-        secs = sample.attribute("secs", "0.0").toDouble();
-        cad = sample.attribute("cad", "0.0").toDouble();
-        hr = sample.attribute("hr", "0.0").toDouble();
-        km = sample.attribute("km", "0.0").toDouble();
-        kph = sample.attribute("kph", "0.0").toDouble();
-        nm = sample.attribute("nm", "0.0").toDouble();
-        watts = sample.attribute("watts", "0.0").toDouble();
-        alt = sample.attribute("alt", "0.0").toDouble();
-        lon = sample.attribute("lon", "0.0").toDouble();
-        lat = sample.attribute("lat", "0.0").toDouble();
-        while ((interval < intervalStops.size()) && (secs >= intervalStops[interval]))
-            ++interval;
-        rideFile->appendPoint(secs, cad, hr, km, kph, nm, watts, alt, lon, lat, headwind, 0.0, RideFile::noTemp, 0, interval);
-        if (!recIntSet) {
-            rideFile->setRecIntSecs(sample.attribute("len").toDouble());
-            recIntSet = true;
+    bool samples = false;
+
+    xml.readNextStartElement(); // <ride>
+    while (xml.readNextStartElement()) {
+
+        if (xml.name() == QLatin1String("attributes")) {
+
+            while (xml.readNextStartElement()) {
+                if (xml.name() == QLatin1String("attribute")) {
+                    QXmlStreamAttributes attr = xml.attributes();
+                    QString key = attr.value(QLatin1String("key")).toString();
+                    QString value = attr.value(QLatin1String("value")).toString();
+                    if (key == "Device type")
+                        rideFile->setDeviceType(value);
+                    else if (key == "File Format")
+                        rideFile->setFileFormat(value);
+                    if (key == "Start time") {
+                        // by default QDateTime is localtime - the source however is UTC
+                        QDateTime aslocal = QDateTime::fromString(value, DATETIME_FORMAT);
+                        // construct in UTC so we can honour the conversion to localtime
+                        QDateTime asUTC = QDateTime(aslocal.date(), aslocal.time(), Qt::UTC);
+                        // now set in localtime
+                        rideFile->setStartTime(asUTC.toLocalTime());
+                    }
+                    if (key == "Identifier") {
+                        rideFile->setId(value);
+                    }
+                }
+                xml.skipCurrentElement();
+            }
+
+        } else if (xml.name() == QLatin1String("override")) {
+
+            // read in metric overrides:
+            //  <override>
+            //    <metric name="skiba_bike_score" value="100"/>
+            //    <metric name="average_speed" secs="3600" km="30"/>
+            //  </override>
+            while (xml.readNextStartElement()) {
+                if (xml.name() == QLatin1String("metric")) {
+                    QXmlStreamAttributes attr = xml.attributes();
+
+                    // setup the metric overrides QMap
+                    QMap<QString, QString> bsm;
+
+                    // for now only value is known to be maintained
+                    bsm.insert("value", attr.value(QLatin1String("value")).toString());
+
+                    // insert into the rideFile overrides
+                    rideFile->metricOverrides.insert(attr.value(QLatin1String("name")).toString(), bsm);
+                }
+                xml.skipCurrentElement();
+            }
+
+        } else if (xml.name() == QLatin1String("tags")) {
+
+            // read in the name/value metadata pairs
+            while (xml.readNextStartElement()) {
+                if (xml.name() == QLatin1String("tag")) {
+                    QXmlStreamAttributes attr = xml.attributes();
+                    rideFile->setTag(attr.value(QLatin1String("name")).toString(), attr.value(QLatin1String("value")).toString());
+                }
+                xml.skipCurrentElement();
+            }
+
+        } else if (xml.name() == QLatin1String("intervals")) {
+
+            while (xml.readNextStartElement()) {
+                if (xml.name() == QLatin1String("interval")) {
+                    QXmlStreamAttributes attr = xml.attributes();
+
+                    // record the stops for old-style datapoint interval numbering
+                    double stop = xmlDouble(attr.value(QLatin1String("stop")));
+                    intervalStops.append(stop);
+
+                    // add a new interval to the new-style interval ranges
+                    add.stop = stop;
+                    add.start = xmlDouble(attr.value(QLatin1String("start")));
+                    add.name = attr.value(QLatin1String("name")).toString();
+                    rideFile->addInterval(add.start, add.stop, add.name);
+                }
+                xml.skipCurrentElement();
+            }
+            std::sort(intervalStops.begin(), intervalStops.end()); // just in case
+
+        } else if (xml.name() == QLatin1String("samples")) {
+
+            samples = true;
+            while (xml.readNextStartElement()) {
+                if (xml.name() == QLatin1String("sample")) {
+                    QXmlStreamAttributes attr = xml.attributes();
+
+                    // missing attributes are 0
+                    double secs, cad, hr, km, kph, nm, watts, alt, lon, lat;
+                    double headwind = 0.0;
+                    secs = xmlDouble(attr.value(QLatin1String("secs")));
+                    cad = xmlDouble(attr.value(QLatin1String("cad")));
+                    hr = xmlDouble(attr.value(QLatin1String("hr")));
+                    km = xmlDouble(attr.value(QLatin1String("km")));
+                    kph = xmlDouble(attr.value(QLatin1String("kph")));
+                    nm = xmlDouble(attr.value(QLatin1String("nm")));
+                    watts = xmlDouble(attr.value(QLatin1String("watts")));
+                    alt = xmlDouble(attr.value(QLatin1String("alt")));
+                    lon = xmlDouble(attr.value(QLatin1String("lon")));
+                    lat = xmlDouble(attr.value(QLatin1String("lat")));
+                    while ((interval < intervalStops.size()) && (secs >= intervalStops[interval]))
+                        ++interval;
+                    rideFile->appendPoint(secs, cad, hr, km, kph, nm, watts, alt, lon, lat, headwind, 0.0, RideFile::noTemp, 0, interval);
+                    if (!recIntSet) {
+                        rideFile->setRecIntSecs(xmlDouble(attr.value(QLatin1String("len"))));
+                        recIntSet = true;
+                    }
+                }
+                xml.skipCurrentElement();
+            }
+
+        } else {
+            xml.skipCurrentElement();
         }
     }
+    file.close();
+
+    if (xml.hasError()) {
+        errors << "Could not parse file.";
+        delete rideFile;
+        return NULL;
+    }
 
-    if (!recIntSet) {
+    // manual file will have no samples
+    if (samples && !recIntSet) {
         errors << "no samples in ride file";
+        delete rideFile;
         return NULL;
     }
 
@@ -67,7 +67,7 @@ GcWindowRegistry* GcWindows;
 void
 GcWindowRegistry::initialize()
 {
-  static GcWindowRegistry GcWindowsInit[30] = {
+  static GcWindowRegistry GcWindowsInit[31] = {
     // name                     GcWinID
     { VIEW_HOME|VIEW_DIARY, tr("Long Term Metrics"),GcWindowTypes::LTM },
     { VIEW_HOME, tr("Performance Manager"),GcWindowTypes::PerformanceManager },
@@ -82,6 +82,7 @@ GcWindowRegistry::initialize()
     { VIEW_ANALYSIS, tr("Critical Mean Maximals"),GcWindowTypes::CriticalPower },
     { VIEW_ANALYSIS, tr("Histogram"),GcWindowTypes::Histogram },
     { VIEW_HOME|VIEW_DIARY, tr("Distribution"),GcWindowTypes::Distribution },
+    { VIEW_HOME|VIEW_DIARY, tr("Pedal Force vs Velocity"),GcWindowTypes::PfPvSummary },
     { VIEW_ANALYSIS, tr("Pedal Force vs Velocity"),GcWindowTypes::PfPv },
     { VIEW_ANALYSIS, tr("Heartrate vs Power"),GcWindowTypes::HrPw },
     { VIEW_ANALYSIS, tr("Google Map"),GcWindowTypes::GoogleMap },
@@ -123,6 +124,7 @@ GcWindowRegistry::newGcWindow(GcWinID id, MainWindow *main) //XXX mainWindow wil
     case GcWindowTypes::GoogleMap: returning = new GoogleMapControl(main); break;
     case GcWindowTypes::Histogram: returning = new HistogramWindow(main); break;
     case GcWindowTypes::Distribution: returning = new HistogramWindow(main, true); break;
+    case GcWindowTypes::PfPvSummary: returning = new PfPvWindow(main, true); break;
     case GcWindowTypes::LTM: returning = new LTMWindow(main, main->useMetricUnits, main->home); break;
 #ifdef GC_HAVE_QWTPLOT3D
     case GcWindowTypes::Model: returning = new ModelWindow(main, main->home); break;
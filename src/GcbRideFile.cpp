@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2026 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "GcbRideFile.h"
+#include <QDataStream>
+#include <string.h>
+
+static int gcbFileReaderRegistered =
+    RideFileFactory::instance().registerCacheReader(
+        "gcb", "GoldenCheetah Binary", new GcbFileReader());
+
+// the samples stay in the file mapping until the
+// ride is modified or somebody asks for dataPoints()
+class GcbSampleSource : public RideFileSampleSource
+{
+    public:
+        GcbSampleSource(QString filename) : file(filename), base(NULL) {}
+        ~GcbSampleSource() {
+            if (base) file.unmap(base);
+            file.close();
+        }
+
+        bool open(QStringList &errors);
+        const GcbFileHeader &header() const { return head; }
+        const uchar *data() const { return base; }
+
+        int samples() const { return head.samples; }
+        bool isDataPresent(RideFile::SeriesType series) const {
+            return head.present & (1<<series);
+        }
+        RideFileSeries series(RideFile::SeriesType series) const {
+            if (series < 0 || series >= RideFile::none || head.columnOffset[series] == 0)
+                return RideFileSeries();
+            return RideFileSeries((const double *)(base + head.columnOffset[series]), head.samples);
+        }
+
+    private:
+        QFile file;
+        uchar *base;
+        GcbFileHeader head;
+};
+
+bool
+GcbSampleSource::open(QStringList &errors)
+{
+    if (!file.open(QIODevice::ReadOnly)) {
+        errors << "Could not open file.";
+        return false;
+    }
+
+    qint64 size = file.size();
+    if (size < (qint64)sizeof(GcbFileHeader) || (base = file.map(0, size)) == NULL) {
+        errors << "Could not map file.";
+        return false;
+    }
+
+    memcpy(&head, base, sizeof(head));
+    if (strncmp(head.magic, "GCB", 4) || head.version != GcbFileVersion) {
+        errors << "Not a current GoldenCheetah Binary file.";
+        return false;
+    }
+
+    // check the blocks are all within the file
+    if (head.metaOffset + head.metaLength > (quint64)size) {
+        errors << "Truncated file.";
+        return false;
+    }
+    for (int i=0; i<RideFile::none; i++) {
+        if (head.columnOffset[i] &&
+            head.columnOffset[i] + (quint64)head.samples * sizeof(double) > (quint64)size) {
+            errors << "Truncated file.";
+            return false;
+        }
+    }
+    return true;
+}
+
+RideFile *
+GcbFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*) const
+{
+    GcbSampleSource *source = new GcbSampleSource(file.fileName());
+    if (!source->open(errors)) {
+        delete source;
+        return NULL;
+    }
+    const GcbFileHeader &head = source->header();
+
+    RideFile *rideFile = new RideFile();
+    rideFile->setRecIntSecs(head.recIntSecs);
+
+    // the metadata block
+    QByteArray meta = QByteArray::fromRawData((const char *)source->data() + head.metaOffset, head.metaLength);
+    QDataStream in(meta);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    QDateTime startTime;
+    QString id, deviceType, fileFormat;
+    QMap<QString,QString> tags;
+    quint32 intervals;
+
+    in >> startTime >> id >> deviceType >> fileFormat;
+    rideFile->setStartTime(startTime);
+    rideFile->setId(id);
+    rideFile->setDeviceType(deviceType);
+    rideFile->setFileFormat(fileFormat);
+
+    in >> intervals;
+    for (quint32 i=0; i<intervals && in.status() == QDataStream::Ok; i++) {
+        double start, stop;
+        QString name;
+        in >> start >> stop >> name;
+        rideFile->addInterval(start, stop, name);
+    }
+
+    in >> tags;
+    QMapIterator<QString,QString> tag(tags);
+    while (tag.hasNext()) {
+        tag.next();
+        rideFile->setTag(tag.key(), tag.value());
+    }
+
+    in >> rideFile->metricOverrides;
+
+    if (in.status() != QDataStream::Ok) {
+        errors << "Could not read metadata.";
+        delete source;
+        delete rideFile;
+        return NULL;
+    }
+
+    // and now the samples
+    if (head.samples) rideFile->setSampleSource(source);
+    else delete source;
+
+    return rideFile;
+}
+
+bool
+GcbFileReader::writeRideFile(MainWindow *, const RideFile *ride, QFile &file) const
+{
+    // metadata first since we need to know how big it is
+    QByteArray meta;
+    QDataStream out(&meta, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_6);
+
+    out << ride->startTime() << ride->id() << ride->deviceType() << ride->fileFormat();
+    out << (quint32) ride->intervals().count();
+    foreach (RideFileInterval interval, ride->intervals())
+        out << interval.start << interval.stop << interval.name;
+    out << ride->tags();
+    out << ride->metricOverrides;
+
+    GcbFileHeader head;
+    memset(&head, 0, sizeof(head));
+    strncpy(head.magic, "GCB", 4);
+    head.version = GcbFileVersion;
+    head.samples = ride->samples();
+    head.recIntSecs = ride->recIntSecs();
+    head.metaOffset = sizeof(head);
+    head.metaLength = meta.size();
+
+    // we store every series that is flagged as present or has
+    // values other than the default, so the samples come back
+    // exactly as they were whatever the flags say
+    QVector<RideFile::SeriesType> stored;
+    quint64 offset = head.metaOffset + head.metaLength;
+    for (int i=0; i<RideFile::none; i++) {
+        RideFile::SeriesType series = static_cast<RideFile::SeriesType>(i);
+        double unset = (series == RideFile::temp) ? RideFile::noTemp : 0.0;
+
+        if (ride->isDataPresent(series)) head.present |= (1<<i);
+
+        // derived series are not held in the samples
+        switch (series) {
+            case RideFile::NP: case RideFile::xPower: case RideFile::vam: case RideFile::wattsKg:
+                continue;
+            default:
+                break;
+        }
+
+        bool store = ride->isDataPresent(series) || series == RideFile::secs;
+        for (unsigned int j=0; store == false && j<head.samples; j++)
+            if (ride->getPointValue(j, series) != unset) store = true;
+
+        if (store) {
+            offset = (offset + gcbColumnAlignment - 1) / gcbColumnAlignment * gcbColumnAlignment;
+            head.columnOffset[i] = offset;
+            offset += head.samples * sizeof(double);
+            stored << series;
+        }
+    }
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+
+    bool ok = file.write((const char *) &head, sizeof(head)) == sizeof(head);
+    ok = ok && file.write(meta) == meta.size();
+
+    QVector<double> column(head.samples);
+    foreach (RideFile::SeriesType series, stored) {
+
+        // pad to the alignment boundary
+        qint64 pad = head.columnOffset[series] - file.pos();
+        if (pad > 0) ok = ok && file.write(QByteArray(pad, '\0')) == pad;
+
+        for (unsigned int j=0; j<head.samples; j++)
+            column[j] = ride->getPointValue(j, series);
+
+        qint64 bytes = head.samples * sizeof(double);
+        ok = ok && file.write((const char *) column.constData(), bytes) == bytes;
+    }
+    file.close();
+
+    return ok;
+}
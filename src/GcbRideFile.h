@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2026 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GcbRideFile_h
+#define _GcbRideFile_h
+#include "GoldenCheetah.h"
+
+#include "RideFile.h"
+
+// The GoldenCheetah binary activity format (.gcb) is kept alongside each
+// ride in the athlete's home directory as a derived cache. It is written
+// after the source file has been parsed and is used in its place until
+// the source file is modified again, see RideFileFactory::openRideFile.
+//
+// The file is memory mapped when it is read and the samples are left in
+// the mapping, so a chart that only needs power only touches those pages.
+//
+static const unsigned int GcbFileVersion = 1;
+// revision history:
+// version  date         description
+// 1        17-Oct-26    Initial - header, metadata and column blocks
+
+// The file has a binary format:
+// 1 x Header - fixed size, describes the version and where the blocks are
+// 1 x Metadata block - start time, id, device, intervals, tags and overrides
+// n x Column blocks - one array of doubles for each series stored
+//
+// The header and columns are written raw in local byte order, like the
+// .cpx cache these are local files so we do not worry about endianness.
+// The metadata is written with a QDataStream. Each column block starts
+// on a gcbColumnAlignment boundary so it can be used in place.
+static const unsigned int gcbColumnAlignment = 64;
+
+struct GcbFileHeader {
+
+    char magic[4];              // "GCB" and a nul
+    unsigned int version;
+    unsigned int samples;       // number of samples in each column
+    unsigned int present;       // RideFileDataPresent, 1 bit per SeriesType
+    double recIntSecs;
+
+    quint64 metaOffset,
+            metaLength;
+
+    quint64 columnOffset[RideFile::none]; // 0 when the series isn't stored
+};
+
+struct GcbFileReader : public RideFileReader {
+    virtual RideFile *openRideFile(QFile &file, QStringList &errors, QList<RideFile*>* = 0) const;
+    bool writeRideFile(MainWindow *, const RideFile *ride, QFile &file) const;
+    bool hasWrite() const { return true; }
+};
+
+#endif // _GcbRideFile_h
@@ -25,11 +25,9 @@
 
 #include "GpxParser.h"
 #include "TimeUtils.h"
+#include "XmlUtils.h"
 #include <math.h>
 
-// use stc strtod to bypass Qt toDouble() issues
-#include <stdlib.h>
-
 GpxParser::GpxParser (RideFile* rideFile)
     : rideFile(rideFile)
 {
@@ -46,44 +44,63 @@ GpxParser::GpxParser (RideFile* rideFile)
     firstTime = true;
     metadata = false;
 
+    buffer.reserve(64);
+}
+
+bool
+GpxParser::parse(QIODevice *device, QStringList &errors)
+{
+    QXmlStreamReader xml(device);
+
+    while (!xml.atEnd()) {
+        switch (xml.readNext()) {
+            case QXmlStreamReader::StartElement: startElement(xml.name(), xml.attributes()); break;
+            case QXmlStreamReader::EndElement: endElement(xml.name()); break;
+            case QXmlStreamReader::Characters: buffer.append(xml.text()); break;
+            default: break;
+        }
+    }
+
+    // whatever was read before the error is kept
+    if (xml.hasError()) {
+        errors << QString("XML error at line %1: %2").arg(xml.lineNumber()).arg(xml.errorString());
+        return false;
+    }
+    return true;
 }
 
-bool GpxParser::startElement( const QString&, const QString&,
-    const QString& qName,
-    const QXmlAttributes& qAttributes)
+void
+GpxParser::startElement(const QStringRef &qName, const QXmlStreamAttributes &qAttributes)
 {
-    buffer.clear();
+    buffer.truncate(0);
 
     if(metadata)
-        return true;
+        return;
 
-    if(qName == "metadata")
+    if(qName == QLatin1String("metadata"))
     {
         metadata = true;
 
     }
-    else if(qName == "trkpt")
+    else if(qName == QLatin1String("trkpt"))
     {
-        int i = qAttributes.index("lat");
-        if(i >= 0)
+        if(qAttributes.hasAttribute(QLatin1String("lat")))
         {
-            lat = qAttributes.value(i).toDouble();
+            lat = xmlDouble(qAttributes.value(QLatin1String("lat")));
         }
         else
         {
             lat = lastLat;
         }
-        i = qAttributes.index("lon");
-        if( i >= 0)
+        if(qAttributes.hasAttribute(QLatin1String("lon")))
         {
-            lon = qAttributes.value(i).toDouble();
+            lon = xmlDouble(qAttributes.value(QLatin1String("lon")));
         }
         else
         {
             lon = lastLon;
         }
     }
-    return TRUE;
 }
 
 #define PI 3.14159265
@@ -93,18 +110,18 @@ inline double toRadians(double degrees)
 
 }
 
-bool
-        GpxParser::endElement( const QString&, const QString&, const QString& qName)
+void
+GpxParser::endElement(const QStringRef &qName)
 {
-    if(qName == "metadata")
+    if(qName == QLatin1String("metadata"))
     {
         metadata = false;
     }
     else if(metadata == true)
     {
-        return true;
+        return;
     }
-    else if (qName == "time")
+    else if (qName == QLatin1String("time"))
     {
 
         time = convertToLocalTime(buffer);
@@ -115,12 +132,12 @@ bool
             firstTime = false;
         }
     }
-    else if (qName == "ele")
+    else if (qName == QLatin1String("ele"))
     {
         alt = buffer.toDouble();  // metric
     }
 
-    else if (qName == "trkpt")
+    else if (qName == QLatin1String("trkpt"))
     {
         if(lastLon == 0)
         {
@@ -128,7 +145,7 @@ bool
             last_time = time;
             lastLon = lon;
             lastLat = lat;
-            return TRUE;
+            return;
         }
         // we need to figure out the distance by using the lon,lat
         // using teh haversine formula
@@ -170,19 +187,19 @@ bool
 	// average all the calculations based on the previous
 	// point.
 
-	if(rideFile->dataPoints().empty()) {
+	if(rideFile->samples() == 0) {
 	    // first point
             rideFile->appendPoint(secs, 0, 0, distance, speed, 0, 0, alt, lon, lat, 0, 0.0, RideFile::noTemp, 0.0, 0);
 	}
 	else {
 	    // assumption that the change in ride is linear...  :)
-	    RideFilePoint *prevPoint = rideFile->dataPoints().back();
-	    double deltaSecs = secs - prevPoint->secs;
-	    double deltaDist = distance - prevPoint->km;
-	    double deltaSpeed = speed - prevPoint->kph;
-	    double deltaAlt = alt - prevPoint->alt;
-	    double deltaLon = lon - prevPoint->lon;
-	    double deltaLat = lat - prevPoint->lat;
+	    RideFilePoint prevPoint = rideFile->point(rideFile->samples()-1);
+	    double deltaSecs = secs - prevPoint.secs;
+	    double deltaDist = distance - prevPoint.km;
+	    double deltaSpeed = speed - prevPoint.kph;
+	    double deltaAlt = alt - prevPoint.alt;
+	    double deltaLon = lon - prevPoint.lon;
+	    double deltaLat = lat - prevPoint.lat;
 
 	    // Smart Recording High Water Mark.
         if ((isGarminSmartRecording.toInt() == 0) ||
@@ -198,20 +215,20 @@ bool
 		// smart recording is on and delta is less than GarminHWM seconds.
 		for(int i = 1; i <= deltaSecs; i++) {
 		    double weight = i/ deltaSecs;
-		    double kph = prevPoint->kph + (deltaSpeed *weight);
+		    double kph = prevPoint.kph + (deltaSpeed *weight);
 		    // need to make sure speed goes to zero
 		    kph = kph > 0.35 ? kph : 0;
-		    double lat = prevPoint->lat + (deltaLat * weight);
-		    double lon = prevPoint->lon + (deltaLon * weight);
+		    double lat = prevPoint.lat + (deltaLat * weight);
+		    double lon = prevPoint.lon + (deltaLon * weight);
 		    rideFile->appendPoint(
-			    prevPoint->secs + (deltaSecs * weight),
+			    prevPoint.secs + (deltaSecs * weight),
 			    0,
 			    0,
-			    prevPoint->km + (deltaDist * weight),
+			    prevPoint.km + (deltaDist * weight),
 			    kph,
 			    0,
 			    0,
-			    prevPoint->alt + (deltaAlt * weight),
+			    prevPoint.alt + (deltaAlt * weight),
 			    lon, // lon
 			    lat, // lat
                 0,
@@ -220,7 +237,6 @@ bool
                 0,
 			    0);
 		}
-		prevPoint = rideFile->dataPoints().back();
 	    }
 	}
 	// update the "lasts" and find the next point
@@ -228,12 +244,4 @@ bool
         lastLon = lon;
         lastLat = lat;
     }
-
-    return TRUE;
-}
-
-bool GpxParser::characters( const QString& str )
-{
-    buffer += str;
-    return TRUE;
 }
@@ -19,26 +19,26 @@
  * Franklin Street, Fifth Floor, Boston, MA  02110-1301	 USA
  */
 
-#ifndef _TcxParser_h
-#define _TcxParser_h
+#ifndef _GpxParser_h
+#define _GpxParser_h
 #include "GoldenCheetah.h"
 
 #include "RideFile.h"
 #include <QString>
 #include <QDateTime>
-#include <QXmlDefaultHandler>
+#include <QXmlStreamReader>
 #include "Settings.h"
 
-class GpxParser : public QXmlDefaultHandler
+// pulls the track from the file with a QXmlStreamReader
+class GpxParser
 {
 public:
     GpxParser(RideFile* rideFile);
 
-    bool startElement( const QString&, const QString&, const QString&,
-		       const QXmlAttributes& );
-    bool endElement( const QString&, const QString&, const QString& );
+    bool parse(QIODevice *device, QStringList &errors);
 
-    bool characters( const QString& );
+    void startElement( const QStringRef&, const QXmlStreamAttributes& );
+    void endElement( const QStringRef& );
 
 private:
 
@@ -65,5 +65,5 @@ private:
 
 };
 
-#endif // _TcxParser_h
+#endif // _GpxParser_h
 
@@ -28,7 +28,6 @@ static int tcxFileReaderRegistered =
 
 RideFile *GpxFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*) const
 {
-    (void) errors;
     RideFile *rideFile = new RideFile();
     rideFile->setRecIntSecs(1.0);
     //rideFile->setDeviceType("GPS Exchange Format");
@@ -36,10 +35,7 @@ RideFile *GpxFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
 
     GpxParser handler(rideFile);
 
-    QXmlInputSource source (&file);
-    QXmlSimpleReader reader;
-    reader.setContentHandler (&handler);
-    reader.parse (source);
+    handler.parse(&file, errors);
 
     return rideFile;
 }
@@ -103,13 +103,6 @@ HrPwPlot::HrPwPlot(MainWindow *mainWindow, HrPwWindow *hrPwWindow) :
     shade_zones = true;
 }
 
-struct DataPoint {
-    double time, hr, watts;
-    int inter;
-    DataPoint(double t, double h, double w, int i) :
-        time(t), hr(h), watts(w), inter(i) {}
-};
-
 void
 HrPwPlot::setAxisTitle(int axis, QString label)
 {
@@ -145,50 +138,22 @@ HrPwPlot::recalc()
 
     // ------ smoothing -----
     // ----------------------
-    double totalWatts = 0.0;
-    double totalHr = 0.0;
-    QList<DataPoint*> list;
-    int i = 0;
     QVector<double> smoothWatts(rideTimeSecs + 1);
     QVector<double> smoothHr(rideTimeSecs + 1);
     QVector<double> smoothTime(rideTimeSecs + 1);
     int decal=0;
 
-    /*for (int secs = 0; ((secs < smooth) && (secs < rideTimeSecs)); ++secs) {
-        smoothWatts[secs] = 0.0;
-        smoothHr[secs]    = 0.0;
-    }*/
-
-    //int interval = 0;
     int smooth = hrPwWindow->smooth;
+    const SmoothedData &smoothed = smoother.smooth(smooth);
 
+    // gaps are dropped
     for (int secs = smooth; secs <= rideTimeSecs; ++secs) {
-        while ((i < arrayLength) && (timeArray[i] <= secs)) {
-            DataPoint *dp =
-                new DataPoint(timeArray[i], hrArray[i], wattsArray[i], interArray[i]);
-	
-            totalWatts += wattsArray[i];
-                totalHr    += hrArray[i];
-	        list.append(dp);
-
-            ++i;
-        }
-        while (!list.empty() && (list.front()->time < secs - smooth)) {
-            DataPoint *dp = list.front();
-            list.removeFirst();
-            totalWatts -= dp->watts;
-            totalHr    -= dp->hr;
-            delete dp;
-        }
-        if (list.empty()) {
+        if (smoothed.count[secs] == 0) {
             ++decal;
         }
         else {
-            smoothWatts[secs-decal]    = totalWatts / list.size();
-            smoothHr[secs-decal]       = totalHr / list.size();
-            // Utiliser interval du fichier
-            //if (smooth/list.size()>0)
-            //	interval = smooth/list.size();
+            smoothWatts[secs-decal]    = smoothed.mean[0][secs];
+            smoothHr[secs-decal]       = smoothed.mean[1][secs];
         }
         smoothTime[secs]  = secs / 60.0;
     }
@@ -487,6 +452,10 @@ HrPwPlot::setDataFromRide(RideItem *_rideItem)
             ++arrayLength;
         }
 
+        smoother.setTimes(timeArray);
+        smoother.addSeries(wattsArray);
+        smoother.addSeries(hrArray);
+
         delay = -1;
         recalc();
     }
@@ -22,6 +22,7 @@
 #include "GoldenCheetah.h"
 #include <qwt_plot.h>
 #include <QtGui>
+#include "Smoother.h"
 
 class QwtPlotCurve;
 class QwtPlotGrid;
@@ -83,6 +84,7 @@ class HrPwPlot : public QwtPlot
         QVector<double> wattsArray;
         QVector<double> timeArray;
         QVector<int> interArray;
+        Smoother smoother;
 
         int arrayLength;
 
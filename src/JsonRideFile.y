@@ -35,28 +35,32 @@
 // in writeRideFile below, this is NOT a generic json parser.
 
 #include "JsonRideFile.h"
+#include <string.h> // for memchr and strncmp
 
-// Set during parser processing, using same
-// naming conventions as yacc/lex -p
-static RideFile *JsonRide;
-
-// term state data is held in these variables
-static RideFilePoint JsonPoint;
-static RideFileInterval JsonInterval;
-static QString JsonString,
-               JsonTagKey, JsonTagValue,
-               JsonOverName, JsonOverKey, JsonOverValue;
-static double JsonNumber;
-static QStringList JsonRideFileerrors;
-static QMap <QString, QString> JsonOverrides;
-
-// Standard yacc/lex variables / functions
-extern int JsonRideFilelex(); // the lexer aka yylex()
-extern void JsonRideFilerestart (FILE *input_file); // the lexer file restart aka yyrestart()
-extern FILE *JsonRideFilein; // used by the lexer aka yyin
-extern char *JsonRideFiletext; // set by the lexer aka yytext
-void JsonRideFileerror(const char *error) // used by parser aka yyerror()
-{ JsonRideFileerrors << error; }
+// The parser is pure and the scanner is hand written (see
+// JsonRideFilelex below) so all the state for a parse is held
+// in a JsonContext, which means any number of threads can be
+// reading .json files at the same time.
+//
+// The scanner works straight off the file contents, keywords
+// are matched in place and numbers are converted without
+// building a string for them, only string values are copied.
+struct JsonContext
+{
+    // the input
+    const char *p, *end;
+
+    // the ride we are building
+    RideFile *ride;
+
+    // term state data
+    RideFilePoint point;
+    QString string,
+            tagKey, tagValue,
+            overName, overKey, overValue;
+    QMap <QString, QString> overrides;
+    QStringList errors;
+};
 
 //
 // Utility functions
@@ -79,13 +83,13 @@ static QString protect(const QString string)
 }
 
 // Un-Escape special characters (JSON compliance)
-static QString unprotect(const QString string)
+// text/length is the string without its enclosing quotes
+static QString unprotect(const char *text, int length)
 {
-    QString string2 = QString::fromLocal8Bit(string.toAscii().data());
+    QString s = QString::fromLocal8Bit(text, length);
 
-    // this is a lexer string so it will be enclosed
-    // in quotes. Lets strip those first
-    QString s = string2.mid(1,string2.length()-2);
+    // nothing to un-escape (almost always)
+    if (!memchr(text, '\\', length)) return s;
 
     // now un-escape the control characters
     s.replace("\\t", "\t");  // tab
@@ -102,12 +106,32 @@ static QString unprotect(const QString string)
 
 %}
 
-%token STRING INTEGER FLOAT
+%define api.pure
+%parse-param { JsonContext *jc }
+%lex-param { JsonContext *jc }
+
+%union {
+    double number;
+    struct { const char *text; int length; } string;
+}
+
+%code {
+// Standard yacc/lex functions, the parser is pure so
+// they get the context passed rather than using globals
+static int JsonRideFilelex(YYSTYPE *lvalp, JsonContext *jc); // the lexer aka yylex()
+static void JsonRideFileerror(JsonContext *jc, const char *error) // used by parser aka yyerror()
+{ jc->errors << error; }
+}
+
+%token <string> STRING
+%token <number> INTEGER FLOAT
 %token RIDE STARTTIME RECINTSECS DEVICETYPE IDENTIFIER
 %token OVERRIDES
 %token TAGS INTERVALS NAME START STOP
 %token SAMPLES SECS KM WATTS NM CAD KPH HR ALTITUDE LAT LON HEADWIND SLOPE TEMP LRBALANCE
 
+%type <number> number
+
 %start document
 %%
 
@@ -140,13 +164,13 @@ rideelement: starttime
  * First class variables
  */
 starttime: STARTTIME ':' string         {
-                                          QDateTime aslocal = QDateTime::fromString(JsonString, DATETIME_FORMAT);
+                                          QDateTime aslocal = QDateTime::fromString(jc->string, DATETIME_FORMAT);
                                           QDateTime asUTC = QDateTime(aslocal.date(), aslocal.time(), Qt::UTC);
-                                          JsonRide->setStartTime(asUTC.toLocalTime());
+                                          jc->ride->setStartTime(asUTC.toLocalTime());
                                         }
-recordint: RECINTSECS ':' number        { JsonRide->setRecIntSecs(JsonNumber); }
-devicetype: DEVICETYPE ':' string       { JsonRide->setDeviceType(JsonString); }
-identifier: IDENTIFIER ':' string       { JsonRide->setId(JsonString); }
+recordint: RECINTSECS ':' number        { jc->ride->setRecIntSecs($3); }
+devicetype: DEVICETYPE ':' string       { jc->ride->setDeviceType(jc->string); }
+identifier: IDENTIFIER ':' string       { jc->ride->setId(jc->string); }
 
 /*
  * Metric Overrides
@@ -154,81 +178,77 @@ identifier: IDENTIFIER ':' string       { JsonRide->setId(JsonString); }
 overrides: OVERRIDES ':' '[' overrides_list ']' ;
 overrides_list: override | overrides_list ',' override ;
 
-override: '{' override_name ':' override_values '}' { JsonRide->metricOverrides.insert(JsonOverName, JsonOverrides);
-                                                      JsonOverrides.clear();
+override: '{' override_name ':' override_values '}' { jc->ride->metricOverrides.insert(jc->overName, jc->overrides);
+                                                      jc->overrides.clear();
                                                     }
-override_name: string                   { JsonOverName = JsonString; }
+override_name: string                   { jc->overName = jc->string; }
 
 override_values: '{' override_value_list '}';
 override_value_list: override_value | override_value_list ',' override_value ;
-override_value: override_key ':' override_value { JsonOverrides.insert(JsonOverKey, JsonOverValue); }
-override_key : string                   { JsonOverKey = JsonString; }
-override_value : string                 { JsonOverValue = JsonString; }
+override_value: override_key ':' override_value { jc->overrides.insert(jc->overKey, jc->overValue); }
+override_key : string                   { jc->overKey = jc->string; }
+override_value : string                 { jc->overValue = jc->string; }
 
 /*
  * Ride metadata tags
  */
 tags: TAGS ':' '{' tags_list '}'
 tags_list: tag | tags_list ',' tag ;
-tag: tag_key ':' tag_value              { JsonRide->setTag(JsonTagKey, JsonTagValue); }
+tag: tag_key ':' tag_value              { jc->ride->setTag(jc->tagKey, jc->tagValue); }
 
-tag_key : string                        { JsonTagKey = JsonString; }
-tag_value : string                      { JsonTagValue = JsonString; }
+tag_key : string                        { jc->tagKey = jc->string; }
+tag_value : string                      { jc->tagValue = jc->string; }
 
 /*
  * Intervals
  */
 intervals: INTERVALS ':' '[' interval_list ']' ;
 interval_list: interval | interval_list ',' interval ;
-interval: '{' NAME ':' string ','       { JsonInterval.name = JsonString; }
-              START ':' number ','      { JsonInterval.start = JsonNumber; }
-              STOP ':' number           { JsonInterval.stop = JsonNumber; }
+interval: '{' NAME ':' string ','
+              START ':' number ','
+              STOP ':' number
           '}'
-                                        { JsonRide->addInterval(JsonInterval.start,
-                                                                JsonInterval.stop,
-                                                                JsonInterval.name);
-                                          JsonInterval = RideFileInterval();
-                                        }
+                                        { jc->ride->addInterval($8, $12, jc->string); }
 /*
  * Ride datapoints
  */
 samples: SAMPLES ':' '[' sample_list ']' ;
 sample_list: sample | sample_list ',' sample ;
-sample: '{' series_list '}'             { JsonRide->appendPoint(JsonPoint.secs, JsonPoint.cad,
-                                                    JsonPoint.hr, JsonPoint.km, JsonPoint.kph,
-                                                    JsonPoint.nm, JsonPoint.watts, JsonPoint.alt,
-                                                    JsonPoint.lon, JsonPoint.lat,
-                                                    JsonPoint.headwind,
-                                                    JsonPoint.slope, JsonPoint.temp, JsonPoint.lrbalance,
-                                                    JsonPoint.interval);
-                                          JsonPoint = RideFilePoint();
+sample: '{' series_list '}'             { jc->ride->appendPoint(jc->point.secs, jc->point.cad,
+                                                    jc->point.hr, jc->point.km, jc->point.kph,
+                                                    jc->point.nm, jc->point.watts, jc->point.alt,
+                                                    jc->point.lon, jc->point.lat,
+                                                    jc->point.headwind,
+                                                    jc->point.slope, jc->point.temp, jc->point.lrbalance,
+                                                    jc->point.interval);
+                                          jc->point = RideFilePoint();
                                         }
 
 series_list: series | series_list ',' series ;
-series: SECS ':' number                 { JsonPoint.secs = JsonNumber; }
-        | KM ':' number                 { JsonPoint.km = JsonNumber; }
-        | WATTS ':' number              { JsonPoint.watts = JsonNumber; }
-        | NM ':' number                 { JsonPoint.nm = JsonNumber; }
-        | CAD ':' number                { JsonPoint.cad = JsonNumber; }
-        | KPH ':' number                { JsonPoint.kph = JsonNumber; }
-        | HR ':' number                 { JsonPoint.hr = JsonNumber; }
-        | ALTITUDE ':' number           { JsonPoint.alt = JsonNumber; }
-        | LAT ':' number                { JsonPoint.lat = JsonNumber; }
-        | LON ':' number                { JsonPoint.lon = JsonNumber; }
-        | HEADWIND ':' number           { JsonPoint.headwind = JsonNumber; }
-        | SLOPE ':' number              { JsonPoint.slope = JsonNumber; }
-        | TEMP ':' number               { JsonPoint.temp = JsonNumber; }
-        | LRBALANCE ':' number          { JsonPoint.lrbalance = JsonNumber; }
+series: SECS ':' number                 { jc->point.secs = $3; }
+        | KM ':' number                 { jc->point.km = $3; }
+        | WATTS ':' number              { jc->point.watts = $3; }
+        | NM ':' number                 { jc->point.nm = $3; }
+        | CAD ':' number                { jc->point.cad = $3; }
+        | KPH ':' number                { jc->point.kph = $3; }
+        | HR ':' number                 { jc->point.hr = $3; }
+        | ALTITUDE ':' number           { jc->point.alt = $3; }
+        | LAT ':' number                { jc->point.lat = $3; }
+        | LON ':' number                { jc->point.lon = $3; }
+        | HEADWIND ':' number           { jc->point.headwind = $3; }
+        | SLOPE ':' number              { jc->point.slope = $3; }
+        | TEMP ':' number               { jc->point.temp = $3; }
+        | LRBALANCE ':' number          { jc->point.lrbalance = $3; }
         ;
 
 /*
  * Primitives
  */
-number: INTEGER                         { JsonNumber = QString(JsonRideFiletext).toInt(); }
-        | FLOAT                         { JsonNumber = QString(JsonRideFiletext).toDouble(); }
+number: INTEGER
+        | FLOAT
         ;
 
-string: STRING                          { JsonString = unprotect(JsonRideFiletext); }
+string: STRING                          { jc->string = unprotect($1.text, $1.length); }
         ;
 %%
 
@@ -237,21 +257,147 @@ static int jsonFileReaderRegistered =
     RideFileFactory::instance().registerReader(
         "json", "GoldenCheetah Json", new JsonFileReader());
 
+//
+// The lexer
+//
+static const struct { const char *name; int token; } JsonKeywords[] = {
+    { "RIDE", RIDE },
+    { "STARTTIME", STARTTIME },
+    { "RECINTSECS", RECINTSECS },
+    { "DEVICETYPE", DEVICETYPE },
+    { "IDENTIFIER", IDENTIFIER },
+    { "OVERRIDES", OVERRIDES },
+    { "TAGS", TAGS },
+    { "INTERVALS", INTERVALS },
+    { "NAME", NAME },
+    { "START", START },
+    { "STOP", STOP },
+    { "SAMPLES", SAMPLES },
+    { "SECS", SECS },
+    { "KM", KM },
+    { "WATTS", WATTS },
+    { "NM", NM },
+    { "CAD", CAD },
+    { "KPH", KPH },
+    { "HR", HR },
+    { "ALT", ALTITUDE }, // ALT clashes with qtnamespace.h:46
+    { "LAT", LAT },
+    { "LON", LON },
+    { "HEADWIND", HEADWIND },
+    { "SLOPE", SLOPE },
+    { "TEMP", TEMP },
+    { "LRBALANCE", LRBALANCE },
+    { NULL, 0 }
+};
+
+// exact powers of ten, anything up to 10^22 is
+// representable so mantissa / power is correctly rounded
+static const double JsonPowers[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// numbers are [-+]?[0-9]+ optionally followed by a fraction and/or exponent
+// we convert them in place, it is locale independent unlike strtod, and
+// only fall back to QByteArray::toDouble when the fast path can't be exact
+static int
+JsonNumber(JsonContext *jc, double &value)
+{
+    const char *begin = jc->p;
+    const char *p = jc->p;
+    bool negative = false, isfloat = false;
+
+    if (*p == '-' || *p == '+') negative = (*p++ == '-');
+
+    quint64 mantissa = 0;
+    int digits = 0, scale = 0;
+    for (; p < jc->end && *p >= '0' && *p <= '9'; p++) {
+        if (mantissa) digits++;
+        mantissa = mantissa * 10 + (*p - '0');
+    }
+    if (p < jc->end && *p == '.') {
+        isfloat = true;
+        for (p++; p < jc->end && *p >= '0' && *p <= '9'; p++, scale--) {
+            if (mantissa) digits++;
+            mantissa = mantissa * 10 + (*p - '0');
+        }
+    }
+    if (p+1 < jc->end && (*p == 'e' || *p == 'E') &&
+        (p[1] == '-' || p[1] == '+' || (p[1] >= '0' && p[1] <= '9'))) {
+        isfloat = true;
+        bool negexp = false;
+        int exponent = 0;
+        if (*++p == '-' || *p == '+') negexp = (*p++ == '-');
+        for (; p < jc->end && *p >= '0' && *p <= '9'; p++)
+            if (exponent < 1000) exponent = exponent * 10 + (*p - '0');
+        scale += negexp ? -exponent : exponent;
+    }
+    jc->p = p;
+
+    if (digits < 15 && scale >= -22 && scale <= 22) {
+        value = scale < 0 ? double(mantissa) / JsonPowers[-scale] : double(mantissa) * JsonPowers[scale];
+        if (negative) value = -value;
+    } else {
+        value = QByteArray(begin, p - begin).toDouble();
+    }
+
+    return isfloat ? FLOAT : INTEGER;
+}
+
+static int
+JsonRideFilelex(YYSTYPE *lvalp, JsonContext *jc)
+{
+    // we just ignore whitespace
+    while (jc->p < jc->end && (*jc->p == ' ' || *jc->p == '\n' || *jc->p == '\t' || *jc->p == '\r'))
+        jc->p++;
+
+    if (jc->p >= jc->end) return 0; // end of input
+
+    // strings and keywords, contains non-quotes or escaped-quotes
+    if (*jc->p == '"') {
+        const char *text = ++jc->p;
+        while (jc->p < jc->end && *jc->p != '"') {
+            if (*jc->p == '\\' && jc->p+1 < jc->end) jc->p++;
+            jc->p++;
+        }
+        if (jc->p >= jc->end) return '"'; // unterminated, let the parser complain
+        int length = jc->p++ - text;
+
+        for (int i=0; JsonKeywords[i].name; i++)
+            if (!strncmp(JsonKeywords[i].name, text, length) && JsonKeywords[i].name[length] == '\0')
+                return JsonKeywords[i].token;
+
+        lvalp->string.text = text;
+        lvalp->string.length = length;
+        return STRING;
+    }
+
+    // numbers
+    const char *digit = (*jc->p == '-' || *jc->p == '+') ? jc->p+1 : jc->p;
+    if (digit < jc->end && *digit >= '0' && *digit <= '9')
+        return JsonNumber(jc, lvalp->number);
+
+    // any other character, typically :, { or }
+    return *jc->p++;
+}
+
 RideFile *
 JsonFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*) const
 {
-    // jsonRide is local and static, used in the parser
-    // JsonRideFilein is the FILE * used by the lexer
-    JsonRideFilein = fopen(file.fileName().toLatin1(), "r");
-    if (JsonRideFilein == NULL) {
+    if (!file.open(QIODevice::ReadOnly)) {
         errors << "unable to open file" + file.fileName();
+        return NULL;
     }
-    // inform the parser/lexer we have a new file
-    JsonRideFilerestart(JsonRideFilein);
+
+    // the whole file is read in one go and scanned in place
+    QByteArray contents = file.readAll();
+    file.close();
 
     // setup
-    JsonRide = new RideFile;
-    JsonRideFileerrors.clear();
+    JsonContext jc;
+    jc.p = contents.constData();
+    jc.end = jc.p + contents.size();
+    jc.ride = new RideFile;
 
     // set to non-zero if you want to
     // to debug the yyparse() state machine
@@ -259,20 +405,20 @@ JsonFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*
     //yydebug = 0;
 
     // parse it
-    JsonRideFileparse();
-
-    // release the file handle
-    fclose(JsonRideFilein);
+    JsonRideFileparse(&jc);
 
     // Only get errors so fail if we have any
     if (errors.count()) {
-        errors << JsonRideFileerrors;
-        delete JsonRide;
+        errors << jc.errors;
+        delete jc.ride;
         return NULL;
-    } else return JsonRide;
+    } else return jc.ride;
 }
 
 // Writes valid .json (validated at www.jsonlint.com)
+//
+// The document is built in a byte buffer and written in one go,
+// samples are the bulk of it so we size the buffer for them up front
 bool
 JsonFileReader::writeRideFile(MainWindow *, const RideFile *ride, QFile &file) const
 {
@@ -282,17 +428,22 @@ JsonFileReader::writeRideFile(MainWindow *, const RideFile *ride, QFile &file) c
     // truncate existing
     file.resize(0);
 
-    // setup streamer
-    QTextStream out(&file);
+    QByteArray out;
+    out.reserve(1024 + ride->dataPoints().count() * 96);
 
     // start of document and ride
-    out << "{\n\t\"RIDE\":{\n";
+    out += "{\n\t\"RIDE\":{\n";
 
     // first class variables
-    out << "\t\t\"STARTTIME\":\"" << protect(ride->startTime().toUTC().toString(DATETIME_FORMAT)) << "\",\n";
-    out << "\t\t\"RECINTSECS\":" << ride->recIntSecs() << ",\n";
-    out << "\t\t\"DEVICETYPE\":\"" << protect(ride->deviceType()) << "\",\n";
-    out << "\t\t\"IDENTIFIER\":\"" << protect(ride->id()) << "\"";
+    out += "\t\t\"STARTTIME\":\"";
+    out += protect(ride->startTime().toUTC().toString(DATETIME_FORMAT)).toLocal8Bit();
+    out += "\",\n\t\t\"RECINTSECS\":";
+    out += QByteArray::number(ride->recIntSecs());
+    out += ",\n\t\t\"DEVICETYPE\":\"";
+    out += protect(ride->deviceType()).toLocal8Bit();
+    out += "\",\n\t\t\"IDENTIFIER\":\"";
+    out += protect(ride->id()).toLocal8Bit();
+    out += "\"";
 
     //
     // OVERRIDES
@@ -311,28 +462,34 @@ JsonFileReader::writeRideFile(MainWindow *, const RideFile *ride, QFile &file) c
             if (k.value().isEmpty()) continue;
 
             if (nonblanks == false) {
-                out << ",\n\t\t\"OVERRIDES\":[\n";
+                out += ",\n\t\t\"OVERRIDES\":[\n";
                 nonblanks = true;
 
             }
             // begin of overrides
-            out << "\t\t\t{ \"" << k.key() << "\":{ ";
+            out += "\t\t\t{ \"";
+            out += k.key().toLocal8Bit();
+            out += "\":{ ";
 
             // key/value pairs
             QMap<QString, QString>::const_iterator j;
             for (j=k.value().constBegin(); j != k.value().constEnd(); j++) {
 
                 // comma separated
-                out << "\"" << j.key() << "\":\"" << j.value() << "\"";
-                if (j+1 != k.value().constEnd()) out << ", ";
+                out += "\"";
+                out += j.key().toLocal8Bit();
+                out += "\":\"";
+                out += j.value().toLocal8Bit();
+                out += "\"";
+                if (j+1 != k.value().constEnd()) out += ", ";
             }
-            if (k+1 != ride->metricOverrides.constEnd()) out << " }},\n";
-            else out << " }}\n";
+            if (k+1 != ride->metricOverrides.constEnd()) out += " }},\n";
+            else out += " }}\n";
         }
 
         if (nonblanks == true) {
             // end of the overrides
-            out << "\t\t]";
+            out += "\t\t]";
         }
     }
 
@@ -341,18 +498,22 @@ JsonFileReader::writeRideFile(MainWindow *, const RideFile *ride, QFile &file) c
     //
     if (ride->tags().count()) {
 
-        out << ",\n\t\t\"TAGS\":{\n";
+        out += ",\n\t\t\"TAGS\":{\n";
 
         QMap<QString,QString>::const_iterator i;
         for (i=ride->tags().constBegin(); i != ride->tags().constEnd(); i++) {
 
-                out << "\t\t\t\"" << i.key() << "\":\"" << protect(i.value()) << "\"";
-                if (i+1 != ride->tags().constEnd()) out << ",\n";
-                else out << "\n";
+                out += "\t\t\t\"";
+                out += i.key().toLocal8Bit();
+                out += "\":\"";
+                out += protect(i.value()).toLocal8Bit();
+                out += "\"";
+                if (i+1 != ride->tags().constEnd()) out += ",\n";
+                else out += "\n";
         }
 
         // end of the tags
-        out << "\t\t}";
+        out += "\t\t}";
     }
 
     //
@@ -360,19 +521,22 @@ JsonFileReader::writeRideFile(MainWindow *, const RideFile *ride, QFile &file) c
     //
     if (!ride->intervals().empty()) {
 
-        out << ",\n\t\t\"INTERVALS\":[\n";
+        out += ",\n\t\t\"INTERVALS\":[\n";
         bool first = true;
 
         foreach (RideFileInterval i, ride->intervals()) {
             if (first) first=false;
-            else out << ",\n";
-
-            out << "\t\t\t{ ";
-            out << "\"NAME\":\"" << protect(i.name) << "\"";
-            out << ", \"START\": " << QString("%1").arg(i.start);
-            out << ", \"STOP\": " << QString("%1").arg(i.stop) << " }";
+            else out += ",\n";
+
+            out += "\t\t\t{ \"NAME\":\"";
+            out += protect(i.name).toLocal8Bit();
+            out += "\", \"START\": ";
+            out += QByteArray::number(i.start);
+            out += ", \"STOP\": ";
+            out += QByteArray::number(i.stop);
+            out += " }";
         }
-        out <<"\n\t\t]";
+        out += "\n\t\t]";
     }
 
     //
@@ -380,45 +544,45 @@ JsonFileReader::writeRideFile(MainWindow *, const RideFile *ride, QFile &file) c
     //
     if (ride->dataPoints().count()) {
 
-        out << ",\n\t\t\"SAMPLES\":[\n";
+        out += ",\n\t\t\"SAMPLES\":[\n";
         bool first = true;
 
+        const RideFileDataPresent *present = ride->areDataPresent();
         foreach (RideFilePoint *p, ride->dataPoints()) {
 
             if (first) first=false;
-            else out << ",\n";
-
-            out << "\t\t\t{ ";
+            else out += ",\n";
 
             // always store time
-            out << "\"SECS\":" << QString("%1").arg(p->secs);
-
-            if (ride->areDataPresent()->km) out << ", \"KM\":" << QString("%1").arg(p->km);
-            if (ride->areDataPresent()->watts) out << ", \"WATTS\":" << QString("%1").arg(p->watts);
-            if (ride->areDataPresent()->nm) out << ", \"NM\":" << QString("%1").arg(p->nm);
-            if (ride->areDataPresent()->cad) out << ", \"CAD\":" << QString("%1").arg(p->cad);
-            if (ride->areDataPresent()->kph) out << ", \"KPH\":" << QString("%1").arg(p->kph);
-            if (ride->areDataPresent()->hr) out << ", \"HR\":"  << QString("%1").arg(p->hr);
-            if (ride->areDataPresent()->alt) out << ", \"ALT\":" << QString("%1").arg(p->alt);
-            if (ride->areDataPresent()->lat)
-                out << ", \"LAT\":" << QString("%1").arg(p->lat, 0, 'g', 11);
-            if (ride->areDataPresent()->lon)
-                out << ", \"LON\":" << QString("%1").arg(p->lon, 0, 'g', 11);
-            if (ride->areDataPresent()->headwind) out << ", \"HEADWIND\":" << QString("%1").arg(p->headwind);
-            if (ride->areDataPresent()->slope) out << ", \"SLOPE\":" << QString("%1").arg(p->slope);
-            if (ride->areDataPresent()->temp && p->temp != RideFile::noTemp) out << ", \"TEMP\":" << QString("%1").arg(p->temp);
+            out += "\t\t\t{ \"SECS\":";
+            out += QByteArray::number(p->secs);
+
+            if (present->km) { out += ", \"KM\":"; out += QByteArray::number(p->km); }
+            if (present->watts) { out += ", \"WATTS\":"; out += QByteArray::number(p->watts); }
+            if (present->nm) { out += ", \"NM\":"; out += QByteArray::number(p->nm); }
+            if (present->cad) { out += ", \"CAD\":"; out += QByteArray::number(p->cad); }
+            if (present->kph) { out += ", \"KPH\":"; out += QByteArray::number(p->kph); }
+            if (present->hr) { out += ", \"HR\":"; out += QByteArray::number(p->hr); }
+            if (present->alt) { out += ", \"ALT\":"; out += QByteArray::number(p->alt); }
+            if (present->lat) { out += ", \"LAT\":"; out += QByteArray::number(p->lat, 'g', 11); }
+            if (present->lon) { out += ", \"LON\":"; out += QByteArray::number(p->lon, 'g', 11); }
+            if (present->headwind) { out += ", \"HEADWIND\":"; out += QByteArray::number(p->headwind); }
+            if (present->slope) { out += ", \"SLOPE\":"; out += QByteArray::number(p->slope); }
+            if (present->temp && p->temp != RideFile::noTemp) { out += ", \"TEMP\":"; out += QByteArray::number(p->temp); }
 
             // sample points in here!
-            out << " }";
+            out += " }";
         }
-        out <<"\n\t\t]";
+        out += "\n\t\t]";
     }
 
     // end of ride and document
-    out << "\n\t}\n}\n";
+    out += "\n\t}\n}\n";
+
+    bool ok = file.write(out) == out.size();
 
     // close
     file.close();
 
-    return true;
+    return ok;
 }
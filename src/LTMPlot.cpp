@@ -22,6 +22,7 @@
 #include "LTMOutliers.h"
 #include "LTMWindow.h"
 #include "MetricAggregator.h"
+#include "DBAccess.h"
 #include "SummaryMetrics.h"
 #include "RideMetric.h"
 #include "Settings.h"
@@ -790,9 +791,14 @@ LTMPlot::createTODCurveData(LTMSettings *settings, MetricDetail metricDetail, QV
 
     for (int i=0; i<(24); i++) x[i]=i;
 
-    foreach (SummaryMetrics rideMetrics, *(settings->data)) {
+    // convert seconds to hours
+    bool hours = metricDetail.metric && (metricDetail.metric->units(true) == "seconds" ||
+                                         metricDetail.metric->units(true) == tr("seconds"));
+    int symbol = MetricResultSet::symbolId(metricDetail.symbol);
 
-        double value = rideMetrics.getForSymbol(metricDetail.symbol);
+    foreach (const SummaryMetrics &rideMetrics, *(settings->data)) {
+
+        double value = rideMetrics.getForSymbol(symbol);
 
         // check values are bounded to stop QWT going berserk
         if (isnan(value) || isinf(value)) value = 0;
@@ -805,9 +811,7 @@ LTMPlot::createTODCurveData(LTMSettings *settings, MetricDetail metricDetail, QV
                 value += metricDetail.metric->conversionSum();
             }
 
-            // convert seconds to hours
-            if (metricDetail.metric->units(true) == "seconds" ||
-                metricDetail.metric->units(true) == tr("seconds")) value /= 3600;
+            if (hours) value /= 3600;
         }
 
         int array = rideMetrics.getRideDate().time().hour();
@@ -846,6 +850,12 @@ LTMPlot::createCurveData(LTMSettings *settings, MetricDetail metricDetail, QVect
     x.resize(maxdays+3); // one for start from zero plus two for 0 value added at head and tail
     y.resize(maxdays+3); // one for start from zero plus two for 0 value added at head and tail
 
+    // metrics from the db are already added up by period
+    if (canUseRollups(settings, metricDetail)) {
+        createRollupCurveData(settings, metricDetail, x, y, n);
+        return;
+    }
+
     // Get metric data, either from metricDB for RideFile metrics
     // or from StressCalculator for PM type metrics
     QList<SummaryMetrics> PMCdata;
@@ -858,11 +868,21 @@ LTMPlot::createCurveData(LTMSettings *settings, MetricDetail metricDetail, QVect
         data = &PMCdata;
     }
 
+    // these are the same for every ride
+    int firstDay = groupForDate(settings->start.date(), settings->groupBy);
+    bool hours = metricDetail.metric && (metricDetail.metric->units(true) == "seconds" ||
+                                         metricDetail.metric->units(true) == tr("seconds"));
+    int type = metricDetail.metric ? metricDetail.metric->type() : RideMetric::Average;
+    if (metricDetail.uunits == "Ramp" ||
+        metricDetail.uunits == tr("Ramp")) type = RideMetric::Total;
+    int symbol = MetricResultSet::symbolId(metricDetail.symbol);
+    int workoutTime = MetricResultSet::symbolId("workout_time");
+
     n=-1;
     int lastDay=0;
     unsigned long secondsPerGroupBy=0;
     bool wantZero = (metricDetail.curveStyle == QwtPlotCurve::Steps);
-    foreach (SummaryMetrics rideMetrics, *data) {
+    foreach (const SummaryMetrics &rideMetrics, *data) {
 
         // day we are on
         int currentDay = groupForDate(rideMetrics.getRideDate().date(), settings->groupBy);
@@ -870,9 +890,9 @@ LTMPlot::createCurveData(LTMSettings *settings, MetricDetail metricDetail, QVect
         // value for day -- measures are stored differently
         double value;
         if (metricDetail.type == METRIC_MEASURE)
-            value = rideMetrics.getText(metricDetail.symbol, "0.0").toDouble();
+            value = rideMetrics.getText(symbol, "0.0").toDouble();
         else
-            value = rideMetrics.getForSymbol(metricDetail.symbol);
+            value = rideMetrics.getForSymbol(symbol);
 
         // check values are bounded to stop QWT going berserk
         if (isnan(value) || isinf(value)) value = 0;
@@ -885,35 +905,28 @@ LTMPlot::createCurveData(LTMSettings *settings, MetricDetail metricDetail, QVect
                 value += metricDetail.metric->conversionSum();
             }
 
-            // convert seconds to hours
-            if (metricDetail.metric->units(true) == "seconds" ||
-                metricDetail.metric->units(true) == tr("seconds")) value /= 3600;
+            if (hours) value /= 3600;
         }
 
         if (value || wantZero) {
-            unsigned long seconds = rideMetrics.getForSymbol("workout_time");
+            unsigned long seconds = rideMetrics.getForSymbol(workoutTime);
             if (metricDetail.type == METRIC_MEASURE) seconds = 1;
             if (currentDay > lastDay) {
                 if (lastDay && wantZero) {
                     while (lastDay<currentDay) {
                         lastDay++;
                         n++;
-                        x[n]=lastDay - groupForDate(settings->start.date(), settings->groupBy);
+                        x[n]=lastDay - firstDay;
                         y[n]=0;
                     }
                 } else {
                     n++;
                 }
                 y[n] = value;
-                x[n] = currentDay - groupForDate(settings->start.date(), settings->groupBy);
+                x[n] = currentDay - firstDay;
                 secondsPerGroupBy = seconds; // reset for new group
             } else {
                 // sum totals, average averages and choose best for Peaks
-                int type = metricDetail.metric ? metricDetail.metric->type() : RideMetric::Average;
-
-                if (metricDetail.uunits == "Ramp" ||
-                    metricDetail.uunits == tr("Ramp")) type = RideMetric::Total;
-
                 switch (type) {
                 case RideMetric::Total:
                     y[n] += value;
@@ -937,6 +950,88 @@ LTMPlot::createCurveData(LTMSettings *settings, MetricDetail metricDetail, QVect
     }
 }
 
+// the rollups hold what createCurveData() would add up from the rides, but
+// they can't know about a filter and a conversion with an offset (like
+// celsius to fahrenheit) doesn't add up. Weeks are kept monday to sunday
+// so the chart must start on a monday too, which LTMWindow makes sure of
+bool
+LTMPlot::canUseRollups(LTMSettings *settings, MetricDetail metricDetail)
+{
+    if (metricDetail.type != METRIC_DB || metricDetail.metric == NULL) return false;
+    if (settings->ltmTool == NULL || settings->ltmTool->isFiltered()) return false;
+    if (!settings->start.date().isValid() || !settings->end.date().isValid()) return false;
+    if (useMetricUnits == false && metricDetail.metric->conversionSum() != 0) return false;
+    if (settings->groupBy == LTM_WEEK && settings->start.date().dayOfWeek() != 1) return false;
+
+    return (settings->groupBy == LTM_DAY || settings->groupBy == LTM_WEEK ||
+            settings->groupBy == LTM_MONTH || settings->groupBy == LTM_YEAR);
+}
+
+void
+LTMPlot::createRollupCurveData(LTMSettings *settings, MetricDetail metricDetail, QVector<double>&x,QVector<double>&y,int&n)
+{
+    QList<MetricRollup> rollups = main->metricDB->db()->getRollups(metricDetail.symbol, settings->groupBy,
+                                                                  settings->start.date(), settings->end.date());
+
+    // convert from stored metric value to imperial and seconds to hours
+    double scale = 1.0;
+    if (useMetricUnits == false) scale = metricDetail.metric->conversion();
+    if (metricDetail.metric->units(true) == "seconds" ||
+        metricDetail.metric->units(true) == tr("seconds")) scale /= 3600;
+
+    int type = metricDetail.metric->type();
+    if (metricDetail.uunits == "Ramp" ||
+        metricDetail.uunits == tr("Ramp")) type = RideMetric::Total;
+
+    int firstDay = groupForDate(settings->start.date(), settings->groupBy);
+    bool wantZero = (metricDetail.curveStyle == QwtPlotCurve::Steps);
+
+    n=-1;
+    int lastDay=0;
+    foreach (const MetricRollup &rollup, rollups) {
+
+        // rides with a zero value are only plotted for steps
+        if (rollup.count == 0 && !wantZero) continue;
+
+        // sum totals, average averages and choose best for Peaks
+        // as createCurveData() does, where the averages are weighted
+        // by the duration of the ride so short rides don't skew it
+        double value = 0;
+        switch (type) {
+        case RideMetric::Total:
+            value = rollup.sum;
+            break;
+        case RideMetric::Average:
+            if (wantZero) value = rollup.allSeconds ? rollup.wsum / rollup.allSeconds : rollup.sum / rollup.rides;
+            else value = rollup.seconds ? rollup.wsum / rollup.seconds : rollup.sum / rollup.count;
+            break;
+        case RideMetric::Peak:
+            value = rollup.count ? rollup.max : 0;
+            if (wantZero && rollup.rides > rollup.count && value < 0) value = 0;
+            break;
+        }
+        value *= scale;
+
+        // check values are bounded to stop QWT going berserk
+        if (isnan(value) || isinf(value)) value = 0;
+
+        int currentDay = groupForDate(rollup.bucket, settings->groupBy);
+        if (lastDay && wantZero) {
+            while (lastDay<currentDay) {
+                lastDay++;
+                n++;
+                x[n]=lastDay - firstDay;
+                y[n]=0;
+            }
+        } else {
+            n++;
+        }
+        y[n] = value;
+        x[n] = currentDay - firstDay;
+        lastDay = currentDay;
+    }
+}
+
 void
 LTMPlot::createPMCCurveData(LTMSettings *settings, MetricDetail metricDetail,
                             QList<SummaryMetrics> &customData)
@@ -98,6 +98,9 @@ class LTMPlot : public QwtPlot
         void createTODCurveData(LTMSettings *, MetricDetail,
                              QVector<double>&, QVector<double>&, int&);
         void createPMCCurveData(LTMSettings *, MetricDetail, QList<SummaryMetrics> &);
+        bool canUseRollups(LTMSettings *, MetricDetail);
+        void createRollupCurveData(LTMSettings *, MetricDetail,
+                             QVector<double>&, QVector<double>&, int&);
         void aggregateCurves(QVector<double> &a, QVector<double>&w); // aggregate a with w, updates a
         int chooseYAxis(QString);
         void refreshZoneLabels(int);
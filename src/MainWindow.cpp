@@ -17,6 +17,8 @@
  */
 
 #include "MainWindow.h"
+#include "RideResidency.h"
+#include "RidePrefetcher.h"
 #include "AboutDialog.h"
 #include "AddIntervalDialog.h"
 #include "AthleteTool.h"
@@ -129,6 +131,13 @@ MainWindow::MainWindow(const QDir &home) :
     zones_(new Zones), hrzones_(new HrZones),
     ride(NULL), workout(NULL)
 {
+    // how long startup takes, see startup.log
+    QTime startup;
+    startup.start();
+
+    // before there are any rides to open
+    residency = new RideResidency(this);
+    prefetcher = new RidePrefetcher(this);
 
     static const QIcon hideIcon(":images/toolbar/main/hideside.png");
     static const QIcon rhideIcon(":images/toolbar/main/hiderside.png");
@@ -319,7 +328,20 @@ MainWindow::MainWindow(const QDir &home) :
     lucene = new Lucene(this, this); // before metricDB attempts to refresh
 #endif
     metricDB = new MetricAggregator(this, home, zones(), hrZones()); // just to catch config updates!
-    metricDB->refreshMetrics();
+
+    // the ride list comes from the db as it was when we last closed and
+    // the files are checked in the background once we're up and running.
+    // first time round there's nothing there so we refresh as we always have
+    int startupSettings = startup.elapsed();
+    QStringList rideFiles = metricDB->knownRides();
+    bool ridesFromDB = !rideFiles.isEmpty();
+    if (ridesFromDB) {
+        isclean = true; // trust it until the check says otherwise
+    } else {
+        metricDB->refreshMetrics();
+        rideFiles = RideFileFactory::instance().listRideFiles(home);
+    }
+    int startupRides = startup.elapsed();
 
     // Downloaders
     withingsDownload = new WithingsDownload(this);
@@ -609,8 +631,10 @@ MainWindow::MainWindow(const QDir &home) :
         intervalSplitter->setSizes(sizes);
     }
 
+    QTime startupTree;
+    startupTree.start();
     QTreeWidgetItem *last = NULL;
-    QStringListIterator i(RideFileFactory::instance().listRideFiles(home));
+    QStringListIterator i(rideFiles);
     while (i.hasNext()) {
         QString name = i.next(), notesFileName;
         QDateTime dt;
@@ -620,6 +644,7 @@ MainWindow::MainWindow(const QDir &home) :
             allRides->addChild(last);
         }
     }
+    int startupTreeTime = startupTree.elapsed();
 
     splitter = new QSplitter;
 
@@ -915,6 +940,20 @@ MainWindow::MainWindow(const QDir &home) :
     scopebar->setShowSidebar(true);
 #endif
     setStyle();
+
+    // startup timing breakdown, the background check adds to it
+    QFile log(home.absolutePath() + "/" + "startup.log");
+    if (log.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        QTextStream out(&log);
+        out << "STARTUP: " << QDateTime::currentDateTime().toString() << "\r\n";
+        out << "Settings, zones and widgets: " << startupSettings << "ms\r\n";
+        out << "Ride list: " << rideFiles.count() << (ridesFromDB ? " rides from the db in " : " rides after a full refresh in ")
+            << (startupRides - startupSettings) << "ms\r\n";
+        out << "Ride tree: " << startupTreeTime << "ms\r\n";
+        out << "Ready: " << startup.elapsed() << "ms\r\n";
+    }
+
+    if (ridesFromDB) metricDB->checkRideFiles();
 }
 
 /*----------------------------------------------------------------------
@@ -1140,6 +1179,9 @@ MainWindow::rideTreeWidgetSelectionChanged()
             }
         }
     }
+
+    // and read ahead the rides we're likely to look at next
+    prefetcher->selected(ride);
 }
 
 void
@@ -1315,12 +1357,35 @@ MainWindow::closeEvent(QCloseEvent* event)
         // clear the clipboard if neccessary
         QApplication::clipboard()->setText("");
 
+        // how the open rides fared, alongside the startup times
+        QFile log(home.absolutePath() + "/" + "startup.log");
+        if (log.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            QTextStream out(&log);
+            out << "RIDE MEMORY: " << residency->hits() << " hits, " << residency->misses() << " misses, "
+                << residency->evictions() << " evicted, " << residency->resident() << " rides resident using "
+                << residency->residentBytes() / 1024 << "KB, peak " << residency->peakBytes() / 1024
+                << "KB, budget " << residency->budget() / 1024 << "KB\r\n";
+            int asked = prefetcher->hits() + prefetcher->misses();
+            out << "RIDE PREFETCH: depth " << prefetcher->depth() << ", " << prefetcher->prefetched() << " read ahead, "
+                << prefetcher->hits() << " of " << asked << " rides ready when asked for ("
+                << (asked ? 100 * prefetcher->hits() / asked : 0) << "%)\r\n";
+        }
+
         // now remove from the list
         if(mainwindows.removeOne(this) == false)
             qDebug()<<"closeEvent: mainwindows list error";
     }
 }
 
+MainWindow::~MainWindow()
+{
+    // the ride items go after us, with the tree
+    delete prefetcher; // waits for the worker
+    prefetcher = NULL;
+    delete residency;
+    residency = NULL;
+}
+
 void
 MainWindow::closeAll()
 {
@@ -1604,6 +1669,49 @@ MainWindow::addRide(QString name, bool /* bSelect =true*/)
     if (!index) treeWidget->setCurrentItem(last);
 }
 
+// the startup check found files added or removed outside of GC, the
+// db is brought up to date after, so we don't signal anything here
+void
+MainWindow::syncRideList(const QStringList &filenames)
+{
+    QSet<QString> files = filenames.toSet();
+    QSet<QString> listed;
+
+    // the caller refreshes the metrics when we're done, so the
+    // aggregator mustn't do it for every ride we take out
+    bool multisave = ismultisave;
+    ismultisave = true;
+
+    // rides whose file has gone, but not the one we're looking at. They
+    // go the same way as removeCurrentRide so everyone holding on to the
+    // item (the navigator, the charts, the prefetcher) lets go of it first
+    for (int index = allRides->childCount()-1; index >= 0; index--) {
+        RideItem *item = static_cast<RideItem*>(allRides->child(index));
+        if (!files.contains(item->fileName) && item != treeWidget->currentItem()) {
+            allRides->removeChild(item);
+            rideDeleted(item);
+            item->freeMemory();
+            delete item;
+        } else {
+            listed << item->fileName;
+        }
+    }
+    ismultisave = multisave;
+
+    // new ones go in date order
+    foreach (QString name, filenames) {
+        QString notesFileName;
+        QDateTime dt;
+        if (listed.contains(name) || !parseRideFileName(name, &notesFileName, &dt)) continue;
+
+        RideItem *item = new RideItem(RIDE_TYPE, home.path(), name, dt, zones(), hrZones(), notesFileName, this);
+        int index = 0;
+        while (index < allRides->childCount() && static_cast<RideItem*>(allRides->child(index))->dateTime <= dt)
+            index++;
+        allRides->insertChild(index, item);
+    }
+}
+
 void
 MainWindow::removeCurrentRide()
 {
@@ -1653,7 +1761,7 @@ MainWindow::removeCurrentRide()
 
     // remove any other derived/additional files; notes, cpi etc
     QStringList extras;
-    extras << "notes" << "cpi" << "cpx";
+    extras << "notes" << "cpi" << "cpx" << RideFileFactory::instance().cacheSuffix();
     foreach (QString extension, extras) {
 
         QString deleteMe = QFileInfo(strOldFileName).baseName() + "." + extension;
@@ -2071,10 +2179,8 @@ MainWindow::addIntervals()
 void
 MainWindow::addIntervalForPowerPeaksForSecs(RideFile *ride, int windowSizeSecs, QString name)
 {
-    QList<BestIntervalDialog::BestInterval> results;
-    BestIntervalDialog::findBests(ride, windowSizeSecs, 1, results);
-    if (results.isEmpty()) return;
-    const BestIntervalDialog::BestInterval &i = results.first();
+    RideFilePeak i = ride->peakPower(windowSizeSecs);
+    if (i.isEmpty()) return;
     QTreeWidgetItem *peak =
         new IntervalItem(ride, name+tr(" (%1 watts)").arg((int) round(i.avg)),
                          i.start, i.stop,
@@ -41,6 +41,8 @@
 #endif
 
 class MetricAggregator;
+class RideResidency;
+class RidePrefetcher;
 class Zones;
 class HrZones;
 class RideFile;
@@ -97,6 +99,8 @@ class MainWindow : public QMainWindow
         QSqlDatabase db;
         RideNavigator *listView;
         MetricAggregator *metricDB;
+        RideResidency *residency; // keeps open rides within budget
+        RidePrefetcher *prefetcher; // reads ahead of the ride list selection
         Seasons *seasons;
         QList<RideFileCache*> cpxCache;
 
@@ -113,6 +117,7 @@ class MainWindow : public QMainWindow
 
         // athlete's ride library
         void addRide(QString name, bool bSelect=true);
+        void syncRideList(const QStringList &filenames);
         void removeCurrentRide();
 
         // save a ride to disk
@@ -212,6 +217,7 @@ class MainWindow : public QMainWindow
         virtual void resizeEvent(QResizeEvent*);
         virtual void moveEvent(QMoveEvent*);
         virtual void closeEvent(QCloseEvent*);
+        ~MainWindow();
         virtual void dragEnterEvent(QDragEnterEvent *);
         virtual void dropEvent(QDropEvent *);
 
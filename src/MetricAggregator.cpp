@@ -33,8 +33,12 @@
 #include <math.h>
 #include <QtXml/QtXml>
 #include <QProgressDialog>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QWaitCondition>
+#include <QSemaphore>
 
-MetricAggregator::MetricAggregator(MainWindow *main, QDir home, const Zones *zones, const HrZones *hrzones) : QObject(main), main(main), home(home), zones(zones), hrzones(hrzones)
+MetricAggregator::MetricAggregator(MainWindow *main, QDir home, const Zones *zones, const HrZones *hrzones) : QObject(main), main(main), home(home), zones(zones), hrzones(hrzones), scanner(NULL)
 {
     colorEngine = new ColorEngine(main);
     dbaccess = new DBAccess(main, home);
@@ -46,7 +50,13 @@ MetricAggregator::MetricAggregator(MainWindow *main, QDir home, const Zones *zon
 
 MetricAggregator::~MetricAggregator()
 {
+    // let the startup check finish with us
+    if (scanner) {
+        scanner->done.acquire();
+        delete scanner;
+    }
     delete colorEngine;
+    qDeleteAll(pmcData);
     delete dbaccess;
 }
 
@@ -65,22 +75,127 @@ void MetricAggregator::refreshMetrics()
     refreshMetrics(QDateTime());
 }
 
-// Refresh not up to date metrics and metrics after date
-void MetricAggregator::refreshMetrics(QDateTime forceAfterThisDate)
+/*----------------------------------------------------------------------
+ * The refresh pipeline -- rides are opened, their metrics computed and
+ * their .cpx caches updated by a pool of worker threads. The results
+ * are handed back to the gui thread which is the only one that writes
+ * to the database (the connection belongs to the thread that opened it)
+ *----------------------------------------------------------------------*/
+
+// what the workers hand back for each ride
+struct MetricRefreshResult
 {
-    // only if we have established a connection to the database
-    if (dbaccess == NULL || main->isclean==true) return;
+    QString name;
+    RideFile *ride;             // NULL if it wasn't opened
+    SummaryMetrics *summary;    // NULL if the metrics were up to date
+    bool modify;                // already in the db
+    bool failed;                // couldn't open it
+    int msecs;                  // time spent in the worker
+    int metricMsecs;            // of which computing the metrics
+};
+
+// results waiting for the writer
+class MetricRefreshQueue
+{
+    public:
+        void post(MetricRefreshResult result) {
+            QMutexLocker locker(&lock);
+            results << result;
+            ready.wakeAll();
+        }
 
-    // first check db structure is still up to date
-    // this is because metadata.xml may add new fields
-    dbaccess->checkDBVersion();
+        // wait up to msecs for something to arrive
+        QList<MetricRefreshResult> take(int msecs) {
+            QMutexLocker locker(&lock);
+            if (results.isEmpty()) ready.wait(&lock, msecs);
+            QList<MetricRefreshResult> returning = results;
+            results.clear();
+            return returning;
+        }
 
-    // Get a list of the ride files
-    QRegExp rx = RideFileFactory::instance().rideFileRegExp();
-    QStringList filenames = RideFileFactory::instance().listRideFiles(home);
-    QStringListIterator i(filenames);
+    private:
+        QMutex lock;
+        QWaitCondition ready;
+        QList<MetricRefreshResult> results;
+};
+
+// first use the ride tag, then measures then fallback to the global
+// setting, as RideFile::getWeight does, but without touching the db
+static double
+weightFor(const RideFile *ride, const QList<SummaryMetrics> &measures, double fallback)
+{
+    double weight;
+    if ((weight = ride->getTag("Weight", "0.0").toDouble()) > 0) return weight;
+
+    for (int i=measures.count()-1; i>=0; i--) {
+        if (measures[i].getDateTime().date() > ride->startTime().date()) continue;
+        if ((weight = measures[i].getText("Weight", "0.0").toDouble()) > 0) return weight;
+    }
+    return fallback;
+}
 
-    // get a Hash map of statistic records and timestamps
+class MetricRefreshTask : public QRunnable
+{
+    public:
+        MetricRefreshTask(const MetricAggregator *aggregator, MetricRefreshQueue *queue,
+                          const RideFileContext *context, const QList<SummaryMetrics> *measures,
+                          double weight, QString name, bool update, bool modify) :
+            aggregator(aggregator), queue(queue), context(context), measures(measures),
+            weight(weight), name(name), update(update), modify(modify) {}
+
+        void run() {
+            QTime elapsed;
+            elapsed.start();
+
+            MetricRefreshResult result;
+            result.name = name;
+            result.ride = NULL;
+            result.summary = NULL;
+            result.modify = modify;
+            result.failed = false;
+            result.metricMsecs = 0;
+
+            QFile file(aggregator->home.absolutePath() + "/" + name);
+
+            // open it if the metrics or the cache need updating, the
+            // weight is resolved here so nothing goes near the db
+            if (update || !RideFileCache::isCurrent(file.fileName())) {
+                QStringList errors;
+                result.ride = RideFileFactory::instance().openRideFile(*context, file, errors);
+                if (result.ride) result.ride->setWeight(weightFor(result.ride, *measures, weight));
+                else result.failed = true;
+            }
+
+            if (result.ride && update) {
+                QTime metrics;
+                metrics.start();
+                result.summary = aggregator->computeMetrics(result.ride, name);
+                result.metricMsecs = metrics.elapsed();
+            }
+
+            // update cache (will check timestamps itself)
+            // we only want to check so passing check=true
+            // because we don't actually want the results now
+            if (result.ride) RideFileCache updater(aggregator->main, file.fileName(), result.ride, true);
+
+            result.msecs = elapsed.elapsed();
+            queue->post(result);
+        }
+
+    private:
+        const MetricAggregator *aggregator;
+        MetricRefreshQueue *queue;
+        const RideFileContext *context;
+        const QList<SummaryMetrics> *measures;
+        double weight;
+        QString name;
+        bool update, modify;
+};
+
+// get a Hash map of statistic records and timestamps
+static QHash<QString, status>
+readStatus(DBAccess *dbaccess)
+{
     QSqlQuery query(dbaccess->connection());
     QHash <QString, status> dbStatus;
     bool rc = query.exec("SELECT filename, timestamp, fingerprint FROM metrics ORDER BY ride_date;");
@@ -91,6 +206,52 @@ void MetricAggregator::refreshMetrics(QDateTime forceAfterThisDate)
         add.fingerprint = query.value(2).toInt();
         dbStatus.insert(filename, add);
     }
+    return dbStatus;
+}
+
+// safe to call from any thread, it only looks at the file system
+void
+MetricAggregator::scanRideFiles(QDir home, RideFileScan &scan)
+{
+    QTime elapsed;
+    elapsed.start();
+
+    scan.filenames = RideFileFactory::instance().listRideFiles(home);
+    scan.modified.clear();
+    foreach (QString name, scan.filenames)
+        scan.modified.insert(name, QFileInfo(home.absolutePath() + "/" + name).lastModified().toTime_t());
+
+    scan.msecs = elapsed.elapsed();
+}
+
+// Refresh not up to date metrics and metrics after date
+void MetricAggregator::refreshMetrics(QDateTime forceAfterThisDate)
+{
+    // only if we have established a connection to the database
+    if (dbaccess == NULL || main->isclean==true) return;
+
+    RideFileScan scan;
+    scanRideFiles(home, scan);
+    refreshMetrics(scan, forceAfterThisDate);
+}
+
+// the refresh itself, against the files as they were scanned
+void MetricAggregator::refreshMetrics(const RideFileScan &scan, QDateTime forceAfterThisDate)
+{
+    // first check db structure is still up to date
+    // this is because metadata.xml may add new fields
+    dbaccess->checkDBVersion();
+
+    // Get a list of the ride files
+    QRegExp rx = RideFileFactory::instance().rideFileRegExp();
+    QStringList filenames = scan.filenames;
+    QStringListIterator i(filenames);
+
+    QHash <QString, status> dbStatus = readStatus(dbaccess);
+
+    // the workers can't query the db so get the weights up front
+    QList<SummaryMetrics> measures = dbaccess->getAllMeasuresFor(QDateTime(), QDateTime());
+    double weight = appsettings->cvalue(main->cyclist, GC_WEIGHT, "75.0").toString().toDouble(); // default to 75kg
 
     // begin LUW -- byproduct of turning off sync (nosync)
     dbaccess->connection().transaction();
@@ -98,8 +259,10 @@ void MetricAggregator::refreshMetrics(QDateTime forceAfterThisDate)
     // Delete statistics for non-existant ride files
     QHash<QString, status>::iterator d;
     for (d = dbStatus.begin(); d != dbStatus.end(); ++d) {
-        if (QFile(home.absolutePath() + "/" + d.key()).exists() == false) {
+        if (!scan.modified.contains(d.key())) {
             dbaccess->deleteRide(d.key());
+            if (rx.exactMatch(d.key()))
+                loadChanged << QDate(rx.cap(1).toInt(), rx.cap(2).toInt(), rx.cap(3).toInt());
 #ifdef GC_HAVE_LUCENE
             main->lucene->deleteRide(d.key());
 #endif
@@ -118,7 +281,7 @@ void MetricAggregator::refreshMetrics(QDateTime forceAfterThisDate)
     bar.setMinimumDuration(0);
     bar.show();
 
-    int processed=0;
+    int processed=0, updated=0;
     QApplication::processEvents(); // get that dialog up!
 
     // log of progress
@@ -128,67 +291,93 @@ void MetricAggregator::refreshMetrics(QDateTime forceAfterThisDate)
     QTextStream out(&log);
     out << "METRIC REFRESH STARTS: " << QDateTime::currentDateTime().toString() + "\r\n";
 
-    while (i.hasNext()) {
-        QString name = i.next();
-        QFile file(home.absolutePath() + "/" + name);
-
-        // if it s missing or out of date then update it!
-        status current = dbStatus.value(name);
-        unsigned long dbTimeStamp = current.timestamp;
-        unsigned long fingerprint = current.fingerprint;
-
-        RideFile *ride = NULL;
+    // the workers open the rides with this, so they don't go near
+    // the metadata or the settings from another thread
+    RideFileContext context(main);
 
-        // update progress bar
-        long elapsedtime = elapsed.elapsed();
-        QString elapsedString = QString("%1:%2:%3").arg(elapsedtime/3600000,2)
-                                                .arg((elapsedtime%3600000)/60000,2,10,QLatin1Char('0'))
-                                                .arg((elapsedtime%60000)/1000,2,10,QLatin1Char('0'));
-        QString title = tr("Refreshing Ride Statistics...\nElapsed: %1\n%2").arg(elapsedString).arg(name);
-        bar.setLabelText(title);
-        bar.setValue(++processed);
-        QApplication::processEvents();
+    // the workers, we keep a couple of rides per thread in flight
+    // so the writer always has something to do, but no more since
+    // each one holds a whole ride in memory until it is written
+    QThreadPool pool;
+    pool.setMaxThreadCount(QThread::idealThreadCount());
+    int inflightMax = 2 * pool.maxThreadCount();
+    int inflight = 0;
+    MetricRefreshQueue queue;
+    bool cancelled = false;
 
-        if (dbTimeStamp < QFileInfo(file).lastModified().toTime_t() ||
-            zoneFingerPrint != fingerprint ||
-            (!forceAfterThisDate.isNull() && name >= forceAfterThisDate.toString("yyyy_MM_dd_hh_mm_ss"))) {
-            QStringList errors;
+    out << "Using " << pool.maxThreadCount() << " worker threads\r\n";
 
-            // log
-            out << "Opening ride: " << name << "\r\n";
+    while ((!cancelled && i.hasNext()) || inflight) {
 
-            // read file and process it if we didn't already...
-            if (ride == NULL) ride = RideFileFactory::instance().openRideFile(main, file, errors);
+        // keep the workers busy
+        while (!cancelled && i.hasNext() && inflight < inflightMax) {
+            QString name = i.next();
 
-            out << "File open completed: " << name << "\r\n";
+            // if it s missing or out of date then update it!
+            status current = dbStatus.value(name);
+            unsigned long dbTimeStamp = current.timestamp;
+            unsigned long fingerprint = current.fingerprint;
 
-            if (ride != NULL) {
+            bool update = dbTimeStamp < scan.modified.value(name) ||
+                          zoneFingerPrint != fingerprint ||
+                          (!forceAfterThisDate.isNull() && name >= forceAfterThisDate.toString("yyyy_MM_dd_hh_mm_ss"));
 
-                out << "Updating statistics: " << name << "\r\n";
-                importRide(home, ride, name, zoneFingerPrint, (dbTimeStamp > 0));
+            pool.start(new MetricRefreshTask(this, &queue, &context, &measures, weight, name, update, (dbTimeStamp > 0)));
+            inflight++;
+        }
 
+        // write whatever is ready in one go, we're already in a transaction
+        QList<MetricRefreshResult> results = queue.take(100);
+        QList<DBRideImport> batch;
+        foreach (MetricRefreshResult result, results) {
+            inflight--;
+            processed++;
+
+            if (result.summary) {
+                batch << DBRideImport(result.summary, result.ride, colorFor(result.ride), zoneFingerPrint);
+                updated++;
+                out << "Updated statistics: " << result.name << " (" << result.msecs << "ms, metrics "
+                    << result.metricMsecs << "ms)\r\n";
+            } else if (result.failed) {
+                out << "Could not open: " << result.name << "\r\n";
             }
         }
-
-        // update cache (will check timestamps itself)
-        // if ride wasn't opened it will do it itself
-        // we only want to check so passing check=true
-        // because we don't actually want the results now
-        RideFileCache updater(main, home.absolutePath() + "/" + name, ride, true);
+        storeMetrics(batch);
 
         // free memory - if needed
-        if (ride) delete ride;
+        foreach (MetricRefreshResult result, results) {
+            if (result.summary) delete result.summary;
+            if (result.ride) delete result.ride;
+        }
 
-        if (bar.wasCanceled()) {
+        // update progress bar
+        long elapsedtime = elapsed.elapsed();
+        QString elapsedString = QString("%1:%2:%3").arg(elapsedtime/3600000,2)
+                                                .arg((elapsedtime%3600000)/60000,2,10,QLatin1Char('0'))
+                                                .arg((elapsedtime%60000)/1000,2,10,QLatin1Char('0'));
+        QString title = tr("Refreshing Ride Statistics...\nElapsed: %1\n%2 of %3").arg(elapsedString)
+                                                .arg(processed).arg(filenames.count());
+        bar.setLabelText(title);
+        bar.setValue(processed);
+        QApplication::processEvents();
+
+        // stop handing out work, but let what is in flight finish
+        if (!cancelled && bar.wasCanceled()) {
             out << "METRIC REFRESH CANCELLED\r\n";
-            break;
+            cancelled = true;
         }
     }
+    pool.waitForDone();
 
     // stop logging
+    double secs = elapsed.elapsed() / 1000.0;
+    out << "Processed " << processed << " rides, updated " << updated << ", in " << secs << "s ("
+        << (secs > 0 ? processed / secs : 0) << " rides/s)\r\n";
     out << "METRIC REFRESH ENDS: " << QDateTime::currentDateTime().toString() + "\r\n";
     log.close();
 
+    updateDailyLoad();
+
     // end LUW -- now syncs DB
     dbaccess->connection().commit();
 #ifdef GC_HAVE_LUCENE
@@ -199,6 +388,100 @@ void MetricAggregator::refreshMetrics(QDateTime forceAfterThisDate)
     dataChanged(); // notify models/views
 }
 
+/*----------------------------------------------------------------------
+ * Startup -- the ride list is shown from the db as it was when we last
+ *            closed, then the files are looked at on a worker thread
+ *            and anything changed outside of GC is caught up with
+ *----------------------------------------------------------------------*/
+
+class RideFileScanner : public QRunnable
+{
+    public:
+        RideFileScanner(MetricAggregator *aggregator, QDir home) : aggregator(aggregator), home(home) {
+            setAutoDelete(false);
+        }
+
+        void run() {
+            MetricAggregator::scanRideFiles(home, scan);
+            QMetaObject::invokeMethod(aggregator, "rideFilesChecked", Qt::QueuedConnection);
+            done.release(); // last, we may be deleted from here on
+        }
+
+        RideFileScan scan;
+        QSemaphore done;
+
+    private:
+        MetricAggregator *aggregator;
+        QDir home;
+};
+
+QStringList
+MetricAggregator::knownRides()
+{
+    if (dbaccess == NULL) return QStringList();
+
+    // a new schema or metadata.xml means the db is empty again
+    dbaccess->checkDBVersion();
+
+    QStringList rides;
+    QSqlQuery query(dbaccess->connection());
+    query.setForwardOnly(true);
+    bool rc = query.exec("SELECT filename FROM metrics ORDER BY ride_date;");
+    while (rc && query.next()) rides << query.value(0).toString();
+    return rides;
+}
+
+void
+MetricAggregator::checkRideFiles()
+{
+    if (scanner) return; // already looking
+
+    scanner = new RideFileScanner(this, home);
+    QThreadPool::globalInstance()->start(scanner);
+}
+
+void
+MetricAggregator::rideFilesChecked()
+{
+    if (!scanner) return;
+
+    scanner->done.acquire();
+    RideFileScan scan = scanner->scan;
+    delete scanner;
+    scanner = NULL;
+
+    // what changed while we were closed?
+    QHash<QString, status> dbStatus = readStatus(dbaccess);
+    unsigned long zoneFingerPrint = zones->getFingerprint() + hrzones->getFingerprint();
+    int added = 0, modified = 0, removed = 0, rezoned = 0;
+
+    foreach (QString name, scan.filenames) {
+        if (!dbStatus.contains(name)) added++;
+        else if (dbStatus.value(name).timestamp < scan.modified.value(name)) modified++;
+        else if (dbStatus.value(name).fingerprint != zoneFingerPrint) rezoned++;
+    }
+    foreach (QString name, dbStatus.keys())
+        if (!scan.modified.contains(name)) removed++;
+
+    // catch up, against the same scan so nothing is looked at twice
+    QTime elapsed;
+    elapsed.start();
+    if (added || removed) main->syncRideList(scan.filenames);
+    if (added || modified || removed || rezoned) {
+        main->isclean = false;
+        refreshMetrics(scan, QDateTime());
+    }
+
+    QFile log(home.absolutePath() + "/" + "startup.log");
+    if (log.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        QTextStream out(&log);
+        out << "RIDE FILE CHECK: " << scan.filenames.count() << " files looked at in the background in "
+            << scan.msecs << "ms\r\n";
+        out << "Added " << added << ", modified " << modified << ", removed " << removed
+            << ", zones changed " << rezoned << ", caught up in " << elapsed.elapsed() << "ms\r\n";
+    }
+}
+
 /*----------------------------------------------------------------------
  * Calculate the metrics for a ride file using the metrics factory
  *----------------------------------------------------------------------*/
@@ -206,8 +489,16 @@ void MetricAggregator::refreshMetrics(QDateTime forceAfterThisDate)
 // add a ride (after import / download)
 void MetricAggregator::addRide(RideItem*ride)
 {
+    // a bulk import brings them all up to date with one
+    // refresh when it is done, see RideImportWizard
+    if (main->ismultisave) {
+        main->isclean = false;
+        return;
+    }
+
     if (ride && ride->ride()) {
         importRide(main->home, ride->ride(), ride->fileName, main->zones()->getFingerprint(), true);
+        updateDailyLoad();
         RideFileCache updater(main, home.absolutePath() + "/" + ride->fileName, ride->ride(), true); // update cpx etc
         dataChanged(); // notify models/views
     }
@@ -220,15 +511,27 @@ void MetricAggregator::update() {
     }
 }
 
-bool MetricAggregator::importRide(QDir path, RideFile *ride, QString fileName, unsigned long fingerprint, bool modify)
+bool MetricAggregator::importRide(QDir, RideFile *ride, QString fileName, unsigned long fingerprint, bool modify)
 {
-    SummaryMetrics *summaryMetric = new SummaryMetrics();
-    QFile file(path.absolutePath() + "/" + fileName);
+    SummaryMetrics *summaryMetric = computeMetrics(ride, fileName);
+    if (summaryMetric == NULL) return false; // not a ridefile!
 
+    storeMetrics(summaryMetric, ride, fingerprint, modify);
+    delete summaryMetric;
+
+    return true;
+}
+
+// safe to call from any thread
+SummaryMetrics *
+MetricAggregator::computeMetrics(RideFile *ride, QString fileName) const
+{
     QRegExp rx = RideFileFactory::instance().rideFileRegExp();
     if (!rx.exactMatch(fileName)) {
-        return false; // not a ridefile!
+        return NULL; // not a ridefile!
     }
+
+    SummaryMetrics *summaryMetric = new SummaryMetrics();
     summaryMetric->setFileName(fileName);
     assert(rx.numCaptures() == 7);
     QDate date(rx.cap(1).toInt(), rx.cap(2).toInt(),rx.cap(3).toInt());
@@ -253,16 +556,76 @@ bool MetricAggregator::importRide(QDir path, RideFile *ride, QString fileName, u
         summaryMetric->setForSymbol(factory.metricName(i), computed.value(factory.metricName(i))->value(true));
     }
 
+    return summaryMetric;
+}
+
+// the db connection belongs to the gui thread
+void
+MetricAggregator::storeMetrics(SummaryMetrics *summaryMetric, RideFile *ride, unsigned long fingerprint, bool modify)
+{
     // what color will this ride be?
-    QColor color = colorEngine->colorFor(ride->getTag(main->rideMetadata()->getColorField(), ""));
+    QColor color = colorFor(ride);
 
     dbaccess->importRide(summaryMetric, ride, color, fingerprint, modify);
+    loadChanged << summaryMetric->getRideDate().date();
 #ifdef GC_HAVE_LUCENE
     main->lucene->importRide(summaryMetric, ride, color, fingerprint, modify);
 #endif
-    delete summaryMetric;
+}
 
-    return true;
+// as above, but a batch at a time for the refresh
+void
+MetricAggregator::storeMetrics(const QList<DBRideImport> &rides)
+{
+    dbaccess->importRides(rides);
+    foreach (DBRideImport add, rides) {
+        loadChanged << add.summary->getRideDate().date();
+#ifdef GC_HAVE_LUCENE
+        main->lucene->importRide(add.summary, add.ride, add.color, add.fingerprint, true);
+#endif
+    }
+}
+
+QColor
+MetricAggregator::colorFor(RideFile *ride) const
+{
+    return colorEngine->colorFor(ride->getTag(main->rideMetadata()->getColorField(), ""));
+}
+
+void
+MetricAggregator::updateDailyLoad()
+{
+    if (loadChanged.isEmpty()) return;
+
+    // the refresh will already have a transaction open, but
+    // addRide won't and that is a sync to disk for every row
+    bool ownTransaction = dbaccess->connection().transaction();
+    dbaccess->updateDailyLoad(loadChanged.toList());
+    dbaccess->updateRollups(loadChanged.toList()); // for the LTM charts
+    if (ownTransaction) dbaccess->connection().commit();
+
+    // the stress only needs working out again from the earliest change
+    QDate earliest;
+    foreach (QDate day, loadChanged)
+        if (!earliest.isValid() || day < earliest) earliest = day;
+    foreach (PMCData *pmc, pmcData) pmc->invalidate(earliest);
+
+    loadChanged.clear();
+}
+
+PMCData *
+MetricAggregator::getPMCData(QString metric, int stsDays, int ltsDays)
+{
+    if (main->isclean == false) refreshMetrics(); // get them up-to-date
+    if (dbaccess == NULL || !PMCData::metrics().contains(metric)) return NULL;
+
+    QString key = QString("%1:%2:%3").arg(metric).arg(stsDays).arg(ltsDays);
+    PMCData *pmc = pmcData.value(key, NULL);
+    if (!pmc) {
+        pmc = new PMCData(dbaccess, metric, stsDays, ltsDays);
+        pmcData.insert(key, pmc);
+    }
+    return pmc;
 }
 
 void
@@ -278,10 +641,10 @@ void
 MetricAggregator::writeAsCSV(QString filename)
 {
     // write all metrics as a CSV file
-    QList<SummaryMetrics> all = getAllMetricsFor(QDateTime(), QDateTime());
+    MetricResultSetPtr all = getMetricResultsFor(QDateTime(), QDateTime());
 
     // write headings
-    if (!all.count()) return; // no dice
+    if (!all->rows()) return; // no dice
 
     // open file.. truncate if exists already
     QFile file(filename);
@@ -289,9 +652,14 @@ MetricAggregator::writeAsCSV(QString filename)
     file.resize(0);
     QTextStream out(&file);
 
+    // columns in symbol order, as they always were
+    QMap<QString, int> columns;
+    foreach (int symbol, all->valueSymbols())
+        columns.insert(MetricResultSet::symbolName(symbol), symbol);
+
     // write headings
     out<<"date, time, filename,";
-    QMapIterator<QString, double>i(all[0].values());
+    QMapIterator<QString, int>i(columns);
     while (i.hasNext()) {
         i.next();
         out<<i.key()<<",";
@@ -299,15 +667,15 @@ MetricAggregator::writeAsCSV(QString filename)
     out<<"\n";
 
     // write values
-    foreach(SummaryMetrics x, all) {
-        out<<x.getRideDate().date().toString("MM/dd/yy")<<","
-           <<x.getRideDate().time().toString()<<","
-           <<x.getFileName()<<",";
+    for (int row=0; row<all->rows(); row++) {
+        out<<all->rideDate(row).date().toString("MM/dd/yy")<<","
+           <<all->rideDate(row).time().toString()<<","
+           <<all->fileName(row)<<",";
 
-        QMapIterator<QString, double>i(x.values());
+        i.toFront();
         while (i.hasNext()) {
             i.next();
-            out<<i.value()<<",";
+            out<<all->value(row, i.value())<<",";
         }
         out<<"\n";
     }
@@ -323,24 +691,47 @@ MetricAggregator::getAllMetricsFor(DateRange dr)
 QList<SummaryMetrics>
 MetricAggregator::getAllMetricsFor(QDateTime start, QDateTime end)
 {
-    if (main->isclean == false) refreshMetrics(); // get them up-to-date
+    return DBAccess::toSummaryMetrics(getMetricResultsFor(start, end));
+}
 
-    QList<SummaryMetrics> empty;
+MetricResultSetPtr
+MetricAggregator::getMetricResultsFor(DateRange dr)
+{
+    return getMetricResultsFor(QDateTime(dr.from, QTime(0,0,0)), QDateTime(dr.to, QTime(23,59,59)));
+}
+
+MetricResultSetPtr
+MetricAggregator::getMetricResultsFor(QDateTime start, QDateTime end)
+{
+    if (main->isclean == false) refreshMetrics(); // get them up-to-date
 
     // only if we have established a connection to the database
     if (dbaccess == NULL) {
         qDebug()<<"lost db connection?";
-        return empty;
+        return MetricResultSetPtr(new MetricResultSet);
     }
 
     // apparently using transactions for queries
     // can improve performance!
     dbaccess->connection().transaction();
-    QList<SummaryMetrics> results = dbaccess->getAllMetricsFor(start, end);
+    MetricResultSetPtr results = dbaccess->getMetricResultsFor(start, end);
     dbaccess->connection().commit();
     return results;
 }
 
+QStringList
+MetricAggregator::getRidesWhere(QString where, const QList<QVariant> &params)
+{
+    if (main->isclean == false) refreshMetrics(); // get them up-to-date
+
+    // only if we have established a connection to the database
+    if (dbaccess == NULL) {
+        qDebug()<<"lost db connection?";
+        return QStringList();
+    }
+    return dbaccess->getRidesWhere(where, params);
+}
+
 SummaryMetrics
 MetricAggregator::getAllMetricsFor(QString filename)
 {
@@ -31,6 +31,17 @@
 #include "MainWindow.h"
 #include "DBAccess.h"
 #include "Colors.h"
+#include "PMCData.h"
+
+class RideFileScanner;
+
+// the ride files in the library and when each was last modified
+struct RideFileScan
+{
+    QStringList filenames;                  // in date order
+    QHash<QString, unsigned long> modified; // as time_t
+    int msecs;                              // how long it took to look
+};
 
 class MetricAggregator : public QObject
 {
@@ -45,11 +56,25 @@ class MetricAggregator : public QObject
 
         void refreshMetrics();
         void refreshMetrics(QDateTime forceAfterThisDate);
+
+        // the rides in the db as they were when we last closed, so the
+        // ride list can be shown before the files are looked at, and
+        // looking at them on a worker thread to catch up afterwards
+        QStringList knownRides();
+        void checkRideFiles();
+        static void scanRideFiles(QDir home, RideFileScan &scan);
+
         void getFirstLast(QDate &, QDate &);
         DBAccess *db() { return dbaccess; }
         SummaryMetrics getAllMetricsFor(QString filename); // for a single ride
         QList<SummaryMetrics> getAllMetricsFor(QDateTime start, QDateTime end);
         QList<SummaryMetrics> getAllMetricsFor(DateRange);
+        MetricResultSetPtr getMetricResultsFor(QDateTime start, QDateTime end);
+        MetricResultSetPtr getMetricResultsFor(DateRange);
+        QStringList getRidesWhere(QString where, const QList<QVariant> &params);
+
+        // daily load and stress for one of the PMCData::metrics()
+        PMCData *getPMCData(QString metric, int stsDays, int ltsDays);
         QList<SummaryMetrics> getAllMeasuresFor(QDateTime start, QDateTime end);
         QList<SummaryMetrics> getAllMeasuresFor(DateRange);
         SummaryMetrics getRideMetrics(QString filename);
@@ -63,6 +88,9 @@ class MetricAggregator : public QObject
         void addRide(RideItem*);
         void importMeasure(SummaryMetrics *sm);
 
+    private slots:
+        void rideFilesChecked();
+
     private:
         MainWindow *main;
         DBAccess *dbaccess;
@@ -70,10 +98,26 @@ class MetricAggregator : public QObject
         const Zones *zones;
         const HrZones *hrzones;
 
+        void refreshMetrics(const RideFileScan &scan, QDateTime forceAfterThisDate);
+        RideFileScanner *scanner; // startup check, if running
+
 	    typedef QHash<QString,RideMetric*> MetricMap;
 	    bool importRide(QDir path, RideFile *ride, QString fileName, unsigned long, bool modify);
+
+        // importRide in two halves so the refresh can compute metrics
+        // in worker threads but write to the database in this one
+        friend class MetricRefreshTask;
+        SummaryMetrics *computeMetrics(RideFile *ride, QString fileName) const;
+        void storeMetrics(SummaryMetrics *summaryMetric, RideFile *ride, unsigned long, bool modify);
+        void storeMetrics(const QList<DBRideImport> &rides);
+        QColor colorFor(RideFile *ride) const;
 	    MetricMap metrics;
         ColorEngine *colorEngine;
+
+        // days with rides added/changed/deleted since the daily load was updated
+        QSet<QDate> loadChanged;
+        void updateDailyLoad();
+        QHash<QString, PMCData*> pmcData;
 };
 
 #endif /* METRICAGGREGATOR_H_ */
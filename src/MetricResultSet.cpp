@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2026 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MetricResultSet.h"
+#include <QHash>
+#include <QMutex>
+
+// the symbol table is shared by everyone, including the
+// metric refresh workers, so it is guarded
+static QMutex symbolLock;
+static QHash<QString,int> symbolIds;
+static QVector<QString> symbolNames;
+
+int
+MetricResultSet::symbolId(const QString &symbol, bool add)
+{
+    QMutexLocker locker(&symbolLock);
+
+    QHash<QString,int>::const_iterator it = symbolIds.find(symbol);
+    if (it != symbolIds.end()) return it.value();
+    if (!add) return -1;
+
+    int id = symbolNames.size();
+    symbolIds.insert(symbol, id);
+    symbolNames.append(symbol);
+    return id;
+}
+
+QString
+MetricResultSet::symbolName(int id)
+{
+    QMutexLocker locker(&symbolLock);
+    return (id >= 0 && id < symbolNames.size()) ? symbolNames[id] : QString();
+}
+
+void
+MetricResultSet::addValueColumn(int symbol)
+{
+    if (hasValue(symbol)) return;
+    while (valueIndex.size() <= symbol) valueIndex.append(-1);
+
+    valueIndex[symbol] = values.size();
+    valueIds.append(symbol);
+    values.append(QVector<double>(count, 0.0));
+}
+
+void
+MetricResultSet::addTextColumn(int symbol)
+{
+    if (hasText(symbol)) return;
+    while (textIndex.size() <= symbol) textIndex.append(-1);
+
+    textIndex[symbol] = texts.size();
+    textIds.append(symbol);
+    texts.append(QVector<QString>(count));
+}
+
+int
+MetricResultSet::addRow(const QString &fileName, const QString &id, const QDateTime &rideDate)
+{
+    fileNames.append(fileName);
+    ids.append(id);
+    rideDates.append(rideDate);
+
+    for (int i=0; i<values.size(); i++) values[i].append(0.0);
+    for (int i=0; i<texts.size(); i++) texts[i].append(QString());
+
+    return count++;
+}
+
+void
+MetricResultSet::setValue(int row, int symbol, double v)
+{
+    if (!hasValue(symbol)) addValueColumn(symbol);
+    values[valueIndex[symbol]][row] = v;
+}
+
+void
+MetricResultSet::setText(int row, int symbol, const QString &v)
+{
+    if (!hasText(symbol)) addTextColumn(symbol);
+    texts[textIndex[symbol]][row] = v;
+}
+
+const QVector<double> &
+MetricResultSet::column(int symbol) const
+{
+    static const QVector<double> empty;
+    int c = valueColumn(symbol);
+    return c >= 0 ? values[c] : empty;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2026 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_MetricResultSet_h
+#define _GC_MetricResultSet_h 1
+#include "GoldenCheetah.h"
+
+#include <QString>
+#include <QVector>
+#include <QList>
+#include <QDateTime>
+#include <QSharedPointer>
+
+// The results of a metrics query held column by column. Metric symbols
+// and metadata field names are interned to small integer ids that are
+// the same for every result set, so charts can look up the ids once and
+// then index straight into the columns for each ride (row).
+//
+// Rows are in the order they were added, which for the db queries is
+// ride date order.
+class MetricResultSet
+{
+    public:
+
+        // interning symbols, symbolId(x, false) returns -1 if
+        // the symbol has never been seen rather than adding it
+        static int symbolId(const QString &symbol, bool add = true);
+        static QString symbolName(int id);
+
+        MetricResultSet() : count(0) {}
+
+        // building a result set; declare the columns
+        // first then add rows and set their values
+        void addValueColumn(int symbol);
+        void addTextColumn(int symbol);
+        int addRow(const QString &fileName, const QString &id, const QDateTime &rideDate);
+        void setValue(int row, int symbol, double v);
+        void setText(int row, int symbol, const QString &v);
+
+        // rows
+        int rows() const { return count; }
+        const QString &fileName(int row) const { return fileNames[row]; }
+        const QString &id(int row) const { return ids[row]; }
+        const QDateTime &rideDate(int row) const { return rideDates[row]; }
+
+        // values, rides without a value for a symbol get 0
+        bool hasValue(int symbol) const { return valueColumn(symbol) >= 0; }
+        double value(int row, int symbol) const {
+            int c = valueColumn(symbol);
+            return c >= 0 ? values[c][row] : 0.0;
+        }
+        const QVector<double> &column(int symbol) const; // empty if not present
+        const QList<int> &valueSymbols() const { return valueIds; }
+
+        // texts, rides without a text get the fallback
+        bool hasText(int symbol) const { return textColumn(symbol) >= 0; }
+        QString text(int row, int symbol, const QString &fallback) const {
+            int c = textColumn(symbol);
+            return c >= 0 ? texts[c][row] : fallback;
+        }
+        const QList<int> &textSymbols() const { return textIds; }
+
+    private:
+
+        int valueColumn(int symbol) const {
+            return (symbol >= 0 && symbol < valueIndex.size()) ? valueIndex[symbol] : -1;
+        }
+        int textColumn(int symbol) const {
+            return (symbol >= 0 && symbol < textIndex.size()) ? textIndex[symbol] : -1;
+        }
+
+        int count;
+        QVector<QString> fileNames, ids;
+        QVector<QDateTime> rideDates;
+
+        // symbol id -> column, -1 if not in this result set
+        QVector<int> valueIndex, textIndex;
+        QList<int> valueIds, textIds;
+        QVector<QVector<double> > values;
+        QVector<QVector<QString> > texts;
+};
+
+typedef QSharedPointer<const MetricResultSet> MetricResultSetPtr;
+
+#endif // _GC_MetricResultSet_h
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2026 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "MinMaxSeriesData.h"
+#include <QApplication>
+#include <QDesktopWidget>
+#include <algorithm>
+
+MinMaxSeriesData::MinMaxSeriesData(const double *xdata, const double *ydata, int n)
+{
+    x.resize(n);
+    y.resize(n);
+    for (int i=0; i<n; i++) {
+        x[i] = xdata[i];
+        y[i] = ydata[i];
+    }
+
+    // resize events don't reset the rect of interest, so aim for
+    // the widest the canvas could get
+    pixels = qMax(QApplication::desktop()->screenGeometry().width(), 256);
+
+    if (n == 0) {
+        bounds = QRectF(1.0, 1.0, -2.0, -2.0); // invalid, as qwt does
+        return;
+    }
+
+    // level 0 pairs the samples, each level after pairs the blocks below it
+    int blocks = n;
+    while (blocks > pixels) {
+
+        int level = minIndex.count();
+        blocks = (blocks + 1) / 2;
+
+        QVector<int> mins(blocks), maxs(blocks);
+        for (int b=0; b<blocks; b++) {
+            int lo, hi, lo2, hi2;
+            if (level == 0) {
+                lo = hi = 2*b;
+                lo2 = hi2 = qMin(2*b+1, n-1);
+            } else {
+                int last = minIndex[level-1].count() - 1;
+                lo = minIndex[level-1][2*b];
+                hi = maxIndex[level-1][2*b];
+                lo2 = minIndex[level-1][qMin(2*b+1, last)];
+                hi2 = maxIndex[level-1][qMin(2*b+1, last)];
+            }
+            mins[b] = y[lo2] < y[lo] ? lo2 : lo;
+            maxs[b] = y[hi2] > y[hi] ? hi2 : hi;
+        }
+        minIndex.append(mins);
+        maxIndex.append(maxs);
+    }
+
+    // the bounds never change, the autoscaler asks for them a lot
+    double miny = y[0], maxy = y[0];
+    for (int i=1; i<n; i++) {
+        if (y[i] < miny) miny = y[i];
+        if (y[i] > maxy) maxy = y[i];
+    }
+    bounds = QRectF(x[0], miny, x[n-1] - x[0], maxy - miny);
+
+    setRectOfInterest(QRectF(x[0], miny, x[n-1] - x[0], maxy - miny));
+}
+
+void
+MinMaxSeriesData::addPoint(int index)
+{
+    points.append(QPointF(x[index], y[index]));
+}
+
+void
+MinMaxSeriesData::setRectOfInterest(const QRectF &rect)
+{
+    points.clear();
+    int n = x.count();
+    if (n == 0) return;
+
+    // the visible samples and one either side so the line
+    // runs off the edge of the canvas rather than stopping short
+    int from = std::lower_bound(x.begin(), x.end(), rect.left()) - x.begin();
+    int to = std::upper_bound(x.begin(), x.end(), rect.right()) - x.begin();
+    from = qMax(from - 1, 0);
+    to = qMin(to, n - 1);
+    if (to < from) to = from;
+
+    // pick the level with about a block per pixel
+    int level = -1, size = 1;
+    while (level+1 < minIndex.count() && (to - from + 1) / size > pixels) {
+        level++;
+        size *= 2;
+    }
+
+    if (level < 0) {
+        // few enough to draw them all
+        points.reserve(to - from + 1);
+        for (int i=from; i<=to; i++) addPoint(i);
+        return;
+    }
+
+    // the edge samples, then the low and high of each block in the order
+    // they were recorded so the line goes up and down in the right place
+    points.reserve(2 * ((to - from) / size + 1) + 2);
+    addPoint(from);
+    for (int b = from / size; b <= to / size; b++) {
+        int lo = minIndex[level][b], hi = maxIndex[level][b];
+        if (lo > hi) std::swap(lo, hi);
+        if (lo > from && lo < to) addPoint(lo);
+        if (hi != lo && hi > from && hi < to) addPoint(hi);
+    }
+    addPoint(to);
+}
+
+size_t
+MinMaxSeriesData::size() const
+{
+    return points.count();
+}
+
+QPointF
+MinMaxSeriesData::sample(size_t i) const
+{
+    return points[i];
+}
+
+QRectF
+MinMaxSeriesData::boundingRect() const
+{
+    return bounds;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2026 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_MinMaxSeriesData_h
+#define _GC_MinMaxSeriesData_h 1
+#include "GoldenCheetah.h"
+
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+#include <qwt_series_data.h>
+
+// Curve data for a whole ride that only hands Qwt as many points as it
+// can draw. A pyramid of the lowest and highest sample in blocks of 2, 4,
+// 8 .. samples is built once, then each time the axes change we pick the
+// level that gives about one block per pixel across the visible range and
+// hand over the min and max of each block. Every peak and trough is a real
+// sample at its real x, so the line looks the same as drawing the lot.
+//
+// x must be in ascending order (time or distance).
+class MinMaxSeriesData : public QwtSeriesData<QPointF>
+{
+    public:
+        MinMaxSeriesData(const double *x, const double *y, int n);
+
+        virtual size_t size() const;
+        virtual QPointF sample(size_t i) const;
+        virtual QRectF boundingRect() const; // of all the samples
+        virtual void setRectOfInterest(const QRectF &rect);
+
+    private:
+        void addPoint(int index);
+
+        QVector<double> x, y;
+        QVector<QVector<int> > minIndex, maxIndex; // level l has blocks of 2^(l+1)
+        QRectF bounds;
+        int pixels;
+
+        QVector<QPointF> points; // what we hand to Qwt
+};
+
+#endif // _GC_MinMaxSeriesData_h
@@ -26,6 +26,11 @@
 #include "Units.h" // for MILES_PER_KM
 
 #include <QWidget>
+#include <limits.h>
+#include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSemaphore>
 
 using namespace Qwt3D; // namespace ref is only visible in this file (is not in any headers)
 
@@ -45,17 +50,20 @@ using namespace Qwt3D; // namespace ref is only visible in this file (is not in
  *
  *----------------------------------------------------------------------*/
 
-// util function to create an x/y key for QHash, effective and quick enough
-static QString xystring(double x, double y) { return QString("%1:%2").arg((int)x).arg((int)y); }
-#if 0
-static void unxystring(QString val, double &x, double &y)
+// the plot asks for a bin by its x/y value, truncated to a whole number
+// as the bins are
+int
+ModelGrid::index(double x, double y) const
 {
-    QRegExp it("^([^:]*):([^:]*)$");
-    it.exactMatch(val);
-    x = it.cap(1).toDouble();
-    y = it.cap(2).toDouble();
+    int bx = (int)x - minx;
+    int by = (int)y - miny;
+    if (bx < 0 || by < 0 || bx % xbin || by % ybin) return -1;
+
+    bx /= xbin;
+    by /= ybin;
+    if (bx >= width || by >= height) return -1;
+    return (by * width) + bx;
 }
-#endif
 
 // returns the color for an xyz point
 class ModelDataColor : public Color
@@ -70,7 +78,8 @@ class ModelDataColor : public Color
 #endif
         {
             QColor cHSV, cRGB;
-            double val = color.value(xystring(x,y), 0.0);
+            int i = grid.index(x,y);
+            double val = (i >= 0 && i < color.count()) ? color[i] : 0.0;
             RGBA colour;
             if (!val) {
                 return RGBA(255,255,255,0); // see thru
@@ -133,8 +142,9 @@ class ModelDataColor : public Color
         }
 
         public:
-            QHash<QString, double> color;
-            QHash<QString, int> num;      // xy map with count of values for averaging
+            ModelGrid grid;
+            QVector<double> color;  // by bin
+            QVector<int> num;       // samples in each bin, 0 for no color
             double min, max;
 
             bool iszones; // if the color value is a zone number
@@ -143,6 +153,14 @@ class ModelDataColor : public Color
 };
 
 
+// the bins a run of samples fell into
+struct ModelBinRange
+{
+    ModelBinRange() : minx(INT_MAX), maxx(INT_MIN), miny(INT_MAX), maxy(INT_MIN), binned(0) {}
+    int minx, maxx, miny, maxy;
+    int binned;
+};
+
 class ModelDataProvider : public Function
 {
     Q_DECLARE_TR_FUNCTIONS(ModelDataProvider)
@@ -156,11 +174,12 @@ class ModelDataProvider : public Function
         double operator () (double x, double y)
         {
             // return the z value for x and y
-            return mz.value(xystring(x,y), 0.0);
+            int i = grid.index(x,y);
+            return (i >= 0 && i < mz.count()) ? mz[i] : 0.0;
         }
         double intervals (double x, double y) // return value for selected intervals
         {
-            return plot.iz.value(xystring(x,y), 0.0)-minz;
+            return plot.intervalz(x,y)-minz;
         }
         double getMinz() { return minz; }
         double getMaxz() { return maxz; }
@@ -173,12 +192,18 @@ class ModelDataProvider : public Function
             plot.inum.clear();
         }
 
-        QHash<QString, double> mz;        // xy map with max z values;
-        QHash<QString, int> mnum;      // xy map with count of values for averaging
+        ModelGrid grid;
+        QVector<double> mz;     // z values by bin, empty if nothing was binned
+        QVector<int> mnum;      // samples in each bin
 
     private:
+        friend class ModelBinner;
 
-        double pointType(const RideFilePoint *, int);
+        void bin(ModelSettings *settings, ModelBinning &binning);
+        void binSamples(const ModelSettings *settings, int from, int to,
+                        int *binx, int *biny, int *cell, ModelBinRange &range);
+
+        double pointType(const RideFilePoint *, int) const;
         QString describeType(int, bool);
         double maxz, minz;
         double cranklength; // used for CPV/AEPF calculation
@@ -187,7 +212,7 @@ class ModelDataProvider : public Function
 };
 
 double
-ModelDataProvider::pointType(const RideFilePoint *point, int type)
+ModelDataProvider::pointType(const RideFilePoint *point, int type) const
 {
     // return the point value for the given type
     switch(type) {
@@ -310,6 +335,150 @@ ModelDataProvider::describeType(int type, bool longer)
     }
 }
 
+// bins a run of samples on a worker thread
+class ModelBinner : public QRunnable
+{
+    public:
+        ModelBinner(ModelDataProvider *provider, const ModelSettings *settings, int from, int to,
+                    int *binx, int *biny, int *cell, QSemaphore *done) :
+            provider(provider), settings(settings), from(from), to(to),
+            binx(binx), biny(biny), cell(cell), done(done) {
+            setAutoDelete(false);
+        }
+
+        void run() {
+            provider->binSamples(settings, from, to, binx, biny, cell, range);
+            done->release();
+        }
+
+        ModelBinRange range;
+
+    private:
+        ModelDataProvider *provider;
+        const ModelSettings *settings;
+        int from, to;
+        int *binx, *biny, *cell; // shared, we only touch [from, to)
+        QSemaphore *done;
+};
+
+void
+ModelDataProvider::binSamples(const ModelSettings *settings, int from, int to,
+                              int *binx, int *biny, int *cell, ModelBinRange &range)
+{
+    // read the columns, building the points here would race the other binners
+    RideFile *ride = settings->ride->ride();
+    RideFileSeries columns[RideFile::none];
+    for (int j=0; j<RideFile::none; j++)
+        columns[j] = ride->series(static_cast<RideFile::SeriesType>(j));
+
+    for (int i=from; i<to; i++) {
+        double values[RideFile::none];
+        for (int j=0; j<RideFile::none; j++)
+            values[j] = columns[j].isEmpty() ? 0 : columns[j][i];
+
+        RideFilePoint sample(values[RideFile::secs], values[RideFile::cad], values[RideFile::hr],
+                             values[RideFile::km], values[RideFile::kph], values[RideFile::nm],
+                             values[RideFile::watts], values[RideFile::alt], values[RideFile::lon],
+                             values[RideFile::lat], values[RideFile::headwind], values[RideFile::slope],
+                             values[RideFile::temp], values[RideFile::lrbalance], (int)values[RideFile::interval]);
+        const RideFilePoint *point = &sample;
+
+        // get x and z bin values - round to nearest bin
+        double dx  = pointType(point, settings->x);
+        int bx = settings->xbin * floor(dx / settings->xbin);
+
+        double dy = pointType(point, settings->y);
+        int by = settings->ybin * floor(dy / settings->ybin);
+
+        cell[i] = -1;
+
+        // ignore zero points
+        if (settings->ignore && (dx==0 || dy==0)) continue;
+
+        // even further ignore 0 for lat/lon
+        if ((settings->y == MODEL_LAT || settings->y == MODEL_LONG) && dy == 0) continue;
+        if ((settings->x == MODEL_LAT || settings->x == MODEL_LONG) && dx == 0) continue;
+
+        binx[i] = bx;
+        biny[i] = by;
+        cell[i] = 0;
+
+        if (bx > range.maxx) range.maxx = bx;
+        if (bx < range.minx) range.minx = bx;
+        if (by > range.maxy) range.maxy = by;
+        if (by < range.miny) range.miny = by;
+        range.binned++;
+    }
+}
+
+// samples binned on each worker thread, it isn't worth it for less
+static const int minBinChunk = 20000;
+
+void
+ModelDataProvider::bin(ModelSettings *settings, ModelBinning &binning)
+{
+    RideFile *ride = settings->ride->ride();
+    int n = ride->samples();
+
+    QVector<int> binx(n), biny(n);
+    binning.cell.resize(n);
+
+    // split the samples between the pool and us, then merge the ranges
+    int chunks = qBound(1, n / minBinChunk, qMax(1, QThread::idealThreadCount()));
+    int size = (n + chunks - 1) / chunks;
+
+    QList<ModelBinner*> workers;
+    QSemaphore finished;
+    ModelBinRange range;
+    for (int from = size; from < n; from += size) {
+        ModelBinner *worker = new ModelBinner(this, settings, from, qMin(from + size, n),
+                                              binx.data(), biny.data(), binning.cell.data(), &finished);
+        workers.append(worker);
+        if (!QThreadPool::globalInstance()->tryStart(worker)) worker->run();
+    }
+    binSamples(settings, 0, qMin(size, n), binx.data(), biny.data(), binning.cell.data(), range);
+    finished.acquire(workers.count());
+
+    foreach (ModelBinner *worker, workers) {
+        range.minx = qMin(range.minx, worker->range.minx);
+        range.maxx = qMax(range.maxx, worker->range.maxx);
+        range.miny = qMin(range.miny, worker->range.miny);
+        range.maxy = qMax(range.maxy, worker->range.maxy);
+        range.binned += worker->range.binned;
+    }
+    qDeleteAll(workers);
+
+    // lay the bins out as a grid
+    ModelGrid &grid = binning.grid;
+    grid = ModelGrid();
+    grid.xbin = settings->xbin;
+    grid.ybin = settings->ybin;
+    if (range.binned) {
+        grid.minx = range.minx;
+        grid.miny = range.miny;
+        grid.width = (range.maxx - range.minx) / grid.xbin + 1;
+        grid.height = (range.maxy - range.miny) / grid.ybin + 1;
+    }
+    for (int i=0; i<n; i++) {
+        if (binning.cell[i] < 0) continue;
+        binning.cell[i] = ((biny[i] - grid.miny) / grid.ybin) * grid.width + (binx[i] - grid.minx) / grid.xbin;
+    }
+
+    // remember what we binned, we watch the ride for changes
+    if (binning.ride != ride) {
+        if (binning.ride) QObject::disconnect(binning.ride, 0, &plot, 0);
+        QObject::connect(ride, SIGNAL(modified()), &plot, SLOT(clearBinning()));
+        QObject::connect(ride, SIGNAL(destroyed()), &plot, SLOT(clearBinning()));
+    }
+    binning.ride = ride;
+    binning.x = settings->x;
+    binning.y = settings->y;
+    binning.xbin = settings->xbin;
+    binning.ybin = settings->ybin;
+    binning.ignore = settings->ignore;
+    binning.binned = range.binned;
+}
+
 /*----------------------------------------------------------------------
  * Setup the data model and plot according to the settings passed from
  * mainwindow.
@@ -340,152 +509,123 @@ ModelDataProvider::ModelDataProvider (BasicModelPlot &plot, ModelSettings *setti
     // if its not setup or no settings exist default to 175mm cranks
     if (cranklength == 0.0) cranklength = 0.175;
 
-    // Run through the ridefile points putting the selected
-    // values into the approprate bins
-    settings->colorProvider->color.clear();
-    settings->colorProvider->num.clear();
-    settings->colorProvider->zonecolor.clear();
+    RideFile *ride = settings->ride->ride();
+    const QVector<RideFilePoint*> &points = ride->dataPoints();
+
+    // Find the bin for each sample, unless the binning we did
+    // last time still applies
+    ModelBinning &binning = plot.binning;
+    if (binning.ride != ride || binning.cell.count() != points.count() ||
+        binning.x != settings->x || binning.y != settings->y ||
+        binning.xbin != settings->xbin || binning.ybin != settings->ybin ||
+        binning.ignore != settings->ignore) {
+        bin(settings, binning);
+    }
+    grid = binning.grid;
+
+    if (binning.binned == 0) {
+
+        // create a null plot -- bin too large!
+        plot.setTitle(tr("No data or bin size too large"));
+        // initialise a null plot
+        setDomain(0,0,0,0);
+        setMinZ(0);
+        setMesh(0,0);
+        mz.clear();
+        settings->colorProvider->color.clear();
+        settings->colorProvider->num.clear();
+        create();
+        return;
+    }
 
     //plot.makeCurrent();
 
-    double maxbinx =-180000, maxbiny =-180000; // was 65535
-    double minbinx =180000, minbiny =180000; // 180000 is the max value (for longitude)
     double mincol =180000, maxcol =-180000;
+    settings->colorProvider->zonecolor.clear();
 
     //
     // Create Plot dataset, filter on values and calculate averages etc
     //
-    foreach(const RideFilePoint *point, settings->ride->ride()->dataPoints()) {
-
-        // get x and z bin values - round to nearest bin
-        double dx  = pointType(point, settings->x);
-        int binx = settings->xbin * floor(dx / settings->xbin);
-
-        double dy = pointType(point, settings->y);
-        int biny = settings->ybin * floor(dy / settings->ybin);
+    // For time the z and color are the sum, otherwise they are the
+    // value of the last sample in the bin.
+    //
+    int cells = grid.cells();
+    double recIntSecs = ride->recIntSecs();
+
+    mz.fill(0.0, cells);
+    mnum.fill(0, cells);
+
+    QVector<double> &colors = settings->colorProvider->color;
+    QVector<int> &colnum = settings->colorProvider->num;
+    settings->colorProvider->grid = grid;
+    colors.fill(0.0, cells);
+    colnum.fill(0, cells);
+
+    plot.iz.clear();
+    plot.inum.clear();
+    if (settings->intervals.count() > 0) {
+        plot.intervals_ = SHOW_INTERVALS;
+        if (settings->frame == true) plot.intervals_ |= SHOW_FRAME;
+        plot.iz.fill(0.0, cells);
+        plot.inum.fill(0, cells);
+    } else {
+        plot.intervals_ = 0;
+    }
 
-        // ignore zero points
-        if (settings->ignore && (dx==0 || dy==0)) continue;
+    for (int i=0; i<points.count(); i++) {
 
-        // even further ignore 0 for lat/lon
-        if ((settings->y == MODEL_LAT || settings->y == MODEL_LONG) && dy == 0) continue;
-        if ((settings->x == MODEL_LAT || settings->x == MODEL_LONG) && dx == 0) continue;
+        int cell = binning.cell[i];
+        if (cell < 0) continue; // ignored
+        const RideFilePoint *point = points[i];
 
         // get z value
         double zed=0;
-        if (settings->z == MODEL_XYTIME) zed = settings->ride->ride()->recIntSecs(); // time at
+        if (settings->z == MODEL_XYTIME) zed = recIntSecs; // time at
         else zed = pointType(point, settings->z); // raw data
 
         // get color value
         double color=0;
-        if (settings->color == MODEL_XYTIME) color = settings->ride->ride()->recIntSecs(); // time at
+        if (settings->color == MODEL_XYTIME) color = recIntSecs; // time at
         else color = pointType(point, settings->color); // raw data
 
         // min max
         if (color > maxcol) maxcol = color;
         if (color < mincol) mincol = color;
-        if (binx > maxbinx) maxbinx = binx;
-        if (binx < minbinx) minbinx = binx;
-        if (biny > maxbiny) maxbiny = biny;
-        if (biny < minbiny) minbiny = biny;
 
-        // How many & Curent Value
         // ZED
-        QString lookup = xystring(binx,biny);
-        int count = mnum.value(lookup, 0.0);
-        double currentz = mz.value(lookup, 0.0);
-
-        if (settings->z == MODEL_XYTIME) {
-            count++;
-            zed += currentz;
-        } else {
-           if (count) zed = ((currentz*count)+zed)/(count+1); // average
-        }
-
-        // always update the max values
-        mz.insert(lookup, zed);
-        mnum.insert(lookup, count);
+        mnum[cell]++;
+        if (settings->z == MODEL_XYTIME) mz[cell] += zed;
+        else mz[cell] = zed;
 
         // NO INTERVALS COLOR IS FOR ALL SAMPLES
         if (settings->intervals.count() == 0 ) {
-            plot.intervals_ = 0;
-
-            int colcount = settings->colorProvider->num.value(lookup, 0.0);
-            double currentcol = settings->colorProvider->color.value(lookup,0.0);
-
-            if (settings->color == MODEL_XYTIME) { // color in time
-                colcount++;
-                color += currentcol;
-            } else { // color in average of
-                if (colcount) color = ((currentcol*colcount)+color)/(colcount+1); // average
-            }
-            settings->colorProvider->color.insert(lookup, color);
-            settings->colorProvider->num.insert(lookup, colcount);
+            colnum[cell]++;
+            if (settings->color == MODEL_XYTIME) colors[cell] += color; // color in time
+            else colors[cell] = color;
+            continue;
         }
 
         // WE HAVE INTERVALS! COLOR AND INTERVAL Z VALUES NEED TO BE TREATED
         // DIFFERENTLY NOW - COLOR IS FOR SELECTED INTERVALS AND WE MAINTAIN
         // A SECOND SET OF Z VALUES SO WE HAVE MAX + INTERVALS
-        if (settings->intervals.count() > 0) {
-            plot.intervals_ = SHOW_INTERVALS;
-            if (settings->frame == true) plot.intervals_ |= SHOW_FRAME;
-
-            QString lookup = xystring(binx, biny); // XXX SEGV on QString in multiple hashes!!!! XXX
-
-            // filter for interval
-            for(int i=0; i<settings->intervals.count(); i++) {
-                IntervalItem *curr = settings->intervals.at(i);
-                if ((point->secs + settings->ride->ride()->recIntSecs()) > curr->start
-                    && point->secs < curr->stop) {
-                    // update colors
-                    int colcount = settings->colorProvider->num.value(lookup,0.0);
-                    double currentcol = settings->colorProvider->color.value(lookup, 0.0);
-
-                    if (settings->color == MODEL_XYTIME) { // color in time
-                        colcount++;
-                        color += currentcol;
-                    } else { // color in average of
-                        if (colcount) color = ((currentcol*colcount)+color)/(colcount+1); // average
-                    }
-                    settings->colorProvider->color.insert(lookup, color);
-                    settings->colorProvider->num.insert(lookup, colcount);
-
-                    double ized=0;
-                    if (settings->z == MODEL_XYTIME) ized = settings->ride->ride()->recIntSecs(); // time at
-                    else ized = pointType(point, settings->z); // raw data
-                    // update interval values
-                    int count = plot.inum.value(lookup, 0.0);
-                    double currentz = plot.iz.value(lookup, 0.0);
-
-                    if (settings->z == MODEL_XYTIME) {
-                        count++;
-                        ized += currentz;
-                    } else {
-                       if (count) ized = ((currentz*count)+ized)/(count+1); // average
-                    }
-
-                    plot.iz.insert(lookup, ized);
-                    plot.inum.insert(lookup, count);
-                    break;
-                }
+        for(int j=0; j<settings->intervals.count(); j++) {
+            IntervalItem *curr = settings->intervals.at(j);
+            if ((point->secs + recIntSecs) > curr->start && point->secs < curr->stop) {
+
+                // update colors
+                colnum[cell]++;
+                if (settings->color == MODEL_XYTIME) colors[cell] += color; // color in time
+                else colors[cell] = color;
+
+                // update interval values
+                plot.inum[cell]++;
+                if (settings->z == MODEL_XYTIME) plot.iz[cell] += zed;
+                else plot.iz[cell] = zed;
+                break;
             }
         }
     }
 
-    if (mz.count() == 0) {
-
-        // create a null plot -- bin too large!
-        plot.setTitle(tr("No data or bin size too large"));
-        // initialise a null plot
-        setDomain(0,0,0,0);
-        setMinZ(0);
-        setMesh(0,0);
-        mz.clear();
-        settings->colorProvider->color.clear();
-        create();
-        return;
-    }
-
     // POST PROCESS DATA SET
 
     // COLOR
@@ -506,23 +646,18 @@ ModelDataProvider::ModelDataProvider (BasicModelPlot &plot, ModelSettings *setti
         }
 
         // iterate over the existing power values converting to a power zone
-        QHashIterator<QString, double> coli(settings->colorProvider->color);
-        while (coli.hasNext()) {
-            coli.next();
-            QString lookup = coli.key();
-            double color = coli.value();
-            // turn into power zone
-            color = zones->whichZone(zone_range, color);
-            // overwrite existing power average with zone number
+        for (int i=0; i<cells; i++) {
+            if (!colnum[i]) continue;
+            // turn into power zone and overwrite the power
             // BUT! the zone numbers start at 1 not 0 here to distinguish
             //      between zone 0 and no value at all
-            settings->colorProvider->color.insert(lookup, color+1);
-
+            colors[i] = zones->whichZone(zone_range, colors[i]) + 1;
         }
         settings->colorProvider->iszones = true;
     } else if (settings->color == MODEL_NONE) {
             settings->colorProvider->iszones = false;
-            settings->colorProvider->color.clear();
+            colors.clear();
+            colnum.clear();
     } else {
         // otherwise just turn off zoning
         settings->colorProvider->iszones = false;
@@ -532,40 +667,26 @@ ModelDataProvider::ModelDataProvider (BasicModelPlot &plot, ModelSettings *setti
     //
     // Convert from absolute values to %age of the entire ride
 
-    double duration = settings->ride->ride()->dataPoints().last()->secs +
-                       settings->ride->ride()->recIntSecs();
+    double duration = points.last()->secs + recIntSecs;
 
     // Multis...
-    if (settings->z == MODEL_XYTIME) {
-        // time on Z axis
-        QHashIterator<QString, double> zi(mz);
-        while (duration && settings->z == MODEL_XYTIME && zi.hasNext()) {
-            zi.next();
-            double timePercent = (zi.value()/duration) * 100;
-            mz.insert(zi.key(), timePercent);
-        }
-    }
-    // Intervals
-    if (settings->z == MODEL_XYTIME) {
+    if (duration && settings->z == MODEL_XYTIME) {
         // time on Z axis
-        QHashIterator<QString, double> ii(plot.iz);
-        while (duration && settings->z == MODEL_XYTIME && ii.hasNext()) {
-            ii.next();
-            double timePercent = (ii.value()/duration) * 100;
-            plot.iz.insert(ii.key(), timePercent);
-        }
+        for (int i=0; i<cells; i++) if (mnum[i]) mz[i] = (mz[i]/duration) * 100;
+
+        // Intervals
+        for (int i=0; i<plot.iz.count(); i++) if (plot.inum[i]) plot.iz[i] = (plot.iz[i]/duration) * 100;
     }
 
         // time on Color
     if (settings->color == MODEL_XYTIME) {
         mincol=65535; maxcol=0;
-        QHashIterator<QString, double> ci(settings->colorProvider->color);
-        while (duration && settings->color == MODEL_XYTIME && ci.hasNext()) {
-            ci.next();
-            double timePercent = (ci.value()/duration) * 100;
+        for (int i=0; duration && i<cells; i++) {
+            if (!colnum[i]) continue;
+            double timePercent = (colors[i]/duration) * 100;
             if (timePercent > maxcol) maxcol = timePercent;
             if (timePercent < mincol) mincol = timePercent;
-            settings->colorProvider->color.insert(ci.key(), timePercent);
+            colors[i] = timePercent;
         }
     }
 
@@ -573,16 +694,13 @@ ModelDataProvider::ModelDataProvider (BasicModelPlot &plot, ModelSettings *setti
     // We DO NOT do the same for color since they represent
     // the entire data set and not just the intervals selected (if any)
     bool first = true;
-    QHashIterator <QString, double> iz(mz);
-    while (iz.hasNext()) {
-        double z;
-        iz.next();
-
-        z = iz.value();
+    for (int i=0; i<cells; i++) {
+        if (!mnum[i]) continue;
+        double z = mz[i];
 
         if (first == true) {
             minz = 0;
-            maxz = iz.value();
+            maxz = z;
         } else {
             if (z > maxz) maxz = z;
             if (z < minz) minz = z;
@@ -627,6 +745,8 @@ ModelDataProvider::ModelDataProvider (BasicModelPlot &plot, ModelSettings *setti
     }
 
     // mesh size
+    double minbinx = grid.minx, maxbinx = grid.minx + (grid.width-1) * grid.xbin;
+    double minbiny = grid.miny, maxbiny = grid.miny + (grid.height-1) * grid.ybin;
     int mx = (maxbinx-minbinx) / settings->xbin;
     int my = (maxbiny-minbiny) / settings->ybin;
 
@@ -861,9 +981,27 @@ BasicModelPlot::BasicModelPlot(MainWindow *parent, ModelSettings *settings) : ma
     updateGL();
 }
 
+void
+BasicModelPlot::clearBinning()
+{
+    // the ride changed or went away, bin it again next time
+    if (binning.ride) disconnect(binning.ride, 0, this, 0);
+    binning.ride = NULL;
+}
+
+double
+BasicModelPlot::intervalz(double x, double y) const
+{
+    int i = binning.grid.index(x,y);
+    return (i >= 0 && i < iz.count()) ? iz[i] : 0.0;
+}
+
 void
 BasicModelPlot::configChanged()
 {
+    // units and crank length change the x/y values
+    clearBinning();
+
     // setColors bg
     QColor rgba = GColor(CPLOTBACKGROUND);
     RGBA bg(rgba.red()/255.0, rgba.green()/255.0, rgba.blue()/255.0, 0);
@@ -1425,7 +1563,7 @@ void Bar::draw(Qwt3D::Triple const& pos)
     // get pos for the interval data
     // call the current data provider
     // which is a global
-    double z =  model->iz.value(xystring(pos.x,pos.y));
+    double z =  model->intervalz(pos.x,pos.y);
     if (z == 0) return;
 
     // do the max bars
@@ -73,6 +73,38 @@ class Water;
 #define SHOW_INTERVALS 1
 #define SHOW_FRAME       2
 
+// the bins as a dense grid, a bin is named by its lowest x and y value
+// and the values for each bin are held in a vector indexed by index()
+class ModelGrid
+{
+    public:
+        ModelGrid() : minx(0), miny(0), xbin(1), ybin(1), width(0), height(0) {}
+
+        int index(double x, double y) const; // -1 if not a bin
+        int cells() const { return width * height; }
+
+        int minx, miny;     // lowest bin on each axis
+        int xbin, ybin;     // bin sizes
+        int width, height;  // bins on each axis
+};
+
+// the bin each sample of a ride falls into for an x and y; it only
+// changes with the ride, the x/y channels or the bin size so it is kept
+// while the user tries different z and color channels
+class ModelBinning
+{
+    public:
+        ModelBinning() : ride(NULL), binned(0) {}
+
+        RideFile *ride;     // NULL when nothing is cached
+        int x, y, xbin, ybin;
+        bool ignore;
+
+        ModelGrid grid;
+        QVector<int> cell;  // index of the bin for each sample, -1 if ignored
+        int binned;         // samples that are in a bin
+};
+
 // the core surface plot
 // qwtplot3d api changes between 0.2.x and 0.3.x
 #if QWT3D_MINOR_VERSION > 2
@@ -104,11 +136,15 @@ class BasicModelPlot : public SurfacePlot
         double diag_;
         int   intervals_;                // SHOW_INTERVALS | SHOW_MAX
         double zpane;
-        QHash<QString, double> iz;         // for selected intervals
-        QHash<QString, double> inum;      // for selected intervals
+        QVector<double> iz;         // for selected intervals, by bin
+        QVector<int> inum;          // for selected intervals, by bin
+        double intervalz(double x, double y) const;
+
+        ModelBinning binning;       // used by the data provider
 
     public slots:
         void configChanged();
+        void clearBinning();
 
     protected:
 
@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2026 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "PMCData.h"
+#include "DBAccess.h"
+#include <math.h>
+
+const QStringList &
+PMCData::metrics()
+{
+    // the choices in the performance manager and ltm charts
+    static QStringList stress = QStringList() << "coggan_tss" << "skiba_bike_score"
+                                              << "daniels_points" << "trimp_points"
+                                              << "trimp_100_points" << "trimp_zonal_points";
+    return stress;
+}
+
+PMCData::PMCData(DBAccess *db, QString metric, int stsDays, int ltsDays) : db(db), metric(metric)
+{
+    init(stsDays, ltsDays);
+}
+
+PMCData::PMCData(int stsDays, int ltsDays) : db(NULL)
+{
+    init(stsDays, ltsDays);
+    loaded = true;
+}
+
+void
+PMCData::init(int stsDays, int ltsDays)
+{
+    ste = exp(-1.0/stsDays);
+    lte = exp(-1.0/ltsDays);
+    stale = 0;
+    loaded = false;
+}
+
+void
+PMCData::addLoad(QDate day, double load)
+{
+    // earlier than anything we have so far
+    if (first.isValid() && day < first) {
+        loads.insert(0, first.daysTo(day) * -1, 0.0);
+        first = day;
+        stale = 0;
+    }
+    if (!first.isValid()) first = day;
+
+    int index = first.daysTo(day);
+    while (loads.count() <= index) loads.append(0.0);
+    loads[index] += load;
+    if (index < stale) stale = index;
+}
+
+void
+PMCData::invalidate(QDate day)
+{
+    if (!db || !loaded) return; // will be read when needed
+    if (!reload.isValid() || day < reload) reload = day;
+}
+
+void
+PMCData::refresh()
+{
+    if (db && (!loaded || reload.isValid())) {
+
+        QDate from = reload;
+        if (!loaded || !first.isValid() || from <= first) {
+
+            // from scratch
+            loads.clear();
+            first = QDate();
+            from = QDate();
+            stale = 0;
+
+        } else {
+
+            // drop the load from the day that changed on
+            if (first.daysTo(from) < loads.count()) loads.resize(first.daysTo(from));
+            if (stale > loads.count()) stale = loads.count();
+        }
+
+        QList<QPair<QDate,double> > days = db->getDailyLoad(metric, from);
+        for (int i=0; i<days.count(); i++) addLoad(days[i].first, days[i].second);
+
+        loaded = true;
+        reload = QDate();
+    }
+
+    // the recurrence from the first stale day
+    int n = loads.count();
+    stsvalues.resize(n);
+    ltsvalues.resize(n);
+    if (stale < n) {
+        for (int i=stale; i<n; i++) {
+            double lastSTS = i ? stsvalues[i-1] : 0.0;
+            double lastLTS = i ? ltsvalues[i-1] : 0.0;
+            stsvalues[i] = (loads[i] * (1.0 - ste)) + (lastSTS * ste);
+            ltsvalues[i] = (loads[i] * (1.0 - lte)) + (lastLTS * lte);
+        }
+    }
+    stale = n;
+}
+
+bool
+PMCData::isEmpty()
+{
+    refresh();
+    return loads.isEmpty();
+}
+
+QDate
+PMCData::firstDay()
+{
+    refresh();
+    return first;
+}
+
+QDate
+PMCData::lastDay()
+{
+    refresh();
+    return loads.isEmpty() ? QDate() : first.addDays(loads.count()-1);
+}
+
+double
+PMCData::load(QDate day)
+{
+    refresh();
+    if (loads.isEmpty() || day < first) return 0.0;
+
+    int index = first.daysTo(day);
+    return index < loads.count() ? loads[index] : 0.0;
+}
+
+double
+PMCData::sts(QDate day)
+{
+    refresh();
+    if (loads.isEmpty() || day < first) return 0.0;
+
+    int index = first.daysTo(day), last = loads.count()-1;
+    return index <= last ? stsvalues[index] : stsvalues[last] * pow(ste, index-last);
+}
+
+double
+PMCData::lts(QDate day)
+{
+    refresh();
+    if (loads.isEmpty() || day < first) return 0.0;
+
+    int index = first.daysTo(day), last = loads.count()-1;
+    return index <= last ? ltsvalues[index] : ltsvalues[last] * pow(lte, index-last);
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2026 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_PMCData_h
+#define _GC_PMCData_h 1
+#include "GoldenCheetah.h"
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QDate>
+
+class DBAccess;
+
+// The daily load for a stress metric and the short and long term stress
+// that follows from it. The recurrence is linear, so the values held here
+// start from zero stress on the first day with a load and StressCalculator
+// adds the decay of whatever initial stress the user has configured.
+//
+// When the daily load comes from the db it is kept up to date by telling
+// us the earliest day that changed; only the load from that day is read
+// back and only the stress from that day on is recomputed.
+class PMCData
+{
+    public:
+
+        // the stress metrics the db keeps a daily load for
+        static const QStringList &metrics();
+
+        // daily load from the db
+        PMCData(DBAccess *db, QString metric, int stsDays, int ltsDays);
+
+        // daily load added with addLoad(), e.g. for a filtered set of rides
+        PMCData(int stsDays, int ltsDays);
+
+        void addLoad(QDate day, double load);
+        void invalidate(QDate day); // the load changed on this day
+
+        // days with a load
+        bool isEmpty();
+        QDate firstDay();
+        QDate lastDay();
+
+        // before the first day they are 0, after the last they decay
+        double load(QDate day);
+        double sts(QDate day);
+        double lts(QDate day);
+
+    private:
+        void init(int stsDays, int ltsDays);
+        void refresh();
+
+        DBAccess *db;
+        QString metric;
+        double ste, lte;
+
+        QDate first;
+        QVector<double> loads, stsvalues, ltsvalues;
+        int stale;          // stress needs recomputing from here
+        bool loaded;        // read from the db
+        QDate reload;       // load needs reading again from here
+};
+
+#endif // _GC_PMCData_h
@@ -167,6 +167,25 @@ GeneralPage::GeneralPage(MainWindow *main) : main(main)
     
     configLayout->addWidget(hystlabel, 7,0, Qt::AlignRight);
     configLayout->addWidget(hystedit, 7,1, Qt::AlignLeft);
+
+    // memory for open rides, the least recently used are closed
+    // when it runs out. 0 means no limit
+    QVariant rideMemory = appsettings->value(this, GC_RIDE_MEMORY, 512);
+    QLabel *rideMemoryLabel = new QLabel(tr("Memory for open rides (MB):"));
+    rideMemoryEdit = new QLineEdit(rideMemory.toString(),this);
+    rideMemoryEdit->setInputMask("00009");
+
+    configLayout->addWidget(rideMemoryLabel, 8,0, Qt::AlignRight);
+    configLayout->addWidget(rideMemoryEdit, 8,1, Qt::AlignLeft);
+
+    // rides read ahead either side of the one selected, 0 is off
+    QVariant prefetch = appsettings->value(this, GC_PREFETCH, 2);
+    QLabel *prefetchLabel = new QLabel(tr("Rides to read ahead:"));
+    prefetchEdit = new QLineEdit(prefetch.toString(),this);
+    prefetchEdit->setInputMask("09");
+
+    configLayout->addWidget(prefetchLabel, 6,0, Qt::AlignRight);
+    configLayout->addWidget(prefetchEdit, 6,1, Qt::AlignLeft);
     
     //
     // Performance manager
@@ -226,6 +245,8 @@ GeneralPage::saveClicked()
 
     // Garmon and cranks
     appsettings->setValue(GC_GARMIN_HWMARK, garminHWMarkedit->text().toInt());
+    appsettings->setValue(GC_RIDE_MEMORY, rideMemoryEdit->text().toInt());
+    appsettings->setValue(GC_PREFETCH, prefetchEdit->text().toInt());
     appsettings->setValue(GC_GARMIN_SMARTRECORD, garminSmartRecord->checkState());
     appsettings->setValue(GC_CRANKLENGTH, crankLengthCombo->currentText());
 
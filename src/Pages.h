@@ -72,6 +72,8 @@ class GeneralPage : public QWidget
         QCheckBox *garminSmartRecord;
         QLineEdit *garminHWMarkedit;
         QLineEdit *hystedit;
+        QLineEdit *rideMemoryEdit;
+        QLineEdit *prefetchEdit;
         QLineEdit *workoutDirectory;
         QPushButton *workoutBrowseButton;
 
@@ -17,7 +17,6 @@
  */
 
 #include "RideMetric.h"
-#include "BestIntervalDialog.h"
 #include "Zones.h"
 #include <math.h>
 #include <QApplication>
@@ -39,14 +38,9 @@ class PeakPower : public RideMetric {
                  const QHash<QString,RideMetric*> &,
                  const MainWindow *) {
 
-        if (!ride->dataPoints().isEmpty()) {
-            QList<BestIntervalDialog::BestInterval> results;
-            BestIntervalDialog::findBests(ride, secs, 1, results);
-            if (results.count() > 0 && results.first().avg < 3000) watts = results.first().avg;
-            else watts = 0.0;
-        } else {
-            watts = 0.0;
-        }
+        RideFilePeak peak = ride->peakPower(secs);
+        if (!peak.isEmpty() && peak.avg < 3000) watts = peak.avg;
+        else watts = 0.0;
         setValue(watts);
     }
     RideMetric *clone() const { return new PeakPower(*this); }
@@ -272,21 +266,17 @@ class PeakPowerHr : public RideMetric {
     void compute(const RideFile *ride, const Zones *, int, const HrZones *, int,
                  const QHash<QString,RideMetric*> &, const MainWindow *) {
 
-        if (!ride->dataPoints().isEmpty()){
-            QList<BestIntervalDialog::BestInterval> results;
-            BestIntervalDialog::findBests(ride, secs, 1, results);
-            if (results.count() > 0) {
-                double start = results.first().start;
-                double stop = results.first().stop;
-                int points = 0;
-
-                foreach(const RideFilePoint *point, ride->dataPoints()) {
-                    if (point->secs >= start && point->secs < stop) {
-                        points++;
-                        hr = (point->hr + (points-1)*hr) / (points);
-                    }
-                }
-            }
+        // average hr over the peak power window
+        RideFilePeak peak = ride->peakPower(secs);
+        if (!peak.isEmpty()) {
+            RideFileSeries times = ride->series(RideFile::secs);
+            RideFileSeries hrs = ride->series(RideFile::hr);
+            double total = 0;
+            int points = 0;
+
+            for (int i=peak.first; i<times.count && times[i] < peak.stop; i++, points++)
+                if (!hrs.isEmpty()) total += hrs[i];
+            hr = points ? total / points : 0;
         } else {
             hr = 0;
         }
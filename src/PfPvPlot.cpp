@@ -25,6 +25,7 @@
 #include "Settings.h"
 #include "Zones.h"
 #include "Colors.h"
+#include "RideFileCache.h"
 
 #include <math.h>
 #include <assert.h>
@@ -33,6 +34,9 @@
 #include <qwt_plot_canvas.h>
 #include <qwt_plot_curve.h>
 #include <qwt_plot_marker.h>
+#include <qwt_plot_spectrogram.h>
+#include <qwt_matrix_raster_data.h>
+#include <qwt_color_map.h>
 #include <qwt_scale_draw.h>
 #include <qwt_symbol.h>
 #include <set>
@@ -118,7 +122,8 @@ public:
 
 
 PfPvPlot::PfPvPlot(MainWindow *mainWindow)
-    : rideItem (NULL), mainWindow(mainWindow), cp_ (0), cad_ (85), cl_ (0.175), shade_zones(true)
+    : rideItem (NULL), mainWindow(mainWindow), histogramCL(0.175), cp_ (0), cad_ (85), cl_ (0.175),
+      shade_zones(true), density_(false)
 {
     setInstanceName("PfPv Plot");
 
@@ -153,6 +158,12 @@ PfPvPlot::PfPvPlot(MainWindow *mainWindow)
     curve = new QwtPlotCurve();
     curve->attach(this);
 
+    // above the zone shading, below the markers and intervals
+    densityMap = new QwtPlotSpectrogram();
+    densityMap->setZ(2);
+    densityMap->setVisible(false);
+    densityMap->attach(this);
+
     cl_ = appsettings->value(this, GC_CRANKLENGTH).toDouble() / 1000.0;
 
     // markup timeInQuadrant
@@ -206,6 +217,11 @@ PfPvPlot::configChanged()
     mY->setLinePen(marker);
     cpCurve->setPen(cp);
 
+    // cells with the least time blend into the background
+    QwtLinearColorMap *colors = new QwtLinearColorMap(GColor(CPLOTBACKGROUND), GColor(CPOWER));
+    colors->addColorStop(0.05, GColor(CCADENCE));
+    densityMap->setColorMap(colors);
+
     setCL(appsettings->value(this, GC_CRANKLENGTH).toDouble() / 1000.0);
 }
 
@@ -358,6 +374,36 @@ PfPvPlot::setData(RideItem *_rideItem)
     rideItem = _rideItem;
     RideFile *ride = rideItem->ride();
 
+    if (ride && density_) {
+
+        // the histogram comes from the ride cache unless the ride
+        // has been edited and not saved, the cache is of the file
+        if (!rideItem->isDirty()) {
+            RideFileCache cache(mainWindow, mainWindow->home.absolutePath() + "/" + rideItem->fileName, ride);
+            histogram = cache.pfpvArray();
+            histogramCL = RideFileCache::crankLength();
+        } else histogram.clear();
+
+        // edited and not saved, or the cache couldn't be written
+        if (histogram.isEmpty()) {
+            QVector<float> cells;
+            RideFileCache::computePfPv(cells, ride, cl_);
+            histogram.resize(cells.size());
+            for (int i=0; i<cells.size(); i++) histogram[i] = cells[i];
+            histogramCL = cl_;
+        }
+
+        curve->setVisible(false);
+        setDensityMap();
+        setCAD(histogramCadence());
+        refreshZoneItems();
+        replot();
+        return;
+    }
+
+    histogram.clear();
+    densityMap->setVisible(false);
+
     if (ride) {
 
         // quickly erase old data
@@ -432,6 +478,88 @@ PfPvPlot::setData(RideItem *_rideItem)
     replot();
 }
 
+void
+PfPvPlot::setData(RideFileCache *cache)
+{
+    // clear out any interval curves which are presently defined
+    foreach (QwtPlotCurve *curve, intervalCurves) {
+        curve->detach();
+        delete curve;
+    }
+    intervalCurves.clear();
+
+    // a date range is always a density map
+    rideItem = NULL;
+    density_ = true;
+    histogram = cache ? cache->pfpvArray() : QVector<double>();
+    histogramCL = RideFileCache::crankLength();
+
+    curve->setVisible(false);
+    setDensityMap();
+    setCAD(histogramCadence());
+    refreshZoneItems();
+    replot();
+}
+
+void
+PfPvPlot::setDensityMap()
+{
+    // shaded on a square root scale so the odd hard effort still
+    // shows next to hours of steady riding, empty cells are NaN
+    // which the color map leaves transparent
+    int rows = histogram.size() / pfpvColumns;
+    QVector<double> values(rows * pfpvColumns);
+    double max = 0;
+    for (int i=0; i<values.size(); i++) {
+        if (histogram[i] > 0) {
+            values[i] = sqrt(histogram[i]);
+            if (values[i] > max) max = values[i];
+        } else {
+            values[i] = qQNaN();
+        }
+    }
+
+    // the cells stretch when the crank length isn't the one we binned
+    // with, CPV goes up with crank length and AEPF comes down
+    double scale = cl_ ? cl_ / histogramCL : 1.0;
+
+    QwtMatrixRasterData *data = new QwtMatrixRasterData;
+    data->setValueMatrix(values, pfpvColumns);
+    data->setInterval(Qt::XAxis, QwtInterval(0, pfpvColumns * pfpvCPVBinSize * scale));
+    data->setInterval(Qt::YAxis, QwtInterval(0, rows * pfpvAEPFBinSize / scale));
+    data->setInterval(Qt::ZAxis, QwtInterval(0, max ? max : 1));
+    densityMap->setData(data);
+    densityMap->setVisible(rows > 0);
+}
+
+// mean cadence over the histogram, cadence doesn't
+// depend upon crank length so it is the same cell to cell
+int
+PfPvPlot::histogramCadence() const
+{
+    double secs = 0, total = 0;
+    for (int i=0; i<histogram.size(); i++) {
+        if (histogram[i] <= 0) continue;
+        double cpv = ((i % pfpvColumns) + 0.5) * pfpvCPVBinSize;
+        total += histogram[i] * (cpv * 60.0) / (histogramCL * 2.0 * PI);
+        secs += histogram[i];
+    }
+    return secs ? total / secs : 0;
+}
+
+void
+PfPvPlot::setDensity(bool value)
+{
+    if (density_ == value) return;
+    density_ = value;
+
+    // rebuild from the ride, which will also show or hide the scatter
+    if (rideItem) {
+        setData(rideItem);
+        showIntervals(rideItem);
+    }
+}
+
 void
 PfPvPlot::showIntervals(RideItem *_rideItem)
 {
@@ -582,16 +710,34 @@ PfPvPlot::recalc()
     maxAEPF = 600;
     maxCPV = 3;
 
+    // the cells stretch with the crank length, see setDensityMap()
+    double scale = cl_ ? cl_ / histogramCL : 1.0;
+
     RideFile *ride;
-    if (rideItem && (ride=rideItem->ride())) {
+    if (density_) {
+
+        // the top and right of the cells with any time in them
+        for (int i=0; i<histogram.size(); i++) {
+            if (histogram[i] <= 0) continue;
+
+            double aepf = ((i / pfpvColumns) + 1) * pfpvAEPFBinSize / scale;
+            double cpv = ((i % pfpvColumns) + 1) * pfpvCPVBinSize * scale;
+
+            if (aepf > maxAEPF) maxAEPF = aepf;
+            if (cpv > maxCPV) maxCPV = cpv;
+        }
+
+    } else if (rideItem && (ride=rideItem->ride())) {
 
         // calculate maximums
-        foreach(const RideFilePoint *p1, ride->dataPoints()) {
+        RideFileSeries watts = ride->series(RideFile::watts);
+        RideFileSeries cad = ride->series(RideFile::cad);
+        for (int i=0; i<watts.count && i<cad.count; i++) {
 
-            if (p1->watts != 0 && p1->cad != 0) {
+            if (watts[i] != 0 && cad[i] != 0) {
 
-                double aepf = (p1->watts * 60.0) / (p1->cad * cl_ * 2.0 * PI);
-                double cpv = (p1->cad * cl_ * 2.0 * PI) / 60.0;
+                double aepf = (watts[i] * 60.0) / (cad[i] * cl_ * 2.0 * PI);
+                double cpv = (cad[i] * cl_ * 2.0 * PI) / 60.0;
 
                 if (aepf > maxAEPF) maxAEPF = aepf;
                 if (cpv > maxCPV) maxCPV = cpv;
@@ -641,25 +787,45 @@ PfPvPlot::recalc()
     mY->setYValue(aepf);
 
     // watch out for null rides
-    if (rideItem && (ride=rideItem->ride())) {
+    if (density_ || (rideItem && (ride=rideItem->ride()))) {
 
         timeInQuadrant[0]=
         timeInQuadrant[1]=
         timeInQuadrant[2]=
         timeInQuadrant[3]= 0.0;
 
-        foreach(const RideFilePoint *p1, ride->dataPoints()) {
-            if (p1->watts != 0 && p1->cad != 0) {
+        if (density_) {
+
+            // each cell goes in the quadrant its centre is in
+            for (int i=0; i<histogram.size(); i++) {
+                if (histogram[i] <= 0) continue;
 
-                double aepf_ = (p1->watts * 60.0) / (p1->cad * cl_ * 2.0 * PI);
-                double cpv_ = (p1->cad * cl_ * 2.0 * PI) / 60.0;
+                double aepf_ = ((i / pfpvColumns) + 0.5) * pfpvAEPFBinSize / scale;
+                double cpv_ = ((i % pfpvColumns) + 0.5) * pfpvCPVBinSize * scale;
 
-                // classic QA quadrants I II III and IV
-                if (aepf_ > aepf && cpv_ > cpv) timeInQuadrant[0] += ride->recIntSecs();
-                else if (aepf_ > aepf && cpv_ <= cpv) timeInQuadrant[1] += ride->recIntSecs();
-                else if (aepf_ <= aepf && cpv_ <= cpv) timeInQuadrant[2] += ride->recIntSecs();
-                else if (aepf_ <= aepf && cpv_ > cpv) timeInQuadrant[3] += ride->recIntSecs();
+                if (aepf_ > aepf && cpv_ > cpv) timeInQuadrant[0] += histogram[i];
+                else if (aepf_ > aepf && cpv_ <= cpv) timeInQuadrant[1] += histogram[i];
+                else if (aepf_ <= aepf && cpv_ <= cpv) timeInQuadrant[2] += histogram[i];
+                else if (aepf_ <= aepf && cpv_ > cpv) timeInQuadrant[3] += histogram[i];
+            }
+
+        } else {
+
+            RideFileSeries watts = ride->series(RideFile::watts);
+            RideFileSeries cad = ride->series(RideFile::cad);
+            for (int i=0; i<watts.count && i<cad.count; i++) {
+                if (watts[i] != 0 && cad[i] != 0) {
 
+                    double aepf_ = (watts[i] * 60.0) / (cad[i] * cl_ * 2.0 * PI);
+                    double cpv_ = (cad[i] * cl_ * 2.0 * PI) / 60.0;
+
+                    // classic QA quadrants I II III and IV
+                    if (aepf_ > aepf && cpv_ > cpv) timeInQuadrant[0] += ride->recIntSecs();
+                    else if (aepf_ > aepf && cpv_ <= cpv) timeInQuadrant[1] += ride->recIntSecs();
+                    else if (aepf_ <= aepf && cpv_ <= cpv) timeInQuadrant[2] += ride->recIntSecs();
+                    else if (aepf_ <= aepf && cpv_ > cpv) timeInQuadrant[3] += ride->recIntSecs();
+
+                }
             }
         }
         double totaltime = timeInQuadrant[0] + timeInQuadrant[1] + timeInQuadrant[2] + timeInQuadrant[3] ;
@@ -750,6 +916,7 @@ void
 PfPvPlot::setCL(double cranklen)
 {
     cl_ = cranklen;
+    if (density_) setDensityMap();
     recalc();
     emit changedCL( QString("%1").arg(cranklen) );
 }
@@ -31,6 +31,8 @@ class RideItem;
 class RideFilePoint;
 class QwtPlotCurve;
 class QwtPlotMarker;
+class QwtPlotSpectrogram;
+class RideFileCache;
 class MainWindow;
 class PfPvPlotZoneLabel;
 
@@ -45,6 +47,7 @@ class PfPvPlot : public QwtPlot
         PfPvPlot(MainWindow *mainWindow);
         void refreshZoneItems();
         void setData(RideItem *_rideItem);
+        void setData(RideFileCache *cache); // density over a date range
         void showIntervals(RideItem *_rideItem);
 
         int getCP();
@@ -69,6 +72,8 @@ class PfPvPlot : public QwtPlot
         void setMergeIntervals(bool value);
         bool frameIntervals() const { return frame_intervals; }
         void setFrameIntervals(bool value);
+        bool density() const { return density_; }
+        void setDensity(bool value);
         void setAxisTitle(int axis, QString label);
 
     public slots:
@@ -81,6 +86,8 @@ class PfPvPlot : public QwtPlot
 
     protected:
         int intervalCount() const;
+        void setDensityMap();
+        int histogramCadence() const;
 
         MainWindow *mainWindow;
         QwtPlotCurve *curve;
@@ -91,11 +98,18 @@ class PfPvPlot : public QwtPlot
         QwtPlotMarker *mX;
         QwtPlotMarker *mY;
 
+        // density mode shows time spent in each cell of the PfPv
+        // histogram kept in the ride cache, rather than every sample
+        QwtPlotSpectrogram *densityMap;
+        QVector<double> histogram;  // seconds, see RideFileCache.h
+        double histogramCL;         // crank length it was binned with
+
         int cp_;
         int cad_;
         double cl_;
         bool shade_zones;    // whether to shade zones, added 27Apr2009 djconnel
         bool merge_intervals, frame_intervals;
+        bool density_;
 
         double timeInQuadrant[4]; // time in seconds spent in each quadrant
         QwtPlotMarker *tiqMarker[4]; // time in seconds spent in each quadrant
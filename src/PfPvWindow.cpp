@@ -20,12 +20,14 @@
 #include "MainWindow.h"
 #include "PfPvPlot.h"
 #include "RideItem.h"
+#include "RideFileCache.h"
 #include "Settings.h"
 #include "Colors.h"
 #include <QtGui>
 
-PfPvWindow::PfPvWindow(MainWindow *mainWindow) :
-    GcWindow(mainWindow), mainWindow(mainWindow), current(NULL)
+PfPvWindow::PfPvWindow(MainWindow *mainWindow, bool rangemode) :
+    GcWindow(mainWindow), mainWindow(mainWindow), current(NULL),
+    rangemode(rangemode), stale(true), source(NULL)
 {
     setInstanceName("Pf/Pv Window");
 
@@ -84,8 +86,21 @@ PfPvWindow::PfPvWindow(MainWindow *mainWindow) :
     frameIntervalPfPvCheckBox->setText(tr("Frame intervals"));
     frameIntervalPfPvCheckBox->setCheckState(Qt::Checked);
     cl->addWidget(frameIntervalPfPvCheckBox);
+
+    densityPfPvCheckBox = new QCheckBox;
+    densityPfPvCheckBox->setText(tr("Density map"));
+    densityPfPvCheckBox->setCheckState(Qt::Unchecked);
+    cl->addWidget(densityPfPvCheckBox);
     cl->addStretch();
 
+    // a date range is only ever a density map and has no intervals
+    if (rangemode) {
+        densityPfPvCheckBox->setCheckState(Qt::Checked);
+        densityPfPvCheckBox->hide();
+        mergeIntervalPfPvCheckBox->hide();
+        frameIntervalPfPvCheckBox->hide();
+    }
+
     connect(pfPvPlot, SIGNAL(changedCP(const QString&)),
             qaCPValue, SLOT(setText(const QString&)) );
     connect(pfPvPlot, SIGNAL(changedCAD(const QString&)),
@@ -104,14 +119,53 @@ PfPvWindow::PfPvWindow(MainWindow *mainWindow) :
                 this, SLOT(setMergeIntervalsPfPvFromCheckBox()));
     connect(frameIntervalPfPvCheckBox, SIGNAL(stateChanged(int)),
                 this, SLOT(setFrameIntervalsPfPvFromCheckBox()));
+    connect(densityPfPvCheckBox, SIGNAL(stateChanged(int)),
+                this, SLOT(setDensityPfPvFromCheckBox()));
     //connect(mainWindow, SIGNAL(rideSelected()), this, SLOT(rideSelected()));
-    connect(this, SIGNAL(rideItemChanged(RideItem*)), this, SLOT(rideSelected()));
-    connect(mainWindow, SIGNAL(intervalSelected()), this, SLOT(intervalSelected()));
-    connect(mainWindow, SIGNAL(intervalsChanged()), this, SLOT(intervalSelected()));
+    if (rangemode) {
+        connect(this, SIGNAL(dateRangeChanged(DateRange)), this, SLOT(dateRangeChanged(DateRange)));
+        connect(mainWindow, SIGNAL(rideAdded(RideItem*)), this, SLOT(rideAddorRemove(RideItem*)));
+        connect(mainWindow, SIGNAL(rideDeleted(RideItem*)), this, SLOT(rideAddorRemove(RideItem*)));
+    } else {
+        connect(this, SIGNAL(rideItemChanged(RideItem*)), this, SLOT(rideSelected()));
+        connect(mainWindow, SIGNAL(intervalSelected()), this, SLOT(intervalSelected()));
+        connect(mainWindow, SIGNAL(intervalsChanged()), this, SLOT(intervalSelected()));
+    }
     connect(mainWindow, SIGNAL(zonesChanged()), this, SLOT(zonesChanged()));
     connect(mainWindow, SIGNAL(configChanged()), pfPvPlot, SLOT(configChanged()));
 }
 
+PfPvWindow::~PfPvWindow()
+{
+    if (source) delete source;
+}
+
+void
+PfPvWindow::rideAddorRemove(RideItem *)
+{
+    stale = true;
+}
+
+void
+PfPvWindow::dateRangeChanged(DateRange dateRange)
+{
+    // has it changed?
+    if (dateRange.from != cfrom || dateRange.to != cto)
+        stale = true;
+
+    if (!amVisible() || !stale) return;
+
+    // sum the histograms in the ride caches for the range
+    RideFileCache *old = source;
+    source = new RideFileCache(mainWindow, dateRange.from, dateRange.to);
+    cfrom = dateRange.from;
+    cto = dateRange.to;
+    stale = false;
+    if (old) delete old;
+
+    pfPvPlot->setData(source);
+}
+
 void
 PfPvWindow::rideSelected()
 {
@@ -172,6 +226,14 @@ PfPvWindow::setFrameIntervalsPfPvFromCheckBox()
     }
 }
 
+void
+PfPvWindow::setDensityPfPvFromCheckBox()
+{
+    if (pfPvPlot->density() != densityPfPvCheckBox->isChecked()) {
+        pfPvPlot->setDensity(densityPfPvCheckBox->isChecked());
+    }
+}
+
 void
 PfPvWindow::setQaCPFromLineEdit()
 {
@@ -26,6 +26,7 @@
 class MainWindow;
 class PfPvPlot;
 class RideItem;
+class RideFileCache;
 
 class PfPvWindow : public GcWindow
 {
@@ -38,10 +39,12 @@ class PfPvWindow : public GcWindow
     Q_PROPERTY(bool shade READ shade WRITE setShade USER true)
     Q_PROPERTY(bool merge READ merge WRITE setMerge USER true)
     Q_PROPERTY(bool frame READ frame WRITE setFrame USER true)
+    Q_PROPERTY(bool density READ density WRITE setDensity USER true)
 
     public:
 
-        PfPvWindow(MainWindow *mainWindow);
+        PfPvWindow(MainWindow *mainWindow, bool rangemode = false);
+        ~PfPvWindow();
 
         // get/set properties
         QString watts() const { return qaCPValue->text(); }
@@ -56,12 +59,16 @@ class PfPvWindow : public GcWindow
         void setMerge(bool x) { mergeIntervalPfPvCheckBox->setChecked(x); }
         bool frame() const { return frameIntervalPfPvCheckBox->isChecked(); }
         void setFrame(bool x) { frameIntervalPfPvCheckBox->setChecked(x); }
+        bool density() const { return densityPfPvCheckBox->isChecked(); }
+        void setDensity(bool x) { densityPfPvCheckBox->setChecked(x); }
 
     public slots:
 
         void rideSelected();
         void intervalSelected();
         void zonesChanged();
+        void dateRangeChanged(DateRange);
+        void rideAddorRemove(RideItem*);
 
     protected slots:
 
@@ -71,6 +78,7 @@ class PfPvWindow : public GcWindow
         void setShadeZonesPfPvFromCheckBox();
         void setMergeIntervalsPfPvFromCheckBox();
         void setFrameIntervalsPfPvFromCheckBox();
+        void setDensityPfPvFromCheckBox();
 
     protected:
 
@@ -80,10 +88,16 @@ class PfPvWindow : public GcWindow
         QCheckBox *shadeZonesPfPvCheckBox;
         QCheckBox *mergeIntervalPfPvCheckBox;
         QCheckBox *frameIntervalPfPvCheckBox;
+        QCheckBox *densityPfPvCheckBox;
         QLineEdit *qaCPValue;
         QLineEdit *qaCadValue;
         QLineEdit *qaClValue;
         RideItem *current;
+
+        // date range mode sums the ride caches
+        bool rangemode, stale;
+        QDate cfrom, cto;
+        RideFileCache *source;
 };
 
 #endif // _GC_PfPvWindow_h
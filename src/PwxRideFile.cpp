@@ -18,7 +18,9 @@
 
 #include "PwxRideFile.h"
 #include "Settings.h"
+#include "XmlUtils.h"
 #include <QDomDocument>
+#include <QXmlStreamReader>
 #include <QVector>
 #include <assert.h>
 
@@ -31,29 +33,52 @@ static int pwxFileReaderRegistered =
 RideFile *
 PwxFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*) const
 {
-    QDomDocument doc("TrainingPeaks PWX");
     if (!file.open(QIODevice::ReadOnly)) {
         errors << "Could not open file.";
         return NULL;
     }
 
-    bool parsed = doc.setContent(&file);
+    QXmlStreamReader xml(&file);
+    RideFile *rideFile = PwxFromStream(xml, errors);
     file.close();
-    if (!parsed) {
-        errors << "Could not parse file.";
-        return NULL;
-    }
-
-    return PwxFromDomDoc(doc, errors);
+    return rideFile;
 }
 
 RideFile *
 PwxFileReader::PwxFromDomDoc(QDomDocument doc, QStringList &errors) const
 {
+    // downloads arrive as a document, we read it back the same way
+    QXmlStreamReader xml(doc.toByteArray());
+    return PwxFromStream(xml, errors);
+}
+
+// the text of a simple element, nested elements are skipped
+static QString
+pwxText(QXmlStreamReader &xml)
+{
+    return xml.readElementText(QXmlStreamReader::SkipChildElements);
+}
+
+RideFile *
+PwxFileReader::PwxFromStream(QXmlStreamReader &xml, QStringList &errors) const
+{
+    // <pwx><workout> ...
+    bool workout = false;
+    if (xml.readNextStartElement() && xml.name() == QLatin1String("pwx")) {
+        while (xml.readNextStartElement()) {
+            if (xml.name() == QLatin1String("workout")) {
+                workout = true;
+                break;
+            }
+            xml.skipCurrentElement();
+        }
+    }
+    if (!workout) {
+        errors << "Could not parse file.";
+        return NULL;
+    }
+
     RideFile *rideFile = new RideFile();
-    QDomElement root = doc.documentElement();
-    QDomNode workout = root.firstChildElement("workout");
-    QDomNode node = workout.firstChild();
 
     // can arrive at any time, so lets cache them
     // and sort out at the end
@@ -67,161 +92,143 @@ PwxFileReader::PwxFromDomDoc(QDomDocument doc, QStringList &errors) const
     double rtime = 0;
     double rdist = 0;
 
-    while (!node.isNull()) {
+    // sample values are converted from here, so it's only allocated once
+    QString scratch;
+    scratch.reserve(32);
 
-        // athlete
-        if (node.nodeName() == "athlete") {
+    while (xml.readNextStartElement()) {
 
-            QDomElement name = node.firstChildElement("name");
-            if (!name.isNull()) {
-                rideFile->setTag("Athlete Name", name.text());
-            }
+        // athlete
+        if (xml.name() == QLatin1String("athlete")) {
 
-            QDomElement weight = node.firstChildElement("weight");
-            if (!weight.isNull()) {
-                rideFile->setTag("Weight", weight.text());
+            while (xml.readNextStartElement()) {
+                if (xml.name() == QLatin1String("name")) rideFile->setTag("Athlete Name", pwxText(xml));
+                else if (xml.name() == QLatin1String("weight")) rideFile->setTag("Weight", pwxText(xml));
+                else xml.skipCurrentElement();
             }
 
         // workout code
-        } else if (node.nodeName() == "code") {
+        } else if (xml.name() == QLatin1String("code")) {
 
-            QDomElement code = node.toElement();
-            rideFile->setTag("Workout Code", code.text());
+            rideFile->setTag("Workout Code", pwxText(xml));
 
         // goal / objective
-        } else if (node.nodeName() == "goal") {
+        } else if (xml.name() == QLatin1String("goal")) {
 
-            QDomElement goal = node.toElement();
-            rideFile->setTag("Objective", goal.text());
+            rideFile->setTag("Objective", pwxText(xml));
 
         // sport
-        } else if (node.nodeName() == "sportType") {
+        } else if (xml.name() == QLatin1String("sportType")) {
 
-            QDomElement sport = node.toElement();
-            rideFile->setTag("Sport", sport.text());
+            rideFile->setTag("Sport", pwxText(xml));
 
         // notes
-        } else if (node.nodeName() == "cmt") {
+        } else if (xml.name() == QLatin1String("cmt")) {
 
-            QDomElement notes = node.toElement();
-            rideNotes = notes.text();
+            rideNotes = pwxText(xml);
 
         // device type and info
-        } else if (node.nodeName() == "device") {
+        } else if (xml.name() == QLatin1String("device")) {
+
+            QString make, model, deviceinfo;
+            while (xml.readNextStartElement()) {
+
+                if (xml.name() == QLatin1String("make")) make = pwxText(xml);
+                else if (xml.name() == QLatin1String("model")) model = pwxText(xml);
+                else if (xml.name() == QLatin1String("extension")) {
+
+                    // device settings data
+                    while (xml.readNextStartElement()) {
+                        deviceinfo += xml.qualifiedName().toString();
+                        deviceinfo += ": ";
+                        deviceinfo += pwxText(xml);
+                        deviceinfo += '\n';
+                    }
+                } else xml.skipCurrentElement();
+            }
 
-            QString devicetype;
             // make and model
-            QDomElement make = node.firstChildElement("make");
-            if (!make.isNull()) devicetype = make.text();
-            QDomElement model = node.firstChildElement("model");
-            if (!model.isNull()) {
+            QString devicetype = make;
+            if (model != "") {
                 if (devicetype != "") devicetype += " ";
-                devicetype += model.text();
+                devicetype += model;
             }
             rideFile->setDeviceType(devicetype);
             rideFile->setFileFormat("Peaksware Data File (pwx)");
-
-            // device settings data
-            QString deviceinfo;
-            QDomElement extension = node.firstChildElement("extension");
-            if (!extension.isNull()) {
-                for (QDomElement info=extension.firstChildElement();
-                    !info.isNull();
-                    info = info.nextSiblingElement()) {
-                    deviceinfo += info.tagName();
-                    deviceinfo += ": ";
-                    deviceinfo += info.text();
-                    deviceinfo += '\n';
-                }
-            }
             rideFile->setTag("Device Info", deviceinfo);
 
         // start date/time
-        } else if (node.nodeName() == "time") {
-            QDomElement date = node.toElement();
-            rideDate = QDateTime::fromString(date.text(), Qt::ISODate);
+        } else if (xml.name() == QLatin1String("time")) {
+
+            rideDate = QDateTime::fromString(pwxText(xml), Qt::ISODate);
             rideFile->setStartTime(rideDate);
 
         // interval data
-        } else if (node.nodeName() == "segment") {
+        } else if (xml.name() == QLatin1String("segment")) {
+
             RideFileInterval add;
+            bool named = false, summary = false, hasDuration = false;
+            double duration = 0;
+            add.start = -1;
+
+            while (xml.readNextStartElement()) {
+
+                if (xml.name() == QLatin1String("name")) {
+                    add.name = pwxText(xml);
+                    named = true;
+
+                } else if (xml.name() == QLatin1String("summarydata")) {
+                    summary = true;
+                    while (xml.readNextStartElement()) {
+                        if (xml.name() == QLatin1String("beginning")) add.start = xmlElementDouble(xml, scratch);
+                        else if (xml.name() == QLatin1String("duration")) {
+                            duration = xmlElementDouble(xml, scratch);
+                            hasDuration = true;
+                        } else xml.skipCurrentElement();
+                    }
+                } else xml.skipCurrentElement();
+            }
+            if (!named) add.name = QString("Interval #%1").arg(++intervals);
 
-            // name
-            QDomElement name = node.firstChildElement("name");
-            if (!name.isNull()) add.name = name.text();
-            else add.name = QString("Interval #%1").arg(++intervals);
-
-            QDomElement summary = node.firstChildElement("summarydata");
-            if (!summary.isNull()) {
-
-                // start
-                QDomElement beginning = summary.firstChildElement("beginning");
-                if (!beginning.isNull()) add.start = beginning.text().toDouble();
-                else add.start = -1;
-
-                // duration - convert to end
-                QDomElement duration = summary.firstChildElement("duration");
-                if (!duration.isNull() && add.start != -1)
-                    add.stop = duration.text().toDouble() + add.start;
-                else
-                    add.stop = -1;
-
-                // add interval
-                if (add.start != -1 && add.stop != -1) {
-                    rideFile->addInterval(add.start, add.stop, add.name);
-                }
+            // duration - convert to end
+            if (hasDuration && add.start != -1) add.stop = duration + add.start;
+            else add.stop = -1;
+
+            // add interval
+            if (summary && add.start != -1 && add.stop != -1) {
+                rideFile->addInterval(add.start, add.stop, add.name);
             }
 
         // data points: offset, hr, spd, pwr, torq, cad, dist, lat, lon, alt (ignored: temp, time)
-        } else if (node.nodeName() == "sample") {
-            RideFilePoint add;
+        } else if (xml.name() == QLatin1String("sample")) {
 
-            // offset (secs)
-            QDomElement off = node.firstChildElement("timeoffset");
-            if (!off.isNull()) add.secs = off.text().toDouble();
-            else add.secs = 0.0;
-            // hr
-            QDomElement hr = node.firstChildElement("hr");
-            if (!hr.isNull()) add.hr = hr.text().toDouble();
-            else add.hr = 0.0;
-            // spd in meters per second converted to kph
-            QDomElement spd = node.firstChildElement("spd");
-            if (!spd.isNull()) add.kph = spd.text().toDouble() * 3.6;
-            else add.kph = 0.0;
-            // pwr
-            QDomElement pwr = node.firstChildElement("pwr");
-            if (!pwr.isNull()) {
-                add.watts = pwr.text().toDouble();
-                // XXX undo the fudge to set zero values to
-                //     1 in the writer (below). This is to keep
-                //     the TP upload web-service happy
-                if (add.watts == 1) add.watts = 0.0;
-            } else add.watts = 0.0;
-            // torq
-            QDomElement torq = node.firstChildElement("torq");
-            if (!torq.isNull()) add.nm = torq.text().toDouble();
-            else add.nm = 0.0;
-            // cad
-            QDomElement cad = node.firstChildElement("cad");
-            if (!cad.isNull()) add.cad = cad.text().toDouble();
-            else add.cad = 0.0;
-            // dist
-            QDomElement dist = node.firstChildElement("dist");
-            if (!dist.isNull()) add.km = dist.text().toDouble() /1000;
-            else add.km = 0.0;
-
-            // lat
-            QDomElement lat = node.firstChildElement("lat");
-            if (!lat.isNull()) add.lat = lat.text().toDouble();
-            else add.lat = 0.0;
-            // lon
-            QDomElement lon = node.firstChildElement("lon");
-            if (!lon.isNull()) add.lon = lon.text().toDouble();
-            else add.lon = 0.0;
-            // alt
-            QDomElement alt = node.firstChildElement("alt");
-            if (!alt.isNull()) add.alt = alt.text().toDouble();
-            else add.alt = 0.0;
+            RideFilePoint add;
+            add.secs = add.hr = add.kph = add.watts = add.nm = add.cad = 0.0;
+            add.km = add.lat = add.lon = add.alt = 0.0;
+
+            while (xml.readNextStartElement()) {
+                QStringRef name = xml.name();
+
+                // offset (secs)
+                if (name == QLatin1String("timeoffset")) add.secs = xmlElementDouble(xml, scratch);
+                else if (name == QLatin1String("hr")) add.hr = xmlElementDouble(xml, scratch);
+                // spd in meters per second converted to kph
+                else if (name == QLatin1String("spd")) add.kph = xmlElementDouble(xml, scratch) * 3.6;
+                else if (name == QLatin1String("pwr")) {
+                    add.watts = xmlElementDouble(xml, scratch);
+                    // XXX undo the fudge to set zero values to
+                    //     1 in the writer (below). This is to keep
+                    //     the TP upload web-service happy
+                    if (add.watts == 1) add.watts = 0.0;
+                }
+                else if (name == QLatin1String("torq")) add.nm = xmlElementDouble(xml, scratch);
+                else if (name == QLatin1String("cad")) add.cad = xmlElementDouble(xml, scratch);
+                else if (name == QLatin1String("dist")) add.km = xmlElementDouble(xml, scratch) / 1000;
+                else if (name == QLatin1String("lat")) add.lat = xmlElementDouble(xml, scratch);
+                else if (name == QLatin1String("lon")) add.lon = xmlElementDouble(xml, scratch);
+                else if (name == QLatin1String("alt")) add.alt = xmlElementDouble(xml, scratch);
+                else xml.skipCurrentElement();
+            }
 
             // do we need to calculate distance?
             if (add.km == 0.0 && samples) {
@@ -239,13 +246,16 @@ PwxFileReader::PwxFromDomDoc(QDomDocument doc, QStringList &errors) const
                     add.nm, add.watts, add.alt, add.lon, add.lat, add.headwind,
                     add.slope, add.temp, add.lrbalance, add.interval);
 
-
-        // ignored for now
-        } else if (node.nodeName() == "summarydata") {
-        } else if (node.nodeName() == "extension") {
+        // ignored for now (summarydata, extension)
+        } else {
+            xml.skipCurrentElement();
         }
+    }
 
-        node = node.nextSibling();
+    if (xml.hasError()) {
+        errors << "Could not parse file.";
+        delete rideFile;
+        return NULL;
     }
 
     // post-process and check
@@ -23,11 +23,13 @@
 #include "RideFile.h"
 #include "MainWindow.h"
 #include <QDomDocument>
+#include <QXmlStreamReader>
 
 struct PwxFileReader : public RideFileReader {
     virtual RideFile *openRideFile(QFile &file, QStringList &errors, QList<RideFile*>* = 0) const; 
     bool writeRideFile(MainWindow *, const RideFile *ride, QFile &file) const;
     virtual RideFile *PwxFromDomDoc(QDomDocument doc, QStringList &errors) const;
+    RideFile *PwxFromStream(QXmlStreamReader &xml, QStringList &errors) const;
     bool hasWrite() const { return true; }
 };
 
@@ -25,25 +25,43 @@
 #include "Settings.h"
 #include "Units.h"
 #include <QtXml/QtXml>
-#include <algorithm> // for std::lower_bound
+#include <QTemporaryFile>
+#include <algorithm> // for std::lower_bound and std::copy
 #include <assert.h>
 
-#define mark() \
-{ \
-    addInterval(start, previous->secs + recIntSecs_, \
-                QString("%1").arg(interval)); \
-    interval = point->interval; \
-    start = point->secs; \
+static bool
+sampled(RideFile::SeriesType series)
+{
+    // only raw sample data is held in columns, the derived
+    // series (NP, xPower etc) are computed by their users
+    switch (series) {
+        case RideFile::secs: case RideFile::cad: case RideFile::hr: case RideFile::km:
+        case RideFile::kph: case RideFile::nm: case RideFile::watts: case RideFile::alt:
+        case RideFile::lon: case RideFile::lat: case RideFile::headwind: case RideFile::slope:
+        case RideFile::temp: case RideFile::lrbalance: case RideFile::interval:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// what a series without a column holds
+static double
+defaultFor(RideFile::SeriesType series)
+{
+    return series == RideFile::temp ? RideFile::noTemp : 0.0;
 }
 
 RideFile::RideFile(const QDateTime &startTime, double recIntSecs) :
             startTime_(startTime), recIntSecs_(recIntSecs),
-            deviceType_("unknown"), data(NULL), weight_(0)
+            deviceType_("unknown"), data(NULL), weight_(0), count_(0), pointsBuilt_(false),
+            source_(NULL), retired_(NULL)
 {
     command = new RideFileCommand(this);
 }
 
-RideFile::RideFile() : recIntSecs_(0.0), deviceType_("unknown"), data(NULL), weight_(0)
+RideFile::RideFile() : recIntSecs_(0.0), deviceType_("unknown"), data(NULL), weight_(0), count_(0),
+                       pointsBuilt_(false), source_(NULL), retired_(NULL)
 {
     command = new RideFileCommand(this);
 }
@@ -54,6 +72,8 @@ RideFile::~RideFile()
     foreach(RideFilePoint *point, dataPoints_)
         delete point;
     delete command;
+    delete source_;
+    delete retired_;
 }
 
 QString
@@ -119,44 +139,38 @@ RideFile::clearIntervals()
 void
 RideFile::fillInIntervals()
 {
-    if (dataPoints_.empty())
+    if (samples() == 0)
         return;
     intervals_.clear();
-    double start = 0.0;
-    int interval = dataPoints().first()->interval;
-    const RideFilePoint *point=NULL, *previous=NULL;
-    foreach (point, dataPoints()) {
-        if (point->interval != interval)
-            mark();
-        previous = point;
-    }
-    if (interval > 0)
-        mark();
-}
 
-struct ComparePointKm {
-    bool operator()(const RideFilePoint *p1, const RideFilePoint *p2) {
-        return p1->km < p2->km;
-    }
-};
+    // works from the columns so a ride that is still
+    // backed by its sample source does not get read in
+    RideFileSeries secs = series(RideFile::secs);
+    RideFileSeries interval = series(RideFile::interval);
+    if (interval.isEmpty()) return; // all zero, so no intervals
 
-struct ComparePointSecs {
-    bool operator()(const RideFilePoint *p1, const RideFilePoint *p2) {
-        return p1->secs < p2->secs;
+    double start = 0.0;
+    int current = interval[0];
+    for (int i=1; i<interval.count; i++) {
+        if (interval[i] != current) {
+            addInterval(start, secs[i-1] + recIntSecs_, QString("%1").arg(current));
+            current = interval[i];
+            start = secs[i];
+        }
     }
-};
+    if (current > 0)
+        addInterval(start, secs[secs.count-1] + recIntSecs_, QString("%1").arg(current));
+}
 
 int
 RideFile::intervalBegin(const RideFileInterval &interval) const
 {
-    RideFilePoint p;
-    p.secs = interval.start;
-    QVector<RideFilePoint*>::const_iterator i = std::lower_bound(
-        dataPoints_.begin(), dataPoints_.end(), &p, ComparePointSecs());
-    if (i == dataPoints_.end())
-        return dataPoints_.size()-1;
-    int offset = i - dataPoints_.begin();
-    if (offset > dataPoints_.size()) return dataPoints_.size()-1;
+    RideFileSeries secs = series(RideFile::secs);
+    const double *i = std::lower_bound(secs.begin(), secs.end(), interval.start);
+    if (i == secs.end())
+        return secs.count-1;
+    int offset = i - secs.begin();
+    if (offset > secs.count) return secs.count-1;
     else if (offset <0) return 0;
     else return offset;
 }
@@ -164,44 +178,38 @@ RideFile::intervalBegin(const RideFileInterval &interval) const
 double
 RideFile::timeToDistance(double secs) const
 {
-    RideFilePoint p;
-    p.secs = secs;
+    RideFileSeries times = series(RideFile::secs);
+    RideFileSeries km = series(RideFile::km);
 
     // Check we have some data and the secs is in bounds
-    if (dataPoints_.isEmpty()) return 0;
-    if (secs < dataPoints_.first()->secs) return dataPoints_.first()->km;
-    if (secs > dataPoints_.last()->secs) return dataPoints_.last()->km;
+    if (times.isEmpty() || km.isEmpty()) return 0;
+    if (secs < times[0]) return km[0];
+    if (secs > times[times.count-1]) return km[km.count-1];
 
-    QVector<RideFilePoint*>::const_iterator i = std::lower_bound(dataPoints_.begin(), dataPoints_.end(), &p, ComparePointSecs());
-    return (*i)->km;
+    const double *i = std::lower_bound(times.begin(), times.end(), secs);
+    return km[i - times.begin()];
 }
 
 int
 RideFile::timeIndex(double secs) const
 {
     // return index offset for specified time
-    RideFilePoint p;
-    p.secs = secs;
-
-    QVector<RideFilePoint*>::const_iterator i = std::lower_bound(
-        dataPoints_.begin(), dataPoints_.end(), &p, ComparePointSecs());
-    if (i == dataPoints_.end())
-        return dataPoints_.size()-1;
-    return i - dataPoints_.begin();
+    RideFileSeries times = series(RideFile::secs);
+    const double *i = std::lower_bound(times.begin(), times.end(), secs);
+    if (i == times.end())
+        return times.count-1;
+    return i - times.begin();
 }
 
 int
 RideFile::distanceIndex(double km) const
 {
     // return index offset for specified distance in km
-    RideFilePoint p;
-    p.km = km;
-
-    QVector<RideFilePoint*>::const_iterator i = std::lower_bound(
-        dataPoints_.begin(), dataPoints_.end(), &p, ComparePointKm());
-    if (i == dataPoints_.end())
-        return dataPoints_.size()-1;
-    return i - dataPoints_.begin();
+    RideFileSeries distance = series(RideFile::km);
+    const double *i = std::lower_bound(distance.begin(), distance.end(), km);
+    if (i == distance.end())
+        return distance.count-1;
+    return i - distance.begin();
 }
 
 
@@ -224,6 +232,17 @@ int RideFileFactory::registerReader(const QString &suffix,
     return 1;
 }
 
+int RideFileFactory::registerCacheReader(const QString &suffix,
+                                         const QString &description,
+                                         RideFileReader *reader)
+{
+    assert(cacheReader_ == NULL);
+    cacheReader_ = reader;
+    cacheSuffix_ = suffix;
+    descriptions_.insert(suffix, description);
+    return 1;
+}
+
 QStringList RideFileFactory::suffixes() const
 {
     return readFuncs_.keys();
@@ -259,8 +278,29 @@ RideFileFactory::writeRideFile(MainWindow *main, const RideFile *ride, QFile &fi
     else return reader->writeRideFile(main, ride, file);
 }
 
+RideFileContext::RideFileContext(MainWindow *main) : main(main)
+{
+    if (main) {
+        home = main->home.absolutePath();
+        foreach (FieldDefinition field, main->rideMetadata()->getFields())
+            if (field.diary == true) diaryFields << field.name;
+    }
+
+    // whether each processor runs by itself and with what settings
+    foreach (QString key, appsettings->allKeys())
+        if (key.startsWith("dp/") || key.startsWith("dataprocess/"))
+            settings.insert(key, appsettings->value(NULL, key));
+}
+
 RideFile *RideFileFactory::openRideFile(MainWindow *main, QFile &file,
                                            QStringList &errors, QList<RideFile*> *rideList) const
+{
+    return openRideFile(RideFileContext(main), file, errors, rideList);
+}
+
+// safe to call from any thread, everything we need is in the context
+RideFile *RideFileFactory::openRideFile(const RideFileContext &context, QFile &file,
+                                           QStringList &errors, QList<RideFile*> *rideList) const
 {
     QString suffix = file.fileName();
     int dot = suffix.lastIndexOf(".");
@@ -268,13 +308,36 @@ RideFile *RideFileFactory::openRideFile(MainWindow *main, QFile &file,
     suffix.remove(0, dot + 1);
     RideFileReader *reader = readFuncs_.value(suffix.toLower());
     assert(reader);
+
+    // rides in the athlete's home directory have a binary cache alongside
+    // them, if it is up-to-date we read that instead of parsing the source
+    QFileInfo sourceInfo(file.fileName());
+    QString cacheName = sourceInfo.absolutePath() + "/" + sourceInfo.baseName() + "." + cacheSuffix_;
+    bool cacheable = cacheReader_ && context.main && rideList == NULL &&
+                     sourceInfo.absolutePath() == context.home;
+
+    RideFile *result = NULL;
+    if (cacheable) {
+        QFileInfo cacheInfo(cacheName);
+        if (cacheInfo.exists() && cacheInfo.lastModified() >= sourceInfo.lastModified()) {
+            QFile cacheFile(cacheName);
+            QStringList cacheErrors; // an old or damaged cache just gets replaced
+            result = cacheReader_->openRideFile(cacheFile, cacheErrors);
+        }
+    }
+
+    if (result == NULL) {
 //qDebug()<<"open"<<file.fileName()<<"start:"<<QDateTime::currentDateTime().toString("hh:mm:ss.zzz");
-    RideFile *result = reader->openRideFile(file, errors, rideList);
+        result = reader->openRideFile(file, errors, rideList);
 //qDebug()<<"open"<<file.fileName()<<"end:"<<QDateTime::currentDateTime().toString("hh:mm:ss.zzz");
 
+        // cache it as parsed, before any of the processing below
+        if (result && cacheable) writeCache(context.main, result, cacheName);
+    }
+
     // NULL returned to indicate openRide failed
     if (result) {
-        result->mainwindow = main;
+        result->mainwindow = context.main;
         if (result->intervals().empty()) result->fillInIntervals();
 
 
@@ -305,10 +368,10 @@ RideFile *RideFileFactory::openRideFile(MainWindow *main, QFile &file,
 
         // Construct the summary text used on the calendar
         QString calendarText;
-        foreach (FieldDefinition field, main->rideMetadata()->getFields()) {
-            if (field.diary == true && result->getTag(field.name, "") != "") {
+        foreach (QString field, context.diaryFields) {
+            if (result->getTag(field, "") != "") {
                 calendarText += QString("%1\n")
-                        .arg(result->getTag(field.name, ""));
+                        .arg(result->getTag(field, ""));
             }
         }
         result->setTag("Calendar Text", calendarText);
@@ -322,7 +385,7 @@ RideFile *RideFileFactory::openRideFile(MainWindow *main, QFile &file,
         result->setTag("Month", result->startTime().toString("MMMM"));
         result->setTag("Weekday", result->startTime().toString("ddd"));
 
-        DataProcessorFactory::instance().autoProcess(result);
+        DataProcessorFactory::instance().autoProcess(result, context);
 
         // what data is present - after processor in case 'derived' or adjusted
         QString flags;
@@ -358,6 +421,24 @@ RideFile *RideFileFactory::openRideFile(MainWindow *main, QFile &file,
     return result;
 }
 
+void
+RideFileFactory::writeCache(MainWindow *main, const RideFile *ride, QString cacheName) const
+{
+    // write it to one side and then replace the old one, which
+    // may still be mapped by a copy of the ride that is open. The
+    // refresh, the prefetcher and the gui thread can all be writing
+    // the same ride so each of them gets a temp file of its own
+    QTemporaryFile temp(cacheName + ".XXXXXX");
+    temp.setAutoRemove(false); // we rename it, or remove it ourselves
+    if (!cacheReader_->writeRideFile(main, ride, temp)) {
+        temp.remove();
+        return;
+    }
+    temp.close();
+    QFile::remove(cacheName);
+    if (!QFile::rename(temp.fileName(), cacheName)) QFile::remove(temp.fileName());
+}
+
 QStringList RideFileFactory::listRideFiles(const QDir &dir) const
 {
     QStringList filters;
@@ -390,8 +471,8 @@ void RideFile::appendPoint(double secs, double cad, double hr, double km,
     if (!isfinite(watts) || watts<0) watts=0;
     if (!isfinite(interval) || interval<0) interval=0;
 
-    dataPoints_.append(new RideFilePoint(secs, cad, hr, km, kph,
-                                         nm, watts, alt, lon, lat, headwind, slope, temp, lrbalance, interval));
+    appendPoint(RideFilePoint(secs, cad, hr, km, kph,
+                              nm, watts, alt, lon, lat, headwind, slope, temp, lrbalance, interval));
     dataPresent.secs     |= (secs != 0);
     dataPresent.cad      |= (cad != 0);
     dataPresent.hr       |= (hr != 0);
@@ -411,13 +492,14 @@ void RideFile::appendPoint(double secs, double cad, double hr, double km,
 
 void RideFile::appendPoint(const RideFilePoint &point)
 {
-    dataPoints_.append(new RideFilePoint(point.secs,point.cad,point.hr,point.km,point.kph,point.nm,point.watts,point.alt,point.lon,point.lat,
-                                         point.headwind, point.slope, point.temp, point.lrbalance, point.interval));
+    detach();
+    insertPoint(count_, new RideFilePoint(point));
 }
 
 void
 RideFile::setDataPresent(SeriesType series, bool value)
 {
+    invalidatePeaks();
     switch (series) {
         case secs : dataPresent.secs = value; break;
         case cad : dataPresent.cad = value; break;
@@ -440,7 +522,7 @@ RideFile::setDataPresent(SeriesType series, bool value)
 }
 
 bool
-RideFile::isDataPresent(SeriesType series)
+RideFile::isDataPresent(SeriesType series) const
 {
     switch (series) {
         case secs : return dataPresent.secs; break;
@@ -454,6 +536,9 @@ RideFile::isDataPresent(SeriesType series)
         case lon : return dataPresent.lon; break;
         case lat : return dataPresent.lat; break;
         case headwind : return dataPresent.headwind; break;
+        case slope : return dataPresent.slope; break;
+        case temp : return dataPresent.temp; break;
+        case lrbalance : return dataPresent.lrbalance; break;
         case interval : return dataPresent.interval; break;
         default:
         case none : return false; break;
@@ -463,6 +548,18 @@ RideFile::isDataPresent(SeriesType series)
 void
 RideFile::setPointValue(int index, SeriesType series, double value)
 {
+    invalidatePeaks();
+    detach();
+    if (sampled(series)) {
+        QVector<double> &column = columns_[series];
+        if (!column.isEmpty() || value != defaultFor(series)) {
+            if (column.isEmpty()) column.fill(defaultFor(series), count_);
+            column[index] = (series == interval) ? int(value) : value; // as a RideFilePoint would
+        }
+    }
+    if (!pointsBuilt_) return;
+
+    // and keep the points in step
     switch (series) {
         case secs : dataPoints_[index]->secs = value; break;
         case cad : dataPoints_[index]->cad = value; break;
@@ -475,6 +572,9 @@ RideFile::setPointValue(int index, SeriesType series, double value)
         case lon : dataPoints_[index]->lon = value; break;
         case lat : dataPoints_[index]->lat = value; break;
         case headwind : dataPoints_[index]->headwind = value; break;
+        case slope : dataPoints_[index]->slope = value; break;
+        case temp : dataPoints_[index]->temp = value; break;
+        case lrbalance : dataPoints_[index]->lrbalance = value; break;
         case interval : dataPoints_[index]->interval = value; break;
         default:
         case none : break;
@@ -498,6 +598,7 @@ RideFilePoint::value(RideFile::SeriesType series) const
         case RideFile::headwind : return headwind; break;
         case RideFile::slope : return slope; break;
         case RideFile::temp : return temp; break;
+        case RideFile::lrbalance : return lrbalance; break;
         case RideFile::interval : return interval; break;
 
         default:
@@ -509,7 +610,24 @@ RideFilePoint::value(RideFile::SeriesType series) const
 double
 RideFile::getPointValue(int index, SeriesType series) const
 {
-    return dataPoints_[index]->value(series);
+    if (!sampled(series)) return 0.0;
+
+    if (source_) {
+        RideFileSeries column = source_->series(series);
+        return column.isEmpty() ? defaultFor(series) : column[index];
+    }
+    const QVector<double> &column = columns_[series];
+    return column.isEmpty() ? defaultFor(series) : column[index];
+}
+
+RideFilePoint
+RideFile::point(int index) const
+{
+    return RideFilePoint(getPointValue(index, secs), getPointValue(index, cad), getPointValue(index, hr),
+                         getPointValue(index, km), getPointValue(index, kph), getPointValue(index, nm),
+                         getPointValue(index, watts), getPointValue(index, alt), getPointValue(index, lon),
+                         getPointValue(index, lat), getPointValue(index, headwind), getPointValue(index, slope),
+                         getPointValue(index, temp), getPointValue(index, lrbalance), getPointValue(index, interval));
 }
 
 QVariant
@@ -610,27 +728,261 @@ RideFile::minimumFor(SeriesType series)
 void
 RideFile::deletePoint(int index)
 {
-    delete dataPoints_[index];
-    dataPoints_.remove(index);
+    deletePoints(index, 1);
 }
 
 void
 RideFile::deletePoints(int index, int count)
 {
-    for(int i=index; i<(index+count); i++) delete dataPoints_[i];
-    dataPoints_.remove(index, count);
+    detach();
+    for (int i=0; i<none; i++)
+        if (!columns_[i].isEmpty()) columns_[i].remove(index, count);
+    count_ -= count;
+
+    if (pointsBuilt_) {
+        for(int i=index; i<(index+count); i++) delete dataPoints_[i];
+        dataPoints_.remove(index, count);
+    }
+    invalidatePeaks();
 }
 
 void
 RideFile::insertPoint(int index, RideFilePoint *point)
 {
-    dataPoints_.insert(index, point);
+    detach();
+    for (int i=0; i<none; i++) {
+        SeriesType series = static_cast<SeriesType>(i);
+        if (!sampled(series)) continue;
+
+        // the column is only started when it gets a value
+        double value = point->value(series);
+        if (columns_[i].isEmpty() && value == defaultFor(series)) continue;
+        if (columns_[i].isEmpty()) columns_[i].fill(defaultFor(series), count_);
+        columns_[i].insert(index, value);
+    }
+    count_++;
+
+    // it's ours, so it either joins the points or goes
+    if (pointsBuilt_) dataPoints_.insert(index, point);
+    else delete point;
+    invalidatePeaks();
 }
 
 void
 RideFile::appendPoints(QVector <struct RideFilePoint *> newRows)
 {
-    dataPoints_ += newRows;
+    detach();
+    foreach (RideFilePoint *point, newRows) insertPoint(count_, point);
+}
+
+//
+// COLUMNAR ACCESS
+//
+// The samples are held as a contiguous array for each series that has
+// any data; a 10 hour ride with power, hr and cadence costs 4 arrays
+// rather than 15 doubles per point, and scanning them avoids chasing a
+// pointer for every sample. A great deal of code (the readers, the
+// editor and the data processors) still wants RideFilePoints though, so
+// dataPoints() makes a copy of the samples as points the first time it
+// is asked and the edits keep it in step from then on.
+//
+void
+RideFile::invalidatePeaks()
+{
+    // the peaks are derived from the samples
+    QMutexLocker locker(&peaksLock_);
+    peaks_.clear();
+}
+
+RideFileSeries
+RideFile::series(SeriesType series) const
+{
+    if (!sampled(series)) return RideFileSeries();
+
+    // we always provide a timebase, but otherwise
+    // don't allocate for series that aren't present
+    if (series != secs && isDataPresent(series) == false) return RideFileSeries();
+
+    // several threads may scan the same ride (e.g. the meanmax
+    // computers) so the first one in gives it a column
+    QMutexLocker locker(&columnsLock_);
+
+    // still backed by the source so just hand out its view
+    if (source_) return source_->series(series);
+
+    QVector<double> &column = columns_[series];
+    if (column.isEmpty()) column.fill(defaultFor(series), count_); // present, but nothing in it
+    return RideFileSeries(column.constData(), column.count());
+}
+
+const QVector<RideFilePoint*> &
+RideFile::dataPoints() const
+{
+    QMutexLocker locker(&columnsLock_);
+    if (pointsBuilt_) return dataPoints_;
+
+    // take a view of every series, the ones without a column are empty
+    int count = source_ ? source_->samples() : count_;
+    RideFileSeries columns[none];
+    for (int i=0; i<none; i++) {
+        SeriesType series = static_cast<SeriesType>(i);
+        if (source_) columns[i] = source_->series(series);
+        else if (!columns_[i].isEmpty()) columns[i] = RideFileSeries(columns_[i].constData(), count);
+    }
+
+    dataPoints_.reserve(count);
+    for (int i=0; i<count; i++) {
+
+        double values[none];
+        for (int j=0; j<none; j++)
+            values[j] = columns[j].isEmpty() ? defaultFor(static_cast<SeriesType>(j)) : columns[j][i];
+
+        dataPoints_.append(new RideFilePoint(values[secs], values[cad], values[hr], values[km],
+                                             values[kph], values[nm], values[watts], values[alt],
+                                             values[lon], values[lat], values[headwind], values[slope],
+                                             values[temp], values[lrbalance], (int)values[interval]));
+    }
+    pointsBuilt_ = true;
+    return dataPoints_;
+}
+
+// copy the samples out of the source before they are changed
+void
+RideFile::detach()
+{
+    QMutexLocker locker(&columnsLock_);
+    if (!source_) return;
+
+    count_ = source_->samples();
+    for (int i=0; i<none; i++) {
+        RideFileSeries column = source_->series(static_cast<SeriesType>(i));
+        columns_[i].clear();
+        if (column.isEmpty() || !sampled(static_cast<SeriesType>(i))) continue;
+
+        columns_[i].resize(count_);
+        std::copy(column.begin(), column.end(), columns_[i].begin());
+    }
+
+    // series() views may still point into the source
+    delete retired_;
+    retired_ = source_;
+    source_ = NULL;
+}
+
+//
+// PEAKS
+//
+// The peak power metrics, their HR and W/kg variants and the peak
+// interval finders all want the best average power over a handful of
+// durations. We find them all in one pass over the samples, keeping a
+// window start for each duration and using a running total, rather than
+// a sorted list of every window for each duration in turn.
+//
+static const double standardPeaks[] = { 1, 5, 10, 15, 20, 30, 60, 120, 300, 600, 1200, 1800, 3600, 0 };
+
+RideFilePeak
+RideFile::peakPower(double secs) const
+{
+    QMutexLocker locker(&peaksLock_);
+
+    if (!peaks_.contains(secs)) {
+        QList<double> durations;
+        if (peaks_.isEmpty())
+            for (int i=0; standardPeaks[i]; i++) durations << standardPeaks[i];
+        if (!durations.contains(secs)) durations << secs;
+        findPeaks(durations);
+    }
+    return peaks_.value(secs);
+}
+
+// called with peaksLock_ held
+void
+RideFile::findPeaks(QList<double> durations) const
+{
+    RideFileSeries times = series(secs);
+    RideFileSeries power = series(watts);
+    int n = times.count;
+    double rec = recIntSecs();
+
+    // running total of power to the start of each sample
+    QVector<double> total(n+1);
+    total[0] = 0;
+    for (int i=0; i<n; i++) total[i+1] = total[i] + (power.isEmpty() ? 0 : power[i]);
+
+    // we want windows with durations in [secs, secs + rec)
+    QVector<int> from(durations.count());
+    QVector<RideFilePeak> best(durations.count());
+    for (int j=0; j<n; j++) {
+        for (int k=0; k<durations.count(); k++) {
+            double windowSize = durations[k];
+
+            // ride is shorter than the window size!
+            if (windowSize > times[n-1] + rec) continue;
+
+            // drop samples from the start until it is short enough, after
+            // a gap longer than the window there may be nothing left
+            int &i = from[k];
+            while (i <= j && (times[j] - times[i] + rec) >= windowSize + rec) i++;
+            if (i > j) continue;
+
+            double duration = times[j] - times[i] + rec;
+            if (duration >= windowSize) {
+                double avg = (total[j+1] - total[i]) * rec / duration;
+                if (best[k].isEmpty() || avg > best[k].avg) {
+                    best[k].start = times[i];
+                    best[k].stop = times[i] + duration;
+                    best[k].avg = avg;
+                    best[k].first = i;
+                    best[k].last = j;
+                }
+            }
+        }
+    }
+    for (int k=0; k<durations.count(); k++) peaks_.insert(durations[k], best[k]);
+}
+
+int
+RideFile::samples() const
+{
+    QMutexLocker locker(&columnsLock_);
+    return source_ ? source_->samples() : count_;
+}
+
+qint64
+RideFile::memoryUsed() const
+{
+    QMutexLocker locker(&columnsLock_);
+
+    qint64 bytes = sizeof(RideFile);
+    bytes += qint64(dataPoints_.capacity()) * sizeof(RideFilePoint*);
+    bytes += qint64(dataPoints_.count()) * sizeof(RideFilePoint);
+    for (int i=0; i<none; i++) bytes += qint64(columns_[i].capacity()) * sizeof(double);
+
+    // samples still with the source are counted as the columns they will be
+    if (source_) {
+        for (int i=0; i<none; i++)
+            if (source_->isDataPresent(static_cast<SeriesType>(i)))
+                bytes += qint64(source_->samples()) * sizeof(double);
+    }
+    return bytes;
+}
+
+void
+RideFile::setSampleSource(RideFileSampleSource *source)
+{
+    for (int i=0; i<none; i++)
+        setDataPresent(static_cast<SeriesType>(i), source->isDataPresent(static_cast<SeriesType>(i)));
+
+    // replaces any samples we already have
+    QMutexLocker locker(&columnsLock_);
+    foreach(RideFilePoint *point, dataPoints_) delete point;
+    dataPoints_.clear();
+    pointsBuilt_ = false;
+    for (int i=0; i<none; i++) columns_[i].clear();
+    count_ = 0;
+
+    delete source_;
+    source_ = source;
 }
 
 void
@@ -644,6 +996,7 @@ void
 RideFile::emitReverted()
 {
     weight_ = 0;
+    invalidatePeaks();
     emit reverted();
 }
 
@@ -651,11 +1004,12 @@ void
 RideFile::emitModified()
 {
     weight_ = 0;
+    invalidatePeaks();
     emit modified();
 }
 
 double
-RideFile::getWeight()
+RideFile::getWeight() const
 {
     if (weight_) return weight_; // cached value
 
@@ -25,11 +25,15 @@
 #include <QFile>
 #include <QList>
 #include <QMap>
+#include <QHash>
+#include <QVariant>
 #include <QVector>
 #include <QObject>
+#include <QMutex>
 
 class RideItem;
 class RideFile;
+class RideFileSampleSource;
 struct RideFilePoint;
 struct RideFileDataPresent;
 struct RideFileInterval;
@@ -44,6 +48,9 @@ class MainWindow;      // for context; cyclist, homedir
 //
 // RideFilePoint represents the data for a single sample in a RideFile.
 //
+// RideFileSeries is a read-only view onto a contiguous column of samples
+// for a single data series, see RideFile::series().
+//
 // RideFileReader is an abstract base class for function-objects that take a
 // filename and return a RideFile object representing the ride stored in the
 // corresponding file.
@@ -74,6 +81,36 @@ struct RideFileInterval
     bool operator< (RideFileInterval right) const { return start < right.start; }
 };
 
+// A lightweight view onto one column of samples held by a RideFile. It
+// does not own the data and is only valid until the ride is next modified,
+// so take a fresh one rather than holding it across edits.
+struct RideFileSeries
+{
+    const double *data;
+    int count;
+
+    RideFileSeries() : data(NULL), count(0) {}
+    RideFileSeries(const double *data, int count) : data(data), count(count) {}
+
+    bool isEmpty() const { return count == 0; }
+    int size() const { return count; }
+    double operator[](int i) const { return data[i]; }
+    const double *begin() const { return data; }
+    const double *end() const { return data + count; }
+};
+
+// RideFilePeak is the best average power for a duration, start and
+// stop are as BestIntervalDialog::findBests reports them and first and
+// last are the indexes of the samples in the window
+struct RideFilePeak
+{
+    double start, stop, avg;
+    int first, last;
+
+    RideFilePeak() : start(0), stop(0), avg(0), first(-1), last(-1) {}
+    bool isEmpty() const { return first < 0; }
+};
+
 class RideFile : public QObject // QObject to emit signals
 {
     Q_OBJECT
@@ -112,11 +149,39 @@ class RideFile : public QObject // QObject to emit signals
                          double temperature, double lrbalance, int interval);
 
         void appendPoint(const RideFilePoint &);
-        const QVector<RideFilePoint*> &dataPoints() const { return dataPoints_; }
+
+        // the samples as RideFilePoints for the code that still wants
+        // them (the editor, the data processors, the writers). They are
+        // copied from the columns the first time they are asked for and
+        // kept in step by the edits, so change them with setPointValue()
+        // and friends, never through the pointers.
+        const QVector<RideFilePoint*> &dataPoints() const;
+        RideFilePoint point(int index) const; // a copy of one sample
+
+        // Working with COLUMNS -- the samples are held as one contiguous
+        // array per data series and only for series that have any data,
+        // a series that is not present returns an empty view.
+        // Prefer these to dataPoints() for full ride scans.
+        int samples() const;
+        RideFileSeries series(SeriesType series) const;
+
+        // roughly what the samples take in memory, in bytes
+        qint64 memoryUsed() const;
+
+        // Working with PEAKS -- the best average power for a duration,
+        // all the usual durations are found in one pass on first use and
+        // kept until the samples change. Empty if the ride is too short.
+        RideFilePeak peakPower(double secs) const;
+
+        // Working with a SAMPLE SOURCE -- when a ride is opened from
+        // a cache the samples are left with the source and read on
+        // demand, they are only copied into columns when the ride is
+        // modified. Takes ownership.
+        void setSampleSource(RideFileSampleSource *source);
 
         // Working with DATAPRESENT flags
         inline const RideFileDataPresent *areDataPresent() const { return &dataPresent; }
-        bool isDataPresent(SeriesType series);
+        bool isDataPresent(SeriesType series) const;
 
         // Working with FIRST CLASS variables
         const QDateTime &startTime() const { return startTime_; }
@@ -150,7 +215,8 @@ class RideFile : public QObject // QObject to emit signals
         void setTag(QString name, QString value) { tags_.insert(name, value); }
 
         MainWindow *mainwindow;
-        double getWeight();
+        double getWeight() const;
+        void setWeight(double weight) { weight_ = weight; } // already resolved by caller
 
         // METRIC OVERRIDES
         QMap<QString,QMap<QString,QString> > metricOverrides;
@@ -191,14 +257,35 @@ class RideFile : public QObject // QObject to emit signals
         QString id_; // global uuid@goldencheetah.org
         QDateTime startTime_;  // time of day that the ride started
         double recIntSecs_;    // recording interval in seconds
-        QVector<RideFilePoint*> dataPoints_;
         RideFileDataPresent dataPresent;
         QString deviceType_;
         QString fileFormat_;
         QList<RideFileInterval> intervals_;
         QMap<QString,QString> tags_;
         EditorData *data;
-        double weight_; // cached to save calls to getWeight();
+        mutable double weight_; // cached to save calls to getWeight();
+
+        // the samples, indexed by SeriesType. A series with nothing but
+        // zeroes (noTemp for temp) has no column until it gets a value
+        mutable QVector<double> columns_[none];
+        int count_;
+        mutable QMutex columnsLock_;
+
+        // the samples as points, made by dataPoints() when first asked
+        mutable QVector<RideFilePoint*> dataPoints_;
+        mutable bool pointsBuilt_;
+
+        // peak power by duration, cleared whenever the samples change
+        void invalidatePeaks();
+        void findPeaks(QList<double> durations) const;
+        mutable QMap<double, RideFilePeak> peaks_;
+        mutable QMutex peaksLock_;
+
+        // samples not yet read from the source, once they have been
+        // copied the source is retired but kept until we are deleted
+        // since series() views may still refer to it
+        void detach();
+        mutable RideFileSampleSource *source_, *retired_;
 };
 
 struct RideFilePoint
@@ -215,6 +302,18 @@ struct RideFilePoint
     double value(RideFile::SeriesType series) const;
 };
 
+// Supplies the samples for a ride lazily, e.g. from a memory mapped file.
+// Each series is a contiguous array of doubles that remains valid for the
+// lifetime of the source; a series that was not stored returns empty.
+class RideFileSampleSource
+{
+    public:
+        virtual ~RideFileSampleSource() {}
+        virtual int samples() const = 0;
+        virtual bool isDataPresent(RideFile::SeriesType series) const = 0;
+        virtual RideFileSeries series(RideFile::SeriesType series) const = 0;
+};
+
 struct RideFileReader {
     virtual ~RideFileReader() {}
     virtual RideFile *openRideFile(QFile &file, QStringList &errors, QList<RideFile*>* = 0) const = 0;
@@ -224,6 +323,26 @@ struct RideFileReader {
     virtual bool writeRideFile(MainWindow *, const RideFile *, QFile &) const { return false; }
 };
 
+// What opening a ride needs from the athlete's window and the settings;
+// where the rides live, the fields on the diary and how the data
+// processors are set up. Make one on the gui thread and a worker can
+// open rides with it, nobody changes it after that.
+class RideFileContext
+{
+    public:
+        RideFileContext() : main(NULL) {}
+        RideFileContext(MainWindow *main); // gui thread only
+
+        QVariant value(const QString &key, const QVariant &def = QVariant()) const {
+            return settings.value(key, def);
+        }
+
+        MainWindow *main; // handed on to the rides, not used off the gui thread
+        QString home;
+        QStringList diaryFields;
+        QHash<QString, QVariant> settings; // the data processor settings only
+};
+
 class RideFileFactory {
 
     private:
@@ -232,7 +351,12 @@ class RideFileFactory {
         QMap<QString,RideFileReader*> readFuncs_;
         QMap<QString,QString> descriptions_;
 
-        RideFileFactory() {}
+        // the derived cache kept alongside rides in the home directory
+        RideFileReader *cacheReader_;
+        QString cacheSuffix_;
+        void writeCache(MainWindow *main, const RideFile *ride, QString cacheName) const;
+
+        RideFileFactory() : cacheReader_(NULL) {}
 
     public:
 
@@ -240,7 +364,14 @@ class RideFileFactory {
 
         int registerReader(const QString &suffix, const QString &description,
                            RideFileReader *reader);
+
+        // the cache reader is not listed with the other suffixes
+        // since its files are never rides in their own right
+        int registerCacheReader(const QString &suffix, const QString &description,
+                                RideFileReader *reader);
+        QString cacheSuffix() const { return cacheSuffix_; }
         RideFile *openRideFile(MainWindow *main, QFile &file, QStringList &errors, QList<RideFile*>* = 0) const;
+        RideFile *openRideFile(const RideFileContext &context, QFile &file, QStringList &errors, QList<RideFile*>* = 0) const;
         bool writeRideFile(MainWindow *main, const RideFile *ride, QFile &file, QString format) const;
         QStringList listRideFiles(const QDir &dir) const;
         QStringList suffixes() const;
@@ -20,11 +20,15 @@
 #include "MainWindow.h"
 #include "Zones.h"
 #include "HrZones.h"
+#include "Settings.h"
 
 #include <math.h> // for pow()
 #include <QDebug>
 #include <QFileInfo>
 #include <QMessageBox>
+#include <QApplication>
+#include <QThread>
+#include <QTime>
 #include <QtAlgorithms> // for qStableSort
 
 static const int maxcache = 25; // lets max out at 25 caches
@@ -59,33 +63,13 @@ RideFileCache::RideFileCache(MainWindow *main, QString fileName, RideFile *passe
     // Get info for ride file and cache file
     QFileInfo rideFileInfo(rideFileName);
     cacheFileName = rideFileInfo.path() + "/" + rideFileInfo.baseName() + ".cpx";
-    QFileInfo cacheFileInfo(cacheFileName);
 
     // is it up-to-date?
-    if (cacheFileInfo.exists() && rideFileInfo.lastModified() <= cacheFileInfo.lastModified() &&
-        cacheFileInfo.size() >= (int)sizeof(struct RideFileCacheHeader)) {
-        // we have a file, it is more recent than the ride file
-        // but is it the latest version?
-        RideFileCacheHeader head;
-        QFile cacheFile(cacheFileName);
-        if (cacheFile.open(QIODevice::ReadOnly) == true) {
-
-            // read the header
-            QDataStream inFile(&cacheFile);
-            inFile.readRawData((char *) &head, sizeof(head));
-            cacheFile.close();
-
-            // is it as recent as we are?
-            if (head.version == RideFileCacheVersion) {
-
-                // Are the CP/LTHR values still correct
-                // XXX todo
+    if (isCurrent(rideFileName)) {
 
-                // WE'RE GOOD
-                if (check == false) readCache(); // if check is false we aren't just checking
-                return;
-            }
-        }
+        // WE'RE GOOD
+        if (check == false) readCache(); // if check is false we aren't just checking
+        return;
     }
 
     // NEED TO UPDATE!!
@@ -112,6 +96,35 @@ RideFileCache::RideFileCache(MainWindow *main, QString fileName, RideFile *passe
     }
 }
 
+bool
+RideFileCache::isCurrent(QString rideFileName)
+{
+    QFileInfo rideFileInfo(rideFileName);
+    QFileInfo cacheFileInfo(rideFileInfo.path() + "/" + rideFileInfo.baseName() + ".cpx");
+
+    if (cacheFileInfo.exists() && rideFileInfo.lastModified() <= cacheFileInfo.lastModified() &&
+        cacheFileInfo.size() >= (int)sizeof(struct RideFileCacheHeader)) {
+        // we have a file, it is more recent than the ride file
+        // but is it the latest version?
+        RideFileCacheHeader head;
+        QFile cacheFile(cacheFileInfo.filePath());
+        if (cacheFile.open(QIODevice::ReadOnly) == true) {
+
+            // read the header
+            QDataStream inFile(&cacheFile);
+            inFile.readRawData((char *) &head, sizeof(head));
+            cacheFile.close();
+
+            // is it as recent as we are?
+            // Are the CP/LTHR values still correct
+            // XXX todo
+            // was the PfPv histogram for this crank length?
+            return head.version == RideFileCacheVersion && head.CL == (float) crankLength();
+        }
+    }
+    return false;
+}
+
 int
 RideFileCache::decimalsFor(RideFile::SeriesType series)
 {
@@ -276,6 +289,13 @@ RideFileCache::distributionArray(RideFile::SeriesType series)
 }
 
 //
+double
+RideFileCache::crankLength()
+{
+    double cl = appsettings->value(NULL, GC_CRANKLENGTH, 0.0).toDouble() / 1000.0;
+    return cl ? cl : 0.175; // default to 175mm cranks if not set
+}
+
 // COMPUTATION
 //
 void
@@ -300,9 +320,10 @@ RideFileCache::refreshCache()
         // all done now, phew
         cacheFile.close();
 
-    } else if (writeerror == false) {
+    } else if (writeerror == false && QThread::currentThread() == qApp->thread()) {
 
-        // popup the first time...
+        // popup the first time, but only from the gui thread
+        // since the refresh also updates caches from workers
         writeerror = true;
         QMessageBox err;
         QString errMessage = QString("Cannot create cache file %1.").arg(cacheFileName);
@@ -328,16 +349,22 @@ void RideFileCache::RideFileCache::compute()
         return;
     }
 
-    // all the mean maxes
-    MeanMaxComputer thread1(ride, wattsMeanMax, RideFile::watts); thread1.start();
-    MeanMaxComputer thread2(ride, hrMeanMax, RideFile::hr); thread2.start();
-    MeanMaxComputer thread3(ride, cadMeanMax, RideFile::cad); thread3.start();
-    MeanMaxComputer thread4(ride, nmMeanMax, RideFile::nm); thread4.start();
-    MeanMaxComputer thread5(ride, kphMeanMax, RideFile::kph); thread5.start();
-    MeanMaxComputer thread6(ride, xPowerMeanMax, RideFile::xPower); thread6.start();
-    MeanMaxComputer thread7(ride, npMeanMax, RideFile::NP); thread7.start();
-    MeanMaxComputer thread8(ride, vamMeanMax, RideFile::vam); thread8.start();
-    MeanMaxComputer thread9(ride, wattsKgMeanMax, RideFile::wattsKg); thread9.start();
+    // all the mean maxes, in the global pool. If there isn't a thread
+    // free we do it here, so we can never wait on a pool that is busy
+    // with work that is itself waiting on us
+    QSemaphore done;
+    QList<MeanMaxComputer*> computers;
+    computers << new MeanMaxComputer(ride, wattsMeanMax, RideFile::watts, &done)
+              << new MeanMaxComputer(ride, hrMeanMax, RideFile::hr, &done)
+              << new MeanMaxComputer(ride, cadMeanMax, RideFile::cad, &done)
+              << new MeanMaxComputer(ride, nmMeanMax, RideFile::nm, &done)
+              << new MeanMaxComputer(ride, kphMeanMax, RideFile::kph, &done)
+              << new MeanMaxComputer(ride, xPowerMeanMax, RideFile::xPower, &done)
+              << new MeanMaxComputer(ride, npMeanMax, RideFile::NP, &done)
+              << new MeanMaxComputer(ride, vamMeanMax, RideFile::vam, &done)
+              << new MeanMaxComputer(ride, wattsKgMeanMax, RideFile::wattsKg, &done);
+    foreach (MeanMaxComputer *computer, computers)
+        if (!QThreadPool::globalInstance()->tryStart(computer)) computer->run();
 
     // all the different distributions
     computeDistribution(wattsDistribution, RideFile::watts);
@@ -346,17 +373,151 @@ void RideFileCache::RideFileCache::compute()
     computeDistribution(nmDistribution, RideFile::nm);
     computeDistribution(kphDistribution, RideFile::kph);
     computeDistribution(wattsKgDistribution, RideFile::wattsKg);
+    computePfPv(pfpv, ride, crankLength());
+
+    // readCache does this for the others, but the pf/pv plot
+    // wants it straight after a refresh too
+    pfpvDouble.resize(pfpv.size());
+    for (int i=0; i<pfpv.size(); i++) pfpvDouble[i] = pfpv[i];
 
     // wait for them threads
-    thread1.wait();
-    thread2.wait();
-    thread3.wait();
-    thread4.wait();
-    thread5.wait();
-    thread6.wait();
-    thread7.wait();
-    thread8.wait();
-    thread9.wait();
+    done.acquire(computers.count());
+    qDeleteAll(computers);
+}
+
+//----------------------------------------------------------------------
+// Exact Mean-Max for all durations
+//----------------------------------------------------------------------
+
+/*
+
+   For each duration we look for the best total over the integrated
+   series, scanning the start positions in blocks. Since the samples
+   are never negative the total over the span that covers every window
+   starting in a block is an upper bound for all of them, so a block
+   that can't beat the best so far is skipped without looking inside.
+
+   The best so far starts as the best window for the previous duration
+   grown by one sample, which is always a real window and nearly always
+   close to the answer, so almost every block is skipped.
+
+   The scan inside a block has no data dependent branches and keeps
+   four independent maxima so the compiler can vectorise it.
+
+*/
+
+void
+MeanMaxComputer::meanMax(const data_t *dataseries_i, int datalength, QVector<data_t> &bests)
+{
+    bests.fill(0, datalength);
+
+    // the pruning relies on the samples not being negative
+    bool prunable = true;
+    for (int i=0; i<datalength; i++) {
+        if (dataseries_i[i+1] < dataseries_i[i]) {
+            prunable = false;
+            break;
+        }
+    }
+
+    const int block = 64;
+    int bestStart = 0;
+
+    for (int length=1; length<datalength; length++) {
+
+        int last = datalength - length; // last start position
+        const data_t *end = dataseries_i + length;
+
+        // seed with last time's best, grown by one sample either side
+        data_t candidate = 0;
+        for (int i=bestStart-1; i<=bestStart; i++) {
+            if (i < 0 || i > last) continue;
+            if (end[i] - dataseries_i[i] > candidate) {
+                candidate = end[i] - dataseries_i[i];
+                bestStart = i;
+            }
+        }
+
+        for (int start=0; start<=last; start+=block) {
+
+            int stop = qMin(start+block, last+1);
+
+            // nothing in this block can beat what we have
+            if (prunable && dataseries_i[stop-1+length] - dataseries_i[start] <= candidate) continue;
+
+            data_t m0=candidate, m1=candidate, m2=candidate, m3=candidate;
+            int i=start;
+            for (; i+3<stop; i+=4) {
+                data_t t0 = end[i] - dataseries_i[i];
+                data_t t1 = end[i+1] - dataseries_i[i+1];
+                data_t t2 = end[i+2] - dataseries_i[i+2];
+                data_t t3 = end[i+3] - dataseries_i[i+3];
+                m0 = t0 > m0 ? t0 : m0;
+                m1 = t1 > m1 ? t1 : m1;
+                m2 = t2 > m2 ? t2 : m2;
+                m3 = t3 > m3 ? t3 : m3;
+            }
+            for (; i<stop; i++) {
+                data_t t = end[i] - dataseries_i[i];
+                m0 = t > m0 ? t : m0;
+            }
+            data_t m = qMax(qMax(m0, m1), qMax(m2, m3));
+
+            // found a better one, remember where for next time
+            if (m > candidate) {
+                candidate = m;
+                for (i=start; i<stop; i++) {
+                    if (end[i] - dataseries_i[i] == m) {
+                        bestStart = i;
+                        break;
+                    }
+                }
+            }
+        }
+        bests[length] = candidate;
+    }
+}
+
+// synthetic rides, a wandering power with some noise and freewheeling
+void
+MeanMaxComputer::benchmark(QTextStream &out)
+{
+    out << "Mean Max benchmark, Mark Rages vs Exact\n";
+
+    int hours[] = { 1, 6, 24 };
+    for (int h=0; h<3; h++) {
+
+        cpintdata data;
+        double power = 200;
+        qsrand(hours[h]);
+        for (int i=0; i<hours[h]*3600; i++) {
+            power += qrand() % 21 - 10;
+            if (power < 0) power = 0;
+            if (power > 600) power = 600;
+            data.points.append(cpintpoint(i+1, (qrand() % 50) ? (int) round(power + qrand() % 100) : 0));
+        }
+        int n = data.points.size();
+        data_t *dataseries_i = integrate_series(data);
+
+        QTime timer;
+        timer.start();
+        QVector<data_t> rages(n);
+        for (int i=1; i<n; i++) rages[i] = divided_max_mean(dataseries_i, n, i, NULL);
+        int ragesElapsed = timer.elapsed();
+
+        timer.start();
+        QVector<data_t> exact;
+        meanMax(dataseries_i, n, exact);
+        int exactElapsed = timer.elapsed();
+
+        int differ = 0;
+        for (int i=1; i<n; i++) if (rages[i] != exact[i]) differ++;
+        free(dataseries_i);
+
+        out << hours[h] << "h ride: Mark Rages " << ragesElapsed << "ms, Exact "
+            << exactElapsed << "ms, " << differ << " durations differ\n";
+    }
+    out.flush();
 }
 
 //----------------------------------------------------------------------
@@ -578,6 +739,13 @@ MeanMaxComputer::divided_max_mean(data_t *dataseries_i, int datalength, int leng
 
 void
 MeanMaxComputer::run()
+{
+    compute();
+    if (done) done->release();
+}
+
+void
+MeanMaxComputer::compute()
 {
     // xPower and NP need watts to be present
     RideFile::SeriesType baseSeries = (series == RideFile::xPower || series == RideFile::NP || series == RideFile::wattsKg) ?
@@ -614,16 +782,18 @@ MeanMaxComputer::run()
     double lastsecs = 0;
     bool first = true;
     double offset = 0;
-    foreach (const RideFilePoint *p, ride->dataPoints()) {
+    RideFileSeries times = ride->series(RideFile::secs);
+    RideFileSeries values = ride->series(baseSeries);
+    for (int index=0; index < times.count; index++) {
 
         // get offset to apply on all samples if first sample
         if (first == true) {
-            offset = p->secs;
+            offset = times[index];
             first = false;
         }
 
         // drag back to start at 0s
-        double psecs = p->secs - offset;
+        double psecs = times[index] - offset;
 
         // fill in any gaps in recording - use same dodgy rounding as before
         int count = (psecs - lastsecs - ride->recIntSecs()) / ride->recIntSecs();
@@ -636,7 +806,7 @@ MeanMaxComputer::run()
         lastsecs = psecs;
 
         double secs = round(psecs * 1000.0) / 1000;
-        if (secs > 0) data.points.append(cpintpoint(secs, (int) round(p->value(baseSeries))));
+        if (secs > 0) data.points.append(cpintpoint(secs, (int) round(values[index])));
     }
 
     // don't bother with insufficient data
@@ -752,14 +922,14 @@ MeanMaxComputer::run()
 
     data_t *dataseries_i = integrate_series(data);
 
-    for (int i=1; i<data.points.size(); i++) {
+    QVector<data_t> bests;
+    meanMax(dataseries_i, data.points.size(), bests);
 
-        int offset;
-        data_t c=divided_max_mean(dataseries_i,data.points.size(),i,&offset);
+    for (int i=1; i<data.points.size(); i++) {
 
         // snaffle it away
         int sec = i*ride->recIntSecs();
-        data_t val = c / (data_t)i;
+        data_t val = bests[i] / (data_t)i;
 
         if (sec < ride_bests.size()) {
             if (series == RideFile::NP || series == RideFile::xPower)
@@ -822,8 +992,10 @@ RideFileCache::computeDistribution(QVector<float> &array, RideFile::SeriesType s
     // which for longs is handily zero
     array.resize(max-min);
 
-    foreach(RideFilePoint *dp, ride->dataPoints()) {
-        double value = dp->value(baseSeries);
+    RideFileSeries values = ride->series(baseSeries);
+    for (int i=0; i<values.count; i++) {
+        double value = values[i];
+        double raw = value;
         if (series == RideFile::wattsKg) {
             value /= ride->getWeight();
         }
@@ -832,17 +1004,41 @@ RideFileCache::computeDistribution(QVector<float> &array, RideFile::SeriesType s
 
         // watts time in zone
         if (series == RideFile::watts && zoneRange != -1)
-            wattsTimeInZone[main->zones()->whichZone(zoneRange, dp->value(series))] += ride->recIntSecs();
+            wattsTimeInZone[main->zones()->whichZone(zoneRange, raw)] += ride->recIntSecs();
 
         // hr time in zone
         if (series == RideFile::hr && hrZoneRange != -1)
-            hrTimeInZone[main->hrZones()->whichZone(hrZoneRange, dp->value(series))] += ride->recIntSecs();
+            hrTimeInZone[main->hrZones()->whichZone(hrZoneRange, raw)] += ride->recIntSecs();
 
         int offset = lvalue - min;
         if (offset >= 0 && offset < array.size()) array[offset] += ride->recIntSecs();
     }
 }
 
+void
+RideFileCache::computePfPv(QVector<float> &array, const RideFile *ride, double crankLength)
+{
+    RideFileSeries watts = ride->series(RideFile::watts);
+    RideFileSeries cad = ride->series(RideFile::cad);
+
+    for (int i=0; i<watts.count && i<cad.count; i++) {
+        if (watts[i] <= 0 || cad[i] <= 0) continue;
+
+        double aepf = (watts[i] * 60.0) / (cad[i] * crankLength * 2.0 * M_PI);
+        double cpv = (cad[i] * crankLength * 2.0 * M_PI) / 60.0;
+
+        // > 2500 newtons is out of bounds, as it is for the scatter
+        int row = aepf / pfpvAEPFBinSize;
+        int column = cpv / pfpvCPVBinSize;
+        if (row >= pfpvRows || column >= pfpvColumns) continue;
+
+        // grows a row at a time, resize zeroes the new cells
+        int cell = (row * pfpvColumns) + column;
+        if (cell >= array.size()) array.resize((row+1) * pfpvColumns);
+        array[cell] += ride->recIntSecs();
+    }
+}
+
 //
 // AGGREGATE FOR A GIVEN DATE RANGE
 //
@@ -855,8 +1051,10 @@ static QDate dateFromFileName(const QString filename) {
     return QDate(); // nil date
 }
 
-// select and update bests
-static void meanMaxAggregate(QVector<double> &into, QVector<double> &other, QVector<QDate>&dates, QDate rideDate)
+// select and update bests, the dates come from the other
+// aggregate if it has them, otherwise it is a single ride
+static void meanMaxAggregate(QVector<double> &into, QVector<double> &other, QVector<QDate>&dates,
+                             QVector<QDate> &otherDates, QDate rideDate)
 {
     if (into.size() < other.size()) {
         into.resize(other.size());
@@ -866,7 +1064,7 @@ static void meanMaxAggregate(QVector<double> &into, QVector<double> &other, QVec
     for (int i=0; i<other.size(); i++)
         if (other[i] > into[i]) {
             into[i] = other[i];
-            dates[i] = rideDate;
+            dates[i] = i < otherDates.size() ? otherDates[i] : rideDate;
         }
 }
 
@@ -878,6 +1076,51 @@ static void distAggregate(QVector<double> &into, QVector<double> &other)
 
 }
 
+RideFileCache::RideFileCache(MainWindow *main) : main(main), rideFileName(""), ride(0)
+{
+    // time in zone are fixed to 10 zone max
+    wattsTimeInZone.resize(10);
+    hrTimeInZone.resize(10);
+}
+
+void
+RideFileCache::aggregate(RideFileCache &other, QDate rideDate)
+{
+    meanMaxAggregate(wattsMeanMaxDouble, other.wattsMeanMaxDouble, wattsMeanMaxDate, other.wattsMeanMaxDate, rideDate);
+    meanMaxAggregate(hrMeanMaxDouble, other.hrMeanMaxDouble, hrMeanMaxDate, other.hrMeanMaxDate, rideDate);
+    meanMaxAggregate(cadMeanMaxDouble, other.cadMeanMaxDouble, cadMeanMaxDate, other.cadMeanMaxDate, rideDate);
+    meanMaxAggregate(nmMeanMaxDouble, other.nmMeanMaxDouble, nmMeanMaxDate, other.nmMeanMaxDate, rideDate);
+    meanMaxAggregate(kphMeanMaxDouble, other.kphMeanMaxDouble, kphMeanMaxDate, other.kphMeanMaxDate, rideDate);
+    meanMaxAggregate(xPowerMeanMaxDouble, other.xPowerMeanMaxDouble, xPowerMeanMaxDate, other.xPowerMeanMaxDate, rideDate);
+    meanMaxAggregate(npMeanMaxDouble, other.npMeanMaxDouble, npMeanMaxDate, other.npMeanMaxDate, rideDate);
+    meanMaxAggregate(vamMeanMaxDouble, other.vamMeanMaxDouble, vamMeanMaxDate, other.vamMeanMaxDate, rideDate);
+    meanMaxAggregate(wattsKgMeanMaxDouble, other.wattsKgMeanMaxDouble, wattsKgMeanMaxDate, other.wattsKgMeanMaxDate, rideDate);
+
+    distAggregate(wattsDistributionDouble, other.wattsDistributionDouble);
+    distAggregate(hrDistributionDouble, other.hrDistributionDouble);
+    distAggregate(cadDistributionDouble, other.cadDistributionDouble);
+    distAggregate(nmDistributionDouble, other.nmDistributionDouble);
+    distAggregate(kphDistributionDouble, other.kphDistributionDouble);
+    distAggregate(xPowerDistributionDouble, other.xPowerDistributionDouble);
+    distAggregate(npDistributionDouble, other.npDistributionDouble);
+    distAggregate(wattsKgDistributionDouble, other.wattsKgDistributionDouble);
+    distAggregate(pfpvDouble, other.pfpvDouble);
+
+    // cumulate timeinzones
+    for (int i=0; i<10; i++) {
+        hrTimeInZone[i] += other.hrTimeInZone[i];
+        wattsTimeInZone[i] += other.wattsTimeInZone[i];
+    }
+}
+
+void
+RideFileCache::aggregateRide(QString rideFileName, QDate rideDate)
+{
+    // get its cached values (will refresh if needed...)
+    RideFileCache rideCache(main, main->home.absolutePath() + "/" + rideFileName);
+    aggregate(rideCache, rideDate);
+}
+
 RideFileCache::RideFileCache(MainWindow *main, QDate start, QDate end, bool filter, QStringList files)
                : start(start), end(end), main(main), rideFileName(""), ride(0) 
 {
@@ -920,42 +1163,45 @@ RideFileCache::RideFileCache(MainWindow *main, QDate start, QDate end, bool filt
     main->setCursor(Qt::WaitCursor);
 
     // Iterate over the ride files (not the cpx files since they /might/ not
-    // exist, or /might/ be out of date.
+    // exist, or /might/ be out of date. We group them by month so whole
+    // months and years can come from the rollups
+    QMap<QDate, QStringList> months;
     foreach (QString rideFileName, RideFileFactory::instance().listRideFiles(main->home)) {
         QDate rideDate = dateFromFileName(rideFileName);
         if (((filter == true && files.contains(rideFileName)) || filter == false) &&
             rideDate >= start && rideDate <= end) {
+            months[QDate(rideDate.year(), rideDate.month(), 1)] << rideFileName;
+        }
+    }
 
-            // get its cached values (will refresh if needed...)
-            RideFileCache rideCache(main, main->home.absolutePath() + "/" + rideFileName);
-
-            // lets aggregate
-            meanMaxAggregate(wattsMeanMaxDouble, rideCache.wattsMeanMaxDouble, wattsMeanMaxDate, rideDate);
-            meanMaxAggregate(hrMeanMaxDouble, rideCache.hrMeanMaxDouble, hrMeanMaxDate, rideDate);
-            meanMaxAggregate(cadMeanMaxDouble, rideCache.cadMeanMaxDouble, cadMeanMaxDate, rideDate);
-            meanMaxAggregate(nmMeanMaxDouble, rideCache.nmMeanMaxDouble, nmMeanMaxDate, rideDate);
-            meanMaxAggregate(kphMeanMaxDouble, rideCache.kphMeanMaxDouble, kphMeanMaxDate, rideDate);
-            meanMaxAggregate(xPowerMeanMaxDouble, rideCache.xPowerMeanMaxDouble, xPowerMeanMaxDate, rideDate);
-            meanMaxAggregate(npMeanMaxDouble, rideCache.npMeanMaxDouble, npMeanMaxDate, rideDate);
-            meanMaxAggregate(vamMeanMaxDouble, rideCache.vamMeanMaxDouble, vamMeanMaxDate, rideDate);
-            meanMaxAggregate(wattsKgMeanMaxDouble, rideCache.wattsKgMeanMaxDouble, wattsKgMeanMaxDate, rideDate);
-
-            distAggregate(wattsDistributionDouble, rideCache.wattsDistributionDouble);
-            distAggregate(hrDistributionDouble, rideCache.hrDistributionDouble);
-            distAggregate(cadDistributionDouble, rideCache.cadDistributionDouble);
-            distAggregate(nmDistributionDouble, rideCache.nmDistributionDouble);
-            distAggregate(kphDistributionDouble, rideCache.kphDistributionDouble);
-            distAggregate(xPowerDistributionDouble, rideCache.xPowerDistributionDouble);
-            distAggregate(npDistributionDouble, rideCache.npDistributionDouble);
-            distAggregate(wattsKgDistributionDouble, rideCache.wattsKgDistributionDouble);
-
-            // cumulate timeinzones
-            for (int i=0; i<10; i++) {
-                hrTimeInZone[i] += rideCache.hrTimeInZone[i];
-                wattsTimeInZone[i] += rideCache.wattsTimeInZone[i];
-            }
+    // the rollups cover every ride, so not when filtering
+    QMap<int, QMap<QDate, QStringList> > years;
+    QMapIterator<QDate, QStringList> month(months);
+    while (month.hasNext()) {
+        month.next();
+        QDate from = month.key();
+        QDate to = from.addMonths(1).addDays(-1);
+
+        if (filter == true || from < start || to > end) {
+
+            // partial month, just the rides
+            foreach (QString rideFileName, month.value())
+                aggregateRide(rideFileName, dateFromFileName(rideFileName));
+
+        } else if (QDate(from.year(), 1, 1) >= start && QDate(from.year(), 12, 31) <= end) {
+
+            // whole year, collect the months
+            years[from.year()].insert(from, month.value());
+
+        } else {
+
+            // whole month
+            QMap<QDate, QStringList> just;
+            just.insert(from, month.value());
+            rollup(from.toString("yyyy_MM"), just);
         }
     }
+    foreach (int year, years.keys()) rollup(QString("%1").arg(year), years[year]);
 
     // set the cursor back to normal
     main->setCursor(Qt::ArrowCursor);
@@ -969,6 +1215,110 @@ RideFileCache::RideFileCache(MainWindow *main, QDate start, QDate end, bool filt
 
 }
 
+//
+// BESTS ROLLUPS
+//
+// Aggregating a season means reading the .cpx for every ride in it, so
+// we keep the aggregate for each month and year in home as yyyy_MM.bests
+// and yyyy.bests. Each one lists the rides it was built from with their
+// timestamps, so when a ride is changed, added or deleted only its month
+// is rebuilt from the .cpx files and its year from the months.
+//
+static const quint32 RideFileRollupVersion = 2;
+
+// aggregate a month or year rollup into this, the months
+// are the rides in each month that the period covers
+void
+RideFileCache::rollup(QString period, QMap<QDate, QStringList> &months)
+{
+    // what it should have been built from
+    QMap<QString, uint> manifest;
+    foreach (QStringList rides, months.values())
+        foreach (QString rideFileName, rides)
+            manifest.insert(rideFileName, QFileInfo(main->home.absolutePath() + "/" + rideFileName).lastModified().toTime_t());
+
+    QString filename = main->home.absolutePath() + "/" + period + ".bests";
+    RideFileCache bests(main);
+
+    if (!bests.readRollup(filename, manifest)) {
+
+        // rebuild it, a year from its months and a month from its rides
+        if (period.length() == 4) {
+            QMapIterator<QDate, QStringList> month(months);
+            while (month.hasNext()) {
+                month.next();
+                QMap<QDate, QStringList> just;
+                just.insert(month.key(), month.value());
+                bests.rollup(month.key().toString("yyyy_MM"), just);
+            }
+        } else {
+            foreach (QString rideFileName, months.begin().value())
+                bests.aggregateRide(rideFileName, dateFromFileName(rideFileName));
+        }
+        bests.writeRollup(filename, manifest);
+    }
+    aggregate(bests, QDate());
+}
+
+bool
+RideFileCache::readRollup(QString filename, QMap<QString, uint> &manifest)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    quint32 version, cacheVersion;
+    double cl;
+    QMap<QString, uint> builtFrom;
+    in >> version;
+    if (version != RideFileRollupVersion) return false;
+    in >> cacheVersion >> cl >> builtFrom;
+
+    // out of date?
+    if (cacheVersion != RideFileCacheVersion || cl != crankLength() || builtFrom != manifest)
+        return false;
+
+    in >> wattsMeanMaxDouble >> hrMeanMaxDouble >> cadMeanMaxDouble >> nmMeanMaxDouble >> kphMeanMaxDouble
+       >> xPowerMeanMaxDouble >> npMeanMaxDouble >> vamMeanMaxDouble >> wattsKgMeanMaxDouble;
+    in >> wattsMeanMaxDate >> hrMeanMaxDate >> cadMeanMaxDate >> nmMeanMaxDate >> kphMeanMaxDate
+       >> xPowerMeanMaxDate >> npMeanMaxDate >> vamMeanMaxDate >> wattsKgMeanMaxDate;
+    in >> wattsDistributionDouble >> hrDistributionDouble >> cadDistributionDouble >> nmDistributionDouble
+       >> kphDistributionDouble >> xPowerDistributionDouble >> npDistributionDouble >> wattsKgDistributionDouble;
+    in >> wattsTimeInZone >> hrTimeInZone;
+    in >> pfpvDouble;
+
+    if (in.status() != QDataStream::Ok || wattsTimeInZone.size() != 10 || hrTimeInZone.size() != 10) {
+
+        // start again
+        *this = RideFileCache(main);
+        return false;
+    }
+    return true;
+}
+
+void
+RideFileCache::writeRollup(QString filename, QMap<QString, uint> &manifest)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return; // we'll just rebuild next time
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_4_6);
+
+    out << RideFileRollupVersion << (quint32) RideFileCacheVersion << crankLength() << manifest;
+
+    out << wattsMeanMaxDouble << hrMeanMaxDouble << cadMeanMaxDouble << nmMeanMaxDouble << kphMeanMaxDouble
+        << xPowerMeanMaxDouble << npMeanMaxDouble << vamMeanMaxDouble << wattsKgMeanMaxDouble;
+    out << wattsMeanMaxDate << hrMeanMaxDate << cadMeanMaxDate << nmMeanMaxDate << kphMeanMaxDate
+        << xPowerMeanMaxDate << npMeanMaxDate << vamMeanMaxDate << wattsKgMeanMaxDate;
+    out << wattsDistributionDouble << hrDistributionDouble << cadDistributionDouble << nmDistributionDouble
+        << kphDistributionDouble << xPowerDistributionDouble << npDistributionDouble << wattsKgDistributionDouble;
+    out << wattsTimeInZone << hrTimeInZone;
+    out << pfpvDouble;
+}
+
 //
 // PERSISTANCE
 //
@@ -981,6 +1331,7 @@ RideFileCache::serialize(QDataStream *out)
     head.version = RideFileCacheVersion;
     head.CP = CP;
     head.LTHR = LTHR;
+    head.CL = crankLength();
 
     head.wattsMeanMaxCount = wattsMeanMax.size();
     head.hrMeanMaxCount = hrMeanMax.size();
@@ -1000,6 +1351,7 @@ RideFileCache::serialize(QDataStream *out)
     head.nmDistrCount = nmDistribution.size();
     head.kphDistCount = kphDistribution.size();
     head.wattsKgDistCount = wattsKgDistribution.size();
+    head.pfpvCount = pfpv.size();
 
     out->writeRawData((const char *) &head, sizeof(head));
 
@@ -1027,6 +1379,9 @@ RideFileCache::serialize(QDataStream *out)
     // time in zone
     out->writeRawData((const char *) wattsTimeInZone.data(), sizeof(float) * wattsTimeInZone.size());
     out->writeRawData((const char *) hrTimeInZone.data(), sizeof(float) * hrTimeInZone.size());
+
+    // pfpv
+    out->writeRawData((const char *) pfpv.data(), sizeof(float) * pfpv.size());
 }
 
 void
@@ -1059,6 +1414,7 @@ RideFileCache::readCache()
         xPowerDistribution.resize(head.xPowerDistCount);
         npDistribution.resize(head.npDistCount);
         wattsKgDistribution.resize(head.wattsKgDistCount);
+        pfpv.resize(head.pfpvCount);
 
         // read in the arrays
         inFile.readRawData((char *) wattsMeanMax.data(), sizeof(float) * wattsMeanMax.size());
@@ -1086,6 +1442,9 @@ RideFileCache::readCache()
         inFile.readRawData((char *) wattsTimeInZone.data(), sizeof(float) * 10);
         inFile.readRawData((char *) hrTimeInZone.data(), sizeof(float) * 10);
 
+        // pfpv
+        inFile.readRawData((char *) pfpv.data(), sizeof(float) * pfpv.size());
+
         // setup the doubles the users use
         doubleArray(wattsMeanMaxDouble, wattsMeanMax, RideFile::watts);
         doubleArray(hrMeanMaxDouble, hrMeanMax, RideFile::hr);
@@ -1106,6 +1465,9 @@ RideFileCache::readCache()
         doubleArray(npDistributionDouble, npDistribution, RideFile::NP);
         doubleArray(wattsKgDistributionDouble, wattsKgDistribution, RideFile::wattsKg);
 
+        pfpvDouble.resize(pfpv.size());
+        for (int i=0; i<pfpv.size(); i++) pfpvDouble[i] = pfpv[i];
+
         cacheFile.close();
     }
 }
@@ -22,7 +22,13 @@
 #include <QString>
 #include <QDataStream>
 #include <QVector>
+#include <QMap>
+#include <QDate>
 #include <QThread>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QTextStream>
 
 class MainWindow;
 class RideFile;
@@ -38,7 +44,7 @@ typedef double data_t;
 // arrays when plotting CP curves and histograms. It is precoputed
 // to save time and cached in a file .cpx
 //
-static const unsigned int RideFileCacheVersion = 7;
+static const unsigned int RideFileCacheVersion = 8;
 // revision history:
 // version  date         description
 // 1        29-Apr-11    Initial - header, mean-max & distribution data blocks
@@ -48,12 +54,23 @@ static const unsigned int RideFileCacheVersion = 7;
 // 5        18-Aug-11    Added VAM mean maximals
 // 6        27-Jun-12    Added W/kg mean maximals and distribution
 // 7        03-Dec-12    Fixed W/kg calculations!
+// 8        17-Oct-13    Added PfPv histogram and the crank length used for it
 
 // The cache file (.cpx) has a binary format:
 // 1 x Header data - describing the version and contents of the cache
 // n x Blocks - meanmax or distribution arrays
 // 1 x Watts TIZ - 10 floats
 // 1 x Heartrate TIZ - 10 floats
+// 1 x PfPv histogram - pfpvCount floats
+
+// The PfPv histogram is the time in seconds spent in each cell of a
+// fixed AEPF x CPV grid, a row for each AEPF bin and a column for each
+// CPV bin. Rows above the highest AEPF seen are left off, so histograms
+// are summed by just adding them up and padding the shorter one.
+static const int pfpvColumns = 125;             // CPV 0 - 5 m/s
+static const double pfpvCPVBinSize = 0.04;      // m/s
+static const int pfpvRows = 200;                // AEPF 0 - 2500 N
+static const double pfpvAEPFBinSize = 12.5;     // N
 
 // The header is written directly to disk, the only
 // field which is endian sensitive is the count field
@@ -79,11 +96,13 @@ struct RideFileCacheHeader {
                  kphDistCount,
                  xPowerDistCount,
                  npDistCount,
-                 wattsKgDistCount;
+                 wattsKgDistCount,
+                 pfpvCount;
 
     int LTHR, // used to calculate Time in Zone (TIZ)
         CP;   // used to calculate Time in Zone (TIZ)
-                
+
+    float CL; // crank length used for the PfPv histogram
 };
 
 
@@ -130,12 +149,22 @@ class RideFileCache
 
         static int decimalsFor(RideFile::SeriesType series);
 
+        // is the .cpx for this ride file there and up to date?
+        static bool isCurrent(QString rideFileName);
+
+        // the crank length the caches are computed for
+        static double crankLength();
+
+        // add a ride to a PfPv histogram, see pfpvColumns above
+        static void computePfPv(QVector<float> &array, const RideFile *ride, double crankLength);
+
         // get data
         QVector<double> &meanMaxArray(RideFile::SeriesType); // return meanmax array for the given series
         QVector<QDate> &meanMaxDates(RideFile::SeriesType series); // the dates of the bests
         QVector<double> &distributionArray(RideFile::SeriesType); // return distribution array for the given series
         QVector<float> &wattsZoneArray() { return wattsTimeInZone; }
         QVector<float> &hrZoneArray() { return hrTimeInZone; }
+        QVector<double> &pfpvArray() { return pfpvDouble; } // seconds in each cell
 
         // explain the array binning / sampling
         double &distBinSize(RideFile::SeriesType); // return distribution bin size
@@ -153,6 +182,14 @@ class RideFileCache
         //void computeMeanMax(QVector<float>&, RideFile::SeriesType);      // compute mean max arrays
         void computeDistribution(QVector<float>&, RideFile::SeriesType); // compute the distributions
 
+        // date range aggregation, see BESTS ROLLUPS in RideFileCache.cpp
+        RideFileCache(MainWindow *main); // empty aggregate
+        void aggregate(RideFileCache &other, QDate rideDate);
+        void aggregateRide(QString rideFileName, QDate rideDate);
+        void rollup(QString period, QMap<QDate, QStringList> &months);
+        bool readRollup(QString filename, QMap<QString, uint> &manifest);
+        void writeRollup(QString filename, QMap<QString, uint> &manifest);
+
 
     private:
 
@@ -234,6 +271,9 @@ class RideFileCache
         QVector<float> wattsTimeInZone;   // time in zone in seconds
         QVector<float> hrTimeInZone;      // time in zone in seconds
 
+        QVector<float> pfpv;              // PfPv histogram in seconds
+        QVector<double> pfpvDouble;
+
         // we need to return doubles not longs, we just use longs
         // to reduce disk storage
         void doubleArray(QVector<double> &into, QVector<float> &from, RideFile::SeriesType series);
@@ -257,25 +297,36 @@ struct cpintdata {
     cpintdata() : rec_int_ms(0) {}
 };
 
-// the mean-max computer ... runs in a thread
-class MeanMaxComputer : public QThread
+// the mean-max computer ... runs in the global thread pool
+class MeanMaxComputer : public QRunnable
 {
     public:
-        MeanMaxComputer(RideFile *ride, QVector<float>&array, RideFile::SeriesType series)
-        : ride(ride), array(array), series(series) {}
+        MeanMaxComputer(RideFile *ride, QVector<float>&array, RideFile::SeriesType series, QSemaphore *done = NULL)
+        : ride(ride), array(array), series(series), done(done) { setAutoDelete(false); }
         void run();
 
+        // exact mean max total for every duration from 1 to datalength-1
+        // samples, worked out from the one integrated series
+        static void meanMax(const data_t *dataseries_i, int datalength, QVector<data_t> &bests);
+
+        // times meanMax against Mark Rages' algorithm on 1h, 6h and 24h rides
+        static void benchmark(QTextStream &out);
+
     private:
 
+        void compute();
+
         // Mark Rages' algorithm for fast find of mean max
-        data_t *integrate_series(cpintdata &data);
-        data_t partial_max_mean(data_t *dataseries_i, int start, int end, int length, int *offset);
-        data_t divided_max_mean(data_t *dataseries_i, int datalength, int length, int *offset);
+        // no longer used by compute, kept for the benchmark
+        static data_t *integrate_series(cpintdata &data);
+        static data_t partial_max_mean(data_t *dataseries_i, int start, int end, int length, int *offset);
+        static data_t divided_max_mean(data_t *dataseries_i, int datalength, int length, int *offset);
 
         RideFile *ride;
         QVector<float> &array;
         QVector<data_t> integratedArray;
 
         RideFile::SeriesType series;
+        QSemaphore *done;
 };
 #endif // _GC_RideFileCache_h
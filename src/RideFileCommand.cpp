@@ -80,7 +80,7 @@ RideFileCommand::insertPoint(int index, RideFilePoint *points)
 void
 RideFileCommand::appendPoints(QVector <RideFilePoint> newRows)
 {
-    AppendPointsCommand *cmd = new AppendPointsCommand(ride, ride->dataPoints().count(), newRows);
+    AppendPointsCommand *cmd = new AppendPointsCommand(ride, ride->samples(), newRows);
     doCommand(cmd);
 }
 
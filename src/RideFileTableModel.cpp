@@ -143,7 +143,7 @@ RideFileTableModel::data(const QModelIndex & index, int role) const
 {
     if (role == Qt::ToolTipRole) return toolTip(index.row(), columnType(index.column()));
 
-    if (index.row() >= ride->dataPoints().count() || index.column() >= headings_.count())
+    if (index.row() >= ride->samples() || index.column() >= headings_.count())
         return QVariant();
     else {
         return ride->getPoint(index.row(), headingsType[index.column()]);
@@ -169,7 +169,7 @@ RideFileTableModel::headerData(int section, Qt::Orientation orient, int role) co
 int
 RideFileTableModel::rowCount(const QModelIndex &) const
 {
-    if (ride) return ride->dataPoints().count();
+    if (ride) return ride->samples();
     else return 0;
 }
 
@@ -183,7 +183,7 @@ RideFileTableModel::columnCount(const QModelIndex &) const
 bool
 RideFileTableModel::setData(const QModelIndex & index, const QVariant &value, int role)
 {
-    if (index.row() >= ride->dataPoints().count() || index.column() >= headings_.count())
+    if (index.row() >= ride->samples() || index.column() >= headings_.count())
         return false;
     else if (role == Qt::EditRole) {
         ride->command->setPointValue(index.row(), headingsType[index.column()], value.toDouble());
@@ -210,7 +210,7 @@ RideFileTableModel::insertRow(int row, const QModelIndex &parent)
 bool
 RideFileTableModel::insertRows(int row, int count, const QModelIndex &)
 {
-    if (row >= ride->dataPoints().count()) return false;
+    if (row >= ride->samples()) return false;
     else {
         while (count--) {
             struct RideFilePoint *p = new RideFilePoint;
@@ -230,7 +230,7 @@ RideFileTableModel::appendRows(QVector<RideFilePoint>newRows)
 bool
 RideFileTableModel::removeRows(int row, int count, const QModelIndex &)
 {
-    if ((row + count) > ride->dataPoints().count()) return false;
+    if ((row + count) > ride->samples()) return false;
     ride->command->deletePoints(row, count);
     return true;
 }
@@ -287,7 +287,7 @@ RideFileTableModel::forceRedraw()
 {
     // tell the view to redraw everything
     if (ride)
-        dataChanged(createIndex(0,0), createIndex(headingsType.count(), ride->dataPoints().count()));
+        dataChanged(createIndex(0,0), createIndex(headingsType.count(), ride->samples()));
 }
 
 //
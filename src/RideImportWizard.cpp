@@ -24,6 +24,10 @@
 #include "MainWindow.h"
 #include "QuarqRideFile.h"
 #include <QWaitCondition>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QMutex>
 #include "Settings.h"
 #include "Units.h"
 #include "GcRideFile.h"
@@ -206,6 +210,247 @@ RideImportWizard::init(QList<QString> files, QDir &home, MainWindow * /*mainWind
     this->show();
 }
 
+/*----------------------------------------------------------------------
+ * Files are parsed and saved by jobs on the thread pool. Each job posts
+ * its result against its row and the dialog picks them up in row order,
+ * so the table still fills in from the top whichever file is done first
+ *----------------------------------------------------------------------*/
+
+// what the table shows for a ride found in a file
+struct RideImportRide
+{
+    QString filename;   // temporary file, when extracted from an archive
+    QDateTime start;
+    int secs;
+    double km;
+};
+
+// what a job hands back
+struct RideImportResult
+{
+    RideImportResult() : saved(false) {}
+
+    QStringList errors;
+    QList<RideImportRide> rides;    // parsing, empty if the file couldn't be read
+    bool saved;                     // saving
+};
+
+class RideImportQueue
+{
+    public:
+        RideImportQueue(int jobs) : results(jobs), posted(jobs, false), submitted(0), cancelled(false) {}
+
+        // the pool queues jobs when it is busy, so this never blocks
+        void submit(QRunnable *job) {
+            submitted++;
+            QThreadPool::globalInstance()->start(job);
+        }
+
+        void post(int job, const RideImportResult &result) {
+            {
+                QMutexLocker locker(&lock);
+                results[job] = result;
+                posted[job] = true;
+                ready.wakeAll();
+            }
+            finished.release();
+        }
+
+        // wait up to msecs for a job to finish
+        bool wait(int job, int msecs) {
+            QMutexLocker locker(&lock);
+            if (!posted[job]) ready.wait(&lock, msecs);
+            return posted[job];
+        }
+
+        RideImportResult take(int job) {
+            QMutexLocker locker(&lock);
+            return results[job];
+        }
+
+        // jobs that haven't started yet just post an empty result
+        void cancel() { QMutexLocker locker(&lock); cancelled = true; }
+        bool isCancelled() { QMutexLocker locker(&lock); return cancelled; }
+
+        // wait for the jobs to let go of the queue
+        void finish() { finished.acquire(submitted); submitted = 0; }
+
+    private:
+        QMutex lock;
+        QWaitCondition ready;
+        QSemaphore finished;
+        QVector<RideImportResult> results;
+        QVector<bool> posted;
+        int submitted;
+        bool cancelled;
+};
+
+static RideImportRide
+importRide(QString filename, const RideFile *ride)
+{
+    RideImportRide summary;
+    summary.filename = filename;
+    summary.start = ride->startTime();
+
+    // time and distance from tags (.gc files)
+    QMap<QString,QString> lookup;
+    lookup = ride->metricOverrides.value("total_distance");
+    summary.km = lookup.value("value", "0.0").toDouble();
+
+    lookup = ride->metricOverrides.value("workout_time");
+    summary.secs = lookup.value("value", "0.0").toDouble();
+
+    // otherwise by looking at last data point
+    int last = ride->samples() - 1;
+    if (last >= 0) {
+        if (!summary.secs) summary.secs = ride->getPointValue(last, RideFile::secs);
+        if (!summary.km) summary.km = ride->getPointValue(last, RideFile::km);
+    }
+    return summary;
+}
+
+// step 2, read the file with the relevant RideFileReader
+class RideImportParser : public QRunnable
+{
+    public:
+        RideImportParser(RideImportQueue *queue, int job, QString filename, const RideFileContext *context) :
+            queue(queue), job(job), filename(filename), context(context) {}
+
+        void run() {
+            RideImportResult result;
+
+            if (!queue->isCancelled()) {
+
+                QFile thisfile(filename);
+                QList<RideFile*> rides;
+                RideFile *ride = RideFileFactory::instance().openRideFile(*context, thisfile, result.errors, &rides);
+
+                // is this an archive of files?
+                if (rides.count() > 1) {
+
+                    // write each as a temporary file, using the original
+                    // filename with "-n" appended
+                    for (int counter=0; counter < rides.count(); counter++) {
+                        QString fulltarget = QDir::tempPath() + "/" + QFileInfo(thisfile).baseName() + QString("-%1.tcx").arg(counter+1);
+                        TcxFileReader reader;
+                        QFile target(fulltarget);
+                        reader.writeRideFile(context->main, rides[counter], target);
+                        result.rides << importRide(fulltarget, rides[counter]);
+                    }
+                    qDeleteAll(rides);
+
+                } else if (ride) {
+                    result.rides << importRide(QString(), ride);
+                    delete ride;
+                }
+            }
+            queue->post(job, result);
+        }
+
+    private:
+        RideImportQueue *queue;
+        int job;
+        QString filename;
+        const RideFileContext *context;
+};
+
+// step 4, copy the file into the library
+class RideImportSaver : public QRunnable
+{
+    public:
+        RideImportSaver(RideImportQueue *queue, int job, const RideFileContext *context, QString source,
+                        QString target, QString temporary, QDateTime ridedatetime) :
+            queue(queue), job(job), context(context), source(source), target(target),
+            temporary(temporary), ridedatetime(ridedatetime) {}
+
+        void run() {
+            RideImportResult result;
+
+            if (queue->isCancelled()) {
+                // leave it
+
+            // if its a gc file we need to parse and serialize
+            // using the ridedatetime and target filename
+            } else if (source.endsWith(".gc", Qt::CaseInsensitive) ||
+                       source.endsWith(".json", Qt::CaseInsensitive)) {
+
+                QFile thisfile(source);
+                RideFile *ride = RideFileFactory::instance().openRideFile(*context, thisfile, result.errors);
+                if (ride) {
+                    ride->setStartTime(ridedatetime);
+
+                    QFile file(target);
+                    if (source.endsWith(".gc", Qt::CaseInsensitive))
+                        result.saved = GcFileReader().writeRideFile(context->main, ride, file);
+                    else
+                        result.saved = JsonFileReader().writeRideFile(context->main, ride, file);
+                    delete ride;
+                }
+
+            // for native file formats the filename IS the ride date time so
+            // no need to write -- we just copy, when overwriting we copy
+            // alongside and move it over the target
+            } else if (temporary != "") {
+                result.saved = QFile(source).copy(temporary) && QFile(temporary).rename(target);
+            } else {
+                result.saved = QFile(source).copy(target);
+            }
+            queue->post(job, result);
+        }
+
+    private:
+        RideImportQueue *queue;
+        int job;
+        const RideFileContext *context;
+        QString source, target, temporary;
+        QDateTime ridedatetime;
+};
+
+void
+RideImportWizard::showRide(int i, const RideImportRide &ride, const QStringList &errors)
+{
+    // ride != NULL but !errors.isEmpty() means they're just warnings
+    if (errors.isEmpty())
+        tableWidget->item(i,5)->setText(tr("Validated"));
+    else
+        tableWidget->item(i,5)->setText(tr("Warning - ") + errors.join(tr(" ")));
+
+    // Set Date and Time
+    if (ride.start.isNull()) {
+
+        // Poo. The user needs to supply the date/time for this ride
+        blanks[i] = true;
+        tableWidget->item(i,1)->setText(tr(""));
+        tableWidget->item(i,2)->setText(tr(""));
+
+    } else {
+
+        // Cool, the date and time was extrcted from the source file
+        blanks[i] = false;
+        tableWidget->item(i,1)->setText(ride.start.toString(tr("dd MMM yyyy")));
+        tableWidget->item(i,2)->setText(ride.start.toString(tr("hh:mm:ss ap")));
+    }
+
+    tableWidget->item(i,1)->setTextAlignment(Qt::AlignRight); // put in the middle
+    tableWidget->item(i,2)->setTextAlignment(Qt::AlignRight); // put in the middle
+
+    // show duration
+    int secs = ride.secs;
+    QChar zero = QLatin1Char ( '0' );
+    QString time = QString("%1:%2:%3").arg(secs/3600,2,10,zero)
+        .arg(secs%3600/60,2,10,zero)
+        .arg(secs%60,2,10,zero);
+    tableWidget->item(i,3)->setText(time);
+    tableWidget->item(i,3)->setTextAlignment(Qt::AlignHCenter); // put in the middle
+
+    // show distance
+    QString dist = mainWindow->useMetricUnits
+        ? QString ("%1 km").arg(ride.km, 0, 'f', 1)
+        : QString ("%1 mi").arg(ride.km * MILES_PER_KM, 0, 'f', 1);
+    tableWidget->item(i,4)->setText(dist);
+    tableWidget->item(i,4)->setTextAlignment(Qt::AlignRight); // put in the middle
+}
+
 int
 RideImportWizard::process()
 {
@@ -258,31 +503,43 @@ RideImportWizard::process()
     repaint();
     QApplication::processEvents();
 
-    // Pass 2 - Read in with the relevant RideFileReader method
+    // Pass 2 - Read in with the relevant RideFileReader method, all the
+    //          files are queued for the thread pool up front
 
     phaseLabel->setText(tr("Step 2 of 4: Validating Files"));
-   for (int i=0; i< filenames.count(); i++) {
 
+    // the jobs open the files with this, taken here on the gui thread
+    RideFileContext context(mainWindow);
+
+    int jobs = filenames.count();
+    RideImportQueue queue(jobs);
+    for (int i=0; i < jobs; i++) {
+        if (!tableWidget->item(i,5)->text().startsWith(tr("Error")))
+            queue.submit(new RideImportParser(&queue, i, filenames[i], &context));
+    }
+
+    // rows move down when an archive turns into several rides
+    for (int job=0, i=0; job < jobs; job++, i++) {
 
         // does the status say Queued?
         if (!tableWidget->item(i,5)->text().startsWith(tr("Error"))) {
 
-              QStringList errors;
-              QFile thisfile(filenames[i]);
-
               tableWidget->item(i,5)->setText(tr("Parsing..."));
               tableWidget->setCurrentCell(i,5);
-              QApplication::processEvents();
-
-              if (aborted) { done(0); }
               this->repaint();
-              QApplication::processEvents();
 
-              QList<RideFile*> rides;
-              RideFile *ride = RideFileFactory::instance().openRideFile(mainWindow, thisfile, errors, &rides);
+              while (!queue.wait(job, 50) && !aborted) QApplication::processEvents();
+              if (aborted) {
+                  queue.cancel();
+                  queue.finish();
+                  done(0);
+                  return 0;
+              }
+
+              RideImportResult result = queue.take(job);
 
               // is this an archive of files?
-              if (rides.count() > 1) {
+              if (result.rides.count() > 1) {
 
                  int here = i;
 
@@ -292,28 +549,22 @@ RideImportWizard::process()
                  tableWidget->removeRow(here);
 
                  // resize dialog according to the number of rows we expect
-                 int willhave = filenames.count() + rides.count();
+                 int willhave = filenames.count() + result.rides.count();
                  resize(920 + ((willhave > 16 ? 24 : 0) +
                      (willhave > 9 && willhave < 17) ? 8 : 0),
                      118 + (willhave > 16 ? 17*20 : (willhave+1) * 20));
 
 
-                 // ok so create a temporary file and add to the tableWidget
+                 // the worker wrote each to a temporary file, add them to the tableWidget
                  int counter = 0;
-                 foreach(RideFile *extracted, rides) {
-
-                     // write as a temporary file, using the original
-                     // filename with "-n" appended
-                     QString fulltarget = QDir::tempPath() + "/" + QFileInfo(thisfile).baseName() + QString("-%1.tcx").arg(counter+1);
-                     TcxFileReader reader;
-                     QFile target(fulltarget);
-                     reader.writeRideFile(mainWindow, extracted, target);
+                 foreach(RideImportRide extracted, result.rides) {
+
+                     QString fulltarget = extracted.filename;
                      deleteMe.append(fulltarget);
-                     delete extracted;
-                     
+
                      // now add each temporary file ...
-                     filenames.insert(here, fulltarget);
-                     blanks.insert(here, true); // by default editable
+                     filenames.insert(here+counter, fulltarget);
+                     blanks.insert(here+counter, true); // by default editable
                      tableWidget->insertRow(here+counter);
 
                      QTableWidgetItem *t;
@@ -355,93 +606,35 @@ RideImportWizard::process()
                      t->setFlags(t->flags() & (~Qt::ItemIsEditable));
                      tableWidget->setItem(here+counter,5,t);
 
+                     // no need to read it again, we already have it
+                     showRide(here+counter, extracted, QStringList());
+
                      counter++;
 
                      tableWidget->adjustSize();
                  }
-                 QApplication::processEvents();
-
 
                  // progress bar needs to adjust...
                  progressBar->setMaximum(filenames.count()*4);
 
-                 // then go back one and re-parse from there
-                 rides.clear();
-   
-                 i--;
-                 goto next; // buttugly I know, but count em across 100,000 lines of code
-
-              }
+                 i += counter - 1;
+                 progressBar->setValue(progressBar->value() + counter - 1);
 
               // did it parse ok?
-              if (ride) {
-
-                   // ride != NULL but !errors.isEmpty() means they're just warnings
-                   if (errors.isEmpty())
-                       tableWidget->item(i,5)->setText(tr("Validated"));
-                   else
-                       tableWidget->item(i,5)->setText(tr("Warning - ") + errors.join(tr(" ")));
-
-                   // Set Date and Time
-                   if (ride->startTime().isNull()) {
-
-                       // Poo. The user needs to supply the date/time for this ride
-                       blanks[i] = true;
-                       tableWidget->item(i,1)->setText(tr(""));
-                       tableWidget->item(i,2)->setText(tr(""));
-
-                   } else {
-
-                       // Cool, the date and time was extrcted from the source file
-                       blanks[i] = false;
-                       tableWidget->item(i,1)->setText(ride->startTime().toString(tr("dd MMM yyyy")));
-                       tableWidget->item(i,2)->setText(ride->startTime().toString(tr("hh:mm:ss ap")));
-                   }
-
-                   tableWidget->item(i,1)->setTextAlignment(Qt::AlignRight); // put in the middle
-                   tableWidget->item(i,2)->setTextAlignment(Qt::AlignRight); // put in the middle
-
-                   // time and distance from tags (.gc files)
-                   QMap<QString,QString> lookup;
-                   lookup = ride->metricOverrides.value("total_distance");
-                   double km = lookup.value("value", "0.0").toDouble();
-
-                   lookup = ride->metricOverrides.value("workout_time");
-                   int secs = lookup.value("value", "0.0").toDouble();
-
-                   // show duration by looking at last data point
-                   if (!ride->dataPoints().isEmpty() && ride->dataPoints().last() != NULL) {
-                       if (!secs) secs = ride->dataPoints().last()->secs;
-                       if (!km) km = ride->dataPoints().last()->km;
-                   }
-
-                   QChar zero = QLatin1Char ( '0' );
-                   QString time = QString("%1:%2:%3").arg(secs/3600,2,10,zero)
-                       .arg(secs%3600/60,2,10,zero)
-                       .arg(secs%60,2,10,zero);
-                   tableWidget->item(i,3)->setText(time);
-                   tableWidget->item(i,3)->setTextAlignment(Qt::AlignHCenter); // put in the middle
-
-                   // show distance by looking at last data point
-                   QString dist = mainWindow->useMetricUnits
-                       ? QString ("%1 km").arg(km, 0, 'f', 1)
-                       : QString ("%1 mi").arg(km * MILES_PER_KM, 0, 'f', 1);
-                   tableWidget->item(i,4)->setText(dist);
-                   tableWidget->item(i,4)->setTextAlignment(Qt::AlignRight); // put in the middle
-
-                   delete ride;
-               } else {
+              } else if (result.rides.count()) {
+
+                  showRide(i, result.rides[0], result.errors);
+
+              } else {
                    // nope - can't handle this file
-                   tableWidget->item(i,5)->setText(tr("Error - ") + errors.join(tr(" ")));
-               }
+                   tableWidget->item(i,5)->setText(tr("Error - ") + result.errors.join(tr(" ")));
+              }
         }
         progressBar->setValue(progressBar->value()+1);
         QApplication::processEvents();
-        if (aborted) { done(0); }
         this->repaint();
-
-        next:;
     }
+    queue.finish();
 
     // Pass 3 - get missing date and times for imported files
     //         Actually allow us to edit date on ANY ride, we
@@ -754,16 +947,19 @@ RideImportWizard::abortClicked()
 
     QChar zero = QLatin1Char ( '0' );
 
+    // work out where each file goes and move any duplicates out of the
+    // way, then the copying and writing is queued for the thread pool
+    RideFileContext context(mainWindow);
+    RideImportQueue queue(filenames.count());
+    QList<int> rows;
+    QList<bool> overwritten;
+    QStringList targets, failures;
+    QSet<QString> claimed;
+
     for (int i=0; i< filenames.count(); i++) {
 
         if (tableWidget->item(i,5)->text().startsWith(tr("Error"))) continue; // skip error
 
-        tableWidget->item(i,5)->setText(tr("Saving..."));
-        tableWidget->setCurrentCell(i,5);
-        QApplication::processEvents();
-        if (aborted) { done(0); }
-        this->repaint();
-
         // Setup the ridetime as a QDateTime
         QDateTime ridedatetime = QDateTime(QDate().fromString(tableWidget->item(i,1)->text(), tr("dd MMM yyyy")),
                                  QTime().fromString(tableWidget->item(i,2)->text(), tr("hh:mm:ss a")));
@@ -779,9 +975,17 @@ RideImportWizard::abortClicked()
                                .arg ( targetnosuffix )
                                .arg ( suffix );
         QString fulltarget = home.absolutePath() + "/" + target;
+        QString fulltargettmp;
+        QString failure;
+        bool overwrite = false;
+
+        // two rides in this import with the same date and time
+        if (claimed.contains(targetnosuffix)) {
+            tableWidget->item(i,5)->setText(tr("Error - File exists"));
+            continue;
+        }
 
-        // if its a gc file we need to parse and serialize
-        // using the ridedatetime and target filename
+        // gc files are parsed and serialized with the new date and time
         if (filenames[i].endsWith(".gc", Qt::CaseInsensitive) ||
             filenames[i].endsWith(".json", Qt::CaseInsensitive)) {
 
@@ -791,100 +995,100 @@ RideImportWizard::abortClicked()
             duplicates = findDuplicates(fulltarget);
             if (duplicates.count() && !overwriteFiles) {
                 tableWidget->item(i,5)->setText(tr("Error - File exists"));
-            } else {
-
-                // wipe away the duplicate
-                foreach(QString duplicate, duplicates) {
-                    removeDuplicate(duplicate); // we do not use removeRide coz it clashes
-                }
-
-                // read the file (again)
-                QStringList errors;
-                QFile thisfile(filenames[i]);
-                RideFile *ride(RideFileFactory::instance().openRideFile(mainWindow, thisfile, errors));
-
-                // update ridedatetime
-                ride->setStartTime(ridedatetime);
-
-                // serialize
-                if (filenames[i].endsWith(".gc")) {
-                    GcFileReader reader;
-                    QFile target(fulltarget);
-                    reader.writeRideFile(mainWindow, ride, target);
-                } else {
-                    JsonFileReader reader;
-                    QFile target(fulltarget);
-                    reader.writeRideFile(mainWindow, ride, target);
-                }
-
-                // clear
-                delete ride;
+                continue;
+            }
 
-                if (duplicates.count()) {
-                    tableWidget->item(i,5)->setText(tr("File Overwritten"));
-                } else {
-                    tableWidget->item(i,5)->setText(tr("File Saved"));
-                    mainWindow->addRide(QFileInfo(fulltarget).fileName(), true);
-                }
+            // wipe away the duplicate
+            foreach(QString duplicate, duplicates) {
+                removeDuplicate(duplicate); // we do not use removeRide coz it clashes
             }
+            overwrite = duplicates.count() > 0;
+            failure = tr("Error - write failed");
 
         } else {
-            // for native file formats the filename IS the ride date time so
-            // no need to write -- we just copy
 
             // so now we have sourcefile in 'filenames[i]' and target file name in 'target'
             if (!fulltarget.compare(filenames[i])) { // they are the same file! so skip copy
                 tableWidget->item(i,5)->setText(tr("Error - Source is Target"));
+                continue;
 
             // CHECK FOR DUPLICATE
             } else if (findDuplicates(fulltarget).count()) {
-                if (overwriteFiles) {
-
-                    // wipe away that duplicate
-                    foreach(QString duplicate, findDuplicates(fulltarget)) {
-                        removeDuplicate(duplicate);
-                    }
-
-                    tableWidget->item(i,5)->setText(tr("Overwriting file..."));
-                    QFile source(filenames[i]);
-                    QString fulltargettmp(home.absolutePath() + tr("/") + targetnosuffix + tr(".tmp"));
-
-                    if (source.copy(fulltargettmp)) {
-
-                        // mv tmp to target
-                        QFile temp(fulltargettmp);
-                        if (temp.rename(fulltarget)) {
-                            tableWidget->item(i,5)->setText(tr("File Overwritten"));
-                            //no need to add since its already there!
-                        } else
-                            tableWidget->item(i,5)->setText(tr("Error - overwrite failed"));
-                    } else {
-                        tableWidget->item(i,5)->setText(tr("Error - overwrite failed"));
-                    }
-                } else {
+                if (!overwriteFiles) {
                     tableWidget->item(i,5)->setText(tr("Error - File exists"));
+                    continue;
                 }
+
+                // wipe away that duplicate
+                foreach(QString duplicate, findDuplicates(fulltarget)) {
+                    removeDuplicate(duplicate);
+                }
+                fulltargettmp = home.absolutePath() + tr("/") + targetnosuffix + tr(".tmp");
+                overwrite = true;
+                failure = tr("Error - overwrite failed");
+
             } else {
-                    tableWidget->item(i,5)->setText(tr("Saving file..."));
-                    QFile source(filenames[i]);
-                    if (source.copy(fulltarget)) {
-                        tableWidget->item(i,5)->setText(tr("File Saved"));
-                        mainWindow->addRide(QFileInfo(fulltarget).fileName(), true); // add to tree view
-                        // free immediately otherwise all imported rides are cached
-                        // and with large imports this can lead to memory exhaustion
-                        // BUT! Some charts/windows will hava snaffled away the ridefile
-                        // pointer which is now invalid so once all the rides have been imported
-                        // we need to select the last one... see below
-                        mainWindow->rideItem()->freeMemory();
-                    } else
-                        tableWidget->item(i,5)->setText(tr("Error - copy failed"));
+                failure = tr("Error - copy failed");
             }
         }
-        QApplication::processEvents();
-        if (aborted) { done(0); }
-        progressBar->setValue(progressBar->value()+1);
+
+        claimed << targetnosuffix;
+        rows << i;
+        overwritten << overwrite;
+        targets << fulltarget;
+        failures << failure;
+        queue.submit(new RideImportSaver(&queue, i, &context, filenames[i], fulltarget, fulltargettmp, ridedatetime));
+    }
+
+    // the metrics and .cpx caches are brought up to date in one go
+    // when we're done, rather than as each ride is added
+    mainWindow->ismultisave = true;
+
+    for (int n=0; n < rows.count(); n++) {
+
+        int i = rows[n];
+        tableWidget->item(i,5)->setText(overwritten[n] ? tr("Overwriting file...") : tr("Saving..."));
+        tableWidget->setCurrentCell(i,5);
         this->repaint();
+
+        while (!queue.wait(i, 50) && !aborted) QApplication::processEvents();
+        if (aborted) break;
+
+        RideImportResult result = queue.take(i);
+
+        if (!result.saved) {
+            if (result.errors.count()) tableWidget->item(i,5)->setText(tr("Error - ") + result.errors.join(tr(" ")));
+            else tableWidget->item(i,5)->setText(failures[n]);
+
+        } else if (overwritten[n]) {
+            tableWidget->item(i,5)->setText(tr("File Overwritten"));
+            //no need to add since its already there!
+
+        } else {
+            tableWidget->item(i,5)->setText(tr("File Saved"));
+            mainWindow->addRide(QFileInfo(targets[n]).fileName(), true); // add to tree view
+            // free immediately otherwise all imported rides are cached
+            // and with large imports this can lead to memory exhaustion
+            // BUT! Some charts/windows will hava snaffled away the ridefile
+            // pointer which is now invalid so once all the rides have been imported
+            // we need to select the last one... see below
+            mainWindow->rideItem()->freeMemory();
+        }
+        progressBar->setValue(progressBar->value()+1);
+        QApplication::processEvents();
     }
+    if (aborted) queue.cancel();
+    queue.finish();
+
+    mainWindow->ismultisave = false;
+    mainWindow->isclean = false;
+    mainWindow->metricDB->refreshMetrics();
+
+    if (aborted) {
+        done(0);
+        return;
+    }
+
 
 #if 0 // NOT UNTIL CPINTPLOT.CPP IS REFACTORED TO SEPERATE CPI FILES MAINTENANCE FROM CP PLOT CODE
     // if done when labelled save we copy the files and run the cpi calculator
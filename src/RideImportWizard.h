@@ -28,6 +28,8 @@
 #include <boost/scoped_ptr.hpp>
 #include "MainWindow.h"
 
+struct RideImportRide;
+
 // Dialog class to show filenames, import progress and to capture user input
 // of ride date and time
 
@@ -54,6 +56,7 @@ private slots:
 
 private:
     void init(QList<QString> files, QDir &home, MainWindow *main);
+    void showRide(int row, const RideImportRide &ride, const QStringList &errors);
     QList <QString> filenames; // list of filenames passed
     QList <bool> blanks; // record of which have a RideFileReader returned date & time
     QDir home; // target directory
@@ -21,6 +21,8 @@
 #include "RideMetric.h"
 #include "RideFile.h"
 #include "MainWindow.h"
+#include "RideResidency.h"
+#include "RidePrefetcher.h"
 #include "Zones.h"
 #include "HrZones.h"
 #include <assert.h>
@@ -29,7 +31,7 @@
 RideItem::RideItem(int type,
                    QString path, QString fileName, const QDateTime &dateTime,
                    const Zones *zones, const HrZones *hrZones, QString notesFileName, MainWindow *main) :
-    QTreeWidgetItem(type), ride_(NULL), main(main), isdirty(false), isedit(false), path(path), fileName(fileName),
+    QTreeWidgetItem(type), ride_(NULL), main(main), isdirty(false), prefetched(false), isedit(false), path(path), fileName(fileName),
     dateTime(dateTime), zones(zones), hrZones(hrZones), notesFileName(notesFileName)
 {
     setText(0, dateTime.toString("ddd"));
@@ -39,15 +41,49 @@ RideItem::RideItem(int type,
     setTextAlignment(2, Qt::AlignRight);
 }
 
+RideItem::~RideItem()
+{
+    if (main && main->residency) main->residency->freed(this);
+}
+
 RideFile *RideItem::ride()
 {
-    if (ride_) return ride_;
+    if (ride_) {
+        if (prefetched && main && main->prefetcher) main->prefetcher->hit();
+        prefetched = false;
+        if (main && main->residency) main->residency->used(this);
+        return ride_;
+    }
 
     // open the ride file
     QFile file(path + "/" + fileName);
     ride_ = RideFileFactory::instance().openRideFile(main, file, errors_);
     if (ride_ == NULL) return NULL; // failed to read ride
 
+    // the budget may mean another ride has to go
+    if (main && main->prefetcher) main->prefetcher->miss();
+    if (main && main->residency) main->residency->loaded(this);
+    opened();
+    return ride_;
+}
+
+// the prefetcher read it for us, unless we got there first
+bool
+RideItem::adopt(RideFile *ride)
+{
+    if (ride_) return false;
+
+    ride_ = ride;
+    errors_.clear();
+    prefetched = true;
+    if (main && main->residency) main->residency->prefetched(this);
+    opened();
+    return true;
+}
+
+void
+RideItem::opened()
+{
     setDirty(false); // we're gonna use on-disk so by
                      // definition it is clean - but do it *after*
                      // we read the file since it will almost
@@ -58,8 +94,6 @@ RideFile *RideItem::ride()
     connect(ride_, SIGNAL(modified()), this, SLOT(modified()));
     connect(ride_, SIGNAL(saved()), this, SLOT(saved()));
     connect(ride_, SIGNAL(reverted()), this, SLOT(reverted()));
-
-    return ride_;
 }
 
 void
@@ -178,11 +212,19 @@ void
 RideItem::freeMemory()
 {
     if (ride_) {
+        if (main && main->residency) main->residency->freed(this);
         delete ride_;
         ride_ = NULL;
+        prefetched = false;
     }
 }
 
+qint64
+RideItem::memoryUsed() const
+{
+    return ride_ ? ride_->memoryUsed() : 0;
+}
+
 #if 0
 void
 RideItem::computeMetrics()
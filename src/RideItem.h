@@ -51,6 +51,8 @@ class RideItem : public QObject, public QTreeWidgetItem //<< for signals/slots
         QStringList errors_;
         MainWindow *main; // to notify widgets when date/time changes
         bool isdirty;
+        bool prefetched; // opened by the prefetcher and not asked for yet
+        void opened();
 
     public slots:
         void modified();
@@ -85,6 +87,10 @@ class RideItem : public QObject, public QTreeWidgetItem //<< for signals/slots
         void setFileName(QString, QString);
         void setStartTime(QDateTime);
         void freeMemory();
+        bool isOpen() const { return ride_ != NULL; }
+        bool adopt(RideFile *ride); // from the prefetcher, false if already open
+        qint64 memoryUsed() const; // by the ride, if it is open
+        ~RideItem();
 
         int zoneRange();
         int hrZoneRange();
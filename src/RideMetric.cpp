@@ -23,6 +23,49 @@
 RideMetricFactory *RideMetricFactory::_instance;
 QVector<QString> RideMetricFactory::noDeps;
 
+// work out the level of a metric from its dependencies, -1 is
+// not yet known and -2 marks one we are working out (a cycle)
+int
+RideMetricFactory::planLevel(int id, QVector<int> &levels) const
+{
+    if (levels[id] >= 0) return levels[id];
+    assert(levels[id] != -2);
+    levels[id] = -2;
+
+    int level = 0;
+    foreach (int dep, dependencyIds[id])
+        level = qMax(level, planLevel(dep, levels) + 1);
+    return levels[id] = level;
+}
+
+void
+RideMetricFactory::plan() const
+{
+    RideMetricFactory *self = const_cast<RideMetricFactory*>(this);
+    QMutexLocker locker(&self->planLock);
+    if (planned) return;
+    checkDependencies();
+
+    // dependencies by id
+    self->dependencyIds.fill(QVector<int>(), metricNames.size());
+    for (int i=0; i<metricNames.size(); i++)
+        foreach (const QString &dep, dependencies(metricNames[i]))
+            self->dependencyIds[i].append(metricIdMap.value(dep));
+
+    // levels, and the order runs through them a level at a time
+    QVector<int> levels(metricNames.size(), -1);
+    int top = 0;
+    for (int i=0; i<metricNames.size(); i++) top = qMax(top, planLevel(i, levels));
+
+    self->planOrder.clear();
+    for (int level=0; level<=top; level++)
+        for (int i=0; i<metricNames.size(); i++)
+            if (levels[i] == level) self->planOrder.append(i);
+    self->planLevels = levels;
+
+    self->planned = true;
+}
+
 QHash<QString,RideMetricPtr>
 RideMetric::computeMetrics(const MainWindow *main, const RideFile *ride, const Zones *zones, const HrZones *hrZones,
                            const QStringList &metrics)
@@ -31,39 +74,53 @@ RideMetric::computeMetrics(const MainWindow *main, const RideFile *ride, const Z
     int hrZoneRange = hrZones->whichRange(ride->startTime().date());
 
     const RideMetricFactory &factory = RideMetricFactory::instance();
-    QStringList todo = metrics;
-    QHash<QString,RideMetric*> done;
+    const QVector<int> &order = factory.executionOrder();
+
+    // the metrics asked for and everything they depend on
+    QVector<bool> needed(factory.metricCount(), false);
+    QVector<int> todo;
+    foreach (QString symbol, metrics) {
+        int id = factory.metricId(symbol);
+        if (id >= 0 && !needed[id]) {
+            needed[id] = true;
+            todo.append(id);
+        }
+    }
     while (!todo.isEmpty()) {
-        QString symbol = todo.takeFirst();
-        if (!factory.haveMetric(symbol)) continue;
-        const QVector<QString> &deps = factory.dependencies(symbol);
-        bool ready = true;
-        foreach (QString dep, deps) {
-            if (!done.contains(dep)) {
-                ready = false;
-                if (!todo.contains(dep))
-                    todo.append(dep);
+        int id = todo.last();
+        todo.pop_back();
+        foreach (int dep, factory.dependencies(id)) {
+            if (!needed[dep]) {
+                needed[dep] = true;
+                todo.append(dep);
             }
         }
-        if (ready) {
-            RideMetric *m = factory.newMetric(symbol);
-            //if (!ride->dataPoints().isEmpty())
-                m->compute(ride, zones, zoneRange, hrZones, hrZoneRange, done, main);
-            if (ride->metricOverrides.contains(symbol))
-                m->override(ride->metricOverrides.value(symbol));
-            done.insert(symbol, m);
-        }
-        else {
-            if (!todo.contains(symbol))
-                todo.append(symbol);
-        }
     }
+
+    // run through the plan, everything a metric depends on comes before
+    // it. The rides are refreshed in parallel so we don't farm out the
+    // metrics of one ride as well, the pool is busy enough already.
+    QVector<RideMetric*> computed(factory.metricCount(), NULL);
+    QHash<QString,RideMetric*> done;
+    foreach (int id, order) {
+        if (!needed[id]) continue;
+
+        QString symbol = factory.metricName(id);
+        RideMetric *m = computed[id] = factory.newMetric(id);
+        //if (!ride->dataPoints().isEmpty())
+            m->compute(ride, zones, zoneRange, hrZones, hrZoneRange, done, main);
+        if (ride->metricOverrides.contains(symbol))
+            m->override(ride->metricOverrides.value(symbol));
+        done.insert(symbol, m);
+    }
+
     QHash<QString,RideMetricPtr> result;
     foreach (QString symbol, metrics) {
-        result.insert(symbol, QSharedPointer<RideMetric>(done.value(symbol)));
-        done.remove(symbol);
+        int id = factory.metricId(symbol);
+        if (result.contains(symbol)) continue;
+        result.insert(symbol, QSharedPointer<RideMetric>(id >= 0 ? computed[id] : NULL));
+        if (id >= 0) computed[id] = NULL;
     }
-    foreach (QString symbol, done.keys())
-        delete done.value(symbol);
+    qDeleteAll(computed);
     return result;
 }
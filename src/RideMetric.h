@@ -24,6 +24,7 @@
 #include <QString>
 #include <QVector>
 #include <QSharedPointer>
+#include <QMutex>
 #include <assert.h>
 #include <math.h>
 #include <QDebug>
@@ -175,7 +176,18 @@ class RideMetricFactory {
     QHash<QString,QVector<QString>*> dependencyMap;
     bool dependenciesChecked;
 
-    RideMetricFactory() : dependenciesChecked(false) {}
+    // The execution plan is built once from the dependencies. Metrics are
+    // identified by their position in metricNames, each one is given a
+    // level one above the highest of its dependencies and the order runs
+    // through the levels, so metrics on the same level are independent.
+    QVector<RideMetric*> metricIds;
+    QHash<QString,int> metricIdMap;
+    QVector<QVector<int> > dependencyIds;
+    QVector<int> planOrder, planLevels;
+    bool planned;
+    QMutex planLock;
+
+    RideMetricFactory() : dependenciesChecked(false), planned(false) {}
     RideMetricFactory(const RideMetricFactory &other);
     RideMetricFactory &operator=(const RideMetricFactory &other);
 
@@ -188,6 +200,9 @@ class RideMetricFactory {
         const_cast<RideMetricFactory*>(this)->dependenciesChecked = true;
     }
 
+    void plan() const;
+    int planLevel(int id, QVector<int> &levels) const;
+
     public:
 
     static RideMetricFactory &instance() {
@@ -220,7 +235,10 @@ class RideMetricFactory {
     bool addMetric(const RideMetric &metric,
                    const QVector<QString> *deps = NULL) {
         assert(!metrics.contains(metric.symbol()));
-        metrics.insert(metric.symbol(), metric.clone());
+        RideMetric *prototype = metric.clone();
+        metrics.insert(metric.symbol(), prototype);
+        metricIdMap.insert(metric.symbol(), metricIds.size());
+        metricIds.append(prototype);
         metricNames.append(metric.symbol());
         metricTypes.append(metric.type());
         if (deps) {
@@ -230,6 +248,7 @@ class RideMetricFactory {
             dependencyMap.insert(metric.symbol(), copy);
             dependenciesChecked = false;
         }
+        planned = false;
         return true;
     }
 
@@ -238,6 +257,14 @@ class RideMetricFactory {
         QVector<QString> *result = dependencyMap.value(symbol);
         return result ? *result : noDeps;
     }
+
+    // Working with the EXECUTION PLAN -- metric ids are the same as the
+    // index used with metricName(i), -1 if there is no such metric
+    int metricId(const QString &symbol) const { return metricIdMap.value(symbol, -1); }
+    RideMetric *newMetric(int id) const { return metricIds[id]->clone(); }
+    const QVector<int> &dependencies(int id) const { plan(); return dependencyIds[id]; }
+    const QVector<int> &executionOrder() const { plan(); return planOrder; }
+    int metricLevel(int id) const { plan(); return planLevels[id]; }
 };
 
 #endif // _GC_RideMetric_h
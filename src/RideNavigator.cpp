@@ -18,6 +18,7 @@
 
 #include "RideNavigator.h"
 #include "RideNavigatorProxy.h"
+#include "RideNavigatorModel.h"
 #include "SearchFilterBox.h"
 
 #include <QtGui>
@@ -42,15 +43,10 @@ RideNavigator::RideNavigator(MainWindow *parent, bool mainwindow) : main(parent)
     if (mainwindow) mainLayout->setContentsMargins(0,0,0,0);
     else mainLayout->setContentsMargins(2,2,2,2); // so we can resize!
 
-    sqlModel = new QSqlTableModel(this, main->metricDB->db()->connection());
-    sqlModel->setTable("metrics");
-    //sqlModel->setSort(2, Qt::AscendingOrder); // date backwards
-    sqlModel->setEditStrategy(QSqlTableModel::OnManualSubmit);
-    sqlModel->select();
-    while (sqlModel->canFetchMore(QModelIndex())) sqlModel->fetchMore(QModelIndex());
+    rideModel = new RideNavigatorModel(this, main->metricDB->db());
 
     searchFilter = new SearchFilter(this);
-    searchFilter->setSourceModel(sqlModel); // filter out/in search results
+    searchFilter->setSourceModel(rideModel); // filter out/in search results
 
     groupByModel = new GroupByModel(this);
     groupByModel->setSourceModel(searchFilter);
@@ -143,7 +139,7 @@ RideNavigator::~RideNavigator()
 {
     delete tableView;
     delete groupByModel;
-    delete sqlModel;
+    delete rideModel;
 }
 
 void
@@ -151,9 +147,10 @@ RideNavigator::refresh()
 {
     fontHeight = QFontMetrics(QFont()).height();
 
-    sqlModel->select();
-    while (sqlModel->canFetchMore(QModelIndex()))
-        sqlModel->fetchMore(QModelIndex());
+    // only the rides that changed are updated, unless the
+    // columns changed too, in which case we start over
+    if (rideModel->refresh()) resetView();
+    else tableView->viewport()->update(); // units may have changed
 
     active=false;
     rideTreeSelectionChanged();
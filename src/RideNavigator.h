@@ -29,10 +29,10 @@
 #include "Settings.h"
 #include "Colors.h"
 
-#include <QSqlTableModel>
 #include <QTableView>
 
 class NavigatorCellDelegate;
+class RideNavigatorModel;
 class GroupByModel;
 class SearchFilter;
 class SearchFilterBox;
@@ -44,7 +44,7 @@ class DataFilter;
 // The RideNavigator
 //
 // A list of rides displayed using a QTreeView on top of
-// a QSQLTableModel which reads from the "metrics" table
+// a RideNavigatorModel which reads from the "metrics" table
 // via the DBAccess database connection
 //
 class RideNavigator : public GcWindow
@@ -129,7 +129,7 @@ class RideNavigator : public GcWindow
         void clearSearch();
 
     protected:
-        QSqlTableModel *sqlModel; // the sql table
+        RideNavigatorModel *rideModel; // the metrics table
         GroupByModel *groupByModel; // for group by
         BUGFIXQSortFilterProxyModel *sortModel; // for sort/filter
 
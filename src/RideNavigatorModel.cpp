@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2026 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "RideNavigatorModel.h"
+#include "DBAccess.h"
+
+#include <QtSql>
+
+// when more rides than this have changed it is quicker for
+// everyone if we just start again (e.g. after a rebuild)
+static const int maxRowUpdates = 50;
+
+RideNavigatorModel::RideNavigatorModel(QObject *parent, DBAccess *db) : QAbstractTableModel(parent), db(db)
+{
+    refresh();
+}
+
+int
+RideNavigatorModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : filenames.count();
+}
+
+int
+RideNavigatorModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : columns.count();
+}
+
+QVariant
+RideNavigatorModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || (role != Qt::DisplayRole && role != Qt::EditRole)) return QVariant();
+
+    int row = index.row();
+    int column = index.column();
+    if (row < 0 || row >= filenames.count() || column < 0 || column >= columns.count()) return QVariant();
+
+    // first time anyone has looked at this column?
+    if (!columns[column].loaded) load(column);
+
+    const Column &c = columns[column];
+    if (c.nulls[row]) return QVariant();
+    else if (c.integer) return QVariant((int)c.values[row]);
+    else if (c.numeric) return QVariant(c.values[row]);
+    else return QVariant(c.texts[row]);
+}
+
+QVariant
+RideNavigatorModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || section < 0 || section >= columns.count()) return QVariant();
+    if (role != Qt::DisplayRole && role != Qt::EditRole) return QVariant();
+
+    return columns[section].header;
+}
+
+bool
+RideNavigatorModel::setHeaderData(int section, Qt::Orientation orientation, const QVariant &value, int role)
+{
+    if (orientation != Qt::Horizontal || section < 0 || section >= columns.count()) return false;
+    if (role != Qt::DisplayRole && role != Qt::EditRole) return false;
+
+    columns[section].header = value;
+    emit headerDataChanged(orientation, section, section);
+    return true;
+}
+
+bool
+RideNavigatorModel::refresh()
+{
+    bool newColumns = readColumns();
+
+    QStringList names;
+    QVector<unsigned long> stamps;
+    readRows(names, stamps);
+
+    // which rides have been written since we last looked?
+    QVector<int> changed;
+    if (!newColumns && names == filenames) {
+        for (int i=0; i<stamps.count() && changed.count() <= maxRowUpdates; i++)
+            if (stamps[i] != writes[i]) changed << i;
+    }
+
+    if (newColumns || names != filenames || changed.count() > maxRowUpdates) {
+
+        // rides added or deleted, start again and read
+        // the columns as the views ask for them
+        beginResetModel();
+        filenames = names;
+        writes = stamps;
+        rowOf.clear();
+        for (int i=0; i<filenames.count(); i++) rowOf.insert(filenames[i], i);
+        for (int i=0; i<columns.count(); i++) {
+            columns[i].loaded = false;
+            columns[i].values.clear();
+            columns[i].texts.clear();
+            columns[i].nulls.clear();
+        }
+        endResetModel();
+
+    } else {
+
+        // just the rides that changed
+        foreach (int row, changed) {
+            writes[row] = stamps[row];
+            reload(row);
+            emit dataChanged(index(row, 0), index(row, columns.count()-1));
+        }
+    }
+    return newColumns;
+}
+
+// the columns of the metrics table, returns true if they are
+// not the ones we have, in which case we start with new ones
+bool
+RideNavigatorModel::readColumns()
+{
+    QSqlRecord record = db->connection().record("metrics");
+
+    bool same = (record.count() == columns.count());
+    for (int i=0; same && i<record.count(); i++)
+        if (record.fieldName(i) != columns[i].name) same = false;
+    if (same) return false;
+
+    columns.clear();
+    for (int i=0; i<record.count(); i++) {
+        Column add;
+        add.name = record.fieldName(i);
+        add.header = add.name;
+        add.integer = (record.field(i).type() == QVariant::Int);
+        add.numeric = add.integer || (record.field(i).type() == QVariant::Double);
+        add.loaded = false;
+        columns << add;
+    }
+    return true;
+}
+
+void
+RideNavigatorModel::readRows(QStringList &names, QVector<unsigned long> &stamps) const
+{
+    QSqlQuery query(db->connection());
+    query.setForwardOnly(true);
+    bool rc = query.exec("SELECT filename FROM metrics ORDER BY ride_date;");
+    while (rc && query.next()) {
+        names << query.value(0).toString();
+        stamps << db->written(names.last());
+    }
+}
+
+void
+RideNavigatorModel::load(int column) const
+{
+    Column &c = columns[column];
+    if (c.numeric) c.values.fill(0, filenames.count());
+    else c.texts.fill(QString(), filenames.count());
+    c.nulls.fill(true, filenames.count());
+
+    // the rows are matched up by filename so they land in
+    // the right place, whatever order the db returns them in
+    QSqlQuery query(db->connection());
+    query.setForwardOnly(true);
+    bool rc = query.exec(QString("SELECT filename, %1 FROM metrics;").arg(c.name));
+    while (rc && query.next()) {
+        int row = rowOf.value(query.value(0).toString(), -1);
+        if (row < 0) continue; // not one of ours (yet)
+
+        if (c.numeric) c.values[row] = query.value(1).toDouble();
+        else c.texts[row] = query.value(1).toString();
+        c.nulls[row] = query.value(1).isNull();
+    }
+    c.loaded = true;
+}
+
+// read one ride again, but only the columns that are in use
+void
+RideNavigatorModel::reload(int row)
+{
+    QList<int> loaded;
+    QString select;
+    for (int i=0; i<columns.count(); i++) {
+        if (columns[i].loaded) {
+            select += QString(loaded.count() ? ", %1" : "%1").arg(columns[i].name);
+            loaded << i;
+        }
+    }
+    if (loaded.isEmpty()) return;
+
+    QSqlQuery query(db->connection());
+    query.setForwardOnly(true);
+    query.prepare(QString("SELECT %1 FROM metrics WHERE filename = ?;").arg(select));
+    query.addBindValue(filenames[row]);
+    if (query.exec() && query.next()) {
+        for (int i=0; i<loaded.count(); i++) {
+            Column &c = columns[loaded[i]];
+            if (c.numeric) c.values[row] = query.value(i).toDouble();
+            else c.texts[row] = query.value(i).toString();
+            c.nulls[row] = query.value(i).isNull();
+        }
+    }
+}
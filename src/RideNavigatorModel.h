@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2026 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_RideNavigatorModel_h
+#define _GC_RideNavigatorModel_h 1
+#include "GoldenCheetah.h"
+
+#include <QAbstractTableModel>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+
+class DBAccess;
+
+//
+// The rides in the "metrics" table for the RideNavigator, the
+// calendar and the diary. It has the same columns as the table
+// but they are held in memory a column at a time, and a column
+// is only read from the db when a view first asks for it, so
+// the hundred or so metrics nobody is looking at cost nothing.
+//
+// refresh() catches up with the table; when the same rides are
+// there and only some have been written since we looked, just
+// those rows are read again and dataChanged() is emitted for them
+// rather than resetting the model.
+//
+class RideNavigatorModel : public QAbstractTableModel
+{
+    Q_OBJECT
+    G_OBJECT
+
+    public:
+        RideNavigatorModel(QObject *parent, DBAccess *db);
+
+        int rowCount(const QModelIndex &parent = QModelIndex()) const;
+        int columnCount(const QModelIndex &parent = QModelIndex()) const;
+        QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
+
+        // the RideNavigator renames the columns to their friendly names
+        QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+        bool setHeaderData(int section, Qt::Orientation orientation, const QVariant &value, int role = Qt::EditRole);
+
+        // catch up with the db, returns true if the columns changed
+        // (metrics or metadata fields were added or removed)
+        bool refresh();
+
+    private:
+        DBAccess *db;
+
+        struct Column {
+            QString name;           // in the metrics table
+            QVariant header;        // in the views
+            bool numeric, integer;
+            bool loaded;            // read from the db yet?
+            QVector<double> values; // numeric columns
+            QVector<QString> texts; // everything else
+            QVector<bool> nulls;    // no value in the db, shown as blank
+        };
+        mutable QVector<Column> columns;
+
+        QStringList filenames;         // a row for each ride, in date order
+        QHash<QString, int> rowOf;     // and back again
+        QVector<unsigned long> writes; // DBAccess::written() when we last read each row
+
+        bool readColumns();
+        void readRows(QStringList &names, QVector<unsigned long> &stamps) const;
+        void load(int column) const;
+        void reload(int row);
+};
+#endif // _GC_RideNavigatorModel_h
@@ -69,27 +69,46 @@ private:
 
     QString starttimeHeader;
 
+    // groups are numbered in the order they are shown, and
+    // the rows are looked up by number, the names are only
+    // needed when the group headings are painted
     QList<QString> groups;
     QList<QModelIndex> groupIndexes;
 
-    QMap<QString, QVector<int>*> groupToSourceRow;
+    QVector<QVector<int> > groupToSourceRow;
+    QVector<int> sourceRowToGroup;
     QVector<int> sourceRowToGroupRow;
+    QVector<QString> groupValues; // value in the groupBy column when grouped
     QList<rankx> rankedRows;
 
     void clearGroups() {
         // Wipe current
-        QMapIterator<QString, QVector<int>*> i(groupToSourceRow);
-        while (i.hasNext()) {
-            i.next();
-            delete i.value();
-        }
         groups.clear();
         groupIndexes.clear();
         groupToSourceRow.clear();
+        sourceRowToGroup.clear();
         sourceRowToGroupRow.clear();
+        groupValues.clear();
         rankedRows.clear();
     }
 
+    // the source row behind one of our rows, or -1
+    int sourceRowFor(const QModelIndex &proxyIndex) const {
+
+        if (proxyIndex.internalPointer() == NULL || proxyIndex.column() == 0) return -1;
+
+        int groupNo = ((QModelIndex*)proxyIndex.internalPointer())->row();
+        if (groupNo < 0 || groupNo >= groups.count()) return -1;
+        if (proxyIndex.row() < 0 || proxyIndex.row() >= groupToSourceRow[groupNo].count()) return -1;
+
+        return groupToSourceRow[groupNo].at(proxyIndex.row());
+    }
+
+    QVariant sourceData(int sourceRow, int column) const {
+        if (sourceRow < 0 || column < 0) return QVariant();
+        return sourceModel()->data(sourceModel()->index(sourceRow, column));
+    }
+
     static bool initGroupRanges();
 
 public:
@@ -124,7 +143,7 @@ public:
         }
 
         connect(model, SIGNAL(modelReset()), this, SLOT(sourceModelChanged()));
-        connect(model, SIGNAL(dataChanged(QModelIndex, QModelIndex)), this, SLOT(sourceModelChanged()));
+        connect(model, SIGNAL(dataChanged(QModelIndex, QModelIndex)), this, SLOT(sourceDataChanged(QModelIndex, QModelIndex)));
         connect(model, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(sourceModelChanged()));
         connect(model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)), this, SLOT(sourceModelChanged()));
         connect(model, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(sourceModelChanged()));
@@ -156,35 +175,22 @@ public:
 
     QModelIndex mapToSource(const QModelIndex &proxyIndex) const {
 
-        if (proxyIndex.internalPointer() != NULL) {
+        int sourceRow = sourceRowFor(proxyIndex);
+        if (sourceRow < 0) return QModelIndex();
 
-            int groupNo = ((QModelIndex*)proxyIndex.internalPointer())->row();
-            if (groupNo < 0 || groupNo >= groups.count() || proxyIndex.column() == 0) {
-                return QModelIndex();
-            }
-
-            return sourceModel()->index(groupToSourceRow.value(groups[groupNo])->at(proxyIndex.row()),
-                                        proxyIndex.column()-2, // accomodate virtual columns
-                                        QModelIndex());
-        }
-        return QModelIndex();
+        return sourceModel()->index(sourceRow,
+                                    proxyIndex.column()-2, // accomodate virtual columns
+                                    QModelIndex());
     }
 
     QModelIndex mapFromSource(const QModelIndex &sourceIndex) const {
 
         // which group did we put this row into?
-        QString group = whichGroup(sourceIndex.row());
-        int groupNo = groups.indexOf(group);
+        int row = sourceIndex.row();
+        if (!sourceIndex.isValid() || row >= sourceRowToGroup.count()) return QModelIndex();
 
-        if (groupNo < 0) {
-            return QModelIndex();
-        } else {
-            QModelIndex *p = new QModelIndex(createIndex(groupNo, 0, (void*)NULL));
-            if (sourceIndex.row() > 0 && sourceIndex.row() < sourceRowToGroupRow.size())
-                return createIndex(sourceRowToGroupRow[sourceIndex.row()], sourceIndex.column()+2, &p); // accomodate virtual columns
-            else
-                return QModelIndex();
-        }
+        return createIndex(sourceRowToGroupRow[row], sourceIndex.column()+2, // accomodate virtual columns
+                           (void*)&groupIndexes[sourceRowToGroup[row]]);
     }
 
     // we override the standard version to make our virtual column zero
@@ -212,25 +218,20 @@ public:
         //if (proxyIndex.internalPointer() != NULL || proxyIndex.column() > 0) {
         if (proxyIndex.column() > 0) {
 
+            int sourceRow = sourceRowFor(proxyIndex);
+
             if (role == Qt::UserRole) {
 
                 QString string;
 
-                if (calendarText != -1 && proxyIndex.internalPointer()) {
+                if (calendarText != -1 && sourceRow >= 0) {
 
-                    // hideous code, sorry
-                    int groupNo = ((QModelIndex*)proxyIndex.internalPointer())->row();
-                    if (groupNo < 0 || groupNo >= groups.count() || proxyIndex.column() == 0) returning="";
-                    else string = sourceModel()->data(sourceModel()->index(groupToSourceRow.value(groups[groupNo])->at(proxyIndex.row()), calendarText)).toString();
+                    string = sourceData(sourceRow, calendarText).toString();
 
                     // get rid of cr, lf and tab chars
                     string.replace("\n", " ");
                     string.replace("\t", " ");
                     string.replace("\r", " ");
-
-                } else {
-
-                    string = "";
                 }
 
                 returning = string;
@@ -238,35 +239,16 @@ public:
 
             } else if (role == Qt::BackgroundRole) {
 
-
-                if (colorColumn != -1 && proxyIndex.internalPointer()) {
-
-                    QString colorstring;
-
-                    // hideous code, sorry
-                    int groupNo = ((QModelIndex*)proxyIndex.internalPointer())->row();
-                    if (groupNo < 0 || groupNo >= groups.count() || proxyIndex.column() == 0)
-                        colorstring="#ffffff";
-                    else colorstring = sourceModel()->data(sourceModel()->index(groupToSourceRow.value(groups[groupNo])->at(proxyIndex.row()), colorColumn)).toString();
-
-                    returning = QColor(colorstring);
+                if (colorColumn != -1 && sourceRow >= 0) {
+                    returning = QColor(sourceData(sourceRow, colorColumn).toString());
                 } else {
                     returning = QColor("#ffffff");
                 }
 
             } else if (role == (Qt::UserRole+1)) {
 
-                if (colorColumn != -1 && proxyIndex.internalPointer()) {
-
-                    QString filename;
-
-                    // hideous code, sorry
-                    int groupNo = ((QModelIndex*)proxyIndex.internalPointer())->row();
-                    if (groupNo < 0 || groupNo >= groups.count() || proxyIndex.column() == 0)
-                        filename="";
-                    else filename = sourceModel()->data(sourceModel()->index(groupToSourceRow.value(groups[groupNo])->at(proxyIndex.row()), fileIndex)).toString();
-
-                    returning = filename;
+                if (colorColumn != -1 && sourceRow >= 0) {
+                    returning = sourceData(sourceRow, fileIndex).toString();
                 } else {
                     returning = "";
                 }
@@ -274,15 +256,7 @@ public:
             } else {
                 // column 1 = ride_time we have to use ride_date
                 if (proxyIndex.column() == 1)  {
-                    QString date;
-
-                    // hideous code, sorry
-                    int groupNo = ((QModelIndex*)proxyIndex.internalPointer())->row();
-                    if (groupNo < 0 || groupNo >= groups.count() || proxyIndex.column() == 0)
-                        date="";
-                    else date = sourceModel()->data(sourceModel()->index(groupToSourceRow.value(groups[groupNo])->at(proxyIndex.row()), dateColumn)).toString();
-
-                    returning = date;//sourceModel()->data(sourceModel()->index(proxyIndex.row(),dateColumn)).toString();
+                    returning = sourceRow >= 0 ? sourceData(sourceRow, dateColumn).toString() : QString("");
                 }
                 else
                     returning = sourceModel()->data(mapToSource(proxyIndex), role);
@@ -302,11 +276,11 @@ public:
                     QString returnString = QString("%1: %2 (%3 activities)")
                                            .arg(sourceModel()->headerData(groupBy, Qt::Horizontal).toString())
                                            .arg(group)
-                                           .arg(groupToSourceRow.value(groups[proxyIndex.row()])->count());
+                                           .arg(groupToSourceRow[proxyIndex.row()].count());
                     returning = QVariant(returnString);
                 } else {
                     QString returnString = QString("%1 activities")
-                                           .arg(groupToSourceRow.value(groups[proxyIndex.row()])->count());
+                                           .arg(groupToSourceRow[proxyIndex.row()].count());
                     returning = QVariant(returnString);
                 }
             }
@@ -347,7 +321,8 @@ public:
         } else if (parent.column() == 0 && parent.internalPointer() == NULL) {
 
             // second level return count of rows for group
-            return groupToSourceRow.value(groups[parent.row()])->count();
+            if (parent.row() < 0 || parent.row() >= groups.count()) return 0;
+            return groupToSourceRow[parent.row()].count();
 
         } else {
 
@@ -367,7 +342,8 @@ public:
         } else if (index.column() == 0 && index.internalPointer() == NULL) {
 
             // first column - the group bys
-            return (groupToSourceRow.value(groups[index.row()])->count() > 0);
+            if (index.row() < 0 || index.row() >= groups.count()) return false;
+            return (groupToSourceRow[index.row()].count() > 0);
 
         } else {
 
@@ -394,13 +370,8 @@ public:
 
     QString whichGroup(int row) const {
 
-        if (row < 0 || row >= rankedRows.count()) return ("");
-        if (groupBy == -1) return tr("All Activities");
-        else return groupFromValue(headerData(groupBy+2, // accomodate virtual column
-                                    Qt::Horizontal).toString(),
-                                    sourceModel()->data(sourceModel()->index(row,groupBy)).toString(),
-                                    rankedRows[row].value, rankedRows.count());
-
+        if (row < 0 || row >= sourceRowToGroup.count()) return ("");
+        return groups[sourceRowToGroup[row]];
     }
 
     // implemented in RideNavigator.cpp, to avoid developers
@@ -420,14 +391,19 @@ public:
         // wipe whatever is there first
         clearGroups();
 
+        int rows = sourceModel()->rowCount(QModelIndex());
+
         if (groupBy >= 0) {
 
-            // rank all the values
-            for (int i=0; i<sourceModel()->rowCount(QModelIndex()); i++) {
+            // rank all the values, we only need to look
+            // at each one once, so remember it as we go
+            for (int i=0; i<rows; i++) {
+                QVariant value = sourceModel()->data(sourceModel()->index(i,groupBy));
                 rankx rank;
-                rank.value = sourceModel()->data(sourceModel()->index(i,groupBy)).toDouble();
+                rank.value = value.toDouble();
                 rank.row = i;
                 rankedRows << rank;
+                groupValues << value.toString();
             }
 
             // rank the entries
@@ -439,54 +415,85 @@ public:
             // sort by row again
             qStableSort(rankedRows.begin(), rankedRows.end(), rankx::sortByRow);
 
+            // which group is each row in? the groups are numbered
+            // as we find them and renumbered into name order after
+            QString heading = headerData(groupBy+2, Qt::Horizontal).toString(); // accomodate virtual column
+            QHash<QString, int> found;
+            QVector<int> rowGroup(rows);
+            for (int i=0; i<rows; i++) {
 
-            // create a QMap from 'group' string to list of rows in that group
-            for (int i=0; i<sourceModel()->rowCount(QModelIndex()); i++) {
-
-                // which group are we in?
-                QString value = whichGroup(i); // uses rankedRows
+                QString value = groupFromValue(heading, groupValues[i], rankedRows[i].value, rows);
 
-                QVector<int> *rows;
-                if ((rows=groupToSourceRow.value(value,NULL)) == NULL) {
-                    // add to list of groups
-                    rows = new QVector<int>;
-                    groupToSourceRow.insert(value, rows);
+                int groupNo = found.value(value, -1);
+                if (groupNo < 0) {
+                    groupNo = groups.count();
+                    found.insert(value, groupNo);
+                    groups << value;
                 }
+                rowGroup[i] = groupNo;
+            }
+
+            // groups are listed by name
+            QList<QString> names = groups;
+            qSort(names);
+            QVector<int> renumber(groups.count());
+            for (int i=0; i<names.count(); i++) renumber[found.value(names[i])] = i;
+            groups = names;
+            groupToSourceRow.resize(groups.count());
+
+            for (int i=0; i<rows; i++) {
+
+                int groupNo = renumber[rowGroup[i]];
+                sourceRowToGroup.append(groupNo);
 
                 // rowmap is an array corresponding to each row in the
                 // source model, and maps to its row # within the group
-                sourceRowToGroupRow.append(rows->count());
+                sourceRowToGroupRow.append(groupToSourceRow[groupNo].count());
 
                 // add to this groups rows
-                rows->append(i);
+                groupToSourceRow[groupNo].append(i);
             }
 
         } else {
 
             // Just one group by 'All Rides'
-            QVector<int> *rows = new QVector<int>;
-            for (int i=0; i<sourceModel()->rowCount(QModelIndex()); i++) {
-                rows->append(i);
+            groups << "All Activities";
+            groupToSourceRow.resize(1);
+            for (int i=0; i<rows; i++) {
+                groupToSourceRow[0].append(i);
+                sourceRowToGroup.append(0);
                 sourceRowToGroupRow.append(i);
             }
-            groupToSourceRow.insert("All Activities", rows);
-
         }
 
         // Update list of groups
-        int group=0;
-        QMapIterator<QString, QVector<int>*> j(groupToSourceRow);
-        while (j.hasNext()) {
-            j.next();
-            groups << j.key();
-            groupIndexes << createIndex(group++,0,(void*)NULL);
-        }
+        for (int group=0; group<groups.count(); group++)
+            groupIndexes << createIndex(group,0,(void*)NULL);
 
         // all done. let the views know everything changed
         endResetModel();
     }
 
 public slots:
+    // some rides were updated, if they are still in the same group we
+    // only need to repaint them, otherwise we work the groups out again
+    void sourceDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+
+        for (int i=topLeft.row(); i<=bottomRight.row(); i++) {
+            if (i < 0 || i >= sourceRowToGroup.count() ||
+                (groupBy >= 0 && sourceData(i, groupBy).toString() != groupValues[i])) {
+                sourceModelChanged();
+                return;
+            }
+        }
+
+        for (int i=topLeft.row(); i<=bottomRight.row(); i++) {
+            QModelIndex parent = groupIndexes[sourceRowToGroup[i]];
+            emit dataChanged(index(sourceRowToGroupRow[i], 0, parent),
+                             index(sourceRowToGroupRow[i], columnCount()-1, parent));
+        }
+    }
+
     void sourceModelChanged() {
         clearGroups();
         setGroupBy(groupBy+2); // accomodate virtual columns
@@ -529,7 +536,9 @@ class SearchFilter : public QSortFilterProxyModel
     SearchFilter(QWidget *p) : QSortFilterProxyModel(p), searchActive(false) {}
 
     void setSourceModel(QAbstractItemModel *model) {
-        QAbstractProxyModel::setSourceModel(model);
+        // not QAbstractProxyModel's, that doesn't hook up the source signals
+        // and we need a ride's dataChanged to reach the GroupByModel
+        QSortFilterProxyModel::setSourceModel(model);
         this->model = model;
 
         // find the filename column
@@ -540,12 +549,8 @@ class SearchFilter : public QSortFilterProxyModel
             }
         }
 
-	// make sure changes are propogated upstream
-        connect(model, SIGNAL(modelReset()), this, SIGNAL(modelReset()));
-        connect(model, SIGNAL(dataChanged(QModelIndex, QModelIndex)), this, SIGNAL(modelReset()));
-        connect(model, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SIGNAL(modelReset()));
-        connect(model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)), this, SIGNAL(modelReset()));
-        connect(model, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SIGNAL(modelReset()));
+        // resets, inserts, moves, removals and dataChanged are all
+        // mapped and passed on by QSortFilterProxyModel itself
     }
 
     bool filterAcceptsRow (int source_row, const QModelIndex &source_parent) const {
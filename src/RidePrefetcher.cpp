@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2026 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "RidePrefetcher.h"
+#include "MainWindow.h"
+#include "RideItem.h"
+#include "RideFile.h"
+#include "Settings.h"
+#include <QApplication>
+#include <QRunnable>
+#include <QThread>
+
+// reads one ride on the prefetch thread
+class RidePrefetchTask : public QRunnable
+{
+    public:
+        RidePrefetchTask(RidePrefetcher *prefetcher, const RideFileContext &context, QString path,
+                         QString filename, int generation) :
+            prefetcher(prefetcher), context(context), path(path), filename(filename), generation(generation) {}
+
+        void run() {
+            // moved on since we were queued
+            if (!prefetcher->isCurrent(generation)) return;
+
+            // don't get in the way of the gui or the refresh
+            QThread::currentThread()->setPriority(QThread::LowestPriority);
+
+            QStringList errors;
+            QFile file(path + "/" + filename);
+            RideFile *ride = RideFileFactory::instance().openRideFile(context, file, errors);
+
+            if (ride) {
+                // build what the charts will want, the columns of each
+                // series we have and the peak powers
+                for (int i=0; i<RideFile::none; i++)
+                    if (ride->isDataPresent(static_cast<RideFile::SeriesType>(i)))
+                        ride->series(static_cast<RideFile::SeriesType>(i));
+                ride->peakPower(1);
+
+                // we leave the .cpx alone, it is written by whoever
+                // opens the ride for real or by the next refresh
+
+                // it belongs to the gui thread from now on, the command
+                // isn't a child so it has to be moved too
+                ride->moveToThread(QApplication::instance()->thread());
+                ride->command->moveToThread(QApplication::instance()->thread());
+            }
+
+            RidePrefetcher::Result result;
+            result.filename = filename;
+            result.ride = ride;
+            result.generation = generation;
+            prefetcher->post(result);
+        }
+
+    private:
+        RidePrefetcher *prefetcher;
+        RideFileContext context; // a copy, the next selection makes a new one
+        QString path, filename;
+        int generation;
+};
+
+RidePrefetcher::RidePrefetcher(MainWindow *main) : QObject(main), main(main),
+    generation(0), depth_(0), prefetched_(0), hits_(0), misses_(0)
+{
+    pool.setMaxThreadCount(1);
+    configChanged();
+    connect(main, SIGNAL(configChanged()), this, SLOT(configChanged()));
+}
+
+RidePrefetcher::~RidePrefetcher()
+{
+    // drop what hasn't started and wait for what has
+    lock.lock();
+    generation++;
+    lock.unlock();
+    pool.waitForDone();
+
+    foreach (Result result, results) delete result.ride;
+}
+
+void
+RidePrefetcher::configChanged()
+{
+    depth_ = appsettings->value(this, GC_PREFETCH, 2).toInt();
+}
+
+bool
+RidePrefetcher::isCurrent(int generation)
+{
+    QMutexLocker locker(&lock);
+    return generation == this->generation;
+}
+
+void
+RidePrefetcher::post(Result result)
+{
+    QMutexLocker locker(&lock);
+    results << result;
+    QMetaObject::invokeMethod(this, "deliver", Qt::QueuedConnection);
+}
+
+void
+RidePrefetcher::selected(RideItem *item)
+{
+    lock.lock();
+    generation++;
+    int current = generation;
+    lock.unlock();
+
+    if (!item || depth_ <= 0) return;
+
+    const QTreeWidgetItem *allRides = main->allRideItems();
+    int index = allRides->indexOfChild(item);
+    if (index < 0) return;
+
+    // next and previous, nearest first
+    QList<RideItem*> wanted;
+    for (int i=1; i<=depth_; i++) {
+        if (index+i < allRides->childCount()) wanted << static_cast<RideItem*>(allRides->child(index+i));
+        if (index-i >= 0) wanted << static_cast<RideItem*>(allRides->child(index-i));
+    }
+
+    // then the rest of its week, the list is in date order
+    QDate monday = item->dateTime.date().addDays(1 - item->dateTime.date().dayOfWeek());
+    QDate sunday = monday.addDays(6);
+    for (int i=index-1; i>=0; i--) {
+        RideItem *other = static_cast<RideItem*>(allRides->child(i));
+        if (other->dateTime.date() < monday) break;
+        if (!wanted.contains(other)) wanted << other;
+    }
+    for (int i=index+1; i<allRides->childCount(); i++) {
+        RideItem *other = static_cast<RideItem*>(allRides->child(i));
+        if (other->dateTime.date() > sunday) break;
+        if (!wanted.contains(other)) wanted << other;
+    }
+
+    // the tasks open the rides with this, taken here on the gui thread
+    RideFileContext context(main);
+    foreach (RideItem *other, wanted) {
+        if (other->isOpen() || other->isDirty()) continue;
+        pool.start(new RidePrefetchTask(this, context, other->path, other->fileName, current));
+    }
+}
+
+void
+RidePrefetcher::deliver()
+{
+    lock.lock();
+    QList<Result> delivering = results;
+    results.clear();
+    lock.unlock();
+
+    const QTreeWidgetItem *allRides = main->allRideItems();
+
+    foreach (Result result, delivering) {
+        if (!result.ride) continue;
+
+        // the item may have gone, or opened the ride itself
+        RideItem *item = NULL;
+        for (int i=0; i<allRides->childCount(); i++) {
+            RideItem *other = static_cast<RideItem*>(allRides->child(i));
+            if (other->fileName == result.filename) {
+                item = other;
+                break;
+            }
+        }
+
+        if (item && item->adopt(result.ride)) prefetched_++;
+        else delete result.ride;
+    }
+}
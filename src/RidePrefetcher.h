@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2026 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_RidePrefetcher_h
+#define _GC_RidePrefetcher_h 1
+#include "GoldenCheetah.h"
+
+#include <QObject>
+#include <QList>
+#include <QMutex>
+#include <QThreadPool>
+
+class MainWindow;
+class RideItem;
+class RideFile;
+
+// Reads the rides either side of the one selected in the ride list, and
+// the rest of its week, on a low priority worker so they are ready when
+// we move on to them. Each is read and its columns and peaks are built,
+// then it is handed to its RideItem if the item hasn't opened the ride
+// itself in the meantime. The .cpx files are left to the gui thread.
+//
+// How many either side is in the general settings (GC_PREFETCH), 0 is off.
+class RidePrefetcher : public QObject
+{
+    Q_OBJECT
+    G_OBJECT
+
+    public:
+        RidePrefetcher(MainWindow *main);
+        ~RidePrefetcher();
+
+        // the ride list selection changed
+        void selected(RideItem *item);
+
+        // called by RideItem::ride()
+        void hit() { hits_++; }     // it was ready
+        void miss() { misses_++; }  // it had to be read there and then
+
+        int depth() const { return depth_; }
+        int prefetched() const { return prefetched_; }
+        int hits() const { return hits_; }
+        int misses() const { return misses_; }
+
+        // for the workers
+        struct Result { QString filename; RideFile *ride; int generation; };
+        bool isCurrent(int generation);
+        void post(Result result);
+
+    public slots:
+        void configChanged();
+
+    private slots:
+        void deliver();
+
+    private:
+        MainWindow *main;
+        QThreadPool pool;       // just the one thread
+
+        QMutex lock;
+        int generation;         // bumped on each selection, older work is dropped
+        QList<Result> results;  // waiting to be handed over
+
+        int depth_, prefetched_, hits_, misses_;
+};
+
+#endif // _GC_RidePrefetcher_h
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2026 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "RideResidency.h"
+#include "MainWindow.h"
+#include "RideItem.h"
+#include "Settings.h"
+#include <QSet>
+
+RideResidency::RideResidency(MainWindow *main) : QObject(main), main(main),
+    budget_(0), resident_(0), peak_(0), hits_(0), misses_(0), evictions_(0)
+{
+    configChanged();
+    connect(main, SIGNAL(configChanged()), this, SLOT(configChanged()));
+}
+
+void
+RideResidency::configChanged()
+{
+    // in MB, 0 means no limit
+    budget_ = appsettings->value(this, GC_RIDE_MEMORY, 512).toLongLong() * 1024 * 1024;
+    evict();
+}
+
+void
+RideResidency::loaded(RideItem *item)
+{
+    misses_++;
+    touch(item);
+    evict();
+}
+
+// not a miss, nobody asked for it yet
+void
+RideResidency::prefetched(RideItem *item)
+{
+    touch(item);
+    evict();
+}
+
+void
+RideResidency::used(RideItem *item)
+{
+    hits_++;
+
+    // charts ask for the same ride over and over
+    if (!lru.isEmpty() && lru.last() == item) return;
+
+    touch(item);
+    evict();
+}
+
+void
+RideResidency::freed(RideItem *item)
+{
+    if (!sizes.contains(item)) return;
+
+    resident_ -= sizes.take(item);
+    lru.removeOne(item);
+}
+
+// make it the most recently used, the one it takes over from is measured
+// again as by now it has usually built its columns, peaks and so on
+void
+RideResidency::touch(RideItem *item)
+{
+    if (!lru.isEmpty() && lru.last() != item) measure(lru.last());
+
+    lru.removeOne(item);
+    lru.append(item);
+    measure(item);
+}
+
+void
+RideResidency::measure(RideItem *item)
+{
+    qint64 bytes = item->memoryUsed();
+    resident_ += bytes - sizes.value(item, 0);
+    sizes.insert(item, bytes);
+    if (resident_ > peak_) peak_ = resident_;
+}
+
+void
+RideResidency::evict()
+{
+    if (budget_ <= 0) return;
+
+    if (resident_ <= budget_) return;
+
+    // any window may still be showing a ride that is no longer selected
+    // (and hold on to its RideFile meanwhile), so those stay put too
+    QSet<RideItem*> pinned;
+    foreach (GcWindow *window, main->findChildren<GcWindow*>())
+        if (window->rideItem()) pinned << window->rideItem();
+
+    // oldest first, the most recent is left alone since it is
+    // usually the one that is being opened or looked at
+    for (int i=0; resident_ > budget_ && i < lru.count()-1;) {
+        RideItem *item = lru[i];
+
+        if (item->isDirty() || item->isedit || item == main->rideItem() || pinned.contains(item)) {
+            i++;
+            continue;
+        }
+
+        item->freeMemory(); // calls freed(), so i is now the next one
+        evictions_++;
+    }
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2026 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_RideResidency_h
+#define _GC_RideResidency_h 1
+#include "GoldenCheetah.h"
+
+#include <QObject>
+#include <QList>
+#include <QHash>
+
+class MainWindow;
+class RideItem;
+
+// Keeps the rides opened by RideItem::ride() within a memory budget. The
+// ride items tell us when they open a ride or hand it out again, and when
+// we are over budget the least recently used are freed. A ride with unsaved
+// changes, being edited, selected or shown in any window is never freed, so
+// the budget can be exceeded for a while if they are all that is left.
+//
+// The budget is in the general settings (GC_RIDE_MEMORY), in MB.
+class RideResidency : public QObject
+{
+    Q_OBJECT
+    G_OBJECT
+
+    public:
+        RideResidency(MainWindow *main);
+
+        // called by RideItem
+        void loaded(RideItem *item);    // it has just opened its ride
+        void prefetched(RideItem *item);// it was given its ride by the prefetcher
+        void used(RideItem *item);      // its ride was already open
+        void freed(RideItem *item);     // its ride was freed or it is going away
+
+        qint64 budget() const { return budget_; }       // bytes, 0 is no limit
+        qint64 residentBytes() const { return resident_; }
+        qint64 peakBytes() const { return peak_; }
+        int resident() const { return lru.count(); }
+        int hits() const { return hits_; }
+        int misses() const { return misses_; }
+        int evictions() const { return evictions_; }
+
+    public slots:
+        void configChanged();
+
+    private:
+        MainWindow *main;
+
+        void touch(RideItem *item);
+        void measure(RideItem *item);
+        void evict();
+
+        QList<RideItem*> lru;           // least recently used first
+        QHash<RideItem*, qint64> sizes; // when last measured
+        qint64 budget_, resident_, peak_;
+        int hits_, misses_, evictions_;
+};
+
+#endif // _GC_RideResidency_h
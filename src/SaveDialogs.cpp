@@ -139,6 +139,9 @@ MainWindow::saveSilent(RideItem *rideItem)
     QFile notesFile(currentFI.path() + QDir::separator() + currentFI.baseName() + ".notes");
     if (notesFile.exists()) notesFile.remove();
 
+    // the binary cache is out of date now, it gets rebuilt on next open
+    QFile::remove(currentFI.path() + QDir::separator() + currentFI.baseName() + "." + RideFileFactory::instance().cacheSuffix());
+
     // When datetime changes we need to update
     // the filename & rename/delete old file
     // we also need to preserve the notes file
@@ -152,6 +152,12 @@
 #define GC_GARMIN_SMARTRECORD "garminSmartRecord"
 #define GC_GARMIN_HWMARK "garminHWMark"
 
+// Memory for rides kept open (MB)
+#define GC_RIDE_MEMORY "rideMemory"
+
+// Rides read ahead either side of the one selected
+#define GC_PREFETCH "prefetchDepth"
+
 // Calendar sync
 #define GC_WEBCAL_URL "webcal_url"
 
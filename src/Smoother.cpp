@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2026 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "Smoother.h"
+#include <math.h>
+
+// windows kept for each ride
+static const int smootherCacheSize = 8;
+
+void
+Smoother::setTimes(const QVector<double> &times)
+{
+    this->times = times;
+    secs = times.isEmpty() ? 0 : (int) ceil(times.last());
+    sums.clear();
+    cache.clear();
+    used.clear();
+}
+
+int
+Smoother::addSeries(const QVector<double> &values)
+{
+    QVector<double> sum(values.count() + 1);
+    sum[0] = 0;
+    for (int i=0; i<values.count(); i++) sum[i+1] = sum[i] + values[i];
+    sums.append(sum);
+    cache.clear();
+    used.clear();
+    return sums.count() - 1;
+}
+
+const SmoothedData &
+Smoother::smooth(int window)
+{
+    if (cache.contains(window)) {
+        used.removeOne(window);
+        used.prepend(window);
+        return cache[window];
+    }
+
+    // make room
+    while (used.count() >= smootherCacheSize) cache.remove(used.takeLast());
+
+    SmoothedData &data = cache[window];
+    used.prepend(window);
+
+    data.window = window;
+    data.count.fill(0, secs + 1);
+    data.last.fill(-1, secs + 1);
+    data.mean.resize(sums.count());
+    for (int s=0; s<sums.count(); s++) data.mean[s].fill(0.0, secs + 1);
+
+    // the window for each second is samples [lo, hi)
+    int lo = 0, hi = 0, n = times.count();
+    for (int t = window; t <= secs; t++) {
+        while (hi < n && times[hi] <= t) hi++;
+        while (lo < hi && times[lo] < t - window) lo++;
+
+        data.last[t] = hi - 1;
+        data.count[t] = hi - lo;
+        if (hi == lo) continue; // a gap
+
+        for (int s=0; s<sums.count(); s++)
+            data.mean[s][t] = (sums[s][hi] - sums[s][lo]) / (hi - lo);
+    }
+    return data;
+}
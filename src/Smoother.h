@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2026 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_Smoother_h
+#define _GC_Smoother_h 1
+#include "GoldenCheetah.h"
+
+#include <QVector>
+#include <QList>
+#include <QMap>
+
+// The moving averages for every whole second of a ride over a window
+// of w seconds; second s averages the samples with a time in [s-w, s].
+// Seconds before the window and gaps in recording have no samples, the
+// plots decide what to show for those.
+struct SmoothedData
+{
+    int window;
+    QVector<int> count;             // samples in the window, 0 for a gap
+    QVector<int> last;              // last sample at or before the second, -1 if none
+    QVector<QVector<double> > mean; // for each series, 0 for a gap
+};
+
+// Smoothing for several series of a ride at once. The sums of each
+// series are accumulated once when the ride is set so a window costs
+// the same however wide it is, and the last few windows asked for are
+// kept so moving the smoothing slider back and forth is instant.
+class Smoother
+{
+    public:
+        Smoother() : secs(0) {}
+
+        // times must be in ascending order, series are numbered in
+        // the order they are added and must be the same length
+        void setTimes(const QVector<double> &times);
+        int addSeries(const QVector<double> &values);
+
+        int seconds() const { return secs; } // last whole second
+        const SmoothedData &smooth(int window);
+
+    private:
+        QVector<double> times;
+        QVector<QVector<double> > sums; // sums[series][i] is of the first i samples
+        int secs;
+
+        QMap<int, SmoothedData> cache;
+        QList<int> used; // most recently used first
+};
+
+#endif // _GC_Smoother_h
@@ -20,7 +20,7 @@ StressCalculator::StressCalculator (
 	int longTermDays = 42) :
 	startDate(startDate), endDate(endDate), shortTermDays(shortTermDays),
 	longTermDays(longTermDays),
-	initialSTS(initialSTS), initialLTS(initialLTS), lastDaysIndex(-1)
+	initialSTS(initialSTS), initialLTS(initialLTS)
 {
     // calc SB for today or tomorrow?
     showSBToday = appsettings->cvalue(cyclist, GC_SB_TODAY).toInt();
@@ -67,146 +67,81 @@ double StressCalculator::min(void) {
 
 void StressCalculator::calculateStress(MainWindow *main, QString, const QString &metric, bool isfilter, QStringList filter)
 {
-    // get all metric data from the year 1900 - 3000
-    QList<SummaryMetrics> results;
-
-    // get metrics
-    results = main->metricDB->getAllMetricsFor(QDateTime(QDate(1900,1,1)), QDateTime(QDate(3000,1,1)));
-
-    if (isfilter) {
-        // remove any we don't have filtered
-        QList<SummaryMetrics> filteredresults;
-        foreach (SummaryMetrics x, results) {
-            if (filter.contains(x.getFileName()))
-                filteredresults << x;
-        }
-        results = filteredresults;
+    // the daily load is kept in the db for the stress metrics, but
+    // a filtered set of rides or any other metric is worked out here
+    PMCData rides(shortTermDays, longTermDays);
+    PMCData *pmc = isfilter ? NULL : main->metricDB->getPMCData(metric, shortTermDays, longTermDays);
+
+    if (!pmc) {
+        MetricResultSetPtr results = main->metricDB->getMetricResultsFor(QDateTime(QDate(1900,1,1)), QDateTime(QDate(3000,1,1)));
+        QSet<QString> filtered = filter.toSet();
+        int symbol = MetricResultSet::symbolId(metric, false);
+
+        for (int i=0; i<results->rows(); i++)
+            if (!isfilter || filtered.contains(results->fileName(i)))
+                rides.addLoad(results->rideDate(i).date(), results->value(i, symbol));
+        pmc = &rides;
     }
 
-    if (results.count() == 0) return; // no ride files found
-
-    // set start and enddate to maximum maximum required date range
-    // remember the date range required so we can truncate afterwards
-    QDateTime startDateNeeded = startDate;
-    QDateTime endDateNeeded   = endDate;
-    startDate = startDate < results[0].getRideDate() ? startDate : results[0].getRideDate();
-    endDate   = endDate > results[results.count()-1].getRideDate() ? endDate : results[results.count()-1].getRideDate();
-
-    int maxarray = startDate.daysTo(endDate) +2; // from zero plus tomorrows SB!
-    stsvalues.resize(maxarray);
-    ltsvalues.resize(maxarray);
-    sbvalues.resize(maxarray);
-    xdays.resize(maxarray);
-    list.resize(maxarray);
-    ltsramp.resize(maxarray);
-    stsramp.resize(maxarray);
-
-    for (int i=0; i<results.count(); i++)
-        addRideData(results[i].getForSymbol(metric), results[i].getRideDate());
-
-    // ensure the last day is covered ...
-    addRideData(0.0, endDate);
-
-    // now truncate the data series to the requested date range
-    int firstindex = startDate.daysTo(startDateNeeded);
-    int lastindex  = startDate.daysTo(endDateNeeded)+2; // for today and tomorrow SB
-
-    // zap the back
-    if (lastindex < maxarray) {
-        stsvalues.remove(lastindex, maxarray-lastindex);
-        ltsvalues.remove(lastindex, maxarray-lastindex);
-        sbvalues.remove(lastindex, maxarray-lastindex);
-        xdays.remove(lastindex, maxarray-lastindex);
-        list.remove(lastindex, maxarray-lastindex);
-        stsramp.remove(lastindex, maxarray-lastindex);
-        ltsramp.remove(lastindex, maxarray-lastindex);
-    }
-    // now zap the front
-    if (firstindex) {
-        stsvalues.remove(0, firstindex);
-        ltsvalues.remove(0, firstindex);
-        ltsramp.remove(0, firstindex);
-        stsramp.remove(0, firstindex);
-        sbvalues.remove(0, firstindex);
-        xdays.remove(0, firstindex);
-        list.remove(0, firstindex);
-    }
+    if (pmc->isEmpty()) return; // no ride files found
 
-    // reapply the requested date range
-    startDate = startDateNeeded;
-    endDate = endDateNeeded;
+    // the initial stress applies to the first ride or the start date
+    // whichever is earlier, and we stop at the last ride or the end date
+    // whichever is later. The day after that is only there for SB.
+    QDate start = startDate.date();
+    QDate anchor = start < pmc->firstDay() ? start : pmc->firstDay();
+    QDate last = endDate.date() > pmc->lastDay() ? endDate.date() : pmc->lastDay();
 
     days = startDate.daysTo(endDate) + 1; // include today
+    int count = days + 1; // plus tomorrows SB!
+
+    stsvalues.fill(0.0, count);
+    ltsvalues.fill(0.0, count);
+    sbvalues.fill(0.0, count);
+    xdays.fill(0.0, count);
+    list.fill(0.0, count);
+    ltsramp.fill(0.0, count);
+    stsramp.fill(0.0, count);
+
+    for (int i=0; i<count; i++) {
+        QDate day = start.addDays(i);
+        int index = anchor.daysTo(day);
+
+        // SB (stress balance) long term - short term, shown the next day
+        if (showSBToday) {
+            if (day <= last) sbvalues[i] = lts(pmc, anchor, day) - sts(pmc, anchor, day);
+        } else if (index > 0) {
+            sbvalues[i] = lts(pmc, anchor, day.addDays(-1)) - sts(pmc, anchor, day.addDays(-1));
+        }
 
-}
-
-/*
- * calculate each day's STS and LTS.  The daily BS values are in
- * the list.  if there aren't enough days in the list yet, we fake
- * the missing days using the supplied initial value for each day.
- * STS and LTS are calculated up to but not including todays' ride.
- * if there are two rides per day the second one is added to the first
- * so the BS/day is correct.
- */
-void StressCalculator::addRideData(double BS, QDateTime rideDate) {
-    int daysIndex = startDate.daysTo(rideDate);
-
-    // fill in any missing days before today
-    int d;
-    for (d = lastDaysIndex + 1; d < daysIndex ; d++) {
-        list[d] = 0.0; // no ride
-        calculate(d);
-    }
+        if (day > last) break;
 
-    // ignore stuff from before start date
-    if(daysIndex < 0) return;
+        list[i] = pmc->load(day);
+        stsvalues[i] = sts(pmc, anchor, day);
+        ltsvalues[i] = lts(pmc, anchor, day);
+        xdays[i] = index+1;
 
-    // today
-    list[daysIndex] += BS;
-    calculate(daysIndex);
-    lastDaysIndex = daysIndex;
+        // ramp
+        if (index > 0) {
+            stsramp[i] = stsvalues[i] - sts(pmc, anchor, day.addDays(-1));
+            ltsramp[i] = ltsvalues[i] - lts(pmc, anchor, day.addDays(-1));
+        }
+    }
 }
 
-
 /*
- * calculate stress (in Bike Score units) using
  * stress = today's BS * (1 - exp(-1/days)) + yesterday's stress * exp(-1/days)
  * where days is the time period of concern- 7 for STS and 42 for LTS.
  *
- * exp(-1/days) for short and long term is calculated when the
- * class is instantiated.
- *
+ * PMCData works that out from zero stress on the first ride, the initial
+ * stress decays from the anchor day on its own and is added to it.
  */
-void StressCalculator::calculate(int daysIndex) {
-    double lastLTS, lastSTS;
-
-    // LTS
-    if (daysIndex == 0)
-        lastLTS = initialLTS;
-    else
-        lastLTS = ltsvalues[daysIndex-1];
-
-    ltsvalues[daysIndex] = (list[daysIndex] * (1.0 - lte)) + (lastLTS * lte);
-
-    // STS
-    if (daysIndex == 0)
-        lastSTS = initialSTS;
-    else
-        lastSTS = stsvalues[daysIndex-1];
-
-    stsvalues[daysIndex] = (list[daysIndex] * (1.0 - ste)) + (lastSTS * ste);
-
-    // SB (stress balance)  long term - short term
-    // XXX FIXED BUG WHERE SB WAS NOT SHOWN ON THE NEXT DAY!
-    if (daysIndex == 0) sbvalues[daysIndex]=0;
-    sbvalues[daysIndex+(showSBToday ? 0 : 1)] =  ltsvalues[daysIndex] - stsvalues[daysIndex] ;
-
-    // xdays
-    xdays[daysIndex] = daysIndex+1;
+double StressCalculator::sts(PMCData *pmc, QDate anchor, QDate day)
+{
+    return pmc->sts(day) + initialSTS * pow(ste, anchor.daysTo(day) + 1);
+}
 
-    // ramp
-    if (daysIndex > 0) {
-        stsramp[daysIndex] = stsvalues[daysIndex] - stsvalues[daysIndex-1];
-        ltsramp[daysIndex] = ltsvalues[daysIndex] - ltsvalues[daysIndex-1];
-    }
+double StressCalculator::lts(PMCData *pmc, QDate anchor, QDate day)
+{
+    return pmc->lts(day) + initialLTS * pow(lte, anchor.daysTo(day) + 1);
 }
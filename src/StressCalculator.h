@@ -17,6 +17,7 @@
 #include <QTreeWidgetItem>
 #include "Settings.h"
 #include "MetricAggregator.h"
+#include "PMCData.h"
 
 class StressCalculator:public QObject {
 
@@ -33,7 +34,6 @@ class StressCalculator:public QObject {
 	double initialLTS;
         double ste, lte;
 
-	int lastDaysIndex;
     bool showSBToday;
 
 	// graph axis arrays
@@ -46,8 +46,8 @@ class StressCalculator:public QObject {
 	// averaging array
 	QVector<double> list;
 
-	void calculate(int daysIndex);
-	void addRideData(double BS, QDateTime rideDate);
+	double sts(PMCData *pmc, QDate anchor, QDate day);
+	double lts(PMCData *pmc, QDate anchor, QDate day);
 
     boost::shared_ptr<QSettings> settings;
 
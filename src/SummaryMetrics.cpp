@@ -49,6 +49,24 @@ SummaryMetrics::toString(QString format, bool UseMetric) const
     return format;
 }
 
+void
+SummaryMetrics::unpack()
+{
+    if (!set) return;
+
+    // anything set since the view was made takes precedence
+    foreach (int symbol, set->valueSymbols()) {
+        QString name = MetricResultSet::symbolName(symbol);
+        if (!value.contains(name)) value.insert(name, set->value(row, symbol));
+    }
+    foreach (int symbol, set->textSymbols()) {
+        QString name = MetricResultSet::symbolName(symbol);
+        if (!text.contains(name)) text.insert(name, set->text(row, symbol, ""));
+    }
+    set.clear();
+    row = -1;
+}
+
 static
 const RideMetric *metricForSymbol(QString symbol)
 {
@@ -110,12 +128,16 @@ QString SummaryMetrics::getAggregated(QString name, const QList<SummaryMetrics>
     double rvalue = 0;
     double rcount = 0; // using double to avoid rounding issues with int when dividing
 
+    // look the symbols up once, not for every ride
+    int symbol = MetricResultSet::symbolId(name);
+    int workoutTime = MetricResultSet::symbolId("workout_time");
+
     // loop through and aggregate
-    foreach (SummaryMetrics rideMetrics, results) {
+    foreach (const SummaryMetrics &rideMetrics, results) {
 
         // get this value
-        double value = rideMetrics.getForSymbol(name);
-        double count = rideMetrics.getForSymbol("workout_time"); // for averaging
+        double value = rideMetrics.getForSymbol(symbol);
+        double count = rideMetrics.getForSymbol(workoutTime); // for averaging
 
         
         // check values are bounded, just in case
@@ -24,11 +24,22 @@
 #include <QMap>
 #include <QDateTime>
 #include <QApplication>
+#include "MetricResultSet.h"
 
 class SummaryMetrics
 {
     Q_DECLARE_TR_FUNCTIONS(SummaryMetrics)
 	public:
+        SummaryMetrics() : row(-1) {}
+
+        // a view of one row of a result set, nothing is copied
+        // until the values are changed or asked for as maps
+        SummaryMetrics(MetricResultSetPtr set, int row) : set(set), row(row) {
+            fileName = set->fileName(row);
+            id = set->id(row);
+            rideDate = set->rideDate(row);
+        }
+
         // filename
 	    QString getFileName() const { return fileName; }
         void    setFileName(QString fileName) { this->fileName = fileName; }
@@ -47,10 +58,30 @@ class SummaryMetrics
 
         // metric values
         void setForSymbol(QString symbol, double v) { value.insert(symbol, v); }
-        double getForSymbol(QString symbol) const { return value.value(symbol, 0.0); }
+        double getForSymbol(QString symbol) const {
+            if (set && !value.contains(symbol))
+                return set->value(row, MetricResultSet::symbolId(symbol, false));
+            return value.value(symbol, 0.0);
+        }
+
+        // the same by interned id, see MetricResultSet::symbolId, for
+        // loops over many rides: look the id up once before the loop
+        // and this goes straight to the column without the symbol lock
+        double getForSymbol(int symbol) const {
+            if (set && value.isEmpty()) return set->value(row, symbol);
+            return getForSymbol(MetricResultSet::symbolName(symbol));
+        }
 
         void setText(QString name, QString v) { text.insert(name, v); }
-        QString getText(QString name, QString fallback) { return text.value(name, fallback); }
+        QString getText(QString name, QString fallback) const {
+            if (set && !text.contains(name))
+                return set->text(row, MetricResultSet::symbolId(name, false), fallback);
+            return text.value(name, fallback);
+        }
+        QString getText(int symbol, QString fallback) const {
+            if (set && text.isEmpty()) return set->text(row, symbol, fallback);
+            return getText(MetricResultSet::symbolName(symbol), fallback);
+        }
 
         // convert to string, using format supplied
         // replaces ${...:units} or ${...} with unit string
@@ -66,10 +97,15 @@ class SummaryMetrics
         // when passed a list of summary metrics and a name return aggregated value as a string
         static QString getAggregated(QString name, const QList<SummaryMetrics> &results, bool useMetricUnits, bool nofmt = false);
 
-        QMap<QString, double> &values() { return value; }
-        QMap<QString, QString> &texts() { return text; }
+        QMap<QString, double> &values() { unpack(); return value; }
+        QMap<QString, QString> &texts() { unpack(); return text; }
 
 	private:
+        void unpack(); // copy the row out of the result set
+
+        MetricResultSetPtr set;
+        int row;
+
 	    QString fileName;
         QString id;
         QDateTime rideDate;
@@ -23,9 +23,6 @@
 #include "TcxParser.h"
 #include "TimeUtils.h"
 
-// use stc strtod to bypass Qt toDouble() issues
-#include <stdlib.h>
-
 TcxParser::TcxParser (RideFile* rideFile, QList<RideFile*> *rides) : rideFile(rideFile), rides(rides)
 {
     isGarminSmartRecording = appsettings->value(NULL, GC_GARMIN_SMARTRECORD,Qt::Checked);
@@ -35,14 +32,41 @@ TcxParser::TcxParser (RideFile* rideFile, QList<RideFile*> *rides) : rideFile(ri
 
     // First initialisation for altitude (not initialised for each point)
     alt= 0;
+
+    // element text is short, this means we only allocate once
+    buffer.reserve(64);
 }
 
 bool
-TcxParser::startElement( const QString&, const QString&, const QString& qName, const QXmlAttributes& qAttributes)
+TcxParser::parse(QIODevice *device, QStringList &errors)
+{
+    QXmlStreamReader xml(device);
+
+    while (!xml.atEnd()) {
+        switch (xml.readNext()) {
+            case QXmlStreamReader::StartElement: startElement(xml.name(), xml.attributes()); break;
+            case QXmlStreamReader::EndElement: endElement(xml.name()); break;
+            case QXmlStreamReader::Characters: buffer.append(xml.text()); break;
+            default: break;
+        }
+    }
+
+    // whatever was read before the error is kept
+    if (xml.hasError()) {
+        errors << QString("XML error at line %1: %2").arg(xml.lineNumber()).arg(xml.errorString());
+        return false;
+    }
+    return true;
+}
+
+// element names are compared without any namespace prefix, so
+// "ns3:Watts" is "Watts"
+void
+TcxParser::startElement(const QStringRef &qName, const QXmlStreamAttributes &qAttributes)
 {
-    buffer.clear();
+    buffer.truncate(0);
 
-    if (qName == "Activity") {
+    if (qName == QLatin1String("Activity")) {
 
         lap = 0;
 
@@ -58,12 +82,12 @@ TcxParser::startElement( const QString&, const QString&, const QString& qName, c
         // if caller is looking for rides...
         if (rides) rides->append(rideFile);
 
-    } else if (qName == "Lap") {
+    } else if (qName == QLatin1String("Lap")) {
 
     // Use the time of the first lap as the time of the activity.
         if (lap == 0) {
 
-            start_time = convertToLocalTime(qAttributes.value("StartTime"));
+            start_time = convertToLocalTime(qAttributes.value(QLatin1String("StartTime")).toString());
             rideFile->setStartTime(start_time);
 
             last_distance = 0.0;
@@ -71,7 +95,7 @@ TcxParser::startElement( const QString&, const QString&, const QString& qName, c
         }
         lap++;
 
-    } else if (qName == "Trackpoint") {
+    } else if (qName == QLatin1String("Trackpoint")) {
 
         power = 0.0;
         cadence = 0.0;
@@ -87,37 +111,24 @@ TcxParser::startElement( const QString&, const QString&, const QString& qName, c
         secs = 0;
 
     }
-
-    return TRUE;
 }
 
-bool
-TcxParser::endElement( const QString&, const QString&, const QString& qName)
+void
+TcxParser::endElement(const QStringRef &qName)
 {
-    if (qName == "Time") {
+    if (qName == QLatin1String("Time")) {
         time = convertToLocalTime(buffer);
         secs = start_time.secsTo(time);
 
-    } else if (qName == "DistanceMeters") { distance = buffer.toDouble() / 1000; }
-    else if (qName == "Watts" || qName == "ns3:Watts") { power = buffer.toDouble(); }
-    else if (qName == "Speed" || qName == "ns3:Speed") { speed = buffer.toDouble() * 3.6; }
-    else if (qName == "Value") { hr = buffer.toDouble(); }
-    else if (qName == "Cadence") { cadence = buffer.toDouble(); }
-    else if (qName == "AltitudeMeters") { alt = buffer.toDouble(); }
-    else if (qName == "LongitudeDegrees") {
-
-        char *p; 
-        setlocale(LC_NUMERIC,"C"); // strtod is locale dependent!
-        lon = strtod(buffer.toLatin1(), &p);
-        setlocale(LC_NUMERIC,"");
-
-    } else if (qName == "LatitudeDegrees") {
-        char *p;
-        setlocale(LC_NUMERIC,"C"); // strtod is locale dependent!
-        lat = strtod(buffer.toLatin1(), &p);
-        setlocale(LC_NUMERIC,"");
-
-    } else if (qName == "Trackpoint") {
+    } else if (qName == QLatin1String("DistanceMeters")) { distance = buffer.toDouble() / 1000; }
+    else if (qName == QLatin1String("Watts")) { power = buffer.toDouble(); }
+    else if (qName == QLatin1String("Speed")) { speed = buffer.toDouble() * 3.6; }
+    else if (qName == QLatin1String("Value")) { hr = buffer.toDouble(); }
+    else if (qName == QLatin1String("Cadence")) { cadence = buffer.toDouble(); }
+    else if (qName == QLatin1String("AltitudeMeters")) { alt = buffer.toDouble(); }
+    else if (qName == QLatin1String("LongitudeDegrees")) { lon = buffer.toDouble(); }
+    else if (qName == QLatin1String("LatitudeDegrees")) { lat = buffer.toDouble(); }
+    else if (qName == QLatin1String("Trackpoint")) {
 
         // Some TCX files have Speed, some have Distance
         // Lets derive Speed from Distance or vice-versa
@@ -152,7 +163,7 @@ TcxParser::endElement( const QString&, const QString&, const QString& qName)
         // average all the calculations based on the previous
         // point.
 
-        if(rideFile->dataPoints().empty()) {
+        if(rideFile->samples() == 0) {
 
             // first point
             rideFile->appendPoint(secs, cadence, hr, distance, speed, torque,
@@ -161,19 +172,19 @@ TcxParser::endElement( const QString&, const QString&, const QString& qName)
         } else {
 
             // assumption that the change in ride is linear...  :)
-            RideFilePoint *prevPoint = rideFile->dataPoints().back();
-            double deltaSecs = secs - prevPoint->secs;
-            double deltaCad = cadence - prevPoint->cad;
-            double deltaHr = hr - prevPoint->hr;
-            double deltaDist = distance - prevPoint->km;
-            double deltaSpeed = speed - prevPoint->kph;
-            double deltaTorque = torque - prevPoint->nm;
-            double deltaPower = power - prevPoint->watts;
-            double deltaAlt = alt - prevPoint->alt;
-            double deltaLon = lon - prevPoint->lon;
-            double deltaLat = lat - prevPoint->lat;
-
-            if (prevPoint->lat == 0 && prevPoint->lon == 0) badgps = true;
+            RideFilePoint prevPoint = rideFile->point(rideFile->samples()-1);
+            double deltaSecs = secs - prevPoint.secs;
+            double deltaCad = cadence - prevPoint.cad;
+            double deltaHr = hr - prevPoint.hr;
+            double deltaDist = distance - prevPoint.km;
+            double deltaSpeed = speed - prevPoint.kph;
+            double deltaTorque = torque - prevPoint.nm;
+            double deltaPower = power - prevPoint.watts;
+            double deltaAlt = alt - prevPoint.alt;
+            double deltaLon = lon - prevPoint.lon;
+            double deltaLat = lat - prevPoint.lat;
+
+            if (prevPoint.lat == 0 && prevPoint.lon == 0) badgps = true;
             // Smart Recording High Water Mark.
             if ((isGarminSmartRecording.toInt() == 0) || (deltaSecs == 1) || (deltaSecs >= GarminHWM.toInt())) {
 
@@ -186,41 +197,33 @@ TcxParser::endElement( const QString&, const QString&, const QString& qName)
                 // smart recording is on and delta is less than GarminHWM seconds.
                 for(int i = 1; i <= deltaSecs; i++) {
                     double weight = i/ deltaSecs;
-                    double kph = prevPoint->kph + (deltaSpeed *weight);
+                    double kph = prevPoint.kph + (deltaSpeed *weight);
                     // need to make sure speed goes to zero
                     kph = kph > 0.35 ? kph : 0;
-                    double cad = prevPoint->cad + (deltaCad * weight);
+                    double cad = prevPoint.cad + (deltaCad * weight);
                     cad = cad > 0.35 ? cad : 0;
-                    //double lat = prevPoint->lat + (deltaLat * weight);
-                    //double lon = prevPoint->lon + (deltaLon * weight);
+                    //double lat = prevPoint.lat + (deltaLat * weight);
+                    //double lon = prevPoint.lon + (deltaLon * weight);
 
-                    rideFile->appendPoint(prevPoint->secs + (deltaSecs * weight),
-                                          prevPoint->cad  + (deltaCad * weight),
-                                          prevPoint->hr +   (deltaHr * weight),
-                                          prevPoint->km + (deltaDist * weight),
+                    rideFile->appendPoint(prevPoint.secs + (deltaSecs * weight),
+                                          prevPoint.cad  + (deltaCad * weight),
+                                          prevPoint.hr +   (deltaHr * weight),
+                                          prevPoint.km + (deltaDist * weight),
                                           kph,
-                                          prevPoint->nm + (deltaTorque * weight),
-                                          prevPoint->watts + (deltaPower * weight),
-                                          prevPoint->alt + (deltaAlt * weight),
-                                          badgps ? 0 : prevPoint->lon + (deltaLon * weight), // lon
-                                          badgps ? 0 : prevPoint->lat + (deltaLat * weight), // lat
+                                          prevPoint.nm + (deltaTorque * weight),
+                                          prevPoint.watts + (deltaPower * weight),
+                                          prevPoint.alt + (deltaAlt * weight),
+                                          badgps ? 0 : prevPoint.lon + (deltaLon * weight), // lon
+                                          badgps ? 0 : prevPoint.lat + (deltaLat * weight), // lat
                                           headwind, // headwind
                                           0.0,
                                           RideFile::noTemp,
                                           0.0,
                                           lap);
                 }
-                prevPoint = rideFile->dataPoints().back();
             }
         }
         last_distance = distance;
         last_time = time;
     }
-    return TRUE;
-}
-
-bool TcxParser::characters( const QString& str )
-{
-    buffer += str;
-    return TRUE;
 }
@@ -24,19 +24,22 @@
 #include "RideFile.h"
 #include <QString>
 #include <QDateTime>
-#include <QXmlDefaultHandler>
+#include <QXmlStreamReader>
 #include "Settings.h"
 
-class TcxParser : public QXmlDefaultHandler
+// pulls the trackpoints from the file with a QXmlStreamReader, the
+// text of each element is gathered in one buffer that is reused
+class TcxParser
 {
 
 public:
 
     TcxParser(RideFile* rideFile, QList<RideFile*>*rides);
 
-    bool startElement( const QString&, const QString&, const QString&, const QXmlAttributes& );
-    bool endElement( const QString&, const QString&, const QString& );
-    bool characters( const QString& );
+    bool parse(QIODevice *device, QStringList &errors);
+
+    void startElement( const QStringRef&, const QXmlStreamAttributes& );
+    void endElement( const QStringRef& );
 
     RideFile*	rideFile;
     QList<RideFile*> *rides; // when parsed multiple rides
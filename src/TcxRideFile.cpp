@@ -34,7 +34,6 @@ static int tcxFileReaderRegistered =
 
 RideFile *TcxFileReader::openRideFile(QFile &file, QStringList &errors, QList<RideFile*>*list) const
 {
-    (void) errors;
     RideFile *rideFile = new RideFile();
     rideFile->setRecIntSecs(1.0);
     rideFile->setDeviceType("Garmin");
@@ -42,10 +41,7 @@ RideFile *TcxFileReader::openRideFile(QFile &file, QStringList &errors, QList<Ri
 
     TcxParser handler(rideFile, list);
 
-    QXmlInputSource source (&file);
-    QXmlSimpleReader reader;
-    reader.setContentHandler (&handler);
-    reader.parse (source);
+    handler.parse(&file, errors);
 
     return rideFile;
 }
@@ -73,10 +73,15 @@ TreeMapPlot::setData(TMSettings *settings)
 {
     root->clear();
 
-    foreach (SummaryMetrics rideMetrics, *(settings->data)) {
-        double value = rideMetrics.getForSymbol(settings->symbol);
-        QString text1 = rideMetrics.getText(settings->field1, "(unknown)");
-        QString text2 = rideMetrics.getText(settings->field2, "(unknown)");
+    // look the symbols up once, not for every ride
+    int symbol = MetricResultSet::symbolId(settings->symbol);
+    int field1 = MetricResultSet::symbolId(settings->field1);
+    int field2 = MetricResultSet::symbolId(settings->field2);
+
+    foreach (const SummaryMetrics &rideMetrics, *(settings->data)) {
+        double value = rideMetrics.getForSymbol(symbol);
+        QString text1 = rideMetrics.getText(field1, "(unknown)");
+        QString text2 = rideMetrics.getText(field2, "(unknown)");
         if (text1 == "") text1 = "(unknown)";
         if (text2 == "") text2 = "(unknown)";
 
@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2026 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include "VirtualElevation.h"
+#include "RideFile.h"
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QSemaphore>
+#include <math.h>
+
+static const double g = 9.80665;
+
+void
+VirtualElevation::setRide(const RideFile *ride)
+{
+    // HARD-CODED DATA: p1->kph
+    const double vfactor = 3.600;
+    const double small_number = 0.00001;
+
+    const RideFileDataPresent *dataPresent = ride->areDataPresent();
+    RideFileSeries watts = ride->series(RideFile::watts);
+    RideFileSeries kph = ride->series(RideFile::kph);
+    RideFileSeries headwinds = ride->series(RideFile::headwind);
+    RideFileSeries alts = ride->series(RideFile::alt);
+    double dt = ride->recIntSecs();
+    int n = ride->samples();
+
+    sp.resize(n);
+    sd.resize(n);
+    sw.resize(n);
+    sk.resize(n);
+    alt.resize(n);
+    altitude = dataPresent->alt;
+
+    // the same sums Aerolab has always used, just with the
+    // parameters taken out so they can be put back in later
+    double p = 0, d = 0, w = 0, k = 0, vlast = 0;
+    for (int i=0; i<n; i++) {
+
+        double power = i < watts.count ? qMax(0.0, watts[i]) : 0;
+        double v = i < kph.count ? kph[i] / vfactor : 0;
+        double headwind = (dataPresent->headwind && i < headwinds.count) ? headwinds[i] / vfactor : v;
+
+        double a;
+        if (v > small_number) {
+            p += power * dt;
+            a = (v*v - vlast*vlast) / (2.0 * dt * v);
+        } else {
+            a = (v - vlast) / dt;
+        }
+        d += v * dt;
+        w += 0.5 * headwind * headwind * v * dt;
+        k += a * v * dt;
+
+        sp[i] = p;
+        sd[i] = d;
+        sw[i] = w;
+        sk[i] = k;
+        alt[i] = i < alts.count ? alts[i] : 0;
+
+        vlast = v;
+    }
+}
+
+double
+VirtualElevation::elevation(int i, const VEParameters &x) const
+{
+    double mg = x.totalMass * g;
+    return x.eoffset + (x.eta * sp[i] - x.cda * x.rho * sw[i]) / mg - x.crr * sd[i] - sk[i] / g;
+}
+
+void
+VirtualElevation::elevations(int from, int to, const VEParameters &x, double *out) const
+{
+    double mg = x.totalMass * g;
+    double c0 = x.eta / mg, c1 = x.cda * x.rho / mg;
+    const double *p = sp.constData(), *w = sw.constData(), *d = sd.constData(), *k = sk.constData();
+
+    for (int i=from; i<to; i++)
+        *out++ = x.eoffset + c0 * p[i] - c1 * w[i] - x.crr * d[i] - k[i] / g;
+}
+
+void
+VirtualElevation::range(const VEParameters &x, double &low, double &high) const
+{
+    low = high = 0;
+    if (count() == 0) return;
+
+    double mg = x.totalMass * g;
+    double c0 = x.eta / mg, c1 = x.cda * x.rho / mg;
+    low = high = x.eoffset + c0 * sp[0] - c1 * sw[0] - x.crr * sd[0] - sk[0] / g;
+    for (int i=1; i<count(); i++) {
+        double e = x.eoffset + c0 * sp[i] - c1 * sw[i] - x.crr * sd[i] - sk[i] / g;
+        if (e < low) low = e;
+        if (e > high) high = e;
+    }
+}
+
+VEFitSums
+VirtualElevation::sums(int from, int to) const
+{
+    VEFitSums sums;
+    from = qMax(0, from);
+    to = qMin(to, count());
+    if (!altitude) return sums;
+
+    // elevation is e0 + c.u - sk/g with c = (eta/mg, -cda*rho/mg, -crr)
+    // and u = (sp, sw, sd), so we fit y = alt + sk/g to e0 + c.u using
+    // samples with a recorded altitude, zero is taken as none recorded
+    for (int i=from; i<to; i++) {
+        if (alt[i] == 0) continue;
+        sums.mu[0] += sp[i];
+        sums.mu[1] += sw[i];
+        sums.mu[2] += sd[i];
+        sums.my += alt[i] + sk[i] / g;
+        sums.m++;
+    }
+    if (sums.m == 0) return sums;
+    for (int j=0; j<3; j++) sums.mu[j] /= sums.m;
+    sums.my /= sums.m;
+
+    // the best e0 takes out the means, so the sums are centred (in a
+    // second pass, the running sums are large and close together)
+    for (int i=from; i<to; i++) {
+        if (alt[i] == 0) continue;
+        double u0 = sp[i] - sums.mu[0], u1 = sw[i] - sums.mu[1], u2 = sd[i] - sums.mu[2];
+        double y = alt[i] + sk[i] / g - sums.my;
+        sums.s00 += u0 * u0; sums.s01 += u0 * u1; sums.s02 += u0 * u2;
+        sums.s11 += u1 * u1; sums.s12 += u1 * u2; sums.s22 += u2 * u2;
+        sums.s0y += u0 * y; sums.s1y += u1 * y; sums.s2y += u2 * y;
+        sums.syy += y * y;
+    }
+    return sums;
+}
+
+VESweepResult
+VirtualElevation::sweep(const VESweep &grid, double totalMass, int from, int to) const
+{
+    if (!altitude) {
+        VESweepResult result;
+        result.bestRms = 0;
+        result.best.cda = result.best.crr = result.best.eta = result.best.rho = result.best.eoffset = 0;
+        result.best.totalMass = totalMass;
+        result.error = tr("Altitude and Power data must be present");
+        return result;
+    }
+    QList<VEFitSums> stretches;
+    stretches << sums(from, to);
+    return sweep(grid, totalMass, stretches);
+}
+
+// scores the combinations for some of the CdAs in a grid, the
+// combinations for each CdA are together so each chunk has its
+// own stretch of the rms surface to fill in
+class VESweepChunk : public QRunnable
+{
+    public:
+        VESweepChunk(const VESweep &grid, double totalMass, const VEFitSums &sums,
+                     int from, int to, double *rms, QSemaphore *done) :
+            grid(grid), totalMass(totalMass), sums(sums), from(from), to(to),
+            rms(rms), done(done), best(-1), bestRss(0) {
+            setAutoDelete(false);
+        }
+
+        void run() {
+            score();
+            if (done) done->release();
+        }
+
+        void score() {
+            double mg = totalMass * g;
+            int index = grid.index(from, 0, 0, 0);
+
+            // each combination is a quadratic, Crr varies fastest so
+            // the inner loop is a polynomial in one variable
+            for (int icda=from; icda<to; icda++) {
+                for (int irho=0; irho<grid.rho.count(); irho++) {
+                    double c1 = -grid.cda[icda] * grid.rho[irho] / mg;
+
+                    for (int ieta=0; ieta<grid.eta.count(); ieta++) {
+                        double c0 = grid.eta[ieta] / mg;
+
+                        double base = sums.syy - 2.0 * (c0 * sums.s0y + c1 * sums.s1y)
+                                    + c0 * c0 * sums.s00 + c1 * c1 * sums.s11 + 2.0 * c0 * c1 * sums.s01;
+                        double linear = 2.0 * (c0 * sums.s02 + c1 * sums.s12 - sums.s2y);
+
+                        const double *crr = grid.crr.constData();
+                        for (int icrr=0; icrr<grid.crr.count(); icrr++) {
+                            double c2 = -crr[icrr];
+                            double rss = qMax(0.0, base + c2 * (linear + c2 * sums.s22));
+                            rms[index] = sqrt(rss / sums.m);
+
+                            if (best < 0 || rss < bestRss) {
+                                best = index;
+                                bestRss = rss;
+                                c[0] = c0; c[1] = c1; c[2] = c2;
+                                parameters.cda = grid.cda[icda];
+                                parameters.crr = crr[icrr];
+                                parameters.eta = grid.eta[ieta];
+                                parameters.rho = grid.rho[irho];
+                            }
+                            index++;
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+        const VESweep &grid;
+        double totalMass;
+        const VEFitSums &sums;
+        int from, to;
+        double *rms;
+        QSemaphore *done;
+
+    public:
+        int best;
+        double bestRss, c[3];
+        VEParameters parameters;
+};
+
+// CdAs scored by each chunk, it isn't worth a thread for less
+static const int minSweepChunk = 16;
+
+VESweepResult
+VirtualElevation::sweep(const VESweep &grid, double totalMass, const QList<VEFitSums> &stretches)
+{
+    VESweepResult result;
+    result.bestRms = 0;
+    result.best.cda = result.best.crr = result.best.eta = result.best.rho = result.best.eoffset = 0;
+    result.best.totalMass = totalMass;
+
+    if (grid.size() == 0) {
+        result.error = tr("Nothing to search");
+        return result;
+    }
+
+    // the centred sums add up, each stretch has taken out its own mean
+    VEFitSums total;
+    foreach (const VEFitSums &sums, stretches) {
+        total.m += sums.m;
+        total.s00 += sums.s00; total.s01 += sums.s01; total.s02 += sums.s02;
+        total.s11 += sums.s11; total.s12 += sums.s12; total.s22 += sums.s22;
+        total.s0y += sums.s0y; total.s1y += sums.s1y; total.s2y += sums.s2y;
+        total.syy += sums.syy;
+    }
+    if (total.m < 2) {
+        result.error = tr("At least two samples with altitude are needed");
+        return result;
+    }
+
+    // share the CdAs out between the pool and us
+    result.rms.resize(grid.size());
+    int n = grid.cda.count();
+    int chunks = qBound(1, n / minSweepChunk, qMax(1, QThread::idealThreadCount()));
+    int size = (n + chunks - 1) / chunks;
+
+    QList<VESweepChunk*> workers;
+    QSemaphore finished;
+    for (int from = size; from < n; from += size) {
+        VESweepChunk *worker = new VESweepChunk(grid, totalMass, total, from, qMin(from + size, n),
+                                                result.rms.data(), &finished);
+        workers.append(worker);
+        QThreadPool::globalInstance()->start(worker);
+    }
+    VESweepChunk mine(grid, totalMass, total, 0, qMin(size, n), result.rms.data(), NULL);
+    mine.score();
+    finished.acquire(workers.count());
+
+    VESweepChunk *best = &mine;
+    foreach (VESweepChunk *worker, workers)
+        if (worker->best >= 0 && (best->best < 0 || worker->bestRss < best->bestRss)) best = worker;
+
+    result.bestRms = result.rms[best->best];
+    result.best.cda = best->parameters.cda;
+    result.best.crr = best->parameters.crr;
+    result.best.eta = best->parameters.eta;
+    result.best.rho = best->parameters.rho;
+
+    // and each stretch gets the offset that suits it
+    foreach (const VEFitSums &sums, stretches)
+        result.eoffsets << sums.my - (best->c[0] * sums.mu[0] + best->c[1] * sums.mu[1] + best->c[2] * sums.mu[2]);
+    result.best.eoffset = result.eoffsets.isEmpty() ? 0 : result.eoffsets.first();
+
+    qDeleteAll(workers);
+    return result;
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2026 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_VirtualElevation_h
+#define _GC_VirtualElevation_h 1
+#include "GoldenCheetah.h"
+
+#include <QVector>
+#include <QList>
+#include <QString>
+#include <QCoreApplication>
+
+class RideFile;
+
+// the parameters of the model, as set on the Aerolab sliders
+struct VEParameters
+{
+    double cda, crr, eta, rho, totalMass, eoffset;
+};
+
+// every combination of these is tried by a sweep
+struct VESweep
+{
+    QVector<double> cda, crr, eta, rho;
+
+    int size() const { return cda.count() * rho.count() * eta.count() * crr.count(); }
+    int index(int icda, int icrr, int ieta, int irho) const {
+        return ((icda * rho.count() + irho) * eta.count() + ieta) * crr.count() + icrr;
+    }
+};
+
+// the rms difference in metres between the virtual and recorded elevation
+// for each combination in a sweep, each with the offset that suits it best
+struct VESweepResult
+{
+    QString error;          // empty if the sweep was done
+    QVector<double> rms;    // indexed by VESweep::index()
+    VEParameters best;      // the combination with the smallest rms
+    double bestRms;
+    QVector<double> eoffsets; // the best offset for each stretch fitted
+};
+
+// a stretch of samples reduced to the sums a fit needs, centred on
+// their own means so stretches from anywhere (other intervals, other
+// rides) just add up and each is fitted with an offset of its own
+struct VEFitSums
+{
+    VEFitSums() : m(0), my(0), s00(0), s01(0), s02(0), s11(0), s12(0), s22(0),
+                  s0y(0), s1y(0), s2y(0), syy(0) { mu[0] = mu[1] = mu[2] = 0; }
+
+    int m;                  // samples with a recorded altitude
+    double mu[3], my;       // their means
+    double s00, s01, s02, s11, s12, s22, s0y, s1y, s2y, syy;
+};
+
+// Virtual elevation (the Chung method) for a ride. The elevation gained
+// each sample is linear in eta, CdA * rho and Crr, so we keep a running
+// sum of each term once when the ride is set and an elevation anywhere in
+// the ride is then a handful of multiplies for any set of parameters.
+//
+// For the same reason the squared difference to the recorded elevation
+// is a quadratic in the parameters; a sweep reduces the ride to a small
+// matrix of sums in one pass and then each combination costs the same
+// however long the ride is.
+class VirtualElevation
+{
+    Q_DECLARE_TR_FUNCTIONS(VirtualElevation)
+
+    public:
+        VirtualElevation() : altitude(false) {}
+
+        void setRide(const RideFile *ride);
+
+        int count() const { return sp.count(); }
+        bool hasAltitude() const { return altitude; }
+
+        // elevation at sample index, and for the samples [from, to)
+        double elevation(int index, const VEParameters &parameters) const;
+        void elevations(int from, int to, const VEParameters &parameters, double *out) const;
+        void range(const VEParameters &parameters, double &low, double &high) const; // whole ride
+
+        // fit the samples [from, to) that have a recorded altitude
+        VEFitSums sums(int from, int to) const;
+        VESweepResult sweep(const VESweep &grid, double totalMass, int from, int to) const;
+
+        // fit several stretches at once, of this ride or of many, with
+        // the grid shared out across the global thread pool
+        static VESweepResult sweep(const VESweep &grid, double totalMass,
+                                   const QList<VEFitSums> &stretches);
+
+    private:
+        // running sums of the energy from power, distance, air resistance
+        // per unit CdA * rho and kinetic energy per unit mass
+        QVector<double> sp, sd, sw, sk;
+        QVector<double> alt;
+        bool altitude;
+};
+
+#endif // _GC_VirtualElevation_h
@@ -17,33 +17,12 @@
  */
 
 #include "RideMetric.h"
-#include "BestIntervalDialog.h"
 #include "Zones.h"
 #include "Settings.h"
 #include "MetricAggregator.h"
 #include <math.h>
 #include <QApplication>
 
-// first use RideFile::startTime, then Measure then fallback to Global Setting
-static double
-getWeight(const MainWindow *main, const RideFile *ride)
-{
-    // ride
-    double weight;
-    if ((weight = ride->getTag("Weight", "0.0").toDouble()) > 0) {
-        return weight;
-    }
-
-    // withings?
-    QList<SummaryMetrics> measures = main->metricDB->getAllMeasuresFor(QDateTime::fromString("Jan 1 00:00:00 1900"), ride->startTime());
-    if (measures.count()) {
-        return measures.last().getText("Weight", "0.0").toDouble();
-    }
-
-    // global options
-    return appsettings->cvalue(main->cyclist, GC_WEIGHT, "75.0").toString().toDouble(); // default to 75kg
-}
-
 class AverageWPK : public RideMetric {
     Q_DECLARE_TR_FUNCTIONS(AverageWPK)
 
@@ -65,11 +44,11 @@ class AverageWPK : public RideMetric {
     void compute(const RideFile *ride, const Zones *, int,
                  const HrZones *, int,
                  const QHash<QString,RideMetric*> &deps,
-                 const MainWindow *main) {
+                 const MainWindow *) {
 
         // get thos dependencies
         double secs = deps.value("workout_time")->value(true);
-        double weight = getWeight(main, ride);
+        double weight = ride->getWeight();
         double ap = deps.value("average_power")->value(true);
 
         // calclate watts per kilo
@@ -98,15 +77,12 @@ class PeakWPK : public RideMetric {
     void compute(const RideFile *ride, const Zones *, int,
                  const HrZones *, int,
                  const QHash<QString,RideMetric*> &,
-                 const MainWindow *main) {
+                 const MainWindow *) {
 
-        if (!ride->dataPoints().isEmpty()) {
-            weight = getWeight(main, ride);
-            //weight = ride->getTag("Weight", appsettings->cvalue(GC_WEIGHT, "75.0").toString()).toDouble(); // default to 75kg
-            QList<BestIntervalDialog::BestInterval> results;
-            BestIntervalDialog::findBests(ride, secs, 1, results);
-            if (results.count() > 0 && results.first().avg < 3000) wpk = results.first().avg / weight;
-            else wpk = 0.0;
+        RideFilePeak peak = ride->peakPower(secs);
+        if (!peak.isEmpty() && peak.avg < 3000) {
+            weight = ride->getWeight();
+            wpk = peak.avg / weight;
         } else {
             wpk = 0.0;
         }
@@ -157,11 +157,12 @@ WkoParser::WkoParser(QFile &file, QStringList &errors, QList<RideFile*>*rides)
     // adjust times to start at zero, some ridefiles have
     // a start time that really blows up the CPX calculator
     // e.g. first sample at 19 hrs ..
-    if (results->dataPoints().count() && results->dataPoints().first()->secs > 0) {
-        double sub = results->dataPoints().first()->secs;
+    int samples = results->samples();
+    if (samples && results->getPointValue(0, RideFile::secs) > 0) {
+        double sub = results->getPointValue(0, RideFile::secs);
 
-        foreach(RideFilePoint *p, results->dataPoints())
-            p->secs -= sub;
+        for (int i=0; i<samples; i++)
+            results->setPointValue(i, RideFile::secs, results->getPointValue(i, RideFile::secs) - sub);
     }
 
     // Post process  the ride intervals to convert from point offsets to time in seconds
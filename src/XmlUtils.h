@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2026 Mark Liversedge (liversedge@gmail.com)
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc., 51
+ * Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef _GC_XmlUtils_h
+#define _GC_XmlUtils_h 1
+#include "GoldenCheetah.h"
+
+#include <QString>
+#include <QStringRef>
+#include <QXmlStreamReader>
+
+// Helpers for the ride file readers that pull samples from a
+// QXmlStreamReader. Numbers are converted from the text where it sits
+// rather than building a QString for every value, so a long ride costs
+// little more than its samples. QString::toDouble() always uses the C
+// locale, so unlike strtod() they are safe on any thread.
+
+// an attribute value or text token, converted in place
+static inline double
+xmlDouble(const QStringRef &text, bool *ok = NULL)
+{
+    return QString::fromRawData(text.unicode(), text.size()).toDouble(ok);
+}
+
+// the text of a simple element like <hr>152</hr>, the reader is left on
+// its end element. Text can arrive in more than one piece so it is put
+// together in scratch, which the caller keeps from one element to the
+// next so it is only allocated once.
+static inline double
+xmlElementDouble(QXmlStreamReader &xml, QString &scratch, bool *ok = NULL)
+{
+    scratch.truncate(0);
+    while (!xml.atEnd()) {
+        QXmlStreamReader::TokenType token = xml.readNext();
+        if (token == QXmlStreamReader::Characters) scratch.append(xml.text());
+        else if (token == QXmlStreamReader::StartElement) xml.skipCurrentElement();
+        else if (token == QXmlStreamReader::EndElement) break;
+    }
+    return scratch.toDouble(ok);
+}
+
+#endif // _GC_XmlUtils_h
@@ -23,6 +23,8 @@
 #include "MainWindow.h"
 #include "Settings.h"
 #include "TrainDB.h"
+#include "RideFileCache.h"
+#include "FitRideFile.h"
 
 #ifdef Q_OS_X11
 #include <X11/Xlib.h>
@@ -37,6 +39,18 @@ main(int argc, char *argv[])
 
     QApplication app(argc, argv);
 
+    // developers: time the mean max algorithms and quit
+    if (app.arguments().contains("--benchmark-meanmax")) {
+        QTextStream out(stdout);
+        MeanMaxComputer::benchmark(out);
+        return 0;
+    }
+    if (app.arguments().contains("--benchmark-fit")) {
+        QTextStream out(stdout);
+        FitFileReader::benchmark(out);
+        return 0;
+    }
+
     QFont font;
     font.fromString(appsettings->value(NULL, GC_FONT_DEFAULT, QFont().toString()).toString());
     font.setPointSize(appsettings->value(NULL, GC_FONT_DEFAULT_SIZE, 12).toInt());
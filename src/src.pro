@@ -266,6 +266,7 @@ HEADERS += \
         GcBubble.h \
         GcCalendar.h \
         GcCalendarModel.h \
+        GcbRideFile.h \
         GcPane.h \
         GcRideFile.h \
         GcToolBar.h \
@@ -308,11 +309,14 @@ HEADERS += \
         ManualRideFile.h \
         MetadataWindow.h \
         MetricAggregator.h \
+        MetricResultSet.h \
+        MinMaxSeriesData.h \
         NewCyclistDialog.h \
         MultiWindow.h \
         NullController.h \
         Pages.h \
         PerfPlot.h \
+        PMCData.h \
         PerformanceManagerWindow.h \
         PfPvPlot.h \
         PfPvWindow.h \
@@ -343,7 +347,10 @@ HEADERS += \
         RideMetadata.h \
         RideMetric.h \
         RideNavigator.h \
+        RideNavigatorModel.h \
         RideNavigatorProxy.h \
+        RidePrefetcher.h \
+        RideResidency.h \
         RideWindow.h \
         RideWithGPSDialog.h \
         SaveDialogs.h \
@@ -357,6 +364,7 @@ HEADERS += \
         Settings.h \
         SimpleNetworkController.h \
         SimpleNetworkClient.h \
+        Smoother.h \
         SpecialFields.h \
         SpinScanPlot.h \
         SpinScanPolarPlot.h \
@@ -386,18 +394,20 @@ HEADERS += \
         TreeMapPlot.h \
         TtbDialog.h \
         Units.h \
+        VirtualElevation.h \
         WeeklySummaryWindow.h \
         WeeklyViewItemDelegate.h \
         WithingsDownload.h \
         WkoRideFile.h \
         WorkoutPlotWindow.h \
         WorkoutWizard.h \
+        XmlUtils.h \
         ZeoDownload.h \
         Zones.h \
         ZoneScaleDraw.h
 
 YACCSOURCES += JsonRideFile.y WithingsParser.y
-LEXSOURCES  += JsonRideFile.l WithingsParser.l
+LEXSOURCES  += WithingsParser.l
 
 #-t turns on debug, use with caution
 #QMAKE_YACCFLAGS = -t -d
@@ -460,6 +470,7 @@ SOURCES += \
         FixTorque.cpp \
         GcBubble.cpp \
         GcCalendar.cpp \
+        GcbRideFile.cpp \
         GcPane.cpp \
         GcRideFile.cpp \
         GcToolBar.cpp \
@@ -503,12 +514,15 @@ SOURCES += \
         ManualRideFile.cpp \
         MetadataWindow.cpp \
         MetricAggregator.cpp \
+        MetricResultSet.cpp \
+        MinMaxSeriesData.cpp \
         NewCyclistDialog.cpp \
         MultiWindow.cpp \
         NullController.cpp \
         Pages.cpp \
         PeakPower.cpp \
         PerfPlot.cpp \
+        PMCData.cpp \
         PerformanceManagerWindow.cpp \
         PfPvPlot.cpp \
         PfPvWindow.cpp \
@@ -538,6 +552,9 @@ SOURCES += \
         RideMetadata.cpp \
         RideMetric.cpp \
         RideNavigator.cpp \
+        RideNavigatorModel.cpp \
+        RidePrefetcher.cpp \
+        RideResidency.cpp \
         RideSummaryWindow.cpp \
         RideWindow.cpp \
         RideWithGPSDialog.cpp \
@@ -551,6 +568,7 @@ SOURCES += \
         SimpleNetworkController.cpp \
         SimpleNetworkClient.cpp \
         SmallPlot.cpp \
+        Smoother.cpp \
         SpecialFields.cpp \
         SpinScanPlot.cpp \
         SpinScanPolarPlot.cpp \
@@ -582,6 +600,7 @@ SOURCES += \
         TreeMapPlot.cpp \
         TtbDialog.cpp \
         TRIMPPoints.cpp \
+        VirtualElevation.cpp \
         WattsPerKilogram.cpp \
         WithingsDownload.cpp \
         WeeklySummaryWindow.cpp \